@@ -157,6 +157,8 @@
         'i18n/rtl_unittest.cc',
         'i18n/string_search_unittest.cc',
         'i18n/time_formatting_unittest.cc',
+        'incoming_task_queue_unittest.cc',
+        'json/json_parser_unittest.cc',
         'json/json_reader_unittest.cc',
         'json/json_value_converter_unittest.cc',
         'json/json_value_serializer_unittest.cc',
@@ -429,6 +431,29 @@
         'test/trace_event_analyzer.h',
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'json/json_perftest.cc',
+        'message_loop_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'threading/worker_pool_posix_perftest.cc',
+        'values_perftest.cc',
+      ],
+      'conditions': [
+        ['OS == "win"', {
+          'sources!': [
+            'threading/worker_pool_posix_perftest.cc',
+          ],
+        }],
+      ],
+    },
     {
       'target_name': 'test_support_perf',
       'type': 'static_library',
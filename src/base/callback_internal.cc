@@ -4,6 +4,8 @@
 
 #include "base/callback_internal.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 
 namespace base {
@@ -18,6 +20,11 @@ void CallbackBase::Reset() {
   polymorphic_invoke_ = NULL;
 }
 
+void CallbackBase::Swap(CallbackBase* other) {
+  bind_state_.swap(other->bind_state_);
+  std::swap(polymorphic_invoke_, other->polymorphic_invoke_);
+}
+
 bool CallbackBase::Equals(const CallbackBase& other) const {
   return bind_state_.get() == other.bind_state_.get() &&
          polymorphic_invoke_ == other.polymorphic_invoke_;
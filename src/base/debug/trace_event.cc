@@ -6,6 +6,7 @@
 
 #include <algorithm>
 
+#include "base/atomicops.h"
 #include "base/bind.h"
 #include "base/file_util.h"
 #include "base/format_macros.h"
@@ -40,6 +41,9 @@ namespace debug {
 // before throwing them away.
 const size_t kTraceEventBufferSize = 500000;
 const size_t kTraceEventBatchSize = 1000;
+// Controls the number of trace events a thread adds between two acquisitions
+// of TraceLog::lock_.
+const size_t kTraceChunkSize = 64;
 
 #define TRACE_EVENT_MAX_CATEGORIES 100
 
@@ -73,6 +77,39 @@ LazyInstance<ThreadLocalPointer<const char>,
              LeakyLazyInstanceTraits<ThreadLocalPointer<const char> > >
     g_current_thread_name = LAZY_INSTANCE_INITIALIZER;
 
+// Serializes events to JSON, and hands them to |output_callback| in batches of
+// kTraceEventBatchSize events.
+class TraceEventBatcher {
+ public:
+  explicit TraceEventBatcher(const TraceLog::OutputCallback& output_callback)
+      : output_callback_(output_callback),
+        num_events_(0) {
+  }
+
+  void Add(const TraceEvent& event) {
+    if (!json_events_str_ptr_)
+      json_events_str_ptr_ = new TraceLog::RefCountedString();
+    else
+      json_events_str_ptr_->data += ",";
+    event.AppendAsJSON(&json_events_str_ptr_->data);
+    if (++num_events_ == kTraceEventBatchSize)
+      Finish();
+  }
+
+  // Hands the last batch to the callback.
+  void Finish() {
+    if (json_events_str_ptr_)
+      output_callback_.Run(json_events_str_ptr_);
+    json_events_str_ptr_ = NULL;
+    num_events_ = 0;
+  }
+
+ private:
+  TraceLog::OutputCallback output_callback_;
+  scoped_refptr<TraceLog::RefCountedString> json_events_str_ptr_;
+  size_t num_events_;
+};
+
 }  // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -319,6 +356,121 @@ void TraceResultBuffer::Finish() {
   output_callback_.Run("]");
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// TraceLog::TraceChunk
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class TraceLog::TraceChunk {
+ public:
+  explicit TraceChunk(ThreadBuffer* owner) : owner_(owner), size_(0) {}
+
+  ThreadBuffer* owner() const { return owner_; }
+  size_t size() const { return size_; }
+  bool IsFull() const { return size_ == kTraceChunkSize; }
+  const TraceEvent& event(size_t index) const { return events_[index]; }
+
+  void AddEvent(int id, const TraceEvent& event) {
+    DCHECK(!IsFull());
+    ids_[size_] = id;
+    events_[size_++] = event;
+  }
+
+  // Sets |*index| to the index of the event |id|, which is usually one of the
+  // last ones, and returns true if it is in this chunk.
+  bool FindEvent(int id, size_t* index) const {
+    for (size_t i = size_; i > 0; --i) {
+      if (ids_[i - 1] == id) {
+        *index = i - 1;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void RemoveEventAt(size_t index) {
+    DCHECK_LT(index, size_);
+    for (size_t i = index + 1; i < size_; ++i) {
+      ids_[i - 1] = ids_[i];
+      events_[i - 1] = events_[i];
+    }
+    events_[--size_] = TraceEvent();
+  }
+
+ private:
+  ThreadBuffer* owner_;
+  size_t size_;
+  int ids_[kTraceChunkSize];
+  TraceEvent events_[kTraceChunkSize];
+
+  DISALLOW_COPY_AND_ASSIGN(TraceChunk);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// TraceLog::ThreadBuffer
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class TraceLog::ThreadBuffer {
+ public:
+  explicit ThreadBuffer(int thread_id)
+      : thread_id_(thread_id),
+        next_event_id_(0),
+        chunk_(0) {
+  }
+
+  ~ThreadBuffer() {
+    delete TakeChunk();
+  }
+
+  int thread_id() const { return thread_id_; }
+
+  // Returns the id of the next event of the thread. Only called on the thread
+  // of the buffer.
+  int GetNextEventId() {
+    int id = next_event_id_;
+    next_event_id_ = (id == kint32max) ? 0 : id + 1;
+    return id;
+  }
+
+  // Takes the chunk being filled out of the buffer while an event is added,
+  // so that Flush() leaves it alone. Returns NULL if there is no chunk, or if
+  // Flush() took it. Only called on the thread of the buffer.
+  TraceChunk* AcquireChunk() {
+    return reinterpret_cast<TraceChunk*>(
+        subtle::NoBarrier_AtomicExchange(&chunk_, 0));
+  }
+
+  // Puts |chunk| back once the event has been added. The release semantics
+  // publish the event to Flush().
+  void ReleaseChunk(TraceChunk* chunk) {
+    subtle::Release_Store(&chunk_, reinterpret_cast<subtle::AtomicWord>(chunk));
+  }
+
+  // Takes the chunk being filled for Flush(), unless the thread is adding an
+  // event to it, in which case it is kept for the next flush.
+  TraceChunk* TakeChunk() {
+    TraceChunk* chunk = reinterpret_cast<TraceChunk*>(
+        subtle::NoBarrier_AtomicExchange(&chunk_, 0));
+    subtle::MemoryBarrier();  // Pairs with the release in ReleaseChunk().
+    return chunk;
+  }
+
+  // Returns the chunk being filled without taking it, for tests.
+  const TraceChunk* PeekChunk() const {
+    return reinterpret_cast<const TraceChunk*>(subtle::Acquire_Load(&chunk_));
+  }
+
+ private:
+  int thread_id_;
+  int next_event_id_;
+  subtle::AtomicWord chunk_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadBuffer);
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // TraceLog
@@ -331,11 +483,17 @@ TraceLog* TraceLog::GetInstance() {
 }
 
 TraceLog::TraceLog()
-    : enabled_(false) {
+    : enabled_(false),
+      buffer_mode_(RECORD_UNTIL_FULL),
+      max_chunks_(kTraceEventBufferSize / kTraceChunkSize),
+      num_chunks_(0),
+      buffer_full_(false) {
   SetProcessID(static_cast<int>(base::GetCurrentProcId()));
 }
 
 TraceLog::~TraceLog() {
+  STLDeleteElements(&chunks_);
+  STLDeleteElements(&thread_buffers_);
 }
 
 const TraceCategory* TraceLog::GetCategory(const char* name) {
@@ -417,7 +575,6 @@ void TraceLog::SetEnabled(const std::vector<std::string>& included_categories,
   AutoLock lock(lock_);
   if (enabled_)
     return;
-  logged_events_.reserve(1024);
   enabled_ = true;
   included_categories_ = included_categories;
   excluded_categories_ = excluded_categories;
@@ -484,8 +641,17 @@ void TraceLog::SetEnabled(bool enabled) {
     SetDisabled();
 }
 
+void TraceLog::SetBufferMode(BufferMode mode, size_t buffer_size_in_bytes) {
+  AutoLock lock(lock_);
+  if (enabled_)
+    return;
+  buffer_mode_ = mode;
+  max_chunks_ = std::max(buffer_size_in_bytes / sizeof(TraceChunk),
+                         static_cast<size_t>(1));
+}
+
 float TraceLog::GetBufferPercentFull() const {
-  return (float)((double)logged_events_.size()/(double)kTraceEventBufferSize);
+  return (float)((double)num_chunks_/(double)max_chunks_);
 }
 
 void TraceLog::SetOutputCallback(const TraceLog::OutputCallback& cb) {
@@ -499,28 +665,36 @@ void TraceLog::SetBufferFullCallback(const TraceLog::BufferFullCallback& cb) {
 }
 
 void TraceLog::Flush() {
-  std::vector<TraceEvent> previous_logged_events;
+  std::vector<TraceChunk*> previous_chunks;
+  std::vector<TraceEvent> previous_metadata_events;
   OutputCallback output_callback_copy;
   {
     AutoLock lock(lock_);
-    previous_logged_events.swap(logged_events_);
+    previous_chunks.assign(chunks_.begin(), chunks_.end());
+    chunks_.clear();
+    for (size_t i = 0; i < thread_buffers_.size(); ++i) {
+      TraceChunk* chunk = thread_buffers_[i]->TakeChunk();
+      if (chunk)
+        previous_chunks.push_back(chunk);
+    }
+    DCHECK_LE(previous_chunks.size(), num_chunks_);
+    num_chunks_ -= previous_chunks.size();
+    buffer_full_ = false;
+    previous_metadata_events.swap(metadata_events_);
     output_callback_copy = output_callback_;
   }  // release lock
 
-  if (output_callback_copy.is_null())
-    return;
-
-  for (size_t i = 0;
-       i < previous_logged_events.size();
-       i += kTraceEventBatchSize) {
-    scoped_refptr<RefCountedString> json_events_str_ptr =
-        new RefCountedString();
-    TraceEvent::AppendEventsAsJSON(previous_logged_events,
-                                   i,
-                                   kTraceEventBatchSize,
-                                   &(json_events_str_ptr->data));
-    output_callback_copy.Run(json_events_str_ptr);
+  if (!output_callback_copy.is_null()) {
+    TraceEventBatcher batcher(output_callback_copy);
+    for (size_t i = 0; i < previous_chunks.size(); ++i) {
+      for (size_t j = 0; j < previous_chunks[i]->size(); ++j)
+        batcher.Add(previous_chunks[i]->event(j));
+    }
+    for (size_t i = 0; i < previous_metadata_events.size(); ++i)
+      batcher.Add(previous_metadata_events[i]);
+    batcher.Finish();
   }
+  STLDeleteElements(&previous_chunks);
 }
 
 int TraceLog::AddTraceEvent(TraceEventPhase phase,
@@ -534,78 +708,175 @@ int TraceLog::AddTraceEvent(TraceEventPhase phase,
                             TraceEventFlags flags) {
   DCHECK(name);
   TimeTicks now = TimeTicks::HighResNow();
-  BufferFullCallback buffer_full_callback_copy;
-  int ret_begin_id = -1;
-  {
-    AutoLock lock(lock_);
-    if (!category->enabled)
-      return -1;
-    if (logged_events_.size() >= kTraceEventBufferSize)
-      return -1;
-
-    int thread_id = static_cast<int>(PlatformThread::CurrentId());
-
-    const char* new_name = PlatformThread::GetName();
-    // Check if the thread name has been set or changed since the previous
-    // call (if any), but don't bother if the new name is empty. Note this will
-    // not detect a thread name change within the same char* buffer address: we
-    // favor common case performance over corner case correctness.
-    if (new_name != g_current_thread_name.Get().Get() &&
-        new_name && *new_name) {
-      g_current_thread_name.Get().Set(new_name);
-      base::hash_map<int, std::string>::iterator existing_name =
-          thread_names_.find(thread_id);
-      if (existing_name == thread_names_.end()) {
-        // This is a new thread id, and a new name.
-        thread_names_[thread_id] = new_name;
-      } else {
-        // This is a thread id that we've seen before, but potentially with a
-        // new name.
-        std::vector<base::StringPiece> existing_names;
-        Tokenize(existing_name->second, ",", &existing_names);
-        bool found = std::find(existing_names.begin(),
-                               existing_names.end(),
-                               new_name) != existing_names.end();
-        if (!found) {
-          existing_name->second.push_back(',');
-          existing_name->second.append(new_name);
-        }
-      }
-    }
-
-    if (threshold_begin_id > -1) {
-      DCHECK(phase == TRACE_EVENT_PHASE_END);
-      size_t begin_i = static_cast<size_t>(threshold_begin_id);
-      // Return now if there has been a flush since the begin event was posted.
-      if (begin_i >= logged_events_.size())
-        return -1;
+  if (!category->enabled)
+    return -1;
+
+  ThreadBuffer* buffer = GetThreadBuffer();
+  UpdateThreadName(buffer->thread_id());
+
+  TraceChunk* chunk = buffer->AcquireChunk();
+  if (threshold_begin_id > -1) {
+    DCHECK(phase == TRACE_EVENT_PHASE_END);
+    bool drop = false;
+    size_t begin_index;
+    if (chunk && chunk->FindEvent(threshold_begin_id, &begin_index)) {
       // Determine whether to drop the begin/end pair.
-      TimeDelta elapsed = now - logged_events_[begin_i].timestamp();
-      if (elapsed < TimeDelta::FromMicroseconds(threshold)) {
+      TimeDelta elapsed = now - chunk->event(begin_index).timestamp();
+      drop = elapsed < TimeDelta::FromMicroseconds(threshold);
+      if (drop) {
         // Remove begin event and do not add end event.
-        // This will be expensive if there have been other events in the
-        // mean time (should be rare).
-        logged_events_.erase(logged_events_.begin() + begin_i);
-        return -1;
+        chunk->RemoveEventAt(begin_index);
       }
+    } else if (!DropRecordedBeginEvent(buffer, threshold_begin_id, now,
+                                       threshold, &drop)) {
+      // Return now if there has been a flush since the begin event was posted.
+      drop = true;
     }
-    ret_begin_id = static_cast<int>(logged_events_.size());
-    logged_events_.push_back(
-        TraceEvent(thread_id,
-                   now, phase, category, name, id,
-                   arg1_name, arg1_val,
-                   arg2_name, arg2_val,
-                   flags));
-
-    if (logged_events_.size() == kTraceEventBufferSize) {
-      buffer_full_callback_copy = buffer_full_callback_;
+    if (drop) {
+      buffer->ReleaseChunk(chunk);
+      return -1;
     }
-  }  // release lock
+  }
+
+  BufferFullCallback buffer_full_callback_copy;
+  if (!chunk || chunk->IsFull())
+    chunk = GetNextChunk(buffer, chunk, &buffer_full_callback_copy);
+
+  int event_id = -1;
+  if (chunk) {
+    event_id = buffer->GetNextEventId();
+    chunk->AddEvent(event_id,
+                    TraceEvent(buffer->thread_id(),
+                               now, phase, category, name, id,
+                               arg1_name, arg1_val,
+                               arg2_name, arg2_val,
+                               flags));
+  }
+  buffer->ReleaseChunk(chunk);
 
   if (!buffer_full_callback_copy.is_null())
     buffer_full_callback_copy.Run();
 
-  return ret_begin_id;
+  return event_id;
+}
+
+TraceLog::ThreadBuffer* TraceLog::GetThreadBuffer() {
+  ThreadBuffer* buffer = thread_buffer_.Get();
+  if (!buffer) {
+    buffer = new ThreadBuffer(static_cast<int>(PlatformThread::CurrentId()));
+    thread_buffer_.Set(buffer);
+    AutoLock lock(lock_);
+    thread_buffers_.push_back(buffer);
+  }
+  return buffer;
+}
+
+void TraceLog::UpdateThreadName(int thread_id) {
+  const char* new_name = PlatformThread::GetName();
+  // Check if the thread name has been set or changed since the previous
+  // call (if any), but don't bother if the new name is empty. Note this will
+  // not detect a thread name change within the same char* buffer address: we
+  // favor common case performance over corner case correctness.
+  if (new_name == g_current_thread_name.Get().Get() || !new_name || !*new_name)
+    return;
+  g_current_thread_name.Get().Set(new_name);
+
+  AutoLock lock(lock_);
+  base::hash_map<int, std::string>::iterator existing_name =
+      thread_names_.find(thread_id);
+  if (existing_name == thread_names_.end()) {
+    // This is a new thread id, and a new name.
+    thread_names_[thread_id] = new_name;
+  } else {
+    // This is a thread id that we've seen before, but potentially with a
+    // new name.
+    std::vector<base::StringPiece> existing_names;
+    Tokenize(existing_name->second, ",", &existing_names);
+    bool found = std::find(existing_names.begin(),
+                           existing_names.end(),
+                           new_name) != existing_names.end();
+    if (!found) {
+      existing_name->second.push_back(',');
+      existing_name->second.append(new_name);
+    }
+  }
+}
+
+TraceLog::TraceChunk* TraceLog::GetNextChunk(
+    ThreadBuffer* buffer,
+    TraceChunk* full_chunk,
+    BufferFullCallback* buffer_full_callback) {
+  AutoLock lock(lock_);
+  if (full_chunk)
+    chunks_.push_back(full_chunk);
+
+  if (num_chunks_ >= max_chunks_) {
+    if (buffer_mode_ == RECORD_CONTINUOUSLY && !chunks_.empty()) {
+      // Make room by dropping the oldest events.
+      delete chunks_.front();
+      chunks_.pop_front();
+      num_chunks_--;
+    } else {
+      if (!buffer_full_) {
+        buffer_full_ = true;
+        *buffer_full_callback = buffer_full_callback_;
+      }
+      return NULL;
+    }
+  }
+  num_chunks_++;
+  return new TraceChunk(buffer);
+}
+
+bool TraceLog::DropRecordedBeginEvent(ThreadBuffer* buffer,
+                                      int begin_id,
+                                      TimeTicks now,
+                                      int64 threshold,
+                                      bool* dropped) {
+  AutoLock lock(lock_);
+  // The begin event is most likely in the last chunk of the thread.
+  for (std::deque<TraceChunk*>::reverse_iterator it = chunks_.rbegin();
+       it != chunks_.rend(); ++it) {
+    size_t begin_index;
+    if ((*it)->owner() != buffer || !(*it)->FindEvent(begin_id, &begin_index))
+      continue;
+    TimeDelta elapsed = now - (*it)->event(begin_index).timestamp();
+    *dropped = elapsed < TimeDelta::FromMicroseconds(threshold);
+    if (*dropped)
+      (*it)->RemoveEventAt(begin_index);
+    return true;
+  }
+  return false;
+}
+
+size_t TraceLog::GetEventsSize() const {
+  size_t size = metadata_events_.size();
+  for (size_t i = 0; i < chunks_.size(); ++i)
+    size += chunks_[i]->size();
+  for (size_t i = 0; i < thread_buffers_.size(); ++i) {
+    const TraceChunk* chunk = thread_buffers_[i]->PeekChunk();
+    if (chunk)
+      size += chunk->size();
+  }
+  return size;
+}
+
+const TraceEvent& TraceLog::GetEventAt(size_t index) const {
+  for (size_t i = 0; i < chunks_.size(); ++i) {
+    if (index < chunks_[i]->size())
+      return chunks_[i]->event(index);
+    index -= chunks_[i]->size();
+  }
+  for (size_t i = 0; i < thread_buffers_.size(); ++i) {
+    const TraceChunk* chunk = thread_buffers_[i]->PeekChunk();
+    if (!chunk)
+      continue;
+    if (index < chunk->size())
+      return chunk->event(index);
+    index -= chunk->size();
+  }
+  DCHECK(index < metadata_events_.size());
+  return metadata_events_[index];
 }
 
 void TraceLog::AddTraceEventEtw(TraceEventPhase phase,
@@ -694,7 +965,7 @@ void TraceLog::AddThreadNameMetadataEvents() {
       it != thread_names_.end();
       it++) {
     if (!it->second.empty())
-      logged_events_.push_back(
+      metadata_events_.push_back(
           TraceEvent(it->first,
                      TimeTicks(), TRACE_EVENT_PHASE_METADATA,
                      g_category_metadata, "thread_name", 0,
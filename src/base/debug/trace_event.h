@@ -128,12 +128,17 @@
 //
 // Then the category.enabled flag is checked. This is a volatile bool, and
 // not intended to be multithread safe. It optimizes access to AddTraceEvent
-// which is threadsafe internally via TraceLog::lock_. The enabled flag may
-// cause some threads to incorrectly call or skip calling AddTraceEvent near
-// the time of the system being enabled or disabled. This is acceptable as
-// we tolerate some data loss while the system is being enabled/disabled and
-// because AddTraceEvent is threadsafe internally and checks the enabled state
-// again under lock.
+// which is threadsafe internally. The enabled flag may cause some threads to
+// incorrectly call or skip calling AddTraceEvent near the time of the system
+// being enabled or disabled. This is acceptable as we tolerate some data loss
+// while the system is being enabled/disabled and because AddTraceEvent is
+// threadsafe internally and checks the enabled state again.
+//
+// AddTraceEvent records into a chunk of events owned by the calling thread
+// without taking any lock, so that tracing doesn't serialize the threads it
+// is measuring. TraceLog::lock_ is only taken when a thread starts a new chunk
+// (every kTraceChunkSize events) or changes its name. Flush collects the
+// chunks of all threads, including the ones being filled.
 //
 // Without the use of these static category pointers and enabled flags all
 // trace points would carry a significant performance cost of aquiring a lock
@@ -149,6 +154,7 @@
 
 #include "build/build_config.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -158,6 +164,7 @@
 #include "base/string_util.h"
 #include "base/synchronization/lock.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
+#include "base/threading/thread_local.h"
 #include "base/timer.h"
 
 // By default, const char* argument values are assumed to have long-lived scope
@@ -848,6 +855,21 @@ class BASE_EXPORT TraceLog {
   void SetEnabled(bool enabled);
   bool IsEnabled() { return enabled_; }
 
+  enum BufferMode {
+    // Drop new events once the buffer is full, and run the buffer full
+    // callback. This is the default.
+    RECORD_UNTIL_FULL,
+    // Drop the oldest events once the buffer is full, like a flight recorder.
+    // The events are only handed to the output callback by Flush() or
+    // SetDisabled().
+    RECORD_CONTINUOUSLY
+  };
+
+  // Set what happens when the buffer is full, and about how many bytes of
+  // events it holds (the copied strings of the events are not accounted for).
+  // Ignored while tracing is enabled.
+  void SetBufferMode(BufferMode mode, size_t buffer_size_in_bytes);
+
   float GetBufferPercentFull() const;
 
   // When enough events are collected, they are handed (in bulk) to
@@ -866,15 +888,17 @@ class BASE_EXPORT TraceLog {
   typedef base::Callback<void(void)> BufferFullCallback;
   void SetBufferFullCallback(const BufferFullCallback& cb);
 
-  // Flushes all logged data to the callback.
+  // Flushes all logged data to the callback. This can be called while
+  // tracing is enabled; events being added by other threads at the same time
+  // are kept for the next flush.
   void Flush();
 
   // Called by TRACE_EVENT* macros, don't call this directly.
   static const TraceCategory* GetCategory(const char* name);
 
   // Called by TRACE_EVENT* macros, don't call this directly.
-  // Returns the index in the internal vector of the event if it was added, or
-  //         -1 if the event was not added.
+  // Returns an id of the event among the events of the current thread if it
+  //         was added, or -1 if the event was not added.
   // On end events, the return value of the begin event can be specified along
   // with a threshold in microseconds. If the elapsed time between begin and end
   // is less than the threshold, the begin/end event pair is dropped.
@@ -921,12 +945,10 @@ class BASE_EXPORT TraceLog {
   // Allows resurrecting our singleton instance post-AtExit processing.
   static void Resurrect();
 
-  // Allow tests to inspect TraceEvents.
-  size_t GetEventsSize() const { return logged_events_.size(); }
-  const TraceEvent& GetEventAt(size_t index) const {
-    DCHECK(index < logged_events_.size());
-    return logged_events_[index];
-  }
+  // Allow tests to inspect the TraceEvents that have not been flushed yet.
+  // No other thread may be adding events at the same time.
+  size_t GetEventsSize() const;
+  const TraceEvent& GetEventAt(size_t index) const;
 
   void SetProcessID(int process_id);
 
@@ -935,19 +957,52 @@ class BASE_EXPORT TraceLog {
   // by the Singleton class.
   friend struct StaticMemorySingletonTraits<TraceLog>;
 
+  // A fixed size block of events, filled by a single thread.
+  class TraceChunk;
+  // The events of a thread: the chunk that it is filling, which is taken out
+  // of the buffer while an event is added (or by Flush()).
+  class ThreadBuffer;
+
   TraceLog();
   ~TraceLog();
   const TraceCategory* GetCategoryInternal(const char* name);
   void AddThreadNameMetadataEvents();
   void AddClockSyncMetadataEvents();
 
-  // TODO(nduca): switch to per-thread trace buffers to reduce thread
-  // synchronization.
+  // Return the buffer of the current thread, creating it if needed.
+  ThreadBuffer* GetThreadBuffer();
+  // Record the new name of the current thread, if it changed.
+  void UpdateThreadName(int thread_id);
+  // Hand |full_chunk| (which may be NULL) to the recorded chunks, and return a
+  // new chunk for |buffer|, or NULL if the buffer is full. Sets
+  // |*buffer_full_callback| if it should be run.
+  TraceChunk* GetNextChunk(ThreadBuffer* buffer,
+                           TraceChunk* full_chunk,
+                           BufferFullCallback* buffer_full_callback);
+  // Look for the begin event |begin_id| of the current thread in the filled
+  // chunks, and drop it (setting |*dropped|) if it was added less than
+  // |threshold| microseconds before |now|. Returns false if it wasn't found.
+  bool DropRecordedBeginEvent(ThreadBuffer* buffer, int begin_id,
+                              TimeTicks now, int64 threshold, bool* dropped);
+
   Lock lock_;
   bool enabled_;
   OutputCallback output_callback_;
   BufferFullCallback buffer_full_callback_;
-  std::vector<TraceEvent> logged_events_;
+  BufferMode buffer_mode_;
+  // The maximum number of chunks (filled, or being filled by a thread).
+  size_t max_chunks_;
+  size_t num_chunks_;
+  // Whether events have been dropped since the last flush because the buffer
+  // was full, in RECORD_UNTIL_FULL mode.
+  bool buffer_full_;
+  // The filled chunks, oldest first.
+  std::deque<TraceChunk*> chunks_;
+  // The buffers of all the threads that have added events, which are only
+  // deleted along with the TraceLog.
+  std::vector<ThreadBuffer*> thread_buffers_;
+  ThreadLocalPointer<ThreadBuffer> thread_buffer_;
+  std::vector<TraceEvent> metadata_events_;
   std::vector<std::string> included_categories_;
   std::vector<std::string> excluded_categories_;
 
@@ -4,6 +4,8 @@
 
 #include "base/debug/trace_event.h"
 
+#include <set>
+
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/json/json_reader.h"
@@ -488,6 +490,32 @@ void ValidateInstantEventPresentOnEveryThread(const ListValue& trace_parsed,
   }
 }
 
+// Returns the number of "multi thread event" events of |thread_id|, and adds
+// their indices to |events|.
+size_t FindInstantEventsOfThread(const ListValue& trace_parsed,
+                                 int thread_id,
+                                 std::set<int>* events) {
+  size_t count = 0;
+  for (size_t i = 0; i < trace_parsed.GetSize(); i++) {
+    DictionaryValue* dict = NULL;
+    std::string name;
+    int thread = 0;
+    int event = 0;
+    if (!trace_parsed.GetDictionary(i, &dict) ||
+        !dict->GetString("name", &name) || name != "multi thread event" ||
+        !dict->GetInteger("args.thread", &thread) || thread != thread_id ||
+        !dict->GetInteger("args.event", &event))
+      continue;
+    events->insert(event);
+    count++;
+  }
+  return count;
+}
+
+void SetTrue(bool* value) {
+  *value = true;
+}
+
 void TraceCallsWithCachedCategoryPointersPointers(const char* name_str) {
   TRACE_EVENT0("category name1", name_str);
   TRACE_EVENT_INSTANT0("category name2", name_str);
@@ -890,6 +918,82 @@ TEST_F(TraceEventTestFixture, DataCapturedManyThreads) {
                                            num_threads, num_events);
 }
 
+// Test that events are dropped, and the buffer full callback run, once the
+// buffer is full.
+TEST_F(TraceEventTestFixture, RecordUntilFull) {
+  ManualTestSetUp();
+  bool buffer_full = false;
+  TraceLog* tracer = TraceLog::GetInstance();
+  tracer->SetBufferFullCallback(base::Bind(&SetTrue, &buffer_full));
+  tracer->SetBufferMode(TraceLog::RECORD_UNTIL_FULL, 64 * 1024);
+  tracer->SetEnabled(true);
+
+  const int num_events = 10000;
+  TraceManyInstantEvents(0, num_events, NULL);
+  EXPECT_TRUE(buffer_full);
+  EXPECT_FLOAT_EQ(1.0f, tracer->GetBufferPercentFull());
+  tracer->SetEnabled(false);
+
+  // The first events are kept.
+  std::set<int> events;
+  EXPECT_EQ(events.size(),
+            FindInstantEventsOfThread(trace_parsed_, 0, &events));
+  ASSERT_FALSE(events.empty());
+  EXPECT_LT(static_cast<int>(events.size()), num_events);
+  EXPECT_EQ(0, *events.begin());
+  EXPECT_EQ(static_cast<int>(events.size()) - 1, *events.rbegin());
+}
+
+// Test that the oldest events are dropped once the buffer is full in
+// RECORD_CONTINUOUSLY mode.
+TEST_F(TraceEventTestFixture, RecordContinuously) {
+  ManualTestSetUp();
+  bool buffer_full = false;
+  TraceLog* tracer = TraceLog::GetInstance();
+  tracer->SetBufferFullCallback(base::Bind(&SetTrue, &buffer_full));
+  tracer->SetBufferMode(TraceLog::RECORD_CONTINUOUSLY, 64 * 1024);
+  tracer->SetEnabled(true);
+
+  const int num_events = 10000;
+  TraceManyInstantEvents(0, num_events, NULL);
+  EXPECT_FALSE(buffer_full);
+  tracer->SetEnabled(false);
+
+  // The last events are kept.
+  std::set<int> events;
+  EXPECT_EQ(events.size(),
+            FindInstantEventsOfThread(trace_parsed_, 0, &events));
+  ASSERT_FALSE(events.empty());
+  EXPECT_LT(static_cast<int>(events.size()), num_events);
+  EXPECT_EQ(num_events - static_cast<int>(events.size()), *events.begin());
+  EXPECT_EQ(num_events - 1, *events.rbegin());
+}
+
+// Test that flushing while another thread adds events flushes each event
+// once.
+TEST_F(TraceEventTestFixture, FlushWhileTracing) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetEnabled(true);
+
+  const int num_events = 20000;
+  Thread thread("1");
+  WaitableEvent task_complete_event(false, false);
+  thread.Start();
+  thread.message_loop()->PostTask(
+      FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                            0, num_events, &task_complete_event));
+  while (!task_complete_event.IsSignaled())
+    TraceLog::GetInstance()->Flush();
+  thread.Stop();
+
+  TraceLog::GetInstance()->SetEnabled(false);
+
+  std::set<int> events;
+  EXPECT_EQ(static_cast<size_t>(num_events),
+            FindInstantEventsOfThread(trace_parsed_, 0, &events));
+  EXPECT_EQ(static_cast<size_t>(num_events), events.size());
+}
+
 // Test that thread and process names show up in the trace
 TEST_F(TraceEventTestFixture, ThreadNames) {
   ManualTestSetUp();
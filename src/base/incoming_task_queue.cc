@@ -0,0 +1,171 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/incoming_task_queue.h"
+
+#include "base/logging.h"
+
+namespace {
+
+// The maximum number of nodes kept for reuse.
+const int kMaxFreeNodes = 64;
+
+}  // namespace
+
+namespace base {
+
+struct IncomingTaskQueue::Node {
+  explicit Node(const PendingTask& pending_task)
+      : task(pending_task), next(NULL) {}
+
+  PendingTask task;
+  Node* next;
+};
+
+IncomingTaskQueue::IncomingTaskQueue()
+    : head_(0), free_nodes_busy_(0), free_nodes_(NULL), num_free_nodes_(0) {
+}
+
+IncomingTaskQueue::~IncomingTaskQueue() {
+  Node* node = reinterpret_cast<Node*>(subtle::NoBarrier_AtomicExchange(&head_,
+                                                                        0));
+  subtle::MemoryBarrier();
+  while (node) {
+    Node* next = node->next;
+    delete node;
+    node = next;
+  }
+
+  while (free_nodes_) {
+    Node* next = free_nodes_->next;
+    delete free_nodes_;
+    free_nodes_ = next;
+  }
+}
+
+bool IncomingTaskQueue::Push(PendingTask* pending_task) {
+  bool was_empty;
+  PushNode(NewNode(pending_task), false, &was_empty);
+  return was_empty;
+}
+
+bool IncomingTaskQueue::PushIfNotEmpty(PendingTask* pending_task) {
+  if (!subtle::NoBarrier_Load(&head_))
+    return false;
+
+  Node* node = NewNode(pending_task);
+  bool was_empty;
+  if (PushNode(node, true, &was_empty))
+    return true;
+
+  // The consumer emptied the queue in the meantime.
+  pending_task->task.Swap(&node->task.task);
+  node->next = NULL;
+  ReleaseNodes(node);
+  return false;
+}
+
+bool IncomingTaskQueue::PopAll(TaskQueue* work_queue) {
+  if (!subtle::NoBarrier_Load(&head_))
+    return false;
+
+  Node* node = reinterpret_cast<Node*>(subtle::NoBarrier_AtomicExchange(&head_,
+                                                                        0));
+  subtle::MemoryBarrier();  // Pairs with the release in PushNode().
+  DCHECK(node);
+
+  // Reverse the list to get the tasks in the order they were pushed.
+  Node* first = NULL;
+  while (node) {
+    Node* next = node->next;
+    node->next = first;
+    first = node;
+    node = next;
+  }
+
+  Closure task;
+  for (node = first; node; node = node->next) {
+    task.Swap(&node->task.task);
+    work_queue->push(node->task);
+    work_queue->back().task.Swap(&task);
+  }
+  ReleaseNodes(first);
+  return true;
+}
+
+bool IncomingTaskQueue::empty() const {
+  return !subtle::Acquire_Load(&head_);
+}
+
+IncomingTaskQueue::Node* IncomingTaskQueue::NewNode(
+    PendingTask* pending_task) {
+  // Take the closure out first, so that only the plain fields get copied.
+  Closure task;
+  task.Swap(&pending_task->task);
+
+  Node* node = NULL;
+  if (TryAcquireFreeNodes()) {
+    node = free_nodes_;
+    if (node) {
+      free_nodes_ = node->next;
+      num_free_nodes_--;
+    }
+    ReleaseFreeNodes();
+  }
+
+  if (node)
+    node->task = *pending_task;
+  else
+    node = new Node(*pending_task);
+  node->task.task.Swap(&task);
+  return node;
+}
+
+bool IncomingTaskQueue::PushNode(Node* node, bool only_if_not_empty,
+                                 bool* was_empty) {
+  // The release semantics of the compare-and-swap publish the contents of
+  // |node| to the consumer.
+  subtle::AtomicWord head = subtle::NoBarrier_Load(&head_);
+  for (;;) {
+    if (!head && only_if_not_empty)
+      return false;
+    node->next = reinterpret_cast<Node*>(head);
+    subtle::AtomicWord previous = subtle::Release_CompareAndSwap(
+        &head_, head, reinterpret_cast<subtle::AtomicWord>(node));
+    if (previous == head)
+      break;
+    head = previous;
+  }
+  *was_empty = !head;
+  return true;
+}
+
+void IncomingTaskQueue::ReleaseNodes(Node* first) {
+  if (TryAcquireFreeNodes()) {
+    while (first && num_free_nodes_ < kMaxFreeNodes) {
+      Node* next = first->next;
+      first->next = free_nodes_;
+      free_nodes_ = first;
+      num_free_nodes_++;
+      first = next;
+    }
+    ReleaseFreeNodes();
+  }
+
+  while (first) {
+    Node* next = first->next;
+    delete first;
+    first = next;
+  }
+}
+
+bool IncomingTaskQueue::TryAcquireFreeNodes() {
+  return !subtle::Acquire_CompareAndSwap(&free_nodes_busy_, 0, 1);
+}
+
+void IncomingTaskQueue::ReleaseFreeNodes() {
+  subtle::Release_Store(&free_nodes_busy_, 0);
+}
+
+}  // namespace base
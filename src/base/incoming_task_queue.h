@@ -0,0 +1,91 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_INCOMING_TASK_QUEUE_H_
+#define BASE_INCOMING_TASK_QUEUE_H_
+#pragma once
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/pending_task.h"
+
+namespace base {
+
+// A queue of PendingTasks that can be filled from any number of threads
+// without taking a lock, and emptied by a single thread (the consumer). It is
+// used by MessageLoop to receive tasks posted from other threads.
+//
+// The tasks are kept on a singly linked list of nodes, newest first. A producer
+// adds a node with a single compare-and-swap on the head of the list, and the
+// consumer detaches the whole list with an atomic exchange (and reverses it to
+// recover the posting order). Nodes are never removed one at a time from the
+// shared list, so there is no ABA problem.
+//
+// The closure of a task is swapped into and out of its node, so its bound
+// state is not copied. Nodes released by the consumer are kept in a small
+// cache for the next tasks. Only one thread at a time uses the cache: the
+// others don't wait for it, they allocate a new node (or delete the released
+// ones) instead.
+class BASE_EXPORT IncomingTaskQueue {
+ public:
+  IncomingTaskQueue();
+
+  // Deletes all the tasks still on the queue. There must be no producers
+  // running at this point.
+  ~IncomingTaskQueue();
+
+  // Moves |pending_task| to the queue, and returns true if the queue was
+  // empty. |pending_task->task| is reset before the task becomes visible to the
+  // consumer, so the caller never holds the last reference to whatever is
+  // bound to the task. This method can be called from any thread.
+  bool Push(PendingTask* pending_task);
+
+  // Like Push(), but leaves |pending_task| alone and returns false if the queue
+  // is empty. Returns true if the task was added.
+  bool PushIfNotEmpty(PendingTask* pending_task);
+
+  // Moves all the tasks from this queue to the end of |work_queue|, in the
+  // order they were pushed. Returns false if there was nothing to move. Must
+  // only be called by the consumer.
+  bool PopAll(TaskQueue* work_queue);
+
+  // Returns true if there are no tasks on the queue. Unless all producers are
+  // done, the answer may be stale by the time it is used.
+  bool empty() const;
+
+ private:
+  struct Node;
+
+  // Returns a node that holds |pending_task|, and resets the task.
+  Node* NewNode(PendingTask* pending_task);
+
+  // Adds |node| to the queue and returns true, unless |only_if_not_empty| is
+  // true and the queue is empty. Sets |was_empty| if the node was added.
+  bool PushNode(Node* node, bool only_if_not_empty, bool* was_empty);
+
+  // Keeps the nodes of the list that starts at |first| for reuse, or deletes
+  // them if the cache is full or in use.
+  void ReleaseNodes(Node* first);
+
+  // Returns true if the calling thread can use the cache of nodes, in which
+  // case it must call ReleaseFreeNodes() when done.
+  bool TryAcquireFreeNodes();
+  void ReleaseFreeNodes();
+
+  // The last Node pushed, or NULL when the queue is empty.
+  subtle::AtomicWord head_;
+
+  // Nodes kept for reuse, only used by the thread that sets
+  // |free_nodes_busy_|.
+  subtle::Atomic32 free_nodes_busy_;
+  Node* free_nodes_;
+  int num_free_nodes_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_INCOMING_TASK_QUEUE_H_
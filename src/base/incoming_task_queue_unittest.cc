@@ -0,0 +1,186 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/incoming_task_queue.h"
+#include "base/location.h"
+#include "base/memory/scoped_vector.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void DoNothing() {
+}
+
+// Sets |*deleted| to true when destroyed.
+class DeletionTracker {
+ public:
+  explicit DeletionTracker(bool* deleted) : deleted_(deleted) {}
+  ~DeletionTracker() { *deleted_ = true; }
+  void Run() {}
+
+ private:
+  bool* deleted_;
+};
+
+// Pushes |num_tasks| tasks, numbered from |first| on their |sequence_num|.
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(IncomingTaskQueue* queue, int first, int num_tasks)
+      : queue_(queue), first_(first), num_tasks_(num_tasks) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_tasks_; i++) {
+      PendingTask task(FROM_HERE, Bind(&DoNothing));
+      task.sequence_num = first_ + i;
+      queue_->Push(&task);
+    }
+  }
+
+ private:
+  IncomingTaskQueue* queue_;
+  int first_;
+  int num_tasks_;
+};
+
+}  // namespace
+
+TEST(IncomingTaskQueueTest, Basics) {
+  IncomingTaskQueue queue;
+  TaskQueue work_queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.PopAll(&work_queue));
+
+  for (int i = 0; i < 10; i++) {
+    PendingTask task(FROM_HERE, Bind(&DoNothing));
+    task.sequence_num = i;
+    EXPECT_EQ(i == 0, queue.Push(&task));
+    EXPECT_TRUE(task.task.is_null());
+    EXPECT_FALSE(queue.empty());
+  }
+
+  EXPECT_TRUE(queue.PopAll(&work_queue));
+  EXPECT_TRUE(queue.empty());
+  ASSERT_EQ(10u, work_queue.size());
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(i, work_queue.front().sequence_num);
+    EXPECT_FALSE(work_queue.front().task.is_null());
+    work_queue.pop();
+  }
+
+  // Reused nodes should behave as new ones.
+  for (int i = 0; i < 3; i++) {
+    PendingTask task(FROM_HERE, Bind(&DoNothing));
+    task.sequence_num = 100 + i;
+    EXPECT_EQ(i == 0, queue.Push(&task));
+  }
+  EXPECT_TRUE(queue.PopAll(&work_queue));
+  ASSERT_EQ(3u, work_queue.size());
+  EXPECT_EQ(100, work_queue.front().sequence_num);
+  EXPECT_EQ(102, work_queue.back().sequence_num);
+}
+
+TEST(IncomingTaskQueueTest, PushIfNotEmpty) {
+  IncomingTaskQueue queue;
+  TaskQueue work_queue;
+
+  PendingTask task(FROM_HERE, Bind(&DoNothing));
+  task.sequence_num = 1;
+  EXPECT_FALSE(queue.PushIfNotEmpty(&task));
+  EXPECT_FALSE(task.task.is_null());
+  EXPECT_TRUE(queue.empty());
+
+  EXPECT_TRUE(queue.Push(&task));
+  PendingTask task2(FROM_HERE, Bind(&DoNothing));
+  task2.sequence_num = 2;
+  EXPECT_TRUE(queue.PushIfNotEmpty(&task2));
+  EXPECT_TRUE(task2.task.is_null());
+
+  EXPECT_TRUE(queue.PopAll(&work_queue));
+  ASSERT_EQ(2u, work_queue.size());
+  EXPECT_EQ(1, work_queue.front().sequence_num);
+  EXPECT_FALSE(work_queue.front().task.is_null());
+  EXPECT_EQ(2, work_queue.back().sequence_num);
+  EXPECT_FALSE(work_queue.back().task.is_null());
+}
+
+// Tests that the tasks held by the queue (or by the cache of nodes) are
+// released as expected.
+TEST(IncomingTaskQueueTest, ReleaseTasks) {
+  bool deleted = false;
+  {
+    IncomingTaskQueue queue;
+    PendingTask task(FROM_HERE, Bind(&DeletionTracker::Run,
+                                     Owned(new DeletionTracker(&deleted))));
+    queue.Push(&task);
+    EXPECT_FALSE(deleted);
+  }
+  EXPECT_TRUE(deleted);
+
+  deleted = false;
+  IncomingTaskQueue queue;
+  {
+    TaskQueue work_queue;
+    PendingTask task(FROM_HERE, Bind(&DeletionTracker::Run,
+                                     Owned(new DeletionTracker(&deleted))));
+    queue.Push(&task);
+    queue.PopAll(&work_queue);
+    EXPECT_FALSE(deleted);
+  }
+  EXPECT_TRUE(deleted);
+}
+
+// Tests that tasks from multiple threads are all received, and that the tasks
+// of each thread keep their order.
+TEST(IncomingTaskQueueTest, MultipleProducers) {
+  const int kNumThreads = 4;
+  const int kNumTasks = 10000;
+
+  IncomingTaskQueue queue;
+  ScopedVector<Producer> producers;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    producers.push_back(new Producer(&queue, i * kNumTasks, kNumTasks));
+    threads.push_back(new DelegateSimpleThread(producers[i], "producer"));
+    threads[i]->Start();
+  }
+
+  std::vector<int> next(kNumThreads);
+  for (int i = 0; i < kNumThreads; i++)
+    next[i] = i * kNumTasks;
+
+  int received = 0;
+  bool done = false;
+  while (!done) {
+    done = true;
+    for (int i = 0; i < kNumThreads; i++) {
+      if (next[i] != (i + 1) * kNumTasks)
+        done = false;
+    }
+
+    TaskQueue work_queue;
+    queue.PopAll(&work_queue);
+    while (!work_queue.empty()) {
+      int sequence_num = work_queue.front().sequence_num;
+      int producer = sequence_num / kNumTasks;
+      ASSERT_EQ(next[producer], sequence_num);
+      next[producer]++;
+      received++;
+      work_queue.pop();
+    }
+  }
+
+  for (int i = 0; i < kNumThreads; i++)
+    threads[i]->Join();
+  EXPECT_EQ(kNumThreads * kNumTasks, received);
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace base
@@ -0,0 +1,684 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_parser.h"
+
+#include <string.h>
+
+#include "base/float_util.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+#include "base/third_party/icu/icu_utf.h"
+#include "base/utf_string_conversion_utils.h"
+
+namespace {
+
+const char kNullString[] = "null";
+const char kTrueString[] = "true";
+const char kFalseString[] = "false";
+
+const int kStackLimit = 100;
+
+// Returns true if [|begin|, |end|) is valid UTF-8 that holds only valid
+// characters, like IsStringUTF8().
+bool IsValidUTF8(const char* begin, const char* end) {
+  int32 length = static_cast<int32>(end - begin);
+  int32 index = 0;
+  while (index < length) {
+    if (static_cast<unsigned char>(begin[index]) < 0x80) {
+      // Fast path for ASCII.
+      ++index;
+      continue;
+    }
+    int32 code_point;
+    CBU8_NEXT(begin, index, length, code_point);
+    if (!base::IsValidCharacter(code_point))
+      return false;
+  }
+  return true;
+}
+
+// Returns the value of the |digits| hex digits at |pos|, which have been
+// validated by the tokenizer.
+uint32 DecodeHexDigits(const char* pos, int digits) {
+  uint32 value = 0;
+  for (int i = 0; i < digits; ++i)
+    value = (value << 4) + HexDigitToInt(pos[i]);
+  return value;
+}
+
+}  // namespace
+
+namespace base {
+
+// A JSON token, as a range of the input.
+class JSONParser::Token {
+ public:
+  enum Type {
+   OBJECT_BEGIN,           // {
+   OBJECT_END,             // }
+   ARRAY_BEGIN,            // [
+   ARRAY_END,              // ]
+   STRING,
+   NUMBER,
+   BOOL_TRUE,              // true
+   BOOL_FALSE,             // false
+   NULL_TOKEN,             // null
+   LIST_SEPARATOR,         // ,
+   OBJECT_PAIR_SEPARATOR,  // :
+   END_OF_INPUT,
+   INVALID_TOKEN,
+  };
+
+  Token(Type t, const char* b, int len)
+      : type(t), begin(b), length(len), has_escapes(false) {}
+
+  static Token CreateInvalidToken() {
+    return Token(INVALID_TOKEN, 0, 0);
+  }
+
+  // Get the character that's one past the end of this token, or '\0' if that
+  // is past |end|.
+  char NextChar(const char* end) const {
+    return begin + length < end ? begin[length] : '\0';
+  }
+
+  // Reads an int from the end of the token.  Returns false if there is no
+  // valid integer at the end of the token.
+  bool ReadInt(const char* end, bool can_have_leading_zeros) {
+    char first = NextChar(end);
+    int len = 0;
+
+    // Read in more digits.
+    char c = first;
+    while ('\0' != c && IsAsciiDigit(c)) {
+      ++length;
+      ++len;
+      c = NextChar(end);
+    }
+    // We need at least 1 digit.
+    if (len == 0)
+      return false;
+
+    if (!can_have_leading_zeros && len > 1 && '0' == first)
+      return false;
+
+    return true;
+  }
+
+  // Reads |digits| hex digits from the token. If the sequence of digits is
+  // not valid (contains other characters), returns false.
+  bool ReadHexDigits(const char* end, int digits) {
+    for (int i = 1; i <= digits; ++i) {
+      if (begin + length + i >= end || !IsHexDigit(begin[length + i]))
+        return false;
+    }
+
+    length += digits;
+    return true;
+  }
+
+  Type type;
+
+  // A pointer into the input that's the beginning of this token.
+  const char* begin;
+
+  // One past the end of the token.
+  int length;
+
+  // For strings, whether the token holds escape sequences.
+  bool has_escapes;
+};
+
+JSONParser::JSONParser(Delegate* delegate)
+    : delegate_(delegate),
+      start_pos_(NULL),
+      end_pos_(NULL),
+      json_pos_(NULL),
+      stack_depth_(0),
+      allow_trailing_comma_(false),
+      delegate_stopped_(false),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_column_(0) {
+}
+
+JSONParser::~JSONParser() {
+}
+
+bool JSONParser::Parse(const StringPiece& json, bool check_root,
+                       bool allow_trailing_comma) {
+  error_code_ = JSONReader::JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+  delegate_stopped_ = false;
+
+  // A null byte ends the input, as it always did for JSONReader.
+  start_pos_ = json.data();
+  end_pos_ = start_pos_ + json.size();
+  if (!json.empty()) {
+    const void* null_byte = memchr(start_pos_, '\0', json.size());
+    if (null_byte)
+      end_pos_ = static_cast<const char*>(null_byte);
+  }
+
+  // The input must be in UTF-8.
+  if (!IsValidUTF8(start_pos_, end_pos_)) {
+    error_code_ = JSONReader::JSON_UNSUPPORTED_ENCODING;
+    return false;
+  }
+
+  // Skip the UTF-8 Byte-Order-Mark (0xEF, 0xBB, 0xBF) the input may start
+  // with, rather than mis-treating it as an invalid character.
+  json_pos_ = start_pos_;
+  if (NextStringMatch("\xEF\xBB\xBF", 3)) {
+    start_pos_ += 3;
+    json_pos_ = start_pos_;
+  }
+  allow_trailing_comma_ = allow_trailing_comma;
+  stack_depth_ = 0;
+
+  if (ParseValue(check_root)) {
+    if (ParseToken().type == Token::END_OF_INPUT)
+      return true;
+    SetErrorCode(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, json_pos_);
+    return false;
+  }
+
+  // Default to calling errors "syntax errors", unless the delegate stopped
+  // the parsing.
+  if (error_code_ == JSONReader::JSON_NO_ERROR && !delegate_stopped_)
+    SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, json_pos_);
+
+  return false;
+}
+
+std::string JSONParser::GetErrorMessage() const {
+  return JSONReader::FormatErrorMessage(
+      error_line_, error_column_, JSONReader::ErrorCodeToString(error_code_));
+}
+
+bool JSONParser::ParseValue(bool is_root) {
+  ++stack_depth_;
+  if (stack_depth_ > kStackLimit) {
+    SetErrorCode(JSONReader::JSON_TOO_MUCH_NESTING, json_pos_);
+    return false;
+  }
+
+  Token token = ParseToken();
+  // The root token must be an array or an object.
+  if (is_root && token.type != Token::OBJECT_BEGIN &&
+      token.type != Token::ARRAY_BEGIN) {
+    SetErrorCode(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, json_pos_);
+    return false;
+  }
+
+  bool result;
+  switch (token.type) {
+    case Token::NULL_TOKEN:
+      result = delegate_->OnNull();
+      break;
+
+    case Token::BOOL_TRUE:
+      result = delegate_->OnBoolean(true);
+      break;
+
+    case Token::BOOL_FALSE:
+      result = delegate_->OnBoolean(false);
+      break;
+
+    case Token::NUMBER:
+      if (!DecodeNumber(token))
+        return false;
+      result = true;
+      break;
+
+    case Token::STRING:
+      result = delegate_->OnString(DecodeString(token));
+      break;
+
+    case Token::ARRAY_BEGIN:
+      json_pos_ += token.length;
+      if (!delegate_->OnListBegin())
+        return Stop();
+      if (!ParseList())
+        return false;
+      // ParseList() consumed the closing bracket.
+      token.length = 0;
+      result = delegate_->OnListEnd();
+      break;
+
+    case Token::OBJECT_BEGIN:
+      json_pos_ += token.length;
+      if (!delegate_->OnDictionaryBegin())
+        return Stop();
+      if (!ParseDictionary())
+        return false;
+      token.length = 0;
+      result = delegate_->OnDictionaryEnd();
+      break;
+
+    default:
+      // We got a token that's not a value, or the end of the input.
+      return false;
+  }
+  if (!result)
+    return Stop();
+  json_pos_ += token.length;
+
+  --stack_depth_;
+  return true;
+}
+
+bool JSONParser::ParseList() {
+  Token token = ParseToken();
+  while (token.type != Token::ARRAY_END) {
+    if (!ParseValue(false))
+      return false;
+
+    // After a list value, we expect a comma or the end of the list.
+    token = ParseToken();
+    if (token.type == Token::LIST_SEPARATOR) {
+      json_pos_ += token.length;
+      token = ParseToken();
+      // Trailing commas are invalid according to the JSON RFC, but some
+      // consumers need the parsing leniency, so handle accordingly.
+      if (token.type == Token::ARRAY_END) {
+        if (!allow_trailing_comma_) {
+          SetErrorCode(JSONReader::JSON_TRAILING_COMMA, json_pos_);
+          return false;
+        }
+        // Trailing comma OK, stop parsing the Array.
+        break;
+      }
+    } else if (token.type != Token::ARRAY_END) {
+      // Unexpected value after list value.  Bail out.
+      return false;
+    }
+  }
+  json_pos_ += token.length;
+  return true;
+}
+
+bool JSONParser::ParseDictionary() {
+  Token token = ParseToken();
+  while (token.type != Token::OBJECT_END) {
+    if (token.type != Token::STRING) {
+      SetErrorCode(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, json_pos_);
+      return false;
+    }
+    if (!delegate_->OnDictionaryKey(DecodeString(token)))
+      return Stop();
+
+    json_pos_ += token.length;
+    token = ParseToken();
+    if (token.type != Token::OBJECT_PAIR_SEPARATOR)
+      return false;
+
+    json_pos_ += token.length;
+    if (!ParseValue(false))
+      return false;
+
+    // After a key/value pair, we expect a comma or the end of the
+    // object.
+    token = ParseToken();
+    if (token.type == Token::LIST_SEPARATOR) {
+      json_pos_ += token.length;
+      token = ParseToken();
+      // Trailing commas are invalid according to the JSON RFC, but some
+      // consumers need the parsing leniency, so handle accordingly.
+      if (token.type == Token::OBJECT_END) {
+        if (!allow_trailing_comma_) {
+          SetErrorCode(JSONReader::JSON_TRAILING_COMMA, json_pos_);
+          return false;
+        }
+        // Trailing comma OK, stop parsing the Object.
+        break;
+      }
+    } else if (token.type != Token::OBJECT_END) {
+      // Unexpected value after last object value.  Bail out.
+      return false;
+    }
+  }
+  json_pos_ += token.length;
+  return true;
+}
+
+JSONParser::Token JSONParser::ParseNumberToken() {
+  // We just grab the number here.  We validate the size in DecodeNumber.
+  // According   to RFC4627, a valid number is: [minus] int [frac] [exp]
+  Token token(Token::NUMBER, json_pos_, 0);
+  char c = CharAt(json_pos_);
+  if ('-' == c)
+    ++token.length;
+
+  if (!token.ReadInt(end_pos_, false))
+    return Token::CreateInvalidToken();
+
+  // Optional fraction part
+  c = token.NextChar(end_pos_);
+  if ('.' == c) {
+    ++token.length;
+    if (!token.ReadInt(end_pos_, true))
+      return Token::CreateInvalidToken();
+    c = token.NextChar(end_pos_);
+  }
+
+  // Optional exponent part
+  if ('e' == c || 'E' == c) {
+    ++token.length;
+    c = token.NextChar(end_pos_);
+    if ('-' == c || '+' == c)
+      ++token.length;
+    if (!token.ReadInt(end_pos_, true))
+      return Token::CreateInvalidToken();
+  }
+
+  return token;
+}
+
+bool JSONParser::DecodeNumber(const Token& token) {
+  StringPiece num_string(token.begin, token.length);
+
+  int num_int;
+  if (StringToInt(num_string, &num_int))
+    return delegate_->OnInteger(num_int) || Stop();
+
+  double num_double;
+  if (StringToDouble(num_string.as_string(), &num_double) &&
+      IsFinite(num_double))
+    return delegate_->OnDouble(num_double) || Stop();
+
+  return false;
+}
+
+JSONParser::Token JSONParser::ParseStringToken() {
+  Token token(Token::STRING, json_pos_, 1);
+  char c = token.NextChar(end_pos_);
+  while ('\0' != c) {
+    if ('\\' == c) {
+      token.has_escapes = true;
+      ++token.length;
+      c = token.NextChar(end_pos_);
+      // Make sure the escaped char is valid.
+      switch (c) {
+        case 'x':
+          if (!token.ReadHexDigits(end_pos_, 2)) {
+            SetErrorCode(JSONReader::JSON_INVALID_ESCAPE,
+                         json_pos_ + token.length);
+            return Token::CreateInvalidToken();
+          }
+          break;
+        case 'u':
+          if (!token.ReadHexDigits(end_pos_, 4)) {
+            SetErrorCode(JSONReader::JSON_INVALID_ESCAPE,
+                         json_pos_ + token.length);
+            return Token::CreateInvalidToken();
+          }
+          break;
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+        case 'v':
+        case '"':
+          break;
+        default:
+          SetErrorCode(JSONReader::JSON_INVALID_ESCAPE,
+                       json_pos_ + token.length);
+          return Token::CreateInvalidToken();
+      }
+    } else if ('"' == c) {
+      ++token.length;
+      return token;
+    }
+    ++token.length;
+    c = token.NextChar(end_pos_);
+  }
+  return Token::CreateInvalidToken();
+}
+
+StringPiece JSONParser::DecodeString(const Token& token) {
+  // Most strings have no escape sequences, and can be passed on as they are
+  // in the input.
+  if (!token.has_escapes)
+    return StringPiece(token.begin + 1, token.length - 2);
+
+  string_buffer_.clear();
+  string_buffer_.reserve(token.length - 2);
+
+  const char* end = token.begin + token.length - 1;
+  for (const char* pos = token.begin + 1; pos < end; ++pos) {
+    char c = *pos;
+    if ('\\' != c) {
+      // Not escaped. The input is valid UTF-8, so multi-byte characters can
+      // be copied byte by byte.
+      string_buffer_.push_back(c);
+      continue;
+    }
+
+    ++pos;
+    switch (*pos) {
+      case '"':
+      case '/':
+      case '\\':
+        string_buffer_.push_back(*pos);
+        break;
+      case 'b':
+        string_buffer_.push_back('\b');
+        break;
+      case 'f':
+        string_buffer_.push_back('\f');
+        break;
+      case 'n':
+        string_buffer_.push_back('\n');
+        break;
+      case 'r':
+        string_buffer_.push_back('\r');
+        break;
+      case 't':
+        string_buffer_.push_back('\t');
+        break;
+      case 'v':
+        string_buffer_.push_back('\v');
+        break;
+
+      case 'x':
+        // \xNN is the code point U+00NN, not a byte.
+        WriteUnicodeCharacter(DecodeHexDigits(pos + 1, 2), &string_buffer_);
+        pos += 2;
+        break;
+      case 'u': {
+        uint32 code_point = DecodeHexDigits(pos + 1, 4);
+        pos += 4;
+        if (CBU16_IS_LEAD(code_point) && end - pos > 6 && pos[1] == '\\' &&
+            pos[2] == 'u' && IsHexDigit(pos[3]) && IsHexDigit(pos[4]) &&
+            IsHexDigit(pos[5]) && IsHexDigit(pos[6])) {
+          uint32 trail = DecodeHexDigits(pos + 3, 4);
+          if (CBU16_IS_TRAIL(trail)) {
+            code_point = CBU16_GET_SUPPLEMENTARY(code_point, trail);
+            pos += 6;
+          }
+        }
+        // Unpaired surrogates can't be represented in UTF-8.
+        if (!IsValidCodepoint(code_point))
+          code_point = 0xFFFD;
+        WriteUnicodeCharacter(code_point, &string_buffer_);
+        break;
+      }
+
+      default:
+        // We should only have valid strings at this point.  If not,
+        // ParseStringToken didn't do it's job.
+        NOTREACHED();
+    }
+  }
+  return string_buffer_;
+}
+
+JSONParser::Token JSONParser::ParseToken() {
+  EatWhitespaceAndComments();
+
+  Token token(Token::INVALID_TOKEN, 0, 0);
+  switch (CharAt(json_pos_)) {
+    case '\0':
+      token.type = Token::END_OF_INPUT;
+      break;
+
+    case 'n':
+      if (NextStringMatch(kNullString, arraysize(kNullString) - 1))
+        token = Token(Token::NULL_TOKEN, json_pos_, 4);
+      break;
+
+    case 't':
+      if (NextStringMatch(kTrueString, arraysize(kTrueString) - 1))
+        token = Token(Token::BOOL_TRUE, json_pos_, 4);
+      break;
+
+    case 'f':
+      if (NextStringMatch(kFalseString, arraysize(kFalseString) - 1))
+        token = Token(Token::BOOL_FALSE, json_pos_, 5);
+      break;
+
+    case '[':
+      token = Token(Token::ARRAY_BEGIN, json_pos_, 1);
+      break;
+
+    case ']':
+      token = Token(Token::ARRAY_END, json_pos_, 1);
+      break;
+
+    case ',':
+      token = Token(Token::LIST_SEPARATOR, json_pos_, 1);
+      break;
+
+    case '{':
+      token = Token(Token::OBJECT_BEGIN, json_pos_, 1);
+      break;
+
+    case '}':
+      token = Token(Token::OBJECT_END, json_pos_, 1);
+      break;
+
+    case ':':
+      token = Token(Token::OBJECT_PAIR_SEPARATOR, json_pos_, 1);
+      break;
+
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-':
+      token = ParseNumberToken();
+      break;
+
+    case '"':
+      token = ParseStringToken();
+      break;
+  }
+  return token;
+}
+
+void JSONParser::EatWhitespaceAndComments() {
+  while (json_pos_ < end_pos_) {
+    switch (*json_pos_) {
+      case ' ':
+      case '\n':
+      case '\r':
+      case '\t':
+        ++json_pos_;
+        break;
+      case '/':
+        // TODO(tc): This isn't in the RFC so it should be a parser flag.
+        if (!EatComment())
+          return;
+        break;
+      default:
+        // Not a whitespace char, just exit.
+        return;
+    }
+  }
+}
+
+bool JSONParser::EatComment() {
+  if ('/' != CharAt(json_pos_))
+    return false;
+
+  char next_char = CharAt(json_pos_ + 1);
+  if ('/' == next_char) {
+    // Line comment, read until \n or \r
+    json_pos_ += 2;
+    while (json_pos_ < end_pos_) {
+      switch (*json_pos_) {
+        case '\n':
+        case '\r':
+          ++json_pos_;
+          return true;
+        default:
+          ++json_pos_;
+      }
+    }
+  } else if ('*' == next_char) {
+    // Block comment, read until */
+    json_pos_ += 2;
+    while (json_pos_ < end_pos_) {
+      if ('*' == *json_pos_ && '/' == CharAt(json_pos_ + 1)) {
+        json_pos_ += 2;
+        return true;
+      }
+      ++json_pos_;
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool JSONParser::Stop() {
+  delegate_stopped_ = true;
+  return false;
+}
+
+bool JSONParser::NextStringMatch(const char* str, size_t length) const {
+  return static_cast<size_t>(end_pos_ - json_pos_) >= length &&
+         memcmp(json_pos_, str, length) == 0;
+}
+
+void JSONParser::SetErrorCode(JSONReader::JsonParseError error,
+                              const char* error_pos) {
+  int line_number = 1;
+  int column_number = 1;
+
+  // Figure out the line and column the error occured at. Continuation bytes
+  // of multi-byte characters don't count as columns.
+  for (const char* pos = start_pos_; pos != error_pos; ++pos) {
+    if (pos >= end_pos_) {
+      NOTREACHED();
+      return;
+    }
+
+    if (*pos == '\n') {
+      ++line_number;
+      column_number = 1;
+    } else if ((*pos & 0xC0) != 0x80) {
+      ++column_number;
+    }
+  }
+
+  error_line_ = line_number;
+  error_column_ = column_number;
+  error_code_ = error;
+}
+
+}  // namespace base
@@ -0,0 +1,190 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A streaming JSON parser. Instead of building a tree of Values, it reports
+// the values it reads to a Delegate, in document order, as it reads them.
+// This lets callers that keep only part of the data, or that convert it into
+// their own structures (see base/json/json_value_converter.h), skip building
+// a Value tree that they would throw away. JSONReader is built on top of it.
+//
+// The parser reads UTF-8 directly, accepts the same input as JSONReader
+// (comments, \x escapes, a leading UTF-8 BOM...) and reports the same errors
+// at the same positions. See json_reader.h for the deviations from the RFC.
+//
+// Usage:
+//   class Counter : public base::JSONParser::Delegate {
+//     ...
+//     virtual bool OnString(const base::StringPiece& value) OVERRIDE {
+//       ++num_strings_;
+//       return true;
+//     }
+//     ...
+//   };
+//
+//   Counter counter;
+//   base::JSONParser parser(&counter);
+//   if (!parser.Parse(json, false, false))
+//     LOG(ERROR) << parser.GetErrorMessage();
+
+#ifndef BASE_JSON_JSON_PARSER_H_
+#define BASE_JSON_JSON_PARSER_H_
+#pragma once
+
+#include <string>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+#include "base/string_piece.h"
+
+namespace base {
+
+class BASE_EXPORT JSONParser {
+ public:
+  // Receives the values read by the parser. Lists and dictionaries are
+  // reported as a Begin call, their contents, and an End call; each value of
+  // a dictionary is preceded by an OnDictionaryKey() call.
+  //
+  // Strings are only valid for the duration of the call. If a method returns
+  // false, parsing stops and Parse() returns false with no error code set.
+  class BASE_EXPORT Delegate {
+   public:
+    virtual bool OnNull() = 0;
+    virtual bool OnBoolean(bool value) = 0;
+    virtual bool OnInteger(int value) = 0;
+    virtual bool OnDouble(double value) = 0;
+    virtual bool OnString(const StringPiece& value) = 0;
+    virtual bool OnListBegin() = 0;
+    virtual bool OnListEnd() = 0;
+    virtual bool OnDictionaryBegin() = 0;
+    virtual bool OnDictionaryKey(const StringPiece& key) = 0;
+    virtual bool OnDictionaryEnd() = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  // |delegate| must outlive the parser.
+  explicit JSONParser(Delegate* delegate);
+  ~JSONParser();
+
+  // Parses |json|, which must be UTF-8, and reports its values to the
+  // delegate. Returns true if |json| holds a single valid JSON value.
+  // If |check_root| is true, we require that the root value be a dictionary
+  // or a list. If |allow_trailing_comma| is true, we ignore trailing commas
+  // in dictionaries and lists even though this goes against the RFC.
+  //
+  // When parsing fails, the delegate has already received the values that
+  // were read before the error, and no End calls are made for the lists and
+  // dictionaries that were left open.
+  bool Parse(const StringPiece& json, bool check_root,
+             bool allow_trailing_comma);
+
+  // Returns the error code if the last call to Parse() failed because of an
+  // error in its input. Returns JSON_NO_ERROR otherwise.
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Returns the position of the error, if any. Columns count characters, not
+  // bytes.
+  int error_line() const { return error_line_; }
+  int error_column() const { return error_column_; }
+
+  // Converts the error to a human-readable string, including line and column
+  // numbers if appropriate.
+  std::string GetErrorMessage() const;
+
+ private:
+  class Token;
+
+  // Recursively parses a value and reports it to the delegate. Returns false
+  // if the input is not valid JSON or if the delegate stopped the parsing.
+  // If |is_root| is true, we verify that the value is either a dictionary or
+  // a list.
+  bool ParseValue(bool is_root);
+
+  // Parses the contents of a list or a dictionary, whose opening bracket has
+  // already been consumed.
+  bool ParseList();
+  bool ParseDictionary();
+
+  // Parses a sequence of characters into a Token::NUMBER. If the sequence of
+  // characters is not a valid number, returns a Token::INVALID_TOKEN. Note
+  // that DecodeNumber is used to actually convert from a string to an
+  // int/double.
+  Token ParseNumberToken();
+
+  // Converts the number that |token| holds into an int or a double and
+  // reports it. Returns false if the number is out of range or if the
+  // delegate stopped the parsing.
+  bool DecodeNumber(const Token& token);
+
+  // Parses a sequence of characters into a Token::STRING. If the sequence of
+  // characters is not a valid string, returns a Token::INVALID_TOKEN. Note
+  // that DecodeString is used to actually decode the escaped string.
+  Token ParseStringToken();
+
+  // Returns the contents of the string that |token| holds, unescaped. The
+  // result points either into the input or into |string_buffer_|, so it is
+  // only valid until the next call.
+  StringPiece DecodeString(const Token& token);
+
+  // Grabs the next token in the JSON stream.  This does not increment the
+  // stream so it can be used to look ahead at the next token.
+  Token ParseToken();
+
+  // Increments |json_pos_| past leading whitespace and comments.
+  void EatWhitespaceAndComments();
+
+  // If |json_pos_| is at the start of a comment, eat it, otherwise, returns
+  // false.
+  bool EatComment();
+
+  // Returns the character at |pos|, or '\0' past the end of the input.
+  char CharAt(const char* pos) const {
+    return pos < end_pos_ ? *pos : '\0';
+  }
+
+  // Records that the delegate stopped the parsing, and returns false.
+  bool Stop();
+
+  // Checks if |json_pos_| matches |str|.
+  bool NextStringMatch(const char* str, size_t length) const;
+
+  // Sets the error code that will be returned to the caller. The current
+  // line and column are determined and added into the final message.
+  void SetErrorCode(JSONReader::JsonParseError error, const char* error_pos);
+
+  Delegate* delegate_;
+
+  // The input string: |start_pos_| is past the BOM, if any, and |end_pos_|
+  // is at the first null byte, if any, or at the end of the input.
+  const char* start_pos_;
+  const char* end_pos_;
+
+  // Pointer to the current position in the input string.
+  const char* json_pos_;
+
+  // Used to keep track of how many nested lists/dicts there are.
+  int stack_depth_;
+
+  // A parser flag that allows trailing commas in objects and arrays.
+  bool allow_trailing_comma_;
+
+  // Whether a delegate method returned false during the last call to Parse().
+  bool delegate_stopped_;
+
+  // Holds the last decoded string that had escape sequences.
+  std::string string_buffer_;
+
+  // Contains the error code for the last call to Parse(), if any.
+  JSONReader::JsonParseError error_code_;
+  int error_line_;
+  int error_column_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONParser);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_PARSER_H_
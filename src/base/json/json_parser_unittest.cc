@@ -0,0 +1,185 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_parser.h"
+
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the events of the parser as a string, and stops the parsing after
+// |max_events| events.
+class EventRecorder : public JSONParser::Delegate {
+ public:
+  explicit EventRecorder(int max_events)
+      : max_events_(max_events), num_events_(0) {}
+
+  const std::string& events() const { return events_; }
+
+  virtual bool OnNull() OVERRIDE {
+    return Record("null");
+  }
+
+  virtual bool OnBoolean(bool value) OVERRIDE {
+    return Record(value ? "true" : "false");
+  }
+
+  virtual bool OnInteger(int value) OVERRIDE {
+    return Record(StringPrintf("int:%d", value));
+  }
+
+  virtual bool OnDouble(double value) OVERRIDE {
+    return Record(StringPrintf("double:%g", value));
+  }
+
+  virtual bool OnString(const StringPiece& value) OVERRIDE {
+    return Record("string:" + value.as_string());
+  }
+
+  virtual bool OnListBegin() OVERRIDE {
+    return Record("[");
+  }
+
+  virtual bool OnListEnd() OVERRIDE {
+    return Record("]");
+  }
+
+  virtual bool OnDictionaryBegin() OVERRIDE {
+    return Record("{");
+  }
+
+  virtual bool OnDictionaryKey(const StringPiece& key) OVERRIDE {
+    return Record("key:" + key.as_string());
+  }
+
+  virtual bool OnDictionaryEnd() OVERRIDE {
+    return Record("}");
+  }
+
+ private:
+  bool Record(const std::string& event) {
+    if (!events_.empty())
+      events_ += " ";
+    events_ += event;
+    return ++num_events_ < max_events_;
+  }
+
+  int max_events_;
+  int num_events_;
+  std::string events_;
+};
+
+// Returns the events of the parser for |json|, or "error" if it can't be
+// parsed.
+std::string ParseEvents(const std::string& json) {
+  EventRecorder recorder(1000);
+  JSONParser parser(&recorder);
+  if (!parser.Parse(json, false, false))
+    return "error";
+  return recorder.events();
+}
+
+}  // namespace
+
+TEST(JSONParserTest, Events) {
+  EXPECT_EQ("null", ParseEvents("null"));
+  EXPECT_EQ("int:-12", ParseEvents(" -12 "));
+  EXPECT_EQ("double:1.5", ParseEvents("1.5"));
+  EXPECT_EQ("double:3e+09", ParseEvents("3000000000"));
+  EXPECT_EQ("[ ]", ParseEvents("[]"));
+  EXPECT_EQ("{ }", ParseEvents("{}"));
+  EXPECT_EQ("{ key:a [ true false { key:b null } ] key:c string:d }",
+            ParseEvents("{\"a\": [true, false, {\"b\": null}], "
+                        "/* comment */ \"c\": \"d\"}"));
+  EXPECT_EQ("error", ParseEvents("[1, 2"));
+  EXPECT_EQ("error", ParseEvents("{\"a\" 1}"));
+}
+
+TEST(JSONParserTest, Strings) {
+  EXPECT_EQ("string:abc", ParseEvents("\"abc\""));
+  EXPECT_EQ("string:a\"b\\c/d\ne", ParseEvents("\"a\\\"b\\\\c\\/d\\ne\""));
+
+  // Multi-byte characters are passed as they are, and \x escapes are code
+  // points rather than bytes.
+  EXPECT_EQ("string:\xC3\xA4\xC3\xA4", ParseEvents("\"\xC3\xA4\\xE4\""));
+  EXPECT_EQ("string:\xE2\x82\xAC", ParseEvents("\"\\u20AC\""));
+
+  // Surrogate pairs make one character, and unpaired surrogates can't be
+  // represented.
+  EXPECT_EQ("string:\xF0\x9F\x98\x80", ParseEvents("\"\\uD83D\\uDE00\""));
+  EXPECT_EQ("string:\xEF\xBF\xBD" "a", ParseEvents("\"\\uD83Da\""));
+  EXPECT_EQ("string:\xEF\xBF\xBD", ParseEvents("\"\\uDE00\""));
+
+  // Keys are decoded the same way.
+  EXPECT_EQ("{ key:\xE2\x82\xAC int:1 }", ParseEvents("{\"\\u20AC\": 1}"));
+}
+
+TEST(JSONParserTest, Input) {
+  // The input ends at the first null byte.
+  EXPECT_EQ("[ int:1 ]", ParseEvents(std::string("[1]\0garbage", 11)));
+  EXPECT_EQ("error", ParseEvents(std::string("[1\0]", 4)));
+
+  // A UTF-8 BOM is skipped.
+  EXPECT_EQ("[ ]", ParseEvents("\xEF\xBB\xBF[]"));
+
+  // The input doesn't need to be null-terminated.
+  std::string json("[12345]");
+  EXPECT_EQ("error", ParseEvents(StringPiece(json.data(), 4).as_string()));
+  EventRecorder recorder(1000);
+  JSONParser parser(&recorder);
+  EXPECT_TRUE(parser.Parse(StringPiece(json.data() + 1, 3), false, false));
+  EXPECT_EQ("int:123", recorder.events());
+}
+
+TEST(JSONParserTest, Errors) {
+  EventRecorder recorder(1000);
+  JSONParser parser(&recorder);
+
+  EXPECT_FALSE(parser.Parse("[1, 2,]", false, false));
+  EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, parser.error_code());
+  EXPECT_EQ(1, parser.error_line());
+  EXPECT_EQ(7, parser.error_column());
+  EXPECT_TRUE(parser.Parse("[1, 2,]", false, true));
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, parser.error_code());
+
+  EXPECT_FALSE(parser.Parse("1", true, false));
+  EXPECT_EQ(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, parser.error_code());
+  EXPECT_EQ("Line: 1, column: 1, Root value must be an array or object.",
+            parser.GetErrorMessage());
+
+  // Columns count characters.
+  EXPECT_FALSE(parser.Parse("[\"\xC3\xA4\xE2\x82\xAC\", x]", false, false));
+  EXPECT_EQ(JSONReader::JSON_SYNTAX_ERROR, parser.error_code());
+  EXPECT_EQ(1, parser.error_line());
+  EXPECT_EQ(8, parser.error_column());
+
+  EXPECT_FALSE(parser.Parse("[\"\xC0\x80\"]", false, false));
+  EXPECT_EQ(JSONReader::JSON_UNSUPPORTED_ENCODING, parser.error_code());
+}
+
+TEST(JSONParserTest, DelegateStops) {
+  const char kJSON[] = "{\"a\": [1, 2], \"b\": 3}";
+
+  // Stopping after any event fails the parsing, without an error.
+  for (int max_events = 1; max_events <= 9; ++max_events) {
+    EventRecorder recorder(max_events);
+    JSONParser parser(&recorder);
+    EXPECT_FALSE(parser.Parse(kJSON, false, false));
+    EXPECT_EQ(JSONReader::JSON_NO_ERROR, parser.error_code());
+    EXPECT_EQ("", parser.GetErrorMessage());
+  }
+
+  EventRecorder recorder(10);
+  JSONParser parser(&recorder);
+  EXPECT_TRUE(parser.Parse(kJSON, false, false));
+  EXPECT_EQ("{ key:a [ int:1 int:2 ] key:b int:3 }", recorder.events());
+}
+
+}  // namespace base
@@ -0,0 +1,174 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/json/json_parser.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_value_converter.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kIterations = 10;
+
+// Returns a trace in the format of about:tracing, which is mostly a long list
+// of small dictionaries.
+std::string MakeTrace(int num_events) {
+  std::string json = "{\"traceEvents\": [\n";
+  for (int i = 0; i < num_events; ++i) {
+    StringAppendF(&json,
+        "{\"cat\": \"task\", \"pid\": %d, \"tid\": %d, \"ts\": %d, "
+        "\"ph\": \"%s\", \"name\": \"MessageLoop::RunTask\", "
+        "\"args\": {\"src_file\": \"base\\/message_loop.cc\", "
+        "\"src_func\": \"PostTask\", \"id\": %d}}%s\n",
+        1000 + i % 3, 2000 + i % 17, 1000000 + i * 13, i % 2 ? "E" : "B", i,
+        i + 1 < num_events ? "," : "");
+  }
+  json += "]}\n";
+  return json;
+}
+
+// Returns a bookmarks file: nested folders of entries with longer strings,
+// some of which need escaping.
+std::string MakeBookmarks(int num_folders, int num_urls) {
+  std::string json = "{\"checksum\": \"9a5bc4d1e0f2b8a7c6d5e4f3a2b1c0d9\", "
+                     "\"roots\": {\"bookmark_bar\": {\"children\": [\n";
+  for (int i = 0; i < num_folders; ++i) {
+    StringAppendF(&json, "{\"children\": [\n");
+    for (int j = 0; j < num_urls; ++j) {
+      StringAppendF(&json,
+          "  {\"date_added\": \"12961%08d\", \"id\": \"%d\", "
+          "\"name\": \"Caf\\u00e9 \\\"%d\\\" \xE2\x80\x94 page title\", "
+          "\"type\": \"url\", "
+          "\"url\": \"http:\\/\\/www.example.com\\/path\\/%d?q=%d\"}%s\n",
+          i * num_urls + j, i * num_urls + j, j, i, j,
+          j + 1 < num_urls ? "," : "");
+    }
+    StringAppendF(&json,
+        "], \"date_added\": \"12961000000\", \"date_modified\": \"0\", "
+        "\"id\": \"f%d\", \"name\": \"Folder %d\", \"type\": \"folder\"}%s\n",
+        i, i, i + 1 < num_folders ? "," : "");
+  }
+  json += "], \"name\": \"Bookmarks bar\", \"type\": \"folder\"}}, "
+          "\"version\": 1}\n";
+  return json;
+}
+
+// Does nothing with the values, to measure the parser alone.
+class NullDelegate : public JSONParser::Delegate {
+ public:
+  NullDelegate() {}
+
+  virtual bool OnNull() OVERRIDE { return true; }
+  virtual bool OnBoolean(bool value) OVERRIDE { return true; }
+  virtual bool OnInteger(int value) OVERRIDE { return true; }
+  virtual bool OnDouble(double value) OVERRIDE { return true; }
+  virtual bool OnString(const StringPiece& value) OVERRIDE { return true; }
+  virtual bool OnListBegin() OVERRIDE { return true; }
+  virtual bool OnListEnd() OVERRIDE { return true; }
+  virtual bool OnDictionaryBegin() OVERRIDE { return true; }
+  virtual bool OnDictionaryKey(const StringPiece& key) OVERRIDE {
+    return true;
+  }
+  virtual bool OnDictionaryEnd() OVERRIDE { return true; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NullDelegate);
+};
+
+struct TraceEvent {
+  std::string category;
+  std::string name;
+  std::string phase;
+  int pid;
+  int tid;
+  double timestamp;
+
+  TraceEvent() : pid(0), tid(0), timestamp(0) {}
+
+  static void RegisterJSONConverter(JSONValueConverter<TraceEvent>* converter) {
+    converter->RegisterStringField("cat", &TraceEvent::category);
+    converter->RegisterStringField("name", &TraceEvent::name);
+    converter->RegisterStringField("ph", &TraceEvent::phase);
+    converter->RegisterIntField("pid", &TraceEvent::pid);
+    converter->RegisterIntField("tid", &TraceEvent::tid);
+    converter->RegisterDoubleField("ts", &TraceEvent::timestamp);
+  }
+};
+
+struct Trace {
+  std::vector<TraceEvent> events;
+
+  static void RegisterJSONConverter(JSONValueConverter<Trace>* converter) {
+    converter->RegisterRepeatedMessage("traceEvents", &Trace::events);
+  }
+};
+
+void LogThroughput(const std::string& name, size_t size, TimeDelta elapsed) {
+  LogPerfResult(name.c_str(),
+                size * kIterations / elapsed.InSecondsF() / (1024 * 1024),
+                "MB/s");
+}
+
+// Measures parsing |json| into a Value tree, and with the parser alone.
+void ParseDocument(const std::string& name, const std::string& json) {
+  PerfTimer reader_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<Value> value(JSONReader::Read(json, false));
+    ASSERT_TRUE(value.get());
+  }
+  LogThroughput("JSONReader_" + name, json.size(), reader_timer.Elapsed());
+
+  NullDelegate delegate;
+  JSONParser parser(&delegate);
+  PerfTimer parser_timer;
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(parser.Parse(json, true, false));
+  LogThroughput("JSONParser_" + name, json.size(), parser_timer.Elapsed());
+}
+
+}  // namespace
+
+TEST(JSONPerfTest, Trace) {
+  ParseDocument("trace", MakeTrace(50000));
+}
+
+TEST(JSONPerfTest, Bookmarks) {
+  ParseDocument("bookmarks", MakeBookmarks(100, 200));
+}
+
+// Compares filling structs from a Value tree and from the parser events.
+TEST(JSONPerfTest, ValueConverter) {
+  std::string json = MakeTrace(50000);
+  JSONValueConverter<Trace> converter;
+
+  PerfTimer tree_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<Value> value(JSONReader::Read(json, false));
+    Trace trace;
+    converter.Convert(*value, &trace);
+    ASSERT_EQ(50000u, trace.events.size());
+  }
+  LogThroughput("JSONValueConverter_tree", json.size(), tree_timer.Elapsed());
+
+  PerfTimer streaming_timer;
+  for (int i = 0; i < kIterations; ++i) {
+    Trace trace;
+    ASSERT_TRUE(converter.ConvertJSON(json, &trace));
+    ASSERT_EQ(50000u, trace.events.size());
+  }
+  LogThroughput("JSONValueConverter_streaming", json.size(),
+                streaming_timer.Elapsed());
+}
+
+}  // namespace base
@@ -6,9 +6,121 @@
 
 #include <string>
 
+#include "base/compiler_specific.h"
+#include "base/json/json_parser.h"
+
 namespace base {
 namespace internal {
 
+namespace {
+
+// Passes the values read by a JSONParser to the ContainerHandler of the list
+// or dictionary they are in.
+class HandlerDispatcher : public JSONParser::Delegate {
+ public:
+  explicit HandlerDispatcher(ContainerHandler* root_handler)
+      : root_handler_(root_handler),
+        null_value_(Value::CreateNullValue()) {
+  }
+
+  virtual ~HandlerDispatcher() {
+    STLDeleteElements(&handlers_);
+  }
+
+  virtual bool OnNull() OVERRIDE {
+    Dispatch(*null_value_);
+    return true;
+  }
+
+  virtual bool OnBoolean(bool value) OVERRIDE {
+    Dispatch(FundamentalValue(value));
+    return true;
+  }
+
+  virtual bool OnInteger(int value) OVERRIDE {
+    Dispatch(FundamentalValue(value));
+    return true;
+  }
+
+  virtual bool OnDouble(double value) OVERRIDE {
+    Dispatch(FundamentalValue(value));
+    return true;
+  }
+
+  virtual bool OnString(const StringPiece& value) OVERRIDE {
+    Dispatch(StringValue(value.as_string()));
+    return true;
+  }
+
+  virtual bool OnListBegin() OVERRIDE {
+    Begin(false);
+    return true;
+  }
+
+  virtual bool OnListEnd() OVERRIDE {
+    End();
+    return true;
+  }
+
+  virtual bool OnDictionaryBegin() OVERRIDE {
+    Begin(true);
+    return true;
+  }
+
+  virtual bool OnDictionaryKey(const StringPiece& key) OVERRIDE {
+    if (handlers_.back())
+      handlers_.back()->OnKey(key);
+    return true;
+  }
+
+  virtual bool OnDictionaryEnd() OVERRIDE {
+    End();
+    return true;
+  }
+
+ private:
+  void Dispatch(const Value& value) {
+    if (!handlers_.empty() && handlers_.back())
+      handlers_.back()->OnValue(value);
+  }
+
+  void Begin(bool is_dictionary) {
+    ContainerHandler* handler = NULL;
+    if (handlers_.empty()) {
+      // Only a root dictionary is converted.
+      if (is_dictionary)
+        handler = root_handler_.release();
+    } else if (handlers_.back()) {
+      handler = handlers_.back()->OnContainer(is_dictionary);
+    }
+    handlers_.push_back(handler);
+  }
+
+  void End() {
+    delete handlers_.back();
+    handlers_.pop_back();
+  }
+
+  scoped_ptr<ContainerHandler> root_handler_;
+
+  // The handlers of the lists and dictionaries being parsed, innermost last.
+  // Lists and dictionaries that are skipped have NULL handlers.
+  std::vector<ContainerHandler*> handlers_;
+
+  scoped_ptr<Value> null_value_;
+
+  DISALLOW_COPY_AND_ASSIGN(HandlerDispatcher);
+};
+
+}  // namespace
+
+bool ParseJSONIntoHandler(const StringPiece& json,
+                          ContainerHandler* root_handler) {
+  HandlerDispatcher dispatcher(root_handler);
+  JSONParser parser(&dispatcher);
+  return parser.Parse(json, true, false);
+}
+
 FieldConverterBase::FieldConverterBase(const std::string& path)
     : field_path_(path) {
 }
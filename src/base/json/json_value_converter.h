@@ -14,6 +14,7 @@
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
+#include "base/string_piece.h"
 #include "base/values.h"
 
 // JSONValueConverter converts a JSON value into a C++ struct in a
@@ -60,6 +61,13 @@
 // and you can put RegisterRepeatedInt or some other types.  Use
 // RegisterRepeatedMessage for nested repeated fields.
 //
+// When the data is still a JSON string, ConvertJSON() fills the struct as the
+// string is parsed, without building a tree of Values first:
+//   Message message;
+//   JSONValueConverter<Message> converter;
+//   if (!converter.ConvertJSON(json_string, &message))
+//     ...  // Not valid JSON.
+//
 
 namespace base {
 
@@ -68,11 +76,35 @@ class JSONValueConverter;
 
 namespace internal {
 
+// Receives the items of a list or dictionary while ConvertJSON() parses them.
+class ContainerHandler {
+ public:
+  virtual ~ContainerHandler() {}
+
+  // Called with the key of each item of a dictionary, before the item.
+  virtual void OnKey(const base::StringPiece& key) {}
+
+  // Called for each item that is neither a list nor a dictionary.
+  virtual void OnValue(const base::Value& value) = 0;
+
+  // Called for each item that is a list or a dictionary. Returns a new
+  // handler for its items, or NULL to skip them.
+  virtual ContainerHandler* OnContainer(bool is_dictionary) = 0;
+};
+
+// Parses |json| and passes the items of its root dictionary to
+// |root_handler|, which is deleted when done. Returns false if |json| is not
+// valid JSON.
+BASE_EXPORT bool ParseJSONIntoHandler(const base::StringPiece& json,
+                                      ContainerHandler* root_handler);
+
 class FieldConverterBase {
  public:
   BASE_EXPORT explicit FieldConverterBase(const std::string& path);
   BASE_EXPORT virtual ~FieldConverterBase();
   virtual void ConvertField(const base::Value& value, void* obj) const = 0;
+  virtual ContainerHandler* CreateHandler(bool is_dictionary,
+                                          void* obj) const = 0;
   const std::string& field_path() const { return field_path_; }
 
  private:
@@ -85,6 +117,13 @@ class ValueConverter {
  public:
   virtual ~ValueConverter() {}
   virtual void Convert(const base::Value& value, FieldType* field) const = 0;
+
+  // Returns a handler that converts the items of a list or dictionary into
+  // |field|, or NULL if |field| can't be converted from one.
+  virtual ContainerHandler* CreateHandler(bool is_dictionary,
+                                          FieldType* field) const {
+    return NULL;
+  }
 };
 
 template <typename StructType, typename FieldType>
@@ -104,6 +143,13 @@ class FieldConverter : public FieldConverterBase {
     value_converter_->Convert(value, &(dst->*field_pointer_));
   }
 
+  virtual ContainerHandler* CreateHandler(
+      bool is_dictionary, void* obj) const OVERRIDE {
+    StructType* dst = reinterpret_cast<StructType*>(obj);
+    return value_converter_->CreateHandler(is_dictionary,
+                                           &(dst->*field_pointer_));
+  }
+
  private:
   FieldType StructType::* field_pointer_;
   scoped_ptr<ValueConverter<FieldType> > value_converter_;
@@ -176,11 +222,41 @@ class NestedValueConverter : public ValueConverter<NestedType> {
     converter_.Convert(value, field);
   }
 
+  virtual ContainerHandler* CreateHandler(
+      bool is_dictionary, NestedType* field) const OVERRIDE {
+    return is_dictionary ? converter_.CreateHandler(field) : NULL;
+  }
+
  private:
   JSONValueConverter<NestedType> converter_;
   DISALLOW_COPY_AND_ASSIGN(NestedValueConverter);
 };
 
+template <typename Element>
+class RepeatedValueHandler : public ContainerHandler {
+ public:
+  RepeatedValueHandler(const BasicValueConverter<Element>* converter,
+                       std::vector<Element>* field)
+      : converter_(converter), field_(field) {
+  }
+
+  virtual void OnValue(const base::Value& value) OVERRIDE {
+    Element e;
+    converter_->Convert(value, &e);
+    field_->push_back(e);
+  }
+
+  virtual ContainerHandler* OnContainer(bool is_dictionary) OVERRIDE {
+    field_->push_back(Element());
+    return NULL;
+  }
+
+ private:
+  const BasicValueConverter<Element>* converter_;
+  std::vector<Element>* field_;
+  DISALLOW_COPY_AND_ASSIGN(RepeatedValueHandler);
+};
+
 template <typename Element>
 class RepeatedValueConverter : public ValueConverter<std::vector<Element> > {
  public:
@@ -206,11 +282,44 @@ class RepeatedValueConverter : public ValueConverter<std::vector<Element> > {
     }
   }
 
+  virtual ContainerHandler* CreateHandler(
+      bool is_dictionary, std::vector<Element>* field) const OVERRIDE {
+    if (is_dictionary)
+      return NULL;
+    return new RepeatedValueHandler<Element>(&basic_converter_, field);
+  }
+
  private:
   BasicValueConverter<Element> basic_converter_;
   DISALLOW_COPY_AND_ASSIGN(RepeatedValueConverter);
 };
 
+template <typename NestedType>
+class RepeatedMessageHandler : public ContainerHandler {
+ public:
+  RepeatedMessageHandler(const JSONValueConverter<NestedType>* converter,
+                         std::vector<NestedType>* field)
+      : converter_(converter), field_(field) {
+  }
+
+  virtual void OnValue(const base::Value& value) OVERRIDE {
+    field_->push_back(NestedType());
+  }
+
+  virtual ContainerHandler* OnContainer(bool is_dictionary) OVERRIDE {
+    field_->push_back(NestedType());
+    if (!is_dictionary)
+      return NULL;
+    // The handler is done before the next element is added.
+    return converter_->CreateHandler(&field_->back());
+  }
+
+ private:
+  const JSONValueConverter<NestedType>* converter_;
+  std::vector<NestedType>* field_;
+  DISALLOW_COPY_AND_ASSIGN(RepeatedMessageHandler);
+};
+
 template <typename NestedType>
 class RepeatedMessageConverter
     : public ValueConverter<std::vector<NestedType> > {
@@ -234,6 +343,13 @@ class RepeatedMessageConverter
     }
   }
 
+  virtual ContainerHandler* CreateHandler(
+      bool is_dictionary, std::vector<NestedType>* field) const OVERRIDE {
+    if (is_dictionary)
+      return NULL;
+    return new RepeatedMessageHandler<NestedType>(&converter_, field);
+  }
+
  private:
   JSONValueConverter<NestedType> converter_;
   DISALLOW_COPY_AND_ASSIGN(RepeatedMessageConverter);
@@ -339,12 +455,106 @@ class JSONValueConverter {
     }
   }
 
+  // Parses |json| and converts its root dictionary into |output| while it is
+  // being parsed. Returns false if |json| is not valid JSON, in which case
+  // |output| may be partially converted.
+  bool ConvertJSON(const base::StringPiece& json, StructType* output) const {
+    return internal::ParseJSONIntoHandler(json, CreateHandler(output));
+  }
+
+  // Returns a handler that converts the items of a dictionary into |output|.
+  internal::ContainerHandler* CreateHandler(StructType* output) const {
+    return new StructHandler(this, output, std::string());
+  }
+
  private:
+  class StructHandler;
+  friend class StructHandler;
+
+  // Returns the field registered for |path|, if any.
+  const internal::FieldConverterBase* FindField(
+      const std::string& path) const {
+    for (std::vector<internal::FieldConverterBase*>::const_iterator it =
+            fields_.begin(); it != fields_.end(); ++it) {
+      if ((*it)->field_path() == path)
+        return *it;
+    }
+    return NULL;
+  }
+
+  // Returns true if a field is registered in the dictionary at |path|.
+  bool HasFieldsUnder(const std::string& path) const {
+    std::string prefix = path + ".";
+    for (std::vector<internal::FieldConverterBase*>::const_iterator it =
+            fields_.begin(); it != fields_.end(); ++it) {
+      if ((*it)->field_path().compare(0, prefix.size(), prefix) == 0)
+        return true;
+    }
+    return false;
+  }
+
   std::vector<internal::FieldConverterBase*> fields_;
 
   DISALLOW_COPY_AND_ASSIGN(JSONValueConverter);
 };
 
+// Converts the items of a dictionary into the fields of a struct. |prefix_|
+// is the path of the dictionary in the struct's dictionary, so that fields
+// registered with paths like "foo.bar" are found.
+template <class StructType>
+class JSONValueConverter<StructType>::StructHandler
+    : public internal::ContainerHandler {
+ public:
+  StructHandler(const JSONValueConverter* converter,
+                StructType* output,
+                const std::string& prefix)
+      : converter_(converter),
+        output_(output),
+        prefix_(prefix),
+        path_is_valid_(false) {
+  }
+
+  virtual void OnKey(const base::StringPiece& key) OVERRIDE {
+    // DictionaryValue::Get() would split keys that have dots.
+    path_is_valid_ = key.find('.') == base::StringPiece::npos;
+    path_ = prefix_;
+    if (!path_.empty())
+      path_.push_back('.');
+    key.AppendToString(&path_);
+  }
+
+  virtual void OnValue(const base::Value& value) OVERRIDE {
+    const internal::FieldConverterBase* field = FindField();
+    if (field)
+      field->ConvertField(value, output_);
+  }
+
+  virtual internal::ContainerHandler* OnContainer(
+      bool is_dictionary) OVERRIDE {
+    const internal::FieldConverterBase* field = FindField();
+    if (field)
+      return field->CreateHandler(is_dictionary, output_);
+    if (is_dictionary && path_is_valid_ && converter_->HasFieldsUnder(path_))
+      return new StructHandler(converter_, output_, path_);
+    return NULL;
+  }
+
+ private:
+  const internal::FieldConverterBase* FindField() const {
+    return path_is_valid_ ? converter_->FindField(path_) : NULL;
+  }
+
+  const JSONValueConverter* converter_;
+  StructType* output_;
+  std::string prefix_;
+
+  // The path of the current item.
+  std::string path_;
+  bool path_is_valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(StructHandler);
+};
+
 }  // namespace base
 
 #endif  // BASE_JSON_JSON_VALUE_CONVERTER_H_
@@ -48,6 +48,20 @@ struct NestedMessage {
   }
 };
 
+// For fields registered with paths.
+struct PathMessage {
+  int foo;
+  std::vector<std::string> strings;
+
+  PathMessage() : foo(0) {}
+
+  static void RegisterJSONConverter(
+      base::JSONValueConverter<PathMessage>* converter) {
+    converter->RegisterIntField("a.b.foo", &PathMessage::foo);
+    converter->RegisterRepeatedString("a.strings", &PathMessage::strings);
+  }
+};
+
 }  // namespace
 
 TEST(JSONValueConverterTest, ParseSimpleMessage) {
@@ -113,4 +127,105 @@ TEST(JSONValueConverterTest, ParseNestedMessage) {
   EXPECT_FALSE(second_child.baz);
 }
 
+TEST(JSONValueConverterTest, ConvertJSONSimpleMessage) {
+  const char normal_data[] =
+      "{\n"
+      "  \"foo\": 1,\n"
+      "  \"unknown\": {\"foo\": 2, \"list\": [3, {\"bar\": \"x\"}]},\n"
+      "  \"bar\": \"b\\u00e4r\",\n"
+      "  \"baz\": true,\n"
+      "  \"ints\": [1, 2]"
+      "}\n";
+
+  SimpleMessage message;
+  base::JSONValueConverter<SimpleMessage> converter;
+  EXPECT_TRUE(converter.ConvertJSON(normal_data, &message));
+  EXPECT_EQ(1, message.foo);
+  EXPECT_EQ("b\xC3\xA4r", message.bar);
+  EXPECT_TRUE(message.baz);
+  EXPECT_EQ(2, static_cast<int>(message.ints.size()));
+  EXPECT_EQ(1, message.ints[0]);
+  EXPECT_EQ(2, message.ints[1]);
+
+  // Invalid JSON is reported, and fields that don't have the right type are
+  // left alone.
+  SimpleMessage other_message;
+  EXPECT_FALSE(converter.ConvertJSON("{\"foo\": 2,", &other_message));
+  EXPECT_EQ(2, other_message.foo);
+  EXPECT_TRUE(converter.ConvertJSON(
+      "{\"foo\": \"3\", \"bar\": [], \"ints\": {\"a\": 1}}",
+      &other_message));
+  EXPECT_EQ(2, other_message.foo);
+  EXPECT_EQ("", other_message.bar);
+  EXPECT_TRUE(other_message.ints.empty());
+
+  // Only a root dictionary is converted.
+  EXPECT_TRUE(converter.ConvertJSON("[{\"foo\": 4}]", &other_message));
+  EXPECT_EQ(2, other_message.foo);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONNestedMessage) {
+  const char normal_data[] =
+      "{\n"
+      "  \"foo\": 1.0,\n"
+      "  \"child\": {\n"
+      "    \"foo\": 1,\n"
+      "    \"bar\": \"bar\",\n"
+      "    \"baz\": true\n"
+      "  },\n"
+      "  \"children\": [{\n"
+      "    \"foo\": 2,\n"
+      "    \"bar\": \"foobar\",\n"
+      "    \"ints\": [4, 5, 6]\n"
+      "  },\n"
+      "  null,\n"
+      "  {\n"
+      "    \"foo\": 3,\n"
+      "    \"child\": {\"foo\": 7}\n"
+      "  }]\n"
+      "}\n";
+
+  // The result is the same as when converting a tree of Values.
+  base::JSONValueConverter<NestedMessage> converter;
+  NestedMessage message;
+  EXPECT_TRUE(converter.ConvertJSON(normal_data, &message));
+  NestedMessage expected;
+  scoped_ptr<Value> value(base::JSONReader::Read(normal_data, false));
+  converter.Convert(*value.get(), &expected);
+
+  EXPECT_EQ(expected.foo, message.foo);
+  EXPECT_EQ(expected.child.foo, message.child.foo);
+  EXPECT_EQ(expected.child.bar, message.child.bar);
+  EXPECT_EQ(expected.child.baz, message.child.baz);
+  ASSERT_EQ(3u, message.children.size());
+  ASSERT_EQ(expected.children.size(), message.children.size());
+  for (size_t i = 0; i < message.children.size(); ++i) {
+    EXPECT_EQ(expected.children[i].foo, message.children[i].foo);
+    EXPECT_EQ(expected.children[i].bar, message.children[i].bar);
+    EXPECT_EQ(expected.children[i].baz, message.children[i].baz);
+    EXPECT_EQ(expected.children[i].ints, message.children[i].ints);
+  }
+  EXPECT_EQ(3, message.children[2].foo);
+}
+
+TEST(JSONValueConverterTest, ConvertJSONPaths) {
+  const char normal_data[] =
+      "{\"a\": {\"b\": {\"foo\": 5}, \"strings\": [\"x\", \"y\"]},"
+      " \"a.b\": {\"foo\": 6}}";
+
+  base::JSONValueConverter<PathMessage> converter;
+  PathMessage message;
+  EXPECT_TRUE(converter.ConvertJSON(normal_data, &message));
+  EXPECT_EQ(5, message.foo);
+  ASSERT_EQ(2u, message.strings.size());
+  EXPECT_EQ("x", message.strings[0]);
+  EXPECT_EQ("y", message.strings[1]);
+
+  PathMessage expected;
+  scoped_ptr<Value> value(base::JSONReader::Read(normal_data, false));
+  converter.Convert(*value.get(), &expected);
+  EXPECT_EQ(expected.foo, message.foo);
+  EXPECT_EQ(expected.strings, message.strings);
+}
+
 }  // namespace base
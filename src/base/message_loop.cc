@@ -43,8 +43,12 @@ namespace {
 
 // A lazily created thread local storage for quick access to a thread's message
 // loop, if one exists.  This should be safe and free of static constructors.
-base::LazyInstance<base::ThreadLocalPointer<MessageLoop> > lazy_tls_ptr =
-    LAZY_INSTANCE_INITIALIZER;
+// It is leaked because posting a task looks at it, and tasks can be posted
+// from non-joinable threads.
+base::LazyInstance<base::ThreadLocalPointer<MessageLoop>,
+                   base::LeakyLazyInstanceTraits<
+                       base::ThreadLocalPointer<MessageLoop> > >
+    lazy_tls_ptr = LAZY_INSTANCE_INITIALIZER;
 
 // Logical events for Histogram profiling. Run with -message-loop-histogrammer
 // to get an accounting of messages and actions taken on each thread.
@@ -395,8 +399,8 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 }
 
 void MessageLoop::AssertIdle() const {
-  // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
+  // We only check |incoming_queue_|, since |work_queue_| belongs to the thread
+  // running this loop.
   DCHECK(incoming_queue_.empty());
 }
 
@@ -525,19 +529,13 @@ void MessageLoop::AddToDelayedWorkQueue(const PendingTask& pending_task) {
 void MessageLoop::ReloadWorkQueue() {
   // We can improve performance of our loading tasks from incoming_queue_ to
   // work_queue_ by waiting until the last minute (work_queue_ is empty) to
-  // load.  That reduces the number of locks-per-task significantly when our
-  // queues get large.
+  // load.  That reduces the number of atomic operations per task significantly
+  // when our queues get large.
   if (!work_queue_.empty())
-    return;  // Wait till we *really* need to lock and load.
+    return;  // Wait till we *really* need to load.
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
-      return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
-  }
+  // Acquire all we can from the inter-thread queue with one atomic exchange.
+  incoming_queue_.PopAll(&work_queue_);
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -627,22 +625,16 @@ void MessageLoop::AddToIncomingQueue(PendingTask* pending_task) {
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
+  if (incoming_queue_.PushIfNotEmpty(pending_task))
+    return;  // Someone else should have started the sub-pump.
 
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(*pending_task);
-    pending_task->task.Reset();
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
-
-    pump = pump_;
-  }
   // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
+  // loop, we cannot touch |this| once the task is on the queue. We use a
+  // stack-based reference to the message pump so that we can call
+  // ScheduleWork after that point.
+  scoped_refptr<base::MessagePump> pump(pump_);
+  if (!incoming_queue_.Push(pending_task))
+    return;  // The consumer has not emptied the queue yet.
 
   pump->ScheduleWork();
 }
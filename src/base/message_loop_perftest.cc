@@ -0,0 +1,126 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Counts the tasks that run on the target loop, and signals |done_| when all
+// of them are done.
+class TaskCounter {
+ public:
+  TaskCounter(int num_tasks, base::WaitableEvent* done)
+      : num_tasks_(num_tasks), count_(0), done_(done) {}
+
+  void Run() {
+    if (++count_ == num_tasks_)
+      done_->Signal();
+  }
+
+ private:
+  int num_tasks_;
+  int count_;
+  base::WaitableEvent* done_;
+};
+
+// Posts |num_tasks| tasks to |target| as soon as |start| is signaled.
+class Poster : public base::DelegateSimpleThread::Delegate {
+ public:
+  Poster(MessageLoop* target, TaskCounter* counter, int num_tasks,
+         base::WaitableEvent* start)
+      : target_(target), counter_(counter), num_tasks_(num_tasks),
+        start_(start) {}
+
+  virtual void Run() {
+    start_->Wait();
+    for (int i = 0; i < num_tasks_; i++) {
+      target_->PostTask(FROM_HERE, base::Bind(&TaskCounter::Run,
+                                              base::Unretained(counter_)));
+    }
+  }
+
+ private:
+  MessageLoop* target_;
+  TaskCounter* counter_;
+  int num_tasks_;
+  base::WaitableEvent* start_;
+};
+
+// Measures how many tasks per second can be posted to an IO loop from
+// |num_threads| threads at the same time.
+void PostTasksFromThreads(int num_threads) {
+  const int kTotalTasks = 400000;
+  int tasks_per_thread = kTotalTasks / num_threads;
+
+  base::Thread target("target");
+  base::Thread::Options options(MessageLoop::TYPE_IO, 0);
+  ASSERT_TRUE(target.StartWithOptions(options));
+
+  base::WaitableEvent start(true, false);
+  base::WaitableEvent done(false, false);
+  TaskCounter counter(tasks_per_thread * num_threads, &done);
+
+  ScopedVector<Poster> posters;
+  ScopedVector<base::DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    posters.push_back(new Poster(target.message_loop(), &counter,
+                                 tasks_per_thread, &start));
+    threads.push_back(new base::DelegateSimpleThread(posters[i], "poster"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  for (int i = 0; i < num_threads; i++)
+    threads[i]->Join();
+  base::TimeDelta post_time = timer.Elapsed();
+  done.Wait();
+  base::TimeDelta run_time = timer.Elapsed();
+
+  std::string name = base::StringPrintf("PostTask_%d_threads", num_threads);
+  LogPerfResult(name.c_str(),
+                tasks_per_thread * num_threads / post_time.InSecondsF(),
+                "posts/s");
+  name = base::StringPrintf("RunTask_%d_threads", num_threads);
+  LogPerfResult(name.c_str(),
+                tasks_per_thread * num_threads / run_time.InSecondsF(),
+                "tasks/s");
+  target.Stop();
+}
+
+}  // namespace
+
+TEST(MessageLoopPerfTest, PostTaskFromMultipleThreads) {
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2)
+    PostTasksFromThreads(num_threads);
+}
+
+// Measures tasks that post another task to their own loop, which do not need
+// to allocate memory for the incoming queue.
+TEST(MessageLoopPerfTest, PostTaskToCurrentLoop) {
+  const int kNumTasks = 400000;
+  MessageLoop loop(MessageLoop::TYPE_IO);
+  base::WaitableEvent done(false, false);
+  TaskCounter counter(kNumTasks, &done);
+
+  PerfTimeLogger timer("PostTask_current_loop");
+  for (int i = 0; i < kNumTasks; i++) {
+    loop.PostTask(FROM_HERE, base::Bind(&TaskCounter::Run,
+                                        base::Unretained(&counter)));
+    if (i % 64 == 63)
+      loop.RunAllPending();
+  }
+  loop.RunAllPending();
+  timer.Done();
+  EXPECT_TRUE(done.IsSignaled());
+}
@@ -15,13 +15,48 @@
 #include <string>
 
 #include "base/debug/leak_annotations.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/pickle.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
 
 namespace base {
 
+namespace {
+
+// Size of the padding around the per-thread sample buffers.
+const size_t kCacheLineSize = 64;
+
+// Hands out the per-thread sample buffer index of each thread.
+subtle::Atomic32 g_next_thread_sample_index = 0;
+
+// Holds one plus the sample buffer index of the current thread, or NULL if the
+// thread has not recorded a sample yet.  It is leaked because histograms are
+// updated from non-joinable threads.
+LazyInstance<ThreadLocalPointer<void>,
+             LeakyLazyInstanceTraits<ThreadLocalPointer<void> > >
+    g_thread_sample_index = LAZY_INSTANCE_INITIALIZER;
+
+size_t GetThreadSampleIndex() {
+  ThreadLocalPointer<void>* tls = g_thread_sample_index.Pointer();
+  intptr_t index = reinterpret_cast<intptr_t>(tls->Get());
+  if (!index) {
+    index = subtle::NoBarrier_AtomicIncrement(&g_next_thread_sample_index, 1);
+    tls->Set(reinterpret_cast<void*>(index));
+  }
+  return static_cast<size_t>(index - 1) % Histogram::kThreadSampleSetCount;
+}
+
+}  // namespace
+
+struct Histogram::ThreadSampleSet {
+  char padding_before[kCacheLineSize];
+  SampleSet sample;
+  char padding_after[kCacheLineSize];
+};
+
 // Static table of checksums for all possible 8 bit bytes.
 const uint32 Histogram::kCrcTable[256] = {0x0, 0x77073096L, 0xee0e612cL,
 0x990951baL, 0x76dc419L, 0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0xedb8832L,
@@ -144,6 +179,8 @@ void Histogram::AddBoolean(bool value) {
   DCHECK(false);
 }
 
+// Note locking not done in this version!!!  This is only used to merge the
+// histograms of other processes, on a single thread.
 void Histogram::AddSampleSet(const SampleSet& sample) {
   sample_.Add(sample);
 }
@@ -392,8 +429,16 @@ size_t Histogram::bucket_count() const {
 // Do a safe atomic snapshot of sample data.
 // This implementation assumes we are on a safe single thread.
 void Histogram::SnapshotSample(SampleSet* sample) const {
-  // Note locking not done in this version!!!
+  // Note locking not done in this version!!!  The per-thread buffers may be
+  // updated while they are merged, which FindCorruption() tolerates.
   *sample = sample_;
+  for (size_t i = 0; i < arraysize(thread_samples_); ++i) {
+    const ThreadSampleSet* thread_sample =
+        reinterpret_cast<const ThreadSampleSet*>(
+            subtle::Acquire_Load(&thread_samples_[i]));
+    if (thread_sample)
+      sample->Add(thread_sample->sample);
+  }
 }
 
 bool Histogram::HasConstructorArguments(Sample minimum,
@@ -448,6 +493,9 @@ Histogram::~Histogram() {
     DLOG(INFO) << output;
   }
 
+  for (size_t i = 0; i < arraysize(thread_samples_); ++i)
+    delete reinterpret_cast<ThreadSampleSet*>(thread_samples_[i]);
+
   // Just to make sure most derived class did this properly...
   DCHECK(ValidateBucketRanges());
 }
@@ -549,8 +597,9 @@ const std::string Histogram::GetAsciiBucketRange(size_t i) const {
 
 // Update histogram data with new sample.
 void Histogram::Accumulate(Sample value, Count count, size_t index) {
-  // Note locking not done in this version!!!
-  sample_.Accumulate(value, count, index);
+  // Note locking not done in this version!!!  Only the threads that share a
+  // buffer (once there are more than kThreadSampleSetCount of them) can race.
+  GetThreadSampleSet()->Accumulate(value, count, index);
 }
 
 void Histogram::SetBucketRange(size_t i, Sample value) {
@@ -580,6 +629,8 @@ uint32 Histogram::CalculateRangeChecksum() const {
 
 void Histogram::Initialize() {
   sample_.Resize(*this);
+  for (size_t i = 0; i < arraysize(thread_samples_); ++i)
+    thread_samples_[i] = 0;
   if (declared_min_ < 1)
     declared_min_ = 1;
   if (declared_max_ > kSampleType_MAX - 1)
@@ -593,6 +644,27 @@ void Histogram::Initialize() {
   cached_ranges_->SetBucketRange(bucket_count_, kSampleType_MAX);
 }
 
+Histogram::SampleSet* Histogram::GetThreadSampleSet() {
+  subtle::AtomicWord* slot = &thread_samples_[GetThreadSampleIndex()];
+  ThreadSampleSet* thread_sample =
+      reinterpret_cast<ThreadSampleSet*>(subtle::Acquire_Load(slot));
+  if (thread_sample)
+    return &thread_sample->sample;
+
+  // Another thread sharing the index may install its buffer first, in which
+  // case ours is discarded.
+  thread_sample = new ThreadSampleSet;
+  thread_sample->sample.Resize(*this);
+  subtle::AtomicWord previous = subtle::Release_CompareAndSwap(
+      slot, 0, reinterpret_cast<subtle::AtomicWord>(thread_sample));
+  if (previous) {
+    delete thread_sample;
+    thread_sample =
+        reinterpret_cast<ThreadSampleSet*>(subtle::Acquire_Load(slot));
+  }
+  return &thread_sample->sample;
+}
+
 // We generate the CRC-32 using the low order bits to select whether to XOR in
 // the reversed polynomial 0xedb88320L.  This is nice and simple, and allows us
 // to keep the quotient in a uint32.  Since we're not concerned about the nature
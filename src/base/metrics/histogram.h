@@ -330,6 +330,10 @@ class BASE_EXPORT Histogram {
   static const Sample kSampleType_MAX = INT_MAX;
   // Initialize maximum number of buckets in histograms as 16,384.
   static const size_t kBucketCount_MAX;
+  // Maximum number of per-thread sample buffers of a histogram. Threads get a
+  // buffer index in the order they first record a sample, and start sharing
+  // buffers once there are more threads than this.
+  static const size_t kThreadSampleSetCount = 16;
 
   typedef std::vector<Count> Counts;
 
@@ -510,7 +514,8 @@ class BASE_EXPORT Histogram {
   void set_cached_ranges(CachedRanges* cached_ranges) {
     cached_ranges_ = cached_ranges;
   }
-  // Snapshot the current complete set of sample data.
+  // Snapshot the current complete set of sample data. The per-thread buffers
+  // are merged into |sample| here, so this is where recording gets paid for.
   // Override with atomic/locked snapshot if needed.
   virtual void SnapshotSample(SampleSet* sample) const;
 
@@ -587,9 +592,16 @@ class BASE_EXPORT Histogram {
 
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
 
+  // A SampleSet that only the threads assigned to it write to, padded so that
+  // buffers written by different threads don't share a cache line.
+  struct ThreadSampleSet;
+
   // Post constructor initialization.
   void Initialize();
 
+  // Return the sample buffer of the current thread, creating it if needed.
+  SampleSet* GetThreadSampleSet();
+
   // Checksum function for accumulating range values into a checksum.
   static uint32 Crc32(uint32 sum, Sample range);
 
@@ -646,8 +658,13 @@ class BASE_EXPORT Histogram {
   uint32 range_checksum_;
 
   // Finally, provide the state that changes with the addition of each new
-  // sample.
+  // sample. |sample_| holds the samples merged in by AddSampleSet(), while
+  // Add() records into the per-thread buffers so that threads recording into
+  // the same histogram don't fight over its cache lines.  The buffers are
+  // ThreadSampleSet pointers, installed with a compare-and-swap the first time
+  // a thread records a sample and deleted along with the histogram.
   SampleSet sample_;
+  subtle::AtomicWord thread_samples_[kThreadSampleSetCount];
 
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
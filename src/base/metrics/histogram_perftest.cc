@@ -0,0 +1,85 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/memory/scoped_vector.h"
+#include "base/metrics/histogram.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTotalSamples = 4000000;
+
+// Adds |num_samples| samples to |histogram| as soon as |start| is signaled.
+class Recorder : public DelegateSimpleThread::Delegate {
+ public:
+  Recorder(Histogram* histogram, int num_samples, WaitableEvent* start)
+      : histogram_(histogram), num_samples_(num_samples), start_(start) {}
+
+  virtual void Run() {
+    start_->Wait();
+    for (int i = 0; i < num_samples_; i++)
+      histogram_->Add(i & 1023);
+  }
+
+ private:
+  Histogram* histogram_;
+  int num_samples_;
+  WaitableEvent* start_;
+};
+
+// Measures how many samples per second |num_threads| threads can record into
+// the same histogram, and how long it then takes to snapshot it.
+void RecordFromThreads(int num_threads) {
+  std::string name = StringPrintf("Histogram_%d_threads", num_threads);
+  Histogram* histogram = Histogram::FactoryGet(name, 1, 1000, 50,
+                                               Histogram::kNoFlags);
+  int samples_per_thread = kTotalSamples / num_threads;
+
+  WaitableEvent start(true, false);
+  ScopedVector<Recorder> recorders;
+  ScopedVector<DelegateSimpleThread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    recorders.push_back(new Recorder(histogram, samples_per_thread, &start));
+    threads.push_back(new DelegateSimpleThread(recorders[i], "recorder"));
+    threads[i]->Start();
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  for (int i = 0; i < num_threads; i++)
+    threads[i]->Join();
+  LogPerfResult(("Add_" + name).c_str(),
+                samples_per_thread * num_threads / timer.Elapsed().InSecondsF(),
+                "samples/s");
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(samples_per_thread * num_threads, sample.TotalCount());
+
+  const int kNumSnapshots = 1000;
+  PerfTimer snapshot_timer;
+  for (int i = 0; i < kNumSnapshots; i++) {
+    Histogram::SampleSet snapshot;
+    histogram->SnapshotSample(&snapshot);
+  }
+  LogPerfResult(("Snapshot_" + name).c_str(),
+                snapshot_timer.Elapsed().InMicroseconds() /
+                    static_cast<double>(kNumSnapshots),
+                "us");
+}
+
+}  // namespace
+
+TEST(HistogramPerfTest, AddFromMultipleThreads) {
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2)
+    RecordFromThreads(num_threads);
+}
+
+}  // namespace base
@@ -8,7 +8,10 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/metrics/histogram.h"
+#include "base/pickle.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -18,6 +21,23 @@ namespace {
 class HistogramTest : public testing::Test {
 };
 
+// Adds |num_samples| samples of |value| to |histogram|.
+class SampleAdder : public DelegateSimpleThread::Delegate {
+ public:
+  SampleAdder(Histogram* histogram, int value, int num_samples)
+      : histogram_(histogram), value_(value), num_samples_(num_samples) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_samples_; i++)
+      histogram_->Add(value_);
+  }
+
+ private:
+  Histogram* histogram_;
+  int value_;
+  int num_samples_;
+};
+
 // Check for basic syntax and use.
 TEST(HistogramTest, StartupShutdownTest) {
   // Try basic construction
@@ -347,6 +367,66 @@ TEST(HistogramTest, BucketPlacementTest) {
     EXPECT_EQ(i + 1, sample.counts(i));
 }
 
+// Check that the samples recorded on many threads all make it to a snapshot,
+// including when there are more threads than per-thread sample buffers.
+TEST(HistogramTest, MultipleThreadsTest) {
+  const int kNumThreads = Histogram::kThreadSampleSetCount / 2;
+  const int kNumSamples = 1000;
+  Histogram* histogram(Histogram::FactoryGet(
+      "Histogram", 1, 64, 8, Histogram::kNoFlags));
+
+  // The threads of each round are joined before the next round starts, so
+  // that the buffers are shared without racing.
+  for (int round = 0; round < 3; round++) {
+    ScopedVector<SampleAdder> adders;
+    ScopedVector<DelegateSimpleThread> threads;
+    for (int i = 0; i < kNumThreads; i++) {
+      adders.push_back(new SampleAdder(histogram, 1 << (i % 7), kNumSamples));
+      threads.push_back(new DelegateSimpleThread(adders[i], "adder"));
+      threads[i]->Start();
+    }
+    for (int i = 0; i < kNumThreads; i++)
+      threads[i]->Join();
+  }
+  histogram->Add(0);
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(0, histogram->FindCorruption(sample));
+  EXPECT_EQ(3 * kNumThreads * kNumSamples + 1, sample.TotalCount());
+  EXPECT_EQ(sample.TotalCount(), sample.redundant_count());
+  EXPECT_EQ(1, sample.counts(0));
+  int64 sum = 0;
+  for (int i = 0; i < kNumThreads; i++)
+    sum += 3 * kNumSamples * (1 << (i % 7));
+  EXPECT_EQ(sum, sample.sum());
+}
+
+// Check that a snapshot that merged the per-thread buffers serializes as a
+// single sample set.
+TEST(HistogramTest, SerializeSnapshotTest) {
+  Histogram* histogram(Histogram::FactoryGet(
+      "Histogram", 1, 64, 8, Histogram::kNoFlags));
+  SampleAdder adder(histogram, 20, 10);
+  DelegateSimpleThread thread(&adder, "adder");
+  thread.Start();
+  thread.Join();
+  histogram->Add(40);
+
+  Histogram::SampleSet snapshot;
+  histogram->SnapshotSample(&snapshot);
+  Pickle pickle;
+  EXPECT_TRUE(snapshot.Serialize(&pickle));
+
+  Histogram::SampleSet sample;
+  void* iter = NULL;
+  EXPECT_TRUE(sample.Deserialize(&iter, pickle));
+  EXPECT_EQ(11, sample.redundant_count());
+  EXPECT_EQ(240, sample.sum());
+  for (size_t i = 0; i < histogram->bucket_count(); i++)
+    EXPECT_EQ(snapshot.counts(i), sample.counts(i));
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -357,12 +437,13 @@ TEST(HistogramTest, CorruptSampleCounts) {
   Histogram* histogram(Histogram::FactoryGet(
       "Histogram", 1, 64, 8, Histogram::kNoFlags));  // As per header file.
 
-  EXPECT_EQ(0, histogram->sample_.redundant_count());
+  Histogram::SampleSet snapshot;
+  histogram->SnapshotSample(&snapshot);
+  EXPECT_EQ(0, snapshot.redundant_count());
   histogram->Add(20);  // Add some samples.
   histogram->Add(40);
-  EXPECT_EQ(2, histogram->sample_.redundant_count());
 
-  Histogram::SampleSet snapshot;
+  snapshot = Histogram::SampleSet();
   histogram->SnapshotSample(&snapshot);
   EXPECT_EQ(Histogram::NO_INCONSISTENCIES, 0);
   EXPECT_EQ(0, histogram->FindCorruption(snapshot));  // No default corruption.
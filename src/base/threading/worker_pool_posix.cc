@@ -4,12 +4,16 @@
 
 #include "base/threading/worker_pool_posix.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "base/bind.h"
 #include "base/debug/trace_event.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
 #include "base/stringprintf.h"
+#include "base/sys_info.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/worker_pool.h"
@@ -26,6 +30,12 @@ const int kIdleSecondsBeforeExit = 10 * 60;
 // function of NSS because of NSS bug 439169.
 const int kWorkerThreadStackSize = 128 * 1024;
 
+// The minimum number of threads used for tasks that are not slow.
+const int kMinFastWorkerThreads = 4;
+
+// Number of times an idle worker looks for tasks before going to sleep.
+const int kSpinCount = 100;
+
 class WorkerPoolImpl {
  public:
   WorkerPoolImpl();
@@ -38,54 +48,84 @@ class WorkerPoolImpl {
 
  private:
   scoped_refptr<base::PosixDynamicThreadPool> pool_;
+#if defined(OS_LINUX)
+  // Runs the tasks that are not slow.
+  scoped_refptr<base::WorkStealingThreadPool> fast_pool_;
+#endif
 };
 
 WorkerPoolImpl::WorkerPoolImpl()
     : pool_(new base::PosixDynamicThreadPool("WorkerPool",
                                              kIdleSecondsBeforeExit)) {
+#if defined(OS_LINUX)
+  int max_threads = std::max(kMinFastWorkerThreads,
+                             SysInfo::NumberOfProcessors());
+  fast_pool_ = new base::WorkStealingThreadPool("FastWorkerPool", max_threads);
+#endif
 }
 
 WorkerPoolImpl::~WorkerPoolImpl() {
   pool_->Terminate();
+#if defined(OS_LINUX)
+  fast_pool_->Terminate();
+#endif
 }
 
 void WorkerPoolImpl::PostTask(const tracked_objects::Location& from_here,
                               Task* task, bool task_is_slow) {
+#if defined(OS_LINUX)
+  if (!task_is_slow) {
+    // The adapter deletes |task| on the worker thread, once it has run.
+    fast_pool_->PostTask(from_here,
+                         base::Bind(&subtle::TaskClosureAdapter::Run,
+                                    new subtle::TaskClosureAdapter(task)));
+    return;
+  }
+#endif
   pool_->PostTask(from_here, task);
 }
 
 void WorkerPoolImpl::PostTask(const tracked_objects::Location& from_here,
                               const base::Closure& task, bool task_is_slow) {
+#if defined(OS_LINUX)
+  if (!task_is_slow) {
+    fast_pool_->PostTask(from_here, task);
+    return;
+  }
+#endif
   pool_->PostTask(from_here, task);
 }
 
 base::LazyInstance<WorkerPoolImpl> g_lazy_worker_pool =
     LAZY_INSTANCE_INITIALIZER;
 
-class WorkerThread : public PlatformThread::Delegate {
+// Runs the tasks handed out by a thread pool until it hands out a null task.
+// Subclasses get the tasks from their pool.
+class WorkerThreadBase : public PlatformThread::Delegate {
  public:
-  WorkerThread(const std::string& name_prefix,
-               base::PosixDynamicThreadPool* pool)
-      : name_prefix_(name_prefix),
-        pool_(pool) {}
+  explicit WorkerThreadBase(const std::string& name_prefix)
+      : name_prefix_(name_prefix) {}
 
   virtual void ThreadMain();
 
+ protected:
+  // Returns the next task to run, or a null task when the thread should exit.
+  virtual PendingTask WaitForTask() = 0;
+
  private:
   const std::string name_prefix_;
-  scoped_refptr<base::PosixDynamicThreadPool> pool_;
 
-  DISALLOW_COPY_AND_ASSIGN(WorkerThread);
+  DISALLOW_COPY_AND_ASSIGN(WorkerThreadBase);
 };
 
-void WorkerThread::ThreadMain() {
+void WorkerThreadBase::ThreadMain() {
   const std::string name = base::StringPrintf(
       "%s/%d", name_prefix_.c_str(), PlatformThread::CurrentId());
   // Note |name.c_str()| must remain valid for for the whole life of the thread.
   PlatformThread::SetName(name.c_str());
 
   for (;;) {
-    PendingTask pending_task = pool_->WaitForTask();
+    PendingTask pending_task = WaitForTask();
     if (pending_task.task.is_null())
       break;
     UNSHIPPED_TRACE_EVENT2("task", "WorkerThread::ThreadMain::Run",
@@ -102,10 +142,48 @@ void WorkerThread::ThreadMain() {
         start_time, tracked_objects::ThreadData::NowForEndOfRun());
   }
 
-  // The WorkerThread is non-joinable, so it deletes itself.
+  // The worker thread is non-joinable, so it deletes itself.
   delete this;
 }
 
+class WorkerThread : public WorkerThreadBase {
+ public:
+  WorkerThread(const std::string& name_prefix,
+               base::PosixDynamicThreadPool* pool)
+      : WorkerThreadBase(name_prefix),
+        pool_(pool) {}
+
+ protected:
+  virtual PendingTask WaitForTask() {
+    return pool_->WaitForTask();
+  }
+
+ private:
+  scoped_refptr<base::PosixDynamicThreadPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerThread);
+};
+
+class StealingWorkerThread : public WorkerThreadBase {
+ public:
+  StealingWorkerThread(const std::string& name_prefix, int index,
+                       base::WorkStealingThreadPool* pool)
+      : WorkerThreadBase(name_prefix),
+        index_(index),
+        pool_(pool) {}
+
+ protected:
+  virtual PendingTask WaitForTask() {
+    return pool_->WaitForTask(index_);
+  }
+
+ private:
+  const int index_;
+  scoped_refptr<base::WorkStealingThreadPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(StealingWorkerThread);
+};
+
 }  // namespace
 
 bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
@@ -213,4 +291,158 @@ PendingTask PosixDynamicThreadPool::WaitForTask() {
   return pending_task;
 }
 
+struct WorkStealingThreadPool::WorkerQueue {
+  explicit WorkerQueue(int index) : index(index) {}
+
+  const int index;
+  Lock lock;  // Protects |tasks|.
+  std::deque<PendingTask> tasks;
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string& name_prefix,
+                                               int max_threads)
+    : name_prefix_(name_prefix),
+      max_threads_(max_threads),
+      num_threads_(0),
+      num_idle_threads_(0),
+      num_sleeping_threads_(0),
+      num_pending_tasks_(0),
+      next_queue_(0),
+      terminated_(0),
+      tasks_available_cv_(&lock_) {
+  DCHECK_GT(max_threads, 0);
+  for (int i = 0; i < max_threads; i++)
+    queues_.push_back(new WorkerQueue(i));
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  for (size_t i = 0; i < queues_.size(); i++)
+    delete queues_[i];
+}
+
+void WorkStealingThreadPool::Terminate() {
+  {
+    AutoLock locked(lock_);
+    DCHECK(!subtle::NoBarrier_Load(&terminated_)) <<
+        "Thread pool is already terminated.";
+    subtle::Release_Store(&terminated_, 1);
+  }
+  tasks_available_cv_.Broadcast();
+}
+
+void WorkStealingThreadPool::PostTask(
+    const tracked_objects::Location& from_here,
+    const base::Closure& task) {
+  PendingTask pending_task(from_here, task);
+  AddTask(&pending_task);
+}
+
+void WorkStealingThreadPool::AddTask(PendingTask* pending_task) {
+  DCHECK(!subtle::NoBarrier_Load(&terminated_)) <<
+      "This thread pool is already terminated.  Do not post new tasks.";
+
+  WorkerQueue* queue = current_queue_.Get();
+  if (!queue) {
+    int num_threads = std::max(
+        static_cast<int>(subtle::NoBarrier_Load(&num_threads_)), 1);
+    subtle::AtomicWord next =
+        subtle::NoBarrier_AtomicIncrement(&next_queue_, 1);
+    queue = queues_[static_cast<uint32>(next) % num_threads];
+  }
+
+  {
+    AutoLock locked(queue->lock);
+    queue->tasks.push_back(*pending_task);
+    pending_task->task.Reset();
+  }
+
+  // This barrier pairs with the one in WaitForTask(): either we see the
+  // sleeping worker, or the worker sees the new task.
+  subtle::Barrier_AtomicIncrement(&num_pending_tasks_, 1);
+  if (subtle::NoBarrier_Load(&num_sleeping_threads_)) {
+    AutoLock locked(lock_);
+    tasks_available_cv_.Signal();
+  } else if (!subtle::NoBarrier_Load(&num_idle_threads_)) {
+    StartWorker();
+  }
+}
+
+PendingTask WorkStealingThreadPool::WaitForTask(int worker) {
+  DCHECK(worker >= 0 && worker < max_threads_);
+  if (!current_queue_.Get())
+    current_queue_.Set(queues_[worker]);
+
+  PendingTask pending_task(FROM_HERE, base::Closure());
+  for (;;) {
+    if (GetTask(worker, &pending_task))
+      break;
+    if (subtle::Acquire_Load(&terminated_))
+      return pending_task;
+
+    // Keep looking for a while before going to sleep.
+    subtle::NoBarrier_AtomicIncrement(&num_idle_threads_, 1);
+    bool found = false;
+    for (int i = 0; i < kSpinCount && !found; i++) {
+      if (subtle::NoBarrier_Load(&num_pending_tasks_))
+        found = GetTask(worker, &pending_task);
+      else
+        PlatformThread::YieldCurrentThread();
+    }
+
+    if (!found) {
+      AutoLock locked(lock_);
+      subtle::Barrier_AtomicIncrement(&num_sleeping_threads_, 1);
+      while (!subtle::Acquire_Load(&num_pending_tasks_) &&
+             !subtle::Acquire_Load(&terminated_)) {
+        tasks_available_cv_.Wait();
+      }
+      subtle::NoBarrier_AtomicIncrement(&num_sleeping_threads_, -1);
+    }
+    subtle::NoBarrier_AtomicIncrement(&num_idle_threads_, -1);
+    if (found)
+      break;
+  }
+
+  // If there are more tasks and nobody else is looking for them, get another
+  // worker (this task may block for a while).
+  if (subtle::NoBarrier_Load(&num_pending_tasks_) &&
+      !subtle::NoBarrier_Load(&num_idle_threads_)) {
+    StartWorker();
+  }
+  return pending_task;
+}
+
+bool WorkStealingThreadPool::GetTask(int worker, PendingTask* pending_task) {
+  // Start with our own queue, then look at the others.
+  for (int i = 0; i < max_threads_; i++) {
+    WorkerQueue* queue = queues_[(worker + i) % max_threads_];
+    AutoLock locked(queue->lock);
+    if (queue->tasks.empty())
+      continue;
+
+    *pending_task = queue->tasks.front();
+    queue->tasks.pop_front();
+    subtle::NoBarrier_AtomicIncrement(&num_pending_tasks_, -1);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::StartWorker() {
+  for (;;) {
+    subtle::AtomicWord num_threads = subtle::NoBarrier_Load(&num_threads_);
+    if (num_threads >= max_threads_)
+      return;
+    if (subtle::NoBarrier_CompareAndSwap(&num_threads_, num_threads,
+                                         num_threads + 1) == num_threads) {
+      // The new PlatformThread will take ownership of the worker, which will
+      // delete itself on exit.
+      StealingWorkerThread* worker = new StealingWorkerThread(
+          name_prefix_, static_cast<int>(num_threads), this);
+      PlatformThread::CreateNonJoinable(kWorkerThreadStackSize, worker);
+      return;
+    }
+  }
+}
+
 }  // namespace base
@@ -27,7 +27,9 @@
 
 #include <queue>
 #include <string>
+#include <vector>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "base/callback_forward.h"
 #include "base/location.h"
@@ -38,6 +40,7 @@
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/thread_local.h"
 #include "base/tracked_objects.h"
 
 class Task;
@@ -100,6 +103,76 @@ class BASE_EXPORT PosixDynamicThreadPool
   DISALLOW_COPY_AND_ASSIGN(PosixDynamicThreadPool);
 };
 
+// A thread pool for bursts of short tasks. It uses at most |max_threads|
+// threads, each one with its own queue of tasks: tasks posted from a worker go
+// to the queue of that worker, and tasks posted from other threads are spread
+// among the queues of all the workers. A worker runs the tasks of its own queue
+// in order, and when that queue is empty it steals the oldest task of another
+// one. Idle workers keep looking for work for a little while before going to
+// sleep, so that bursts of tasks don't have to wake up threads.
+//
+// Threads are started as needed and never exit before Terminate(), so this
+// pool should not be used for tasks that block for a long time.
+class BASE_EXPORT WorkStealingThreadPool
+    : public RefCountedThreadSafe<WorkStealingThreadPool> {
+ public:
+  class WorkStealingThreadPoolPeer;
+
+  // All worker threads will share the same |name_prefix|.
+  WorkStealingThreadPool(const std::string& name_prefix, int max_threads);
+  ~WorkStealingThreadPool();
+
+  // Indicates that the thread pool is going away. Wakes up all the workers and
+  // lets them exit once there are no more tasks to run.
+  void Terminate();
+
+  // Adds |task| to the thread pool.
+  void PostTask(const tracked_objects::Location& from_here,
+                const Closure& task);
+
+  // Worker thread method to get the next task to run, waiting for one if
+  // needed. Returns a null task when the worker should exit. |worker| is the
+  // index of the calling worker.
+  PendingTask WaitForTask(int worker);
+
+ private:
+  friend class WorkStealingThreadPoolPeer;
+  struct WorkerQueue;
+
+  // Adds pending_task to the thread pool. This function will clear
+  // |pending_task->task|.
+  void AddTask(PendingTask* pending_task);
+
+  // Takes a task from the queue of |worker|, or steals one from another queue.
+  // Returns false if there are no tasks.
+  bool GetTask(int worker, PendingTask* pending_task);
+
+  // Starts a new worker thread, unless there are |max_threads_| already.
+  void StartWorker();
+
+  const std::string name_prefix_;
+  const int max_threads_;
+
+  // One queue per worker (including the ones not started yet).
+  std::vector<WorkerQueue*> queues_;
+
+  // The queue of the worker running on the current thread.
+  ThreadLocalPointer<WorkerQueue> current_queue_;
+
+  subtle::AtomicWord num_threads_;           // Workers started.
+  subtle::AtomicWord num_idle_threads_;      // Spinning or sleeping.
+  subtle::AtomicWord num_sleeping_threads_;
+  subtle::AtomicWord num_pending_tasks_;     // Tasks on all the queues.
+  subtle::AtomicWord next_queue_;  // For tasks posted from other threads.
+  subtle::AtomicWord terminated_;
+
+  // Used to put idle workers to sleep and to wake them up.
+  Lock lock_;
+  ConditionVariable tasks_available_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingThreadPool);
+};
+
 }  // namespace base
 
 #endif  // BASE_THREADING_WORKER_POOL_POSIX_H_
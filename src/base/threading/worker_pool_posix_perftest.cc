@@ -0,0 +1,97 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/ref_counted.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool_posix.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kNumTasks = 100000;
+const int kNumLatencyTasks = 2000;
+
+// Counts the tasks that have run, and signals |done| after the last one.
+class Counter {
+ public:
+  Counter(int num_tasks, WaitableEvent* done)
+      : num_tasks_(num_tasks), count_(0), done_(done) {}
+
+  void Run() {
+    AutoLock locked(lock_);
+    if (++count_ == num_tasks_)
+      done_->Signal();
+  }
+
+ private:
+  Lock lock_;
+  int num_tasks_;
+  int count_;
+  WaitableEvent* done_;
+};
+
+// Records the time between posting a task and running it.
+void MeasureLatency(TimeTicks posted, TimeDelta* latency,
+                    WaitableEvent* done) {
+  *latency = TimeTicks::Now() - posted;
+  done->Signal();
+}
+
+// Posts a burst of short tasks to |pool| and measures how long it takes to run
+// all of them. Then measures the latency of single tasks posted to a pool that
+// is otherwise idle.
+template <class Pool>
+void RunPoolTest(Pool* pool, const std::string& name) {
+  WaitableEvent done(false, false);
+  Counter counter(kNumTasks, &done);
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumTasks; i++)
+    pool->PostTask(FROM_HERE, Bind(&Counter::Run, Unretained(&counter)));
+  done.Wait();
+  LogPerfResult((name + "_throughput").c_str(),
+                kNumTasks / timer.Elapsed().InSecondsF(), "tasks/s");
+
+  TimeDelta total_latency;
+  for (int i = 0; i < kNumLatencyTasks; i++) {
+    TimeDelta latency;
+    pool->PostTask(FROM_HERE, Bind(&MeasureLatency, TimeTicks::Now(),
+                                   &latency, &done));
+    done.Wait();
+    total_latency += latency;
+  }
+  LogPerfResult((name + "_latency").c_str(),
+                total_latency.InMicroseconds() /
+                    static_cast<double>(kNumLatencyTasks),
+                "us");
+  pool->Terminate();
+}
+
+}  // namespace
+
+TEST(WorkerPoolPosixPerfTest, DynamicThreadPool) {
+  scoped_refptr<PosixDynamicThreadPool> pool(
+      new PosixDynamicThreadPool("dynamic_pool", 60));
+  RunPoolTest(pool.get(), "PosixDynamicThreadPool");
+}
+
+TEST(WorkerPoolPosixPerfTest, WorkStealingThreadPool) {
+  int max_threads = std::max(4, SysInfo::NumberOfProcessors());
+  scoped_refptr<WorkStealingThreadPool> pool(
+      new WorkStealingThreadPool("stealing_pool", max_threads));
+  RunPoolTest(pool.get(), "WorkStealingThreadPool");
+}
+
+}  // namespace base
@@ -43,6 +43,22 @@ class PosixDynamicThreadPool::PosixDynamicThreadPoolPeer {
   DISALLOW_COPY_AND_ASSIGN(PosixDynamicThreadPoolPeer);
 };
 
+// Peer class to provide passthrough access to WorkStealingThreadPool internals.
+class WorkStealingThreadPool::WorkStealingThreadPoolPeer {
+ public:
+  explicit WorkStealingThreadPoolPeer(WorkStealingThreadPool* pool)
+      : pool_(pool) {}
+
+  int num_threads() const {
+    return static_cast<int>(subtle::NoBarrier_Load(&pool_->num_threads_));
+  }
+
+ private:
+  WorkStealingThreadPool* pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingThreadPoolPeer);
+};
+
 namespace {
 
 // IncrementingTask's main purpose is to increment a counter.  It also updates a
@@ -236,4 +252,132 @@ TEST_F(PosixDynamicThreadPoolTest, Complex) {
   EXPECT_EQ(4, counter_);
 }
 
+namespace {
+
+const int kMaxStealingThreads = 3;
+
+// Posts |num_tasks| tasks created by |factory| to |pool|. When this runs on a
+// worker thread, the tasks go to the queue of that worker.
+void PostTasksFromWorker(WorkStealingThreadPool* pool, int num_tasks,
+                         const base::Callback<base::Closure(void)>& factory) {
+  for (int i = 0; i < num_tasks; i++)
+    pool->PostTask(FROM_HERE, factory.Run());
+}
+
+class WorkStealingThreadPoolTest : public testing::Test {
+ protected:
+  WorkStealingThreadPoolTest()
+      : pool_(new base::WorkStealingThreadPool("stealing_pool",
+                                               kMaxStealingThreads)),
+        peer_(pool_.get()),
+        counter_(0),
+        num_waiting_to_start_(0),
+        num_waiting_to_start_cv_(&num_waiting_to_start_lock_),
+        start_(true, false) {}
+
+  virtual void TearDown() {
+    pool_->Terminate();
+  }
+
+  void WaitForCounter(int value) {
+    for (;;) {
+      {
+        base::AutoLock locked(counter_lock_);
+        if (counter_ >= value)
+          return;
+      }
+      PlatformThread::Sleep(10);
+    }
+  }
+
+  void WaitForTasksToStart(int num_tasks) {
+    base::AutoLock num_waiting_to_start_locked(num_waiting_to_start_lock_);
+    while (num_waiting_to_start_ < num_tasks) {
+      num_waiting_to_start_cv_.Wait();
+    }
+  }
+
+  base::Closure CreateNewIncrementingTaskCallback() {
+    return base::Bind(&IncrementingTask, &counter_lock_, &counter_,
+                      &unique_threads_lock_, &unique_threads_);
+  }
+
+  base::Closure CreateNewBlockingIncrementingTaskCallback() {
+    BlockingIncrementingTaskArgs args = {
+        &counter_lock_, &counter_, &unique_threads_lock_, &unique_threads_,
+        &num_waiting_to_start_lock_, &num_waiting_to_start_,
+        &num_waiting_to_start_cv_, &start_
+    };
+    return base::Bind(&BlockingIncrementingTask, args);
+  }
+
+  // Returns a callback that creates incrementing tasks.
+  base::Callback<base::Closure(void)> IncrementingTaskFactory() {
+    return base::Bind(
+        &WorkStealingThreadPoolTest::CreateNewIncrementingTaskCallback,
+        base::Unretained(this));
+  }
+
+  scoped_refptr<base::WorkStealingThreadPool> pool_;
+  base::WorkStealingThreadPool::WorkStealingThreadPoolPeer peer_;
+  Lock counter_lock_;
+  int counter_;
+  Lock unique_threads_lock_;
+  std::set<PlatformThreadId> unique_threads_;
+  Lock num_waiting_to_start_lock_;
+  int num_waiting_to_start_;
+  ConditionVariable num_waiting_to_start_cv_;
+  base::WaitableEvent start_;
+};
+
+}  // namespace
+
+TEST_F(WorkStealingThreadPoolTest, Basic) {
+  EXPECT_EQ(0, peer_.num_threads());
+
+  const int kNumTasks = 1000;
+  for (int i = 0; i < kNumTasks; i++)
+    pool_->PostTask(FROM_HERE, CreateNewIncrementingTaskCallback());
+
+  WaitForCounter(kNumTasks);
+  EXPECT_EQ(kNumTasks, counter_);
+  EXPECT_LE(1, peer_.num_threads());
+  EXPECT_GE(kMaxStealingThreads, peer_.num_threads());
+  EXPECT_GE(static_cast<size_t>(kMaxStealingThreads), unique_threads_.size());
+}
+
+TEST_F(WorkStealingThreadPoolTest, BoundedThreads) {
+  // Block all the workers, and post some more tasks.
+  for (int i = 0; i < kMaxStealingThreads; i++)
+    pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTaskCallback());
+  for (int i = 0; i < 10; i++)
+    pool_->PostTask(FROM_HERE, CreateNewIncrementingTaskCallback());
+
+  WaitForTasksToStart(kMaxStealingThreads);
+  EXPECT_EQ(kMaxStealingThreads, peer_.num_threads());
+
+  start_.Signal();
+  WaitForCounter(kMaxStealingThreads + 10);
+  EXPECT_EQ(kMaxStealingThreads, peer_.num_threads());
+  EXPECT_EQ(static_cast<size_t>(kMaxStealingThreads), unique_threads_.size());
+}
+
+// Tests that the tasks posted by a worker to its own queue are run by all the
+// workers.
+TEST_F(WorkStealingThreadPoolTest, TasksFromWorkers) {
+  for (int i = 0; i < kMaxStealingThreads; i++)
+    pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTaskCallback());
+  WaitForTasksToStart(kMaxStealingThreads);
+
+  // Once the workers are released, one of them posts more tasks to its own
+  // queue.
+  const int kNumTasks = 20;
+  pool_->PostTask(FROM_HERE, base::Bind(&PostTasksFromWorker, pool_,
+                                        kNumTasks, IncrementingTaskFactory()));
+  start_.Signal();
+
+  WaitForCounter(kMaxStealingThreads + kNumTasks);
+  EXPECT_EQ(kMaxStealingThreads + kNumTasks, counter_);
+}
+
 }  // namespace base
@@ -63,6 +63,18 @@ class PostTaskAndReplyTester
   ThreadCheckerImpl thread_checker_;
 };
 
+class SignalingTask : public Task {
+ public:
+  explicit SignalingTask(WaitableEvent* event) : event_(event) {}
+
+  virtual void Run() {
+    event_->Signal();
+  }
+
+ private:
+  WaitableEvent* event_;
+};
+
 }  // namespace
 
 TEST_F(WorkerPoolTest, PostTask) {
@@ -82,6 +94,17 @@ TEST_F(WorkerPoolTest, PostTask) {
   long_test_event.Wait();
 }
 
+TEST_F(WorkerPoolTest, PostLegacyTask) {
+  WaitableEvent test_event(false, false);
+  WaitableEvent long_test_event(false, false);
+
+  WorkerPool::PostTask(FROM_HERE, new SignalingTask(&test_event), false);
+  WorkerPool::PostTask(FROM_HERE, new SignalingTask(&long_test_event), true);
+
+  test_event.Wait();
+  long_test_event.Wait();
+}
+
 TEST_F(WorkerPoolTest, PostTaskAndReply) {
   MessageLoop message_loop;
   scoped_refptr<PostTaskAndReplyTester> tester(new PostTaskAndReplyTester());
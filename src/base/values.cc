@@ -13,6 +13,14 @@
 
 namespace {
 
+// Orders the entries of a DictionaryValue by key.
+struct EntryKeyLess {
+  bool operator()(const std::pair<std::string, Value*>& entry,
+                  const base::StringPiece& key) const {
+    return base::StringPiece(entry.first) < key;
+  }
+};
+
 // Make a deep copy of |node|, but don't include empty lists or dictionaries
 // in the copy. It's possible for this function to return NULL and it
 // expects |node| to always be non-NULL.
@@ -367,9 +375,7 @@ bool DictionaryValue::GetAsDictionary(const DictionaryValue** out_value) const {
 
 bool DictionaryValue::HasKey(const std::string& key) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator current_entry = dictionary_.find(key);
-  DCHECK((current_entry == dictionary_.end()) || current_entry->second);
-  return current_entry != dictionary_.end();
+  return FindValue(key) != NULL;
 }
 
 void DictionaryValue::Clear() {
@@ -386,24 +392,25 @@ void DictionaryValue::Set(const std::string& path, Value* in_value) {
   DCHECK(IsStringUTF8(path));
   DCHECK(in_value);
 
-  std::string current_path(path);
+  StringPiece current_path(path);
   DictionaryValue* current_dictionary = this;
   for (size_t delimiter_position = current_path.find('.');
-       delimiter_position != std::string::npos;
+       delimiter_position != StringPiece::npos;
        delimiter_position = current_path.find('.')) {
     // Assume that we're indexing into a dictionary.
-    std::string key(current_path, 0, delimiter_position);
-    DictionaryValue* child_dictionary = NULL;
-    if (!current_dictionary->GetDictionary(key, &child_dictionary)) {
-      child_dictionary = new DictionaryValue;
-      current_dictionary->SetWithoutPathExpansion(key, child_dictionary);
+    StringPiece key(current_path.substr(0, delimiter_position));
+    Value* child = current_dictionary->FindValue(key);
+    if (!child || !child->IsType(TYPE_DICTIONARY)) {
+      child = new DictionaryValue;
+      current_dictionary->SetWithoutPathExpansion(key.as_string(), child);
     }
 
-    current_dictionary = child_dictionary;
-    current_path.erase(0, delimiter_position + 1);
+    current_dictionary = static_cast<DictionaryValue*>(child);
+    current_path.remove_prefix(delimiter_position + 1);
   }
 
-  current_dictionary->SetWithoutPathExpansion(current_path, in_value);
+  current_dictionary->SetWithoutPathExpansion(current_path.as_string(),
+                                              in_value);
 }
 
 void DictionaryValue::SetBoolean(const std::string& path, bool in_value) {
@@ -430,34 +437,47 @@ void DictionaryValue::SetString(const std::string& path,
 
 void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
-  // If there's an existing value here, we need to delete it, because
-  // we own all our children.
-  std::pair<ValueMap::iterator, bool> ins_res =
-      dictionary_.insert(std::make_pair(key, in_value));
-  if (!ins_res.second) {
-    DCHECK_NE(ins_res.first->second, in_value);  // This would be bogus
-    delete ins_res.first->second;
-    ins_res.first->second = in_value;
+  // Keys mostly come in order, e.g. from JSONReader.
+  if (dictionary_.empty() || dictionary_.back().first < key) {
+    dictionary_.push_back(std::make_pair(key, in_value));
+    return;
+  }
+
+  ValueMap::iterator entry = LowerBound(key);
+  if (entry != dictionary_.end() && entry->first == key) {
+    // If there's an existing value here, we need to delete it, because
+    // we own all our children.
+    DCHECK_NE(entry->second, in_value);  // This would be bogus
+    delete entry->second;
+    entry->second = in_value;
+    return;
   }
+  dictionary_.insert(entry, std::make_pair(key, in_value));
 }
 
 bool DictionaryValue::Get(const std::string& path, Value** out_value) const {
   DCHECK(IsStringUTF8(path));
-  std::string current_path(path);
+  StringPiece current_path(path);
   const DictionaryValue* current_dictionary = this;
   for (size_t delimiter_position = current_path.find('.');
-       delimiter_position != std::string::npos;
+       delimiter_position != StringPiece::npos;
        delimiter_position = current_path.find('.')) {
-    DictionaryValue* child_dictionary = NULL;
-    if (!current_dictionary->GetDictionary(
-            current_path.substr(0, delimiter_position), &child_dictionary))
+    Value* child = current_dictionary->FindValue(
+        current_path.substr(0, delimiter_position));
+    if (!child || !child->IsType(TYPE_DICTIONARY))
       return false;
 
-    current_dictionary = child_dictionary;
-    current_path.erase(0, delimiter_position + 1);
+    current_dictionary = static_cast<DictionaryValue*>(child);
+    current_path.remove_prefix(delimiter_position + 1);
   }
 
-  return current_dictionary->GetWithoutPathExpansion(current_path, out_value);
+  Value* value = current_dictionary->FindValue(current_path);
+  if (!value)
+    return false;
+
+  if (out_value)
+    *out_value = value;
+  return true;
 }
 
 bool DictionaryValue::GetBoolean(const std::string& path,
@@ -562,11 +582,10 @@ bool DictionaryValue::GetList(const std::string& path,
 bool DictionaryValue::GetWithoutPathExpansion(const std::string& key,
                                               Value** out_value) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
+  Value* entry = FindValue(key);
+  if (!entry)
     return false;
 
-  Value* entry = entry_iterator->second;
   if (out_value)
     *out_value = entry;
   return true;
@@ -656,8 +675,8 @@ bool DictionaryValue::Remove(const std::string& path, Value** out_value) {
 bool DictionaryValue::RemoveWithoutPathExpansion(const std::string& key,
                                                  Value** out_value) {
   DCHECK(IsStringUTF8(key));
-  ValueMap::iterator entry_iterator = dictionary_.find(key);
-  if (entry_iterator == dictionary_.end())
+  ValueMap::iterator entry_iterator = LowerBound(key);
+  if (entry_iterator == dictionary_.end() || entry_iterator->first != key)
     return false;
 
   Value* entry = entry_iterator->second;
@@ -697,10 +716,13 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
 
+  // The entries are copied in order, straight into place.
+  result->dictionary_.reserve(dictionary_.size());
   for (ValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
-    result->SetWithoutPathExpansion(current_entry->first,
-                                    current_entry->second->DeepCopy());
+    result->dictionary_.push_back(
+        std::make_pair(current_entry->first,
+                       current_entry->second->DeepCopy()));
   }
 
   return result;
@@ -712,26 +734,42 @@ bool DictionaryValue::Equals(const Value* other) const {
 
   const DictionaryValue* other_dict =
       static_cast<const DictionaryValue*>(other);
-  key_iterator lhs_it(begin_keys());
-  key_iterator rhs_it(other_dict->begin_keys());
-  while (lhs_it != end_keys() && rhs_it != other_dict->end_keys()) {
-    Value* lhs;
-    Value* rhs;
-    if (*lhs_it != *rhs_it ||
-        !GetWithoutPathExpansion(*lhs_it, &lhs) ||
-        !other_dict->GetWithoutPathExpansion(*rhs_it, &rhs) ||
-        !lhs->Equals(rhs)) {
+  if (dictionary_.size() != other_dict->dictionary_.size())
+    return false;
+
+  // Both dictionaries are sorted, so the entries can be compared in order.
+  ValueMap::const_iterator lhs_it(dictionary_.begin());
+  ValueMap::const_iterator rhs_it(other_dict->dictionary_.begin());
+  for (; lhs_it != dictionary_.end(); ++lhs_it, ++rhs_it) {
+    if (lhs_it->first != rhs_it->first ||
+        !lhs_it->second->Equals(rhs_it->second)) {
       return false;
     }
-    ++lhs_it;
-    ++rhs_it;
   }
-  if (lhs_it != end_keys() || rhs_it != other_dict->end_keys())
-    return false;
 
   return true;
 }
 
+ValueMap::iterator DictionaryValue::LowerBound(
+    const StringPiece& key) {
+  return std::lower_bound(dictionary_.begin(), dictionary_.end(), key,
+                          EntryKeyLess());
+}
+
+ValueMap::const_iterator DictionaryValue::LowerBound(
+    const StringPiece& key) const {
+  return std::lower_bound(dictionary_.begin(), dictionary_.end(), key,
+                          EntryKeyLess());
+}
+
+Value* DictionaryValue::FindValue(const StringPiece& key) const {
+  ValueMap::const_iterator entry = LowerBound(key);
+  if (entry == dictionary_.end() || StringPiece(entry->first) != key)
+    return NULL;
+  DCHECK(entry->second);
+  return entry->second;
+}
+
 ///////////////////// ListValue ////////////////////
 
 ListValue::ListValue() : Value(TYPE_LIST) {
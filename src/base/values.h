@@ -25,12 +25,14 @@
 #include <iterator>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/base_export.h"
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
 #include "base/string16.h"
+#include "base/string_piece.h"
 
 // This file declares "using base::Value", etc. at the bottom, so that
 // current code can use these classes without the base namespace. In
@@ -47,7 +49,12 @@ class StringValue;
 class Value;
 
 typedef std::vector<Value*> ValueVector;
-typedef std::map<std::string, Value*> ValueMap;
+
+// The entries of a DictionaryValue, sorted by key. A sorted vector takes much
+// less memory than a map, and is faster to search. Insertions in the middle
+// are slower, but dictionaries are mostly built in key order (JSONWriter
+// writes them so) and read much more often than they are modified.
+typedef std::vector<std::pair<std::string, Value*> > ValueMap;
 
 // The Value class is the base class for Values. A Value can be instantiated
 // via the Create*Value() factory methods, or by directly creating instances of
@@ -212,6 +219,10 @@ class BASE_EXPORT BinaryValue: public Value {
 // DictionaryValue provides a key-value dictionary with (optional) "path"
 // parsing for recursive access; see the comment at the top of the file. Keys
 // are |std::string|s and should be UTF-8 encoded.
+//
+// Like the iterators of a vector, the iterators of a dictionary are
+// invalidated when keys are added or removed, but not when the value of an
+// existing key is replaced.
 class BASE_EXPORT DictionaryValue : public Value {
  public:
   DictionaryValue();
@@ -372,6 +383,13 @@ class BASE_EXPORT DictionaryValue : public Value {
   virtual bool Equals(const Value* other) const OVERRIDE;
 
  private:
+  // Returns the first entry whose key is not less than |key|.
+  ValueMap::iterator LowerBound(const StringPiece& key);
+  ValueMap::const_iterator LowerBound(const StringPiece& key) const;
+
+  // Returns the value of |key|, without path expansion, or NULL.
+  Value* FindValue(const StringPiece& key) const;
+
   ValueMap dictionary_;
 
   DISALLOW_COPY_AND_ASSIGN(DictionaryValue);
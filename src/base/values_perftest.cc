@@ -0,0 +1,142 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX)
+#include <malloc.h>
+#endif
+
+namespace {
+
+const int kNumSections = 200;
+const int kKeysPerSection = 50;
+const int kNumSiteKeys = 5000;
+const int kNumLookups = 1000000;
+
+// Returns a dictionary shaped like a large preferences file: many small
+// dictionaries of settings, and one large dictionary keyed by site.
+DictionaryValue* MakePreferences() {
+  DictionaryValue* prefs = new DictionaryValue;
+  for (int i = 0; i < kNumSections; ++i) {
+    DictionaryValue* section = new DictionaryValue;
+    for (int j = 0; j < kKeysPerSection; ++j) {
+      std::string key = base::StringPrintf("setting_%d", j);
+      switch (j % 4) {
+        case 0:
+          section->SetBoolean(key, j % 3 == 0);
+          break;
+        case 1:
+          section->SetInteger(key, i * j);
+          break;
+        case 2:
+          section->SetDouble(key, i / 7.0);
+          break;
+        case 3:
+          section->SetString(key, "http://www.example.com/");
+          break;
+      }
+    }
+    prefs->Set(base::StringPrintf("section_%d", i), section);
+  }
+
+  DictionaryValue* sites = new DictionaryValue;
+  for (int i = 0; i < kNumSiteKeys; ++i) {
+    DictionaryValue* site = new DictionaryValue;
+    site->SetInteger("per_plugin", i % 3);
+    site->SetInteger("last_visit", 1300000000 + i);
+    sites->SetWithoutPathExpansion(
+        base::StringPrintf("http://site%d.example.com:80", i), site);
+  }
+  prefs->Set("content_settings", sites);
+  return prefs;
+}
+
+// Returns the number of bytes allocated from the heap, or 0 if unknown.
+size_t GetAllocatedBytes() {
+#if defined(OS_LINUX)
+  return mallinfo().uordblks;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace
+
+// Measures the memory taken by the Values read from a preferences file.
+TEST(ValuesPerfTest, Memory) {
+  scoped_ptr<DictionaryValue> prefs(MakePreferences());
+  std::string json;
+  base::JSONWriter::Write(prefs.get(), false, &json);
+  prefs.reset();
+
+  size_t before = GetAllocatedBytes();
+  PerfTimer timer;
+  scoped_ptr<Value> value(base::JSONReader::Read(json, false));
+  base::TimeDelta read_time = timer.Elapsed();
+  size_t after = GetAllocatedBytes();
+  ASSERT_TRUE(value.get());
+
+  if (before || after) {
+    LogPerfResult("Values_memory", static_cast<double>(after - before),
+                  "bytes");
+  }
+  LogPerfResult("Values_read", read_time.InMillisecondsF(), "ms");
+
+  PerfTimer copy_timer;
+  scoped_ptr<Value> copy(value->DeepCopy());
+  LogPerfResult("Values_deep_copy", copy_timer.Elapsed().InMillisecondsF(),
+                "ms");
+  EXPECT_TRUE(copy->Equals(value.get()));
+}
+
+// Measures lookups by path, and by key in a large dictionary.
+TEST(ValuesPerfTest, Lookups) {
+  scoped_ptr<DictionaryValue> prefs(MakePreferences());
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < 1000; ++i) {
+    paths.push_back(base::StringPrintf("section_%d.setting_%d",
+                                       (i * 7) % kNumSections,
+                                       (i * 4 + 1) % kKeysPerSection));
+  }
+  PerfTimer path_timer;
+  int found = 0;
+  for (int i = 0; i < kNumLookups; ++i) {
+    int value;
+    if (prefs->GetInteger(paths[i % paths.size()], &value))
+      found++;
+  }
+  LogPerfResult("Values_path_lookups",
+                kNumLookups / path_timer.Elapsed().InSecondsF(), "lookups/s");
+  EXPECT_EQ(kNumLookups, found);
+
+  DictionaryValue* sites = NULL;
+  ASSERT_TRUE(prefs->GetDictionary("content_settings", &sites));
+  std::vector<std::string> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(base::StringPrintf("http://site%d.example.com:80",
+                                      (i * 37) % kNumSiteKeys));
+  }
+  PerfTimer key_timer;
+  found = 0;
+  for (int i = 0; i < kNumLookups; ++i) {
+    DictionaryValue* site;
+    if (sites->GetDictionaryWithoutPathExpansion(keys[i % keys.size()], &site))
+      found++;
+  }
+  LogPerfResult("Values_key_lookups",
+                kNumLookups / key_timer.Elapsed().InSecondsF(), "lookups/s");
+  EXPECT_EQ(kNumLookups, found);
+}
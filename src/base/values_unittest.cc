@@ -755,4 +755,57 @@ TEST(ValuesTest, DictionaryIterator) {
   EXPECT_TRUE(seen2);
 }
 
+// Tests that keys are kept in order whatever the order they are set in.
+TEST(ValuesTest, DictionaryKeyOrder) {
+  const char* const kKeys[] = { "m", "c", "x", "a", "n", "b", "z", "y" };
+  DictionaryValue dict;
+  for (size_t i = 0; i < arraysize(kKeys); ++i)
+    dict.SetInteger(kKeys[i], static_cast<int>(i));
+  EXPECT_EQ(arraysize(kKeys), dict.size());
+
+  // Replacing a value doesn't add a key.
+  dict.SetInteger("n", 42);
+  EXPECT_EQ(arraysize(kKeys), dict.size());
+
+  std::string keys;
+  for (DictionaryValue::key_iterator it = dict.begin_keys();
+       it != dict.end_keys(); ++it) {
+    keys += *it;
+  }
+  EXPECT_EQ("abcmnxyz", keys);
+
+  for (size_t i = 0; i < arraysize(kKeys); ++i) {
+    int value = -1;
+    EXPECT_TRUE(dict.GetIntegerWithoutPathExpansion(kKeys[i], &value));
+    EXPECT_EQ(kKeys[i] == std::string("n") ? 42 : static_cast<int>(i), value);
+  }
+  EXPECT_FALSE(dict.HasKey("d"));
+  EXPECT_FALSE(dict.HasKey(""));
+  EXPECT_FALSE(dict.HasKey("zz"));
+
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("c", NULL));
+  EXPECT_TRUE(dict.RemoveWithoutPathExpansion("z", NULL));
+  EXPECT_FALSE(dict.RemoveWithoutPathExpansion("d", NULL));
+  keys.clear();
+  for (DictionaryValue::Iterator it(dict); it.HasNext(); it.Advance())
+    keys += it.key();
+  EXPECT_EQ("abmnxy", keys);
+
+  // Paths go through nested dictionaries, and replace values that aren't
+  // dictionaries.
+  dict.SetString("b.c.d", "e");
+  std::string value;
+  EXPECT_TRUE(dict.GetString("b.c.d", &value));
+  EXPECT_EQ("e", value);
+  EXPECT_FALSE(dict.GetString("b.c", &value));
+  EXPECT_FALSE(dict.GetString("b.c.d.e", &value));
+  EXPECT_FALSE(dict.GetString("b.", &value));
+  EXPECT_EQ(6u, dict.size());
+
+  scoped_ptr<DictionaryValue> copy(dict.DeepCopy());
+  EXPECT_TRUE(copy->Equals(&dict));
+  copy->SetInteger("n", 43);
+  EXPECT_FALSE(copy->Equals(&dict));
+}
+
 }  // namespace base
@@ -106,6 +106,7 @@
 #include "net/base/cookie_monster.h"
 #include "net/base/net_module.h"
 #include "net/base/sdch_manager.h"
+#include "net/disk_cache/disk_cache.h"
 #include "net/http/http_basic_stream.h"
 #include "net/http/http_network_layer.h"
 #include "net/http/http_stream_factory.h"
@@ -270,6 +271,15 @@ void InitializeNetworkOptions(const CommandLine& parsed_command_line) {
   if (parsed_command_line.HasSwitch(switches::kEnableHttpPipelining))
     net::HttpStreamFactory::set_http_pipelining_enabled(true);
 
+  if (parsed_command_line.HasSwitch(switches::kDiskCacheShards)) {
+    int value;
+    if (base::StringToInt(
+            parsed_command_line.GetSwitchValueASCII(switches::kDiskCacheShards),
+            &value)) {
+      disk_cache::SetNumCacheShards(value);
+    }
+  }
+
   if (parsed_command_line.HasSwitch(switches::kTestingFixedHttpPort)) {
     int value;
     base::StringToInt(
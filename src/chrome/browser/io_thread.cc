@@ -10,8 +10,10 @@
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/debug/leak_tracker.h"
+#include "base/file_path.h"
 #include "base/logging.h"
 #include "base/metrics/field_trial.h"
+#include "base/path_service.h"
 #include "base/stl_util.h"
 #include "base/string_number_conversions.h"
 #include "base/string_split.h"
@@ -31,6 +33,8 @@
 #include "chrome/browser/net/proxy_service_factory.h"
 #include "chrome/browser/net/sdch_dictionary_fetcher.h"
 #include "chrome/browser/prefs/pref_service.h"
+#include "chrome/common/chrome_constants.h"
+#include "chrome/common/chrome_paths.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/pref_names.h"
 #include "content/browser/gpu/gpu_process_host.h"
@@ -39,6 +43,7 @@
 #include "content/public/common/content_client.h"
 #include "content/public/common/url_fetcher.h"
 #include "net/base/cert_verifier.h"
+#include "net/base/cert_verify_cache.h"
 #include "net/base/cookie_monster.h"
 #include "net/base/default_origin_bound_cert_store.h"
 #include "net/base/host_cache.h"
@@ -445,6 +450,17 @@ void IOThread::Init() {
   globals_->host_resolver.reset(
       CreateGlobalHostResolver(net_log_));
   globals_->cert_verifier.reset(new net::CertVerifier);
+  FilePath user_data_dir;
+  if (PathService::Get(chrome::DIR_USER_DATA, &user_data_dir)) {
+    globals_->cert_verify_cache = new net::CertVerifyCache(
+        user_data_dir.Append(chrome::kCertVerifyCacheFilename));
+    globals_->cert_verifier->set_shared_cache(globals_->cert_verify_cache);
+    BrowserThread::PostTask(
+        BrowserThread::FILE, FROM_HERE,
+        base::Bind(base::IgnoreResult(&net::CertVerifyCache::Load),
+                   globals_->cert_verify_cache));
+  }
+  globals_->off_the_record_cert_verifier.reset(new net::CertVerifier);
   globals_->transport_security_state.reset(new net::TransportSecurityState(""));
   globals_->ssl_config_service = GetSSLConfigService();
   globals_->http_auth_handler_factory.reset(CreateDefaultAuthHandlerFactory(
@@ -543,6 +559,15 @@ void IOThread::CleanUp() {
 
   system_proxy_config_service_.reset();
 
+  // The FILE thread is stopped after this one, so the cache is written before
+  // the browser exits.
+  if (globals_->cert_verify_cache) {
+    BrowserThread::PostTask(
+        BrowserThread::FILE, FROM_HERE,
+        base::Bind(base::IgnoreResult(&net::CertVerifyCache::Save),
+                   globals_->cert_verify_cache));
+  }
+
   delete globals_;
   globals_ = NULL;
 
@@ -28,6 +28,7 @@ class SystemURLRequestContextGetter;
 
 namespace net {
 class CertVerifier;
+class CertVerifyCache;
 class CookieStore;
 class FtpTransactionFactory;
 class HostResolver;
@@ -69,6 +70,11 @@ class IOThread : public content::BrowserThreadDelegate {
     scoped_ptr<net::NetworkDelegate> system_network_delegate;
     scoped_ptr<net::HostResolver> host_resolver;
     scoped_ptr<net::CertVerifier> cert_verifier;
+    // Keeps the results of |cert_verifier| for the next sessions.
+    scoped_refptr<net::CertVerifyCache> cert_verify_cache;
+    // Used by the incognito profiles, so that their results are never written
+    // to the disk.
+    scoped_ptr<net::CertVerifier> off_the_record_cert_verifier;
     // This TransportSecurityState doesn't load or save any state. It's only
     // used to enforce pinning for system requests and will only use built-in
     // pins.
@@ -55,7 +55,11 @@ using content::BrowserThread;
 // Subsequent to loading, mutations may be queued by any thread using
 // AddCookie, UpdateCookieAccessTime, and DeleteCookie. These are flushed to
 // disk on the DB thread every 30 seconds, 512 operations, or call to Flush(),
-// whichever occurs first.
+// whichever occurs first. Before a batch is written, the operations on the
+// same cookie are coalesced, so that e.g. a cookie added and deleted within a
+// batch never reaches the disk, and only the last access time update of a
+// cookie is written. The database is kept in write-ahead log mode, so that a
+// commit appends to the log rather than rewriting pages of the database.
 class SQLitePersistentCookieStore::Backend
     : public base::RefCountedThreadSafe<SQLitePersistentCookieStore::Backend> {
  public:
@@ -96,6 +100,9 @@ class SQLitePersistentCookieStore::Backend
 
   void SetClearLocalStateOnExit(bool clear_local_state);
 
+  // Coalesces the pending operations and copies the remaining ones to |ops|.
+  void CoalescePendingOperationsForTesting(std::vector<Operation>* ops);
+
  private:
   friend class base::RefCountedThreadSafe<SQLitePersistentCookieStore::Backend>;
 
@@ -110,12 +117,6 @@ class SQLitePersistentCookieStore::Backend
 
   class PendingOperation {
    public:
-    typedef enum {
-      COOKIE_ADD,
-      COOKIE_UPDATEACCESS,
-      COOKIE_DELETE,
-    } OperationType;
-
     PendingOperation(OperationType op,
                      const net::CookieMonster::CanonicalCookie& cc)
         : op_(op), cc_(cc) { }
@@ -128,6 +129,8 @@ class SQLitePersistentCookieStore::Backend
     net::CookieMonster::CanonicalCookie cc_;
   };
 
+  typedef std::list<PendingOperation*> PendingOperationsList;
+
  private:
   // Creates or loads the SQLite database on DB thread.
   void LoadAndNotifyOnDBThread(const LoadedCallback& loaded_callback,
@@ -174,10 +177,15 @@ class SQLitePersistentCookieStore::Backend
   bool LoadCookiesForDomains(const std::set<std::string>& key);
 
   // Batch a cookie operation (add or delete)
-  void BatchOperation(PendingOperation::OperationType op,
+  void BatchOperation(OperationType op,
                       const net::CookieMonster::CanonicalCookie& cc);
+  // Removes from |ops| the operations which are superseded by later
+  // operations on the same cookie within |ops|.
+  static void CoalesceOperations(PendingOperationsList* ops);
   // Commit our pending operations to the database.
   void Commit();
+  // Commits, and then copies the write-ahead log into the database file.
+  void CommitAndCheckpoint();
   // Close() executed on the background thread.
   void InternalBackgroundClose();
 
@@ -187,7 +195,6 @@ class SQLitePersistentCookieStore::Backend
   scoped_ptr<sql::Connection> db_;
   sql::MetaTable meta_table_;
 
-  typedef std::list<PendingOperation*> PendingOperationsList;
   PendingOperationsList pending_;
   PendingOperationsList::size_type num_pending_;
   // True if the persistent store should be deleted upon destruction.
@@ -488,6 +495,14 @@ bool SQLitePersistentCookieStore::Backend::InitializeDatabase() {
 
   db_->set_error_delegate(GetErrorHandlerForCookieDb());
 
+  // With a write-ahead log, a commit appends the changed pages to the log
+  // instead of rewriting them in the database and in a rollback journal, and
+  // only needs to sync the log when it is checkpointed; losing the last
+  // commits on a power failure is fine for cookies. If the mode can't be
+  // changed the database keeps its rollback journal.
+  ignore_result(db_->Execute("PRAGMA journal_mode=WAL"));
+  ignore_result(db_->Execute("PRAGMA synchronous=NORMAL"));
+
   if (!EnsureDatabaseVersion() || !InitTable(db_.get())) {
     NOTREACHED() << "Unable to open cookie DB.";
     db_.reset();
@@ -728,21 +743,21 @@ bool SQLitePersistentCookieStore::Backend::EnsureDatabaseVersion() {
 
 void SQLitePersistentCookieStore::Backend::AddCookie(
     const net::CookieMonster::CanonicalCookie& cc) {
-  BatchOperation(PendingOperation::COOKIE_ADD, cc);
+  BatchOperation(COOKIE_ADD, cc);
 }
 
 void SQLitePersistentCookieStore::Backend::UpdateCookieAccessTime(
     const net::CookieMonster::CanonicalCookie& cc) {
-  BatchOperation(PendingOperation::COOKIE_UPDATEACCESS, cc);
+  BatchOperation(COOKIE_UPDATEACCESS, cc);
 }
 
 void SQLitePersistentCookieStore::Backend::DeleteCookie(
     const net::CookieMonster::CanonicalCookie& cc) {
-  BatchOperation(PendingOperation::COOKIE_DELETE, cc);
+  BatchOperation(COOKIE_DELETE, cc);
 }
 
 void SQLitePersistentCookieStore::Backend::BatchOperation(
-    PendingOperation::OperationType op,
+    OperationType op,
     const net::CookieMonster::CanonicalCookie& cc) {
   // Commit every 30 seconds.
   static const int kCommitIntervalMs = 30 * 1000;
@@ -773,6 +788,80 @@ void SQLitePersistentCookieStore::Backend::BatchOperation(
   }
 }
 
+// static
+void SQLitePersistentCookieStore::Backend::CoalesceOperations(
+    PendingOperationsList* ops) {
+  // The last operation in |ops| on each cookie, which is identified by its
+  // creation time.
+  typedef std::map<int64, PendingOperationsList::iterator> LastOperationMap;
+  LastOperationMap last_operations;
+
+  for (PendingOperationsList::iterator it = ops->begin(); it != ops->end(); ) {
+    PendingOperationsList::iterator current = it++;
+    int64 creation_time = (*current)->cc().CreationDate().ToInternalValue();
+    LastOperationMap::iterator last = last_operations.find(creation_time);
+    if (last == last_operations.end()) {
+      last_operations[creation_time] = current;
+      continue;
+    }
+
+    PendingOperationsList::iterator previous = last->second;
+    OperationType previous_op = (*previous)->op();
+    switch ((*current)->op()) {
+      case COOKIE_UPDATEACCESS:
+        if (previous_op == COOKIE_ADD) {
+          // Add the cookie with its latest access time instead.
+          PendingOperation* add = new PendingOperation(
+              COOKIE_ADD, (*current)->cc());
+          delete *current;
+          *current = add;
+          delete *previous;
+          ops->erase(previous);
+        } else if (previous_op == COOKIE_UPDATEACCESS) {
+          delete *previous;
+          ops->erase(previous);
+        }
+        last->second = current;
+        break;
+
+      case COOKIE_DELETE:
+        if (previous_op == COOKIE_ADD) {
+          // The cookie was added within this batch, so it isn't in the
+          // database; neither operation needs to be written.
+          delete *current;
+          ops->erase(current);
+          delete *previous;
+          ops->erase(previous);
+          last_operations.erase(last);
+          break;
+        }
+        if (previous_op == COOKIE_UPDATEACCESS) {
+          delete *previous;
+          ops->erase(previous);
+        }
+        last->second = current;
+        break;
+
+      default:
+        // An addition following a deletion replaces the row of the deleted
+        // cookie, so both are kept, in order.
+        last->second = current;
+        break;
+    }
+  }
+}
+
+void SQLitePersistentCookieStore::Backend::CoalescePendingOperationsForTesting(
+    std::vector<Operation>* ops) {
+  base::AutoLock locked(lock_);
+  CoalesceOperations(&pending_);
+  num_pending_ = pending_.size();
+  for (PendingOperationsList::const_iterator it = pending_.begin();
+       it != pending_.end(); ++it) {
+    ops->push_back(Operation((*it)->op(), (*it)->cc()));
+  }
+}
+
 void SQLitePersistentCookieStore::Backend::Commit() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
 
@@ -787,6 +876,8 @@ void SQLitePersistentCookieStore::Backend::Commit() {
   if (!db_.get() || ops.empty())
     return;
 
+  CoalesceOperations(&ops);
+
   sql::Statement add_smt(db_->GetCachedStatement(SQL_FROM_HERE,
       "INSERT INTO cookies (creation_utc, host_key, name, value, path, "
       "expires_utc, secure, httponly, last_access_utc, has_expires, "
@@ -821,7 +912,7 @@ void SQLitePersistentCookieStore::Backend::Commit() {
     // Free the cookies as we commit them to the database.
     scoped_ptr<PendingOperation> po(*it);
     switch (po->op()) {
-      case PendingOperation::COOKIE_ADD:
+      case COOKIE_ADD:
         add_smt.Reset();
         add_smt.BindInt64(0, po->cc().CreationDate().ToInternalValue());
         add_smt.BindString(1, po->cc().Domain());
@@ -838,7 +929,7 @@ void SQLitePersistentCookieStore::Backend::Commit() {
           NOTREACHED() << "Could not add a cookie to the DB.";
         break;
 
-      case PendingOperation::COOKIE_UPDATEACCESS:
+      case COOKIE_UPDATEACCESS:
         update_access_smt.Reset();
         update_access_smt.BindInt64(0,
             po->cc().LastAccessDate().ToInternalValue());
@@ -848,7 +939,7 @@ void SQLitePersistentCookieStore::Backend::Commit() {
           NOTREACHED() << "Could not update cookie last access time in the DB.";
         break;
 
-      case PendingOperation::COOKIE_DELETE:
+      case COOKIE_DELETE:
         del_smt.Reset();
         del_smt.BindInt64(0, po->cc().CreationDate().ToInternalValue());
         if (!del_smt.Run())
@@ -869,7 +960,8 @@ void SQLitePersistentCookieStore::Backend::Flush(
     const base::Closure& callback) {
   DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
   BrowserThread::PostTask(
-      BrowserThread::DB, FROM_HERE, base::Bind(&Backend::Commit, this));
+      BrowserThread::DB, FROM_HERE,
+      base::Bind(&Backend::CommitAndCheckpoint, this));
   if (!callback.is_null()) {
     // We want the completion task to run immediately after Commit() returns.
     // Posting it from here means there is less chance of another task getting
@@ -878,6 +970,16 @@ void SQLitePersistentCookieStore::Backend::Flush(
   }
 }
 
+void SQLitePersistentCookieStore::Backend::CommitAndCheckpoint() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+  Commit();
+
+  // Flush() promises that the cookies are in the database file itself, not
+  // only in its write-ahead log.
+  if (db_.get() && !db_->Execute("PRAGMA wal_checkpoint"))
+    LOG(WARNING) << "Unable to checkpoint the cookie database.";
+}
+
 // Fire off a close message to the background thread.  We could still have a
 // pending commit timer or Load operations holding references on us, but if/when
 // this fires we will already have been cleaned up and it will be ignored.
@@ -970,3 +1072,8 @@ void SQLitePersistentCookieStore::Flush(const base::Closure& callback) {
   else if (!callback.is_null())
     MessageLoop::current()->PostTask(FROM_HERE, callback);
 }
+
+void SQLitePersistentCookieStore::CoalescePendingOperationsForTesting(
+    std::vector<Operation>* ops) {
+  backend_->CoalescePendingOperationsForTesting(ops);
+}
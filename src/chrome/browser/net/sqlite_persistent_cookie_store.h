@@ -9,10 +9,12 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/callback_forward.h"
 #include "base/compiler_specific.h"
+#include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "net/base/cookie_monster.h"
 
@@ -48,8 +50,24 @@ class SQLitePersistentCookieStore
   virtual void Flush(const base::Closure& callback) OVERRIDE;
 
  private:
+  FRIEND_TEST_ALL_PREFIXES(SQLitePersistentCookieStoreTest,
+                           TestCoalesceOperations);
+
   class Backend;
 
+  // The kinds of cookie operations batched between commits.
+  enum OperationType {
+    COOKIE_ADD,
+    COOKIE_UPDATEACCESS,
+    COOKIE_DELETE,
+  };
+  typedef std::pair<OperationType, net::CookieMonster::CanonicalCookie>
+      Operation;
+
+  // Coalesces the operations batched so far the way the next commit would,
+  // and copies the ones left to |ops|, in order. They stay pending.
+  void CoalescePendingOperationsForTesting(std::vector<Operation>* ops);
+
   scoped_refptr<Backend> backend_;
 
   DISALLOW_COPY_AND_ASSIGN(SQLitePersistentCookieStore);
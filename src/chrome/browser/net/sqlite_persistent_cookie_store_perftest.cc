@@ -6,6 +6,7 @@
 #include "base/message_loop.h"
 #include "base/perftimer.h"
 #include "base/scoped_temp_dir.h"
+#include "base/stl_util.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/test/thread_test_helper.h"
@@ -23,7 +24,8 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
       : db_thread_(BrowserThread::DB),
         io_thread_(BrowserThread::IO),
         loaded_event_(false, false),
-        key_loaded_event_(false, false) {
+        key_loaded_event_(false, false),
+        flushed_event_(false, false) {
   }
 
   void OnLoaded(
@@ -38,6 +40,16 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
     key_loaded_event_.Signal();
   }
 
+  void OnFlushed() {
+    flushed_event_.Signal();
+  }
+
+  void Flush() {
+    store_->Flush(base::Bind(&SQLitePersistentCookieStorePerfTest::OnFlushed,
+                             base::Unretained(this)));
+    flushed_event_.Wait();
+  }
+
   void Load() {
     store_->Load(base::Bind(&SQLitePersistentCookieStorePerfTest::OnLoaded,
                                 base::Unretained(this)));
@@ -49,7 +61,7 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
     io_thread_.Start();
     ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
     store_ = new SQLitePersistentCookieStore(
-      temp_dir_.path().Append(chrome::kCookieFilename));
+      temp_dir_.path().Append(chrome::kCookieFilename), false);
     std::vector<net::CookieMonster::CanonicalCookie*> cookies;
     Load();
     ASSERT_EQ(0u, cookies_.size());
@@ -64,7 +76,7 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
           net::CookieMonster::CanonicalCookie(gurl,
             base::StringPrintf("Cookie_%d", cookie_num), "1",
             domain_name, "/", std::string(), std::string(),
-            t, t, t, false, false, true));
+            t, t, t, false, false, true, true));
       }
     }
     // Replace the store effectively destroying the current one and forcing it
@@ -77,7 +89,7 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
     ASSERT_TRUE(helper->Run());
 
     store_ = new SQLitePersistentCookieStore(
-      temp_dir_.path().Append(chrome::kCookieFilename));
+      temp_dir_.path().Append(chrome::kCookieFilename), false);
   }
 
  protected:
@@ -85,6 +97,7 @@ class SQLitePersistentCookieStorePerfTest : public testing::Test {
   content::TestBrowserThread io_thread_;
   base::WaitableEvent loaded_event_;
   base::WaitableEvent key_loaded_event_;
+  base::WaitableEvent flushed_event_;
   std::vector<net::CookieMonster::CanonicalCookie*> cookies_;
   ScopedTempDir temp_dir_;
   scoped_refptr<SQLitePersistentCookieStore> store_;
@@ -114,3 +127,54 @@ TEST_F(SQLitePersistentCookieStorePerfTest, TestLoadPerformance) {
 
   ASSERT_EQ(15000U, cookies_.size());
 }
+
+// Test the time until the cookies of the first requested eTLD+1 are available
+// on a freshly opened store, which includes opening the database.
+TEST_F(SQLitePersistentCookieStorePerfTest, TestTimeToFirstCookie) {
+  PerfTimeLogger timer("Time to first cookie");
+  store_->LoadCookiesForKey("domain_150.com",
+    base::Bind(&SQLitePersistentCookieStorePerfTest::OnKeyLoaded,
+               base::Unretained(this)));
+  key_loaded_event_.Wait();
+  timer.Done();
+
+  ASSERT_EQ(50U, cookies_.size());
+}
+
+// Test the throughput of commits of additions, and of access time updates,
+// most of which are superseded by later updates of the same cookie before
+// the batch is written.
+TEST_F(SQLitePersistentCookieStorePerfTest, TestCommitPerformance) {
+  Load();
+  ASSERT_EQ(15000U, cookies_.size());
+
+  const int kNumAddedCookies = 5000;
+  base::Time t = base::Time::Now();
+  PerfTimeLogger add_timer("Commit 5000 added cookies");
+  for (int cookie_num = 0; cookie_num < kNumAddedCookies; ++cookie_num) {
+    t += base::TimeDelta::FromInternalValue(10);
+    store_->AddCookie(
+      net::CookieMonster::CanonicalCookie(GURL(),
+        base::StringPrintf("Added_%d", cookie_num), "1",
+        ".added.com", "/", std::string(), std::string(),
+        t, t, t, false, false, true, true));
+  }
+  Flush();
+  add_timer.Done();
+
+  PerfTimeLogger update_timer("Commit 15000 access time updates");
+  for (int round = 0; round < 5; ++round) {
+    t += base::TimeDelta::FromMinutes(1);
+    for (int i = round; i < 15000; i += 5) {
+      cookies_[i]->SetLastAccessDate(t);
+      store_->UpdateCookieAccessTime(*cookies_[i]);
+      cookies_[(i * 7) % 15000]->SetLastAccessDate(t);
+      store_->UpdateCookieAccessTime(*cookies_[(i * 7) % 15000]);
+    }
+  }
+  Flush();
+  update_timer.Done();
+
+  STLDeleteContainerPointers(cookies_.begin(), cookies_.end());
+  cookies_.clear();
+}
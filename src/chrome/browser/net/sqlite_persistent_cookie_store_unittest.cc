@@ -156,6 +156,101 @@ TEST_F(SQLitePersistentCookieStoreTest, TestPersistance) {
   ASSERT_EQ(0U, cookies.size());
 }
 
+// Test that the operations on a cookie within one batch are written as their
+// combined effect.
+TEST_F(SQLitePersistentCookieStoreTest, TestCoalescedOperations) {
+  base::Time t = base::Time::Now() + base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie added_and_deleted(
+      GURL(), "C", "D", "http://foo.bar", "/", std::string(), std::string(),
+      t, t, t, false, false, true, true);
+  store_->AddCookie(added_and_deleted);
+  store_->DeleteCookie(added_and_deleted);
+
+  t += base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie accessed(
+      GURL(), "E", "F", "http://foo.bar", "/", std::string(), std::string(),
+      t, t, t, false, false, true, true);
+  store_->AddCookie(accessed);
+  base::Time last_access = t + base::TimeDelta::FromMinutes(1);
+  accessed.SetLastAccessDate(last_access);
+  store_->UpdateCookieAccessTime(accessed);
+  last_access += base::TimeDelta::FromMinutes(1);
+  accessed.SetLastAccessDate(last_access);
+  store_->UpdateCookieAccessTime(accessed);
+
+  store_ = NULL;
+  scoped_refptr<base::ThreadTestHelper> helper(
+      new base::ThreadTestHelper(
+          BrowserThread::GetMessageLoopProxyForThread(BrowserThread::DB)));
+  // Make sure we wait until the destructor has run.
+  ASSERT_TRUE(helper->Run());
+  store_ = new SQLitePersistentCookieStore(
+      temp_dir_.path().Append(chrome::kCookieFilename), false);
+
+  std::vector<net::CookieMonster::CanonicalCookie*> cookies;
+  Load(&cookies);
+  ASSERT_EQ(2U, cookies.size());
+  net::CookieMonster::CanonicalCookie* cookie_a = NULL;
+  net::CookieMonster::CanonicalCookie* cookie_e = NULL;
+  for (size_t i = 0; i < cookies.size(); ++i) {
+    if (cookies[i]->Name() == "A")
+      cookie_a = cookies[i];
+    else if (cookies[i]->Name() == "E")
+      cookie_e = cookies[i];
+  }
+  ASSERT_TRUE(cookie_a != NULL);
+  ASSERT_TRUE(cookie_e != NULL);
+  EXPECT_EQ(last_access, cookie_e->LastAccessDate());
+  STLDeleteContainerPointers(cookies.begin(), cookies.end());
+}
+
+// Test which operations of a batch are left after coalescing.
+TEST_F(SQLitePersistentCookieStoreTest, TestCoalesceOperations) {
+  // The addition of cookie A in setup has not been committed yet.
+  base::Time t = base::Time::Now() + base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie added_and_deleted(
+      GURL(), "C", "D", "http://foo.bar", "/", std::string(), std::string(),
+      t, t, t, false, false, true, true);
+  store_->AddCookie(added_and_deleted);
+  store_->DeleteCookie(added_and_deleted);
+
+  t += base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie added(
+      GURL(), "E", "F", "http://foo.bar", "/", std::string(), std::string(),
+      t, t, t, false, false, true, true);
+  store_->AddCookie(added);
+  base::Time last_access = t + base::TimeDelta::FromMinutes(1);
+  added.SetLastAccessDate(last_access);
+  store_->UpdateCookieAccessTime(added);
+  last_access += base::TimeDelta::FromMinutes(1);
+  added.SetLastAccessDate(last_access);
+  store_->UpdateCookieAccessTime(added);
+
+  t += base::TimeDelta::FromMicroseconds(10);
+  net::CookieMonster::CanonicalCookie updated(
+      GURL(), "G", "H", "http://foo.bar", "/", std::string(), std::string(),
+      t, t, t, false, false, true, true);
+  store_->UpdateCookieAccessTime(updated);
+  store_->UpdateCookieAccessTime(updated);
+  store_->DeleteCookie(updated);
+
+  std::vector<SQLitePersistentCookieStore::Operation> ops;
+  store_->CoalescePendingOperationsForTesting(&ops);
+  ASSERT_EQ(3U, ops.size());
+  EXPECT_EQ(SQLitePersistentCookieStore::COOKIE_ADD, ops[0].first);
+  EXPECT_EQ("A", ops[0].second.Name());
+  EXPECT_EQ(SQLitePersistentCookieStore::COOKIE_ADD, ops[1].first);
+  EXPECT_EQ("E", ops[1].second.Name());
+  EXPECT_EQ(last_access, ops[1].second.LastAccessDate());
+  EXPECT_EQ(SQLitePersistentCookieStore::COOKIE_DELETE, ops[2].first);
+  EXPECT_EQ("G", ops[2].second.Name());
+
+  // Coalescing again leaves the batch unchanged.
+  ops.clear();
+  store_->CoalescePendingOperationsForTesting(&ops);
+  EXPECT_EQ(3U, ops.size());
+}
+
 // Test that priority load of cookies for a specfic domain key could be
 // completed before the entire store is loaded
 TEST_F(SQLitePersistentCookieStoreTest, TestLoadCookiesForKey) {
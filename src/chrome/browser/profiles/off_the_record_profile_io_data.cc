@@ -165,7 +165,7 @@ void OffTheRecordProfileIOData::LazyInitializeInternal(
   main_context->set_host_resolver(
       io_thread_globals->host_resolver.get());
   main_context->set_cert_verifier(
-      io_thread_globals->cert_verifier.get());
+      io_thread_globals->off_the_record_cert_verifier.get());
   main_context->set_http_auth_handler_factory(
       io_thread_globals->http_auth_handler_factory.get());
   main_context->set_fraudulent_certificate_reporter(
@@ -21,6 +21,7 @@ var HttpCacheView = (function() {
     superClass.call(this, HttpCacheView.MAIN_BOX_ID);
 
     this.statsDiv_ = $(HttpCacheView.STATS_DIV_ID);
+    this.ioBufferPoolStatsDiv_ = $(HttpCacheView.IO_BUFFER_POOL_STATS_DIV_ID);
 
     // Register to receive http cache info.
     g_browser.addHttpCacheInfoObserver(this, true);
@@ -32,6 +33,8 @@ var HttpCacheView = (function() {
   // IDs for special HTML elements in http_cache_view.html
   HttpCacheView.MAIN_BOX_ID = 'http-cache-view-tab-content';
   HttpCacheView.STATS_DIV_ID = 'http-cache-view-cache-stats';
+  HttpCacheView.IO_BUFFER_POOL_STATS_DIV_ID =
+      'http-cache-view-io-buffer-pool-stats';
 
   cr.addSingletonGetter(HttpCacheView);
 
@@ -45,17 +48,31 @@ var HttpCacheView = (function() {
 
     onHttpCacheInfoChanged: function(info) {
       this.statsDiv_.innerHTML = '';
+      this.ioBufferPoolStatsDiv_.innerHTML = '';
 
       if (!info)
         return false;
 
       // Print the statistics.
-      var statsUl = addNode(this.statsDiv_, 'ul');
-      for (var statName in info.stats) {
+      this.addStats_(this.statsDiv_, info.stats);
+
+      // The pool only exists once the network stack has pooled a buffer.
+      if (info.ioBufferPool)
+        this.addStats_(this.ioBufferPoolStatsDiv_, info.ioBufferPool);
+      else
+        addTextNode(this.ioBufferPoolStatsDiv_, 'No buffers pooled yet.');
+      return true;
+    },
+
+    /**
+     * Adds a list of the key/value pairs of |stats| to |node|.
+     */
+    addStats_: function(node, stats) {
+      var statsUl = addNode(node, 'ul');
+      for (var statName in stats) {
         var li = addNode(statsUl, 'li');
-        addTextNode(li, statName + ': ' + info.stats[statName]);
+        addTextNode(li, statName + ': ' + stats[statName]);
       }
-      return true;
     }
   };
 
@@ -48,6 +48,7 @@
 #include "net/base/escape.h"
 #include "net/base/host_cache.h"
 #include "net/base/host_resolver.h"
+#include "net/base/io_buffer_pool.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
 #include "net/base/sys_addrinfo.h"
@@ -1139,6 +1140,12 @@ void NetInternalsMessageHandler::IOThreadImpl::OnGetHttpCacheInfo(
 
   info_dict->Set("stats", stats_dict);
 
+  // The network stack reads and writes on the IO thread, so its buffers come
+  // from the pool of this thread.
+  net::IOBufferPool* io_buffer_pool = net::IOBufferPool::current();
+  if (io_buffer_pool)
+    info_dict->Set("ioBufferPool", io_buffer_pool->GetStatsAsValue());
+
   SendJavascriptCommand("receivedHttpCacheInfo", info_dict);
 }
 
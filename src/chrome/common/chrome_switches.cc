@@ -400,6 +400,10 @@ const char kDisableXSSAuditor[]             = "disable-xss-auditor";
 // UserDatadir.
 const char kDiskCacheDir[]                  = "disk-cache-dir";
 
+// Number of cache threads used by the disk cache. Each thread handles its own
+// part of the cache.
+const char kDiskCacheShards[]               = "disk-cache-shards";
+
 // Forces the maximum disk space to be used by the disk cache, in bytes.
 const char kDiskCacheSize[]                 = "disk-cache-size";
 
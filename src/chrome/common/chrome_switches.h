@@ -120,6 +120,7 @@ extern const char kDisableWebResources[];
 extern const char kDisableWebSecurity[];
 extern const char kDisableXSSAuditor[];
 extern const char kDiskCacheDir[];
+extern const char kDiskCacheShards[];
 extern const char kDiskCacheSize[];
 extern const char kDnsLogDetails[];
 extern const char kDnsPrefetchDisable[];
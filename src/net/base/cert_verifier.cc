@@ -13,6 +13,7 @@
 #include "base/synchronization/lock.h"
 #include "base/time.h"
 #include "base/threading/worker_pool.h"
+#include "net/base/cert_verify_cache.h"
 #include "net/base/crl_set.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
@@ -203,7 +204,7 @@ class CertVerifierWorker {
       // memory leaks or worse errors.
       base::AutoLock locked(lock_);
       if (!canceled_) {
-        cert_verifier_->HandleResult(cert_, hostname_, flags_,
+        cert_verifier_->HandleResult(cert_, hostname_, flags_, crl_set_,
                                      error_, verify_result_);
       }
     }
@@ -336,6 +337,7 @@ CertVerifier::CertVerifier()
       max_cache_entries_(kMaxCacheEntries),
       requests_(0),
       cache_hits_(0),
+      shared_cache_hits_(0),
       inflight_joins_(0) {
   CertDatabase::AddObserver(this);
 }
@@ -345,6 +347,7 @@ CertVerifier::CertVerifier(TimeService* time_service)
       max_cache_entries_(kMaxCacheEntries),
       requests_(0),
       cache_hits_(0),
+      shared_cache_hits_(0),
       inflight_joins_(0) {
   CertDatabase::AddObserver(this);
 }
@@ -388,6 +391,21 @@ int CertVerifier::Verify(X509Certificate* cert,
     cache_.erase(i);
   }
 
+  // Then the shared cache, whose entries may have been verified by another
+  // CertVerifier or a previous session.
+  if (shared_cache_) {
+    CachedCertVerifyResult cached_result;
+    if (shared_cache_->Lookup(cert, hostname, flags, crl_set,
+                              time_service_->Now(), &cached_result)) {
+      shared_cache_hits_++;
+      // The result was decoded from the shared cache, so keep it around.
+      InsertInCache(key, cached_result, time_service_->Now());
+      *out_req = NULL;
+      *verify_result = cached_result.result;
+      return cached_result.error;
+    }
+  }
+
   // No cache hit. See if an identical request is currently in flight.
   CertVerifierJob* job;
   std::map<RequestParams, CertVerifierJob*>::const_iterator j;
@@ -435,6 +453,12 @@ void CertVerifier::ClearCache() {
   // Leaves inflight_ alone.
 }
 
+void CertVerifier::set_shared_cache(CertVerifyCache* shared_cache) {
+  DCHECK(CalledOnValidThread());
+
+  shared_cache_ = shared_cache;
+}
+
 size_t CertVerifier::GetCacheSize() const {
   DCHECK(CalledOnValidThread());
 
@@ -446,6 +470,7 @@ size_t CertVerifier::GetCacheSize() const {
 void CertVerifier::HandleResult(X509Certificate* cert,
                                 const std::string& hostname,
                                 int flags,
+                                CRLSet* crl_set,
                                 int error,
                                 const CertVerifyResult& verify_result) {
   DCHECK(CalledOnValidThread());
@@ -461,6 +486,26 @@ void CertVerifier::HandleResult(X509Certificate* cert,
   const RequestParams key(cert->fingerprint(), cert->ca_fingerprint(),
                           hostname, flags);
 
+  InsertInCache(key, cached_result, current_time);
+  if (shared_cache_)
+    shared_cache_->Insert(cert, hostname, flags, crl_set, cached_result);
+
+  std::map<RequestParams, CertVerifierJob*>::iterator j;
+  j = inflight_.find(key);
+  if (j == inflight_.end()) {
+    NOTREACHED();
+    return;
+  }
+  CertVerifierJob* job = j->second;
+  inflight_.erase(j);
+
+  job->HandleResult(cached_result);
+  delete job;
+}
+
+void CertVerifier::InsertInCache(const RequestParams& key,
+                                 const CachedCertVerifyResult& cached_result,
+                                 const base::Time& current_time) {
   DCHECK_GE(max_cache_entries_, 1u);
   DCHECK_LE(cache_.size(), max_cache_entries_);
   if (cache_.size() == max_cache_entries_) {
@@ -479,24 +524,14 @@ void CertVerifier::HandleResult(X509Certificate* cert,
   }
 
   cache_.insert(std::make_pair(key, cached_result));
-
-  std::map<RequestParams, CertVerifierJob*>::iterator j;
-  j = inflight_.find(key);
-  if (j == inflight_.end()) {
-    NOTREACHED();
-    return;
-  }
-  CertVerifierJob* job = j->second;
-  inflight_.erase(j);
-
-  job->HandleResult(cached_result);
-  delete job;
 }
 
 void CertVerifier::OnCertTrustChanged(const X509Certificate* cert) {
   DCHECK(CalledOnValidThread());
 
   ClearCache();
+  if (shared_cache_)
+    shared_cache_->Clear();
 }
 
 /////////////////////////////////////////////////////////////////////
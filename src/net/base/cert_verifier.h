@@ -10,6 +10,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
 #include "base/time.h"
@@ -24,6 +25,7 @@ namespace net {
 class BoundNetLog;
 class CertVerifierJob;
 class CertVerifierWorker;
+class CertVerifyCache;
 class CRLSet;
 class X509Certificate;
 
@@ -123,8 +125,14 @@ class NET_EXPORT CertVerifier : NON_EXPORTED_BASE(public base::NonThreadSafe),
 
   void set_max_cache_entries(size_t max) { max_cache_entries_ = max; }
 
+  // Sets a cache which is consulted when a request misses the cache of this
+  // verifier, and which is given every new result. |shared_cache| may be
+  // shared with other CertVerifiers, and may be NULL.
+  void set_shared_cache(CertVerifyCache* shared_cache);
+
   uint64 requests() const { return requests_; }
   uint64 cache_hits() const { return cache_hits_; }
+  uint64 shared_cache_hits() const { return shared_cache_hits_; }
   uint64 inflight_joins() const { return inflight_joins_; }
 
  private:
@@ -179,9 +187,15 @@ class NET_EXPORT CertVerifier : NON_EXPORTED_BASE(public base::NonThreadSafe),
   void HandleResult(X509Certificate* cert,
                     const std::string& hostname,
                     int flags,
+                    CRLSet* crl_set,
                     int error,
                     const CertVerifyResult& verify_result);
 
+  // Adds |cached_result| to |cache_|, evicting an entry if it is full.
+  void InsertInCache(const RequestParams& key,
+                     const CachedCertVerifyResult& cached_result,
+                     const base::Time& current_time);
+
   // CertDatabase::Observer methods:
   virtual void OnCertTrustChanged(const X509Certificate* cert) OVERRIDE;
 
@@ -198,8 +212,11 @@ class NET_EXPORT CertVerifier : NON_EXPORTED_BASE(public base::NonThreadSafe),
   // The number of CachedCertVerifyResult objects that we'll cache.
   size_t max_cache_entries_;
 
+  scoped_refptr<CertVerifyCache> shared_cache_;
+
   uint64 requests_;
   uint64 cache_hits_;
+  uint64 shared_cache_hits_;
   uint64 inflight_joins_;
 
   DISALLOW_COPY_AND_ASSIGN(CertVerifier);
@@ -0,0 +1,85 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/cert_verifier.h"
+
+#include "base/file_path.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "net/base/cert_test_util.h"
+#include "net/base/cert_verify_cache.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/test_completion_callback.h"
+#include "net/base/x509_certificate.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumVerifications = 200;
+
+class CertVerifierPerfTest : public testing::Test {
+ public:
+  CertVerifierPerfTest() : message_loop_(new MessageLoopForIO()) {}
+
+  virtual void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    cert_ = ImportCertFromFile(GetTestCertsDirectory(), "ok_cert.pem");
+    ASSERT_NE(static_cast<X509Certificate*>(NULL), cert_);
+  }
+
+ protected:
+  // Verifies |cert_| once with a new CertVerifier, which uses |shared_cache|
+  // if it is not NULL, as a new session would.
+  void VerifyWithNewVerifier(CertVerifyCache* shared_cache) {
+    CertVerifier verifier;
+    verifier.set_shared_cache(shared_cache);
+    CertVerifyResult verify_result;
+    TestCompletionCallback callback;
+    CertVerifier::RequestHandle request_handle;
+    int rv = verifier.Verify(cert_, "www.example.com", 0, NULL,
+                             &verify_result, callback.callback(),
+                             &request_handle, BoundNetLog());
+    rv = callback.GetResult(rv);
+    EXPECT_TRUE(IsCertificateError(rv));
+  }
+
+  scoped_ptr<MessageLoop> message_loop_;
+  ScopedTempDir temp_dir_;
+  scoped_refptr<X509Certificate> cert_;
+};
+
+}  // namespace
+
+// Measures the time from Verify() to the result when every session has to
+// build and verify the chain.
+TEST_F(CertVerifierPerfTest, ColdVerify) {
+  PerfTimeLogger timer("Cert_verifier_cold_verify");
+  for (int i = 0; i < kNumVerifications; ++i)
+    VerifyWithNewVerifier(NULL);
+  timer.Done();
+}
+
+// Measures the same with a warm cache, which was saved by a previous session
+// and mapped by this one.
+TEST_F(CertVerifierPerfTest, WarmSharedCacheVerify) {
+  FilePath path = temp_dir_.path().AppendASCII("Certificate Verifications");
+  scoped_refptr<CertVerifyCache> previous_cache(new CertVerifyCache(path));
+  VerifyWithNewVerifier(previous_cache);
+  ASSERT_TRUE(previous_cache->Save());
+
+  scoped_refptr<CertVerifyCache> shared_cache(new CertVerifyCache(path));
+  ASSERT_TRUE(shared_cache->Load());
+
+  PerfTimeLogger timer("Cert_verifier_warm_shared_cache_verify");
+  for (int i = 0; i < kNumVerifications; ++i)
+    VerifyWithNewVerifier(shared_cache);
+  timer.Done();
+}
+
+}  // namespace net
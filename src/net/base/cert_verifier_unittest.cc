@@ -8,6 +8,7 @@
 #include "base/file_path.h"
 #include "base/stringprintf.h"
 #include "net/base/cert_test_util.h"
+#include "net/base/cert_verify_cache.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/base/test_completion_callback.h"
@@ -73,6 +74,64 @@ TEST(CertVerifierTest, CacheHit) {
   ASSERT_EQ(1u, verifier.GetCacheSize());
 }
 
+// Tests that a result verified by one CertVerifier is served synchronously to
+// another one from their shared cache.
+TEST(CertVerifierTest, SharedCacheHit) {
+  scoped_refptr<CertVerifyCache> shared_cache(
+      new CertVerifyCache(FilePath()));
+
+  TestTimeService* time_service = new TestTimeService;
+  base::Time current_time = base::Time::Now();
+  time_service->set_current_time(current_time);
+  CertVerifier verifier(time_service);
+  verifier.set_shared_cache(shared_cache);
+
+  FilePath certs_dir = GetTestCertsDirectory();
+  scoped_refptr<X509Certificate> test_cert(
+      ImportCertFromFile(certs_dir, "ok_cert.pem"));
+  ASSERT_NE(static_cast<X509Certificate*>(NULL), test_cert);
+
+  int error;
+  CertVerifyResult verify_result;
+  TestCompletionCallback callback;
+  CertVerifier::RequestHandle request_handle;
+
+  error = verifier.Verify(test_cert, "www.example.com", 0, NULL, &verify_result,
+                          callback.callback(), &request_handle, BoundNetLog());
+  ASSERT_EQ(ERR_IO_PENDING, error);
+  ASSERT_TRUE(request_handle != NULL);
+  error = callback.WaitForResult();
+  ASSERT_TRUE(IsCertificateError(error));
+  ASSERT_EQ(1u, shared_cache->size());
+
+  TestTimeService* time_service2 = new TestTimeService;
+  time_service2->set_current_time(current_time);
+  CertVerifier verifier2(time_service2);
+  verifier2.set_shared_cache(shared_cache);
+
+  error = verifier2.Verify(test_cert, "www.example.com", 0, NULL,
+                           &verify_result, callback.callback(),
+                           &request_handle, BoundNetLog());
+  // Synchronous completion.
+  ASSERT_NE(ERR_IO_PENDING, error);
+  ASSERT_TRUE(IsCertificateError(error));
+  ASSERT_TRUE(request_handle == NULL);
+  ASSERT_EQ(1u, verifier2.requests());
+  ASSERT_EQ(0u, verifier2.cache_hits());
+  ASSERT_EQ(1u, verifier2.shared_cache_hits());
+  ASSERT_EQ(1u, verifier2.GetCacheSize());
+
+  // The result is now in the cache of |verifier2|.
+  error = verifier2.Verify(test_cert, "www.example.com", 0, NULL,
+                           &verify_result, callback.callback(),
+                           &request_handle, BoundNetLog());
+  ASSERT_TRUE(IsCertificateError(error));
+  ASSERT_TRUE(request_handle == NULL);
+  ASSERT_EQ(2u, verifier2.requests());
+  ASSERT_EQ(1u, verifier2.cache_hits());
+  ASSERT_EQ(1u, verifier2.shared_cache_hits());
+}
+
 // Tests the same server certificate with different intermediate CA
 // certificates.  These should be treated as different certificate chains even
 // though the two X509Certificate objects contain the same server certificate.
@@ -0,0 +1,427 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/cert_verify_cache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/pickle.h"
+#include "base/sha1.h"
+#include "base/threading/worker_pool.h"
+#include "net/base/crl_set.h"
+#include "net/base/x509_certificate.h"
+
+namespace net {
+
+namespace {
+
+// The number of entries kept in memory until the next Save().
+const size_t kMaxUnsavedEntries = 1024;
+
+const uint32 kFileMagic = 0x43565243;  // "CRVC"
+const uint32 kFileVersion = 1;
+
+// A cache file is a FileHeader, followed by |num_entries| IndexEntries sorted
+// by key, followed by the pickled CertVerifyResult of each entry.
+struct FileHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 num_entries;
+  uint32 reserved;
+};
+COMPILE_ASSERT(sizeof(FileHeader) == 16, bad_FileHeader);
+
+struct IndexEntry {
+  unsigned char key[20];
+  uint32 crl_set_sequence;
+  int64 expiry;  // The internal value of a base::Time.
+  int32 error;
+  uint32 data_offset;  // From the start of the file.
+  uint32 data_size;
+  uint32 reserved;
+};
+COMPILE_ASSERT(sizeof(IndexEntry) == 48, bad_IndexEntry);
+
+// The data of each entry starts at a multiple of kDataAlignment, so that it
+// can be read in place by Pickle.
+const size_t kDataAlignment = 8;
+
+class IndexEntryLessThan {
+ public:
+  bool operator() (const IndexEntry& lhs, const SHA1Fingerprint& rhs) const {
+    return memcmp(lhs.key, rhs.data, sizeof(rhs.data)) < 0;
+  }
+};
+
+// An entry as it is written to a cache file.
+struct Record {
+  uint32 crl_set_sequence;
+  int64 expiry;
+  int32 error;
+  std::string data;
+};
+
+uint32 GetSequence(const CRLSet* crl_set) {
+  return crl_set ? crl_set->sequence() : 0;
+}
+
+void PersistResult(const CertVerifyResult& result, Pickle* pickle) {
+  pickle->WriteUInt32(result.cert_status);
+  pickle->WriteBool(result.has_md5);
+  pickle->WriteBool(result.has_md2);
+  pickle->WriteBool(result.has_md4);
+  pickle->WriteBool(result.has_md5_ca);
+  pickle->WriteBool(result.has_md2_ca);
+  pickle->WriteBool(result.is_issued_by_known_root);
+  pickle->WriteInt(static_cast<int>(result.public_key_hashes.size()));
+  for (size_t i = 0; i < result.public_key_hashes.size(); ++i) {
+    pickle->WriteBytes(result.public_key_hashes[i].data,
+                       sizeof(result.public_key_hashes[i].data));
+  }
+  pickle->WriteBool(result.verified_cert != NULL);
+  if (result.verified_cert)
+    result.verified_cert->Persist(pickle);
+}
+
+bool ReadResult(const Pickle& pickle, CertVerifyResult* result) {
+  void* iter = NULL;
+  int num_hashes;
+  bool has_verified_cert;
+  if (!pickle.ReadUInt32(&iter, &result->cert_status) ||
+      !pickle.ReadBool(&iter, &result->has_md5) ||
+      !pickle.ReadBool(&iter, &result->has_md2) ||
+      !pickle.ReadBool(&iter, &result->has_md4) ||
+      !pickle.ReadBool(&iter, &result->has_md5_ca) ||
+      !pickle.ReadBool(&iter, &result->has_md2_ca) ||
+      !pickle.ReadBool(&iter, &result->is_issued_by_known_root) ||
+      !pickle.ReadInt(&iter, &num_hashes) ||
+      num_hashes < 0) {
+    return false;
+  }
+  result->public_key_hashes.clear();
+  for (int i = 0; i < num_hashes; ++i) {
+    const char* data;
+    SHA1Fingerprint hash;
+    if (!pickle.ReadBytes(&iter, &data, sizeof(hash.data)))
+      return false;
+    memcpy(hash.data, data, sizeof(hash.data));
+    result->public_key_hashes.push_back(hash);
+  }
+  if (!pickle.ReadBool(&iter, &has_verified_cert))
+    return false;
+  result->verified_cert = NULL;
+  if (has_verified_cert) {
+    result->verified_cert = X509Certificate::CreateFromPickle(
+        pickle, &iter, X509Certificate::PICKLETYPE_CERTIFICATE_CHAIN);
+    if (!result->verified_cert)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+CertVerifyCache::CertVerifyCache(const FilePath& path)
+    : path_(path),
+      num_mapped_entries_(0),
+      generation_(0) {
+}
+
+bool CertVerifyCache::Load() {
+  base::AutoLock locked(lock_);
+  return MapFile();
+}
+
+bool CertVerifyCache::Save() {
+  std::string contents;
+  EntryMap saved_entries;
+  uint32 generation;
+  {
+    base::AutoLock locked(lock_);
+    contents = Serialize(base::Time::Now());
+    saved_entries = entries_;
+    generation = generation_;
+  }
+
+  // The new file is written next to the old one, which may still be mapped.
+  FilePath temp_path(path_.value() + FILE_PATH_LITERAL(".tmp"));
+  int size = static_cast<int>(contents.size());
+  if (file_util::WriteFile(temp_path, contents.data(), size) != size) {
+    file_util::Delete(temp_path, false);
+    return false;
+  }
+
+  base::AutoLock locked(lock_);
+  if (generation != generation_) {
+    // The cache was cleared while the file was being written, so the file
+    // holds entries which must not be used anymore.
+    file_util::Delete(temp_path, false);
+    return false;
+  }
+
+  // The old file is unmapped first, since mapped files cannot be replaced on
+  // every platform.
+  file_.reset();
+  num_mapped_entries_ = 0;
+  bool moved = file_util::Move(temp_path, path_);
+  if (!moved)
+    file_util::Delete(temp_path, false);
+  if (!MapFile())
+    return false;
+
+  if (moved) {
+    // Entries which were written are now found in the file, unless they have
+    // been replaced in the meantime.
+    for (EntryMap::const_iterator it = saved_entries.begin();
+         it != saved_entries.end(); ++it) {
+      EntryMap::iterator entry = entries_.find(it->first);
+      if (entry != entries_.end() &&
+          entry->second.result.expiry == it->second.result.expiry) {
+        entries_.erase(entry);
+      }
+    }
+  }
+  return moved;
+}
+
+bool CertVerifyCache::Lookup(X509Certificate* cert,
+                             const std::string& hostname,
+                             int flags,
+                             const CRLSet* crl_set,
+                             base::Time now,
+                             CachedCertVerifyResult* result) {
+  const SHA1Fingerprint key = ComputeKey(cert, hostname, flags);
+  const uint32 sequence = GetSequence(crl_set);
+
+  base::AutoLock locked(lock_);
+  EntryMap::const_iterator it = entries_.find(key);
+  if (it != entries_.end()) {
+    if (it->second.crl_set_sequence != sequence ||
+        it->second.result.HasExpired(now)) {
+      return false;
+    }
+    *result = it->second.result;
+    return true;
+  }
+  return LookupMapped(key, sequence, now, result);
+}
+
+void CertVerifyCache::Insert(X509Certificate* cert,
+                             const std::string& hostname,
+                             int flags,
+                             const CRLSet* crl_set,
+                             const CachedCertVerifyResult& result) {
+  const SHA1Fingerprint key = ComputeKey(cert, hostname, flags);
+
+  base::AutoLock locked(lock_);
+  if (entries_.size() >= kMaxUnsavedEntries &&
+      entries_.find(key) == entries_.end()) {
+    // Like CertVerifier, drop the expired entries, or else the first one.
+    const base::Time now = base::Time::Now();
+    for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ) {
+      EntryMap::iterator cur = it++;
+      if (cur->second.result.HasExpired(now))
+        entries_.erase(cur);
+    }
+    if (entries_.size() >= kMaxUnsavedEntries)
+      entries_.erase(entries_.begin());
+  }
+
+  Entry& entry = entries_[key];
+  entry.crl_set_sequence = GetSequence(crl_set);
+  entry.result = result;
+}
+
+void CertVerifyCache::Clear() {
+  base::AutoLock locked(lock_);
+  file_.reset();
+  num_mapped_entries_ = 0;
+  entries_.clear();
+  generation_++;
+  // This may be called on a thread which is not allowed to block on file IO.
+  base::WorkerPool::PostTask(
+      FROM_HERE, base::Bind(&CertVerifyCache::DeleteFile, this, generation_),
+      false);
+}
+
+size_t CertVerifyCache::size() const {
+  base::AutoLock locked(lock_);
+  return num_mapped_entries_ + entries_.size();
+}
+
+CertVerifyCache::~CertVerifyCache() {}
+
+// static
+SHA1Fingerprint CertVerifyCache::ComputeKey(X509Certificate* cert,
+                                            const std::string& hostname,
+                                            int flags) {
+  const SHA1Fingerprint& cert_fingerprint = cert->fingerprint();
+  const SHA1Fingerprint& ca_fingerprint = cert->ca_fingerprint();
+  std::string input;
+  input.append(reinterpret_cast<const char*>(cert_fingerprint.data),
+               sizeof(cert_fingerprint.data));
+  input.append(reinterpret_cast<const char*>(ca_fingerprint.data),
+               sizeof(ca_fingerprint.data));
+  input.append(reinterpret_cast<const char*>(&flags), sizeof(flags));
+  input.append(hostname);
+
+  SHA1Fingerprint key;
+  base::SHA1HashBytes(reinterpret_cast<const unsigned char*>(input.data()),
+                      input.size(), key.data);
+  return key;
+}
+
+bool CertVerifyCache::LookupMapped(const SHA1Fingerprint& key,
+                                   uint32 crl_set_sequence,
+                                   base::Time now,
+                                   CachedCertVerifyResult* result) const {
+  if (!file_.get())
+    return false;
+
+  const IndexEntry* begin =
+      reinterpret_cast<const IndexEntry*>(file_->data() + sizeof(FileHeader));
+  const IndexEntry* end = begin + num_mapped_entries_;
+  const IndexEntry* entry =
+      std::lower_bound(begin, end, key, IndexEntryLessThan());
+  if (entry == end || memcmp(entry->key, key.data, sizeof(key.data)) != 0)
+    return false;
+
+  // The result is only decoded if it is usable.
+  if (entry->crl_set_sequence != crl_set_sequence ||
+      now >= base::Time::FromInternalValue(entry->expiry)) {
+    return false;
+  }
+  if (entry->data_offset > file_->length() ||
+      entry->data_size > file_->length() - entry->data_offset) {
+    return false;
+  }
+  Pickle pickle(
+      reinterpret_cast<const char*>(file_->data() + entry->data_offset),
+      entry->data_size);
+  if (!ReadResult(pickle, &result->result))
+    return false;
+  result->error = entry->error;
+  result->expiry = base::Time::FromInternalValue(entry->expiry);
+  return true;
+}
+
+std::string CertVerifyCache::Serialize(base::Time now) const {
+  typedef std::map<SHA1Fingerprint, Record, SHA1FingerprintLessThan> RecordMap;
+  RecordMap records;
+
+  if (file_.get()) {
+    const IndexEntry* index =
+        reinterpret_cast<const IndexEntry*>(file_->data() + sizeof(FileHeader));
+    for (size_t i = 0; i < num_mapped_entries_; ++i) {
+      const IndexEntry& entry = index[i];
+      if (now >= base::Time::FromInternalValue(entry.expiry))
+        continue;
+      if (entry.data_offset > file_->length() ||
+          entry.data_size > file_->length() - entry.data_offset) {
+        continue;
+      }
+      SHA1Fingerprint key;
+      memcpy(key.data, entry.key, sizeof(key.data));
+      Record& record = records[key];
+      record.crl_set_sequence = entry.crl_set_sequence;
+      record.expiry = entry.expiry;
+      record.error = entry.error;
+      record.data.assign(
+          reinterpret_cast<const char*>(file_->data() + entry.data_offset),
+          entry.data_size);
+    }
+  }
+
+  for (EntryMap::const_iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->second.result.HasExpired(now)) {
+      // An expired entry still supersedes the one in the file.
+      records.erase(it->first);
+      continue;
+    }
+    Pickle pickle;
+    PersistResult(it->second.result.result, &pickle);
+    Record& record = records[it->first];
+    record.crl_set_sequence = it->second.crl_set_sequence;
+    record.expiry = it->second.result.expiry.ToInternalValue();
+    record.error = it->second.result.error;
+    record.data.assign(static_cast<const char*>(pickle.data()), pickle.size());
+  }
+
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kFileMagic;
+  header.version = kFileVersion;
+  header.num_entries = static_cast<uint32>(records.size());
+
+  std::string index;
+  std::string data;
+  size_t data_start = sizeof(header) + records.size() * sizeof(IndexEntry);
+  for (RecordMap::const_iterator it = records.begin(); it != records.end();
+       ++it) {
+    // Pads the data of the previous entry.
+    size_t padding = (kDataAlignment - data.size() % kDataAlignment) %
+        kDataAlignment;
+    data.append(padding, '\0');
+
+    IndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.key, it->first.data, sizeof(entry.key));
+    entry.crl_set_sequence = it->second.crl_set_sequence;
+    entry.expiry = it->second.expiry;
+    entry.error = it->second.error;
+    entry.data_offset = static_cast<uint32>(data_start + data.size());
+    entry.data_size = static_cast<uint32>(it->second.data.size());
+    index.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    data.append(it->second.data);
+  }
+
+  std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+  contents.append(index);
+  contents.append(data);
+  return contents;
+}
+
+bool CertVerifyCache::MapFile() {
+  file_.reset();
+  num_mapped_entries_ = 0;
+  if (!file_util::PathExists(path_))
+    return false;
+
+  file_.reset(new file_util::MemoryMappedFile());
+  if (!file_->Initialize(path_) || file_->length() < sizeof(FileHeader)) {
+    file_.reset();
+    return false;
+  }
+
+  const FileHeader* header =
+      reinterpret_cast<const FileHeader*>(file_->data());
+  size_t max_entries =
+      (file_->length() - sizeof(FileHeader)) / sizeof(IndexEntry);
+  if (header->magic != kFileMagic || header->version != kFileVersion ||
+      header->num_entries > max_entries) {
+    LOG(WARNING) << "Invalid certificate verification cache file.";
+    file_.reset();
+    return false;
+  }
+  num_mapped_entries_ = header->num_entries;
+  return true;
+}
+
+void CertVerifyCache::DeleteFile(uint32 generation) {
+  base::AutoLock locked(lock_);
+  // A Save() which completed after the Clear() mapped a file without any of
+  // the cleared entries.
+  if (generation != generation_ || file_.get())
+    return;
+  file_util::Delete(path_, false);
+}
+
+}  // namespace net
@@ -0,0 +1,147 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_CERT_VERIFY_CACHE_H_
+#define NET_BASE_CERT_VERIFY_CACHE_H_
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/cert_verifier.h"
+#include "net/base/net_export.h"
+#include "net/base/x509_cert_types.h"
+
+namespace file_util {
+class MemoryMappedFile;
+}
+
+namespace net {
+
+class CRLSet;
+class X509Certificate;
+
+// CertVerifyCache is a cache of certificate verification results which
+// outlives the process. It can be shared by several CertVerifiers, which may
+// live on different threads.
+//
+// Results are kept in a file which is memory mapped by Load(). Lookups binary
+// search the index of the mapped file, so only the entries which are hit are
+// ever read and decoded. New results are kept in memory until Save() writes
+// them, along with the unexpired entries of the mapped file, to a new file.
+//
+// Entries are keyed by a hash of the certificate chain, the hostname and the
+// verification flags. Each entry records the sequence number of the CRLSet it
+// was verified against, and is not used by a verification against another
+// CRLSet, so that pushing a new CRLSet invalidates the whole cache.
+class NET_EXPORT CertVerifyCache
+    : public base::RefCountedThreadSafe<CertVerifyCache> {
+ public:
+  // |path| is the file which backs the cache. No file IO is done until Load()
+  // or Save() is called.
+  explicit CertVerifyCache(const FilePath& path);
+
+  // Maps the file at |path|. Returns false if the file does not exist or is
+  // not a valid cache file, in which case the cache starts out empty. Blocks
+  // on file IO.
+  bool Load();
+
+  // Writes all unexpired entries to |path|, and maps the new file. Blocks on
+  // file IO. Lookups from other threads are not blocked while the file is
+  // being written.
+  bool Save();
+
+  // Looks up the result of verifying |cert| for |hostname| with |flags|
+  // against |crl_set|, which may be NULL. Returns true and fills |result| if
+  // an entry which has not expired at |now| is found.
+  bool Lookup(X509Certificate* cert,
+              const std::string& hostname,
+              int flags,
+              const CRLSet* crl_set,
+              base::Time now,
+              CachedCertVerifyResult* result);
+
+  // Stores |result| as the result of verifying |cert| for |hostname| with
+  // |flags| against |crl_set|, which may be NULL.
+  void Insert(X509Certificate* cert,
+              const std::string& hostname,
+              int flags,
+              const CRLSet* crl_set,
+              const CachedCertVerifyResult& result);
+
+  // Drops every entry, including those of the mapped file, and deletes the
+  // file in the background, so that the entries are not loaded again by the
+  // next session. A Save() which is already writing the file fails.
+  void Clear();
+
+  // Returns the number of entries, counting the mapped ones whether or not
+  // they have been superseded or have expired.
+  size_t size() const;
+
+ private:
+  friend class base::RefCountedThreadSafe<CertVerifyCache>;
+
+  struct Entry {
+    uint32 crl_set_sequence;
+    CachedCertVerifyResult result;
+  };
+
+  typedef std::map<SHA1Fingerprint, Entry, SHA1FingerprintLessThan> EntryMap;
+
+  ~CertVerifyCache();
+
+  // Returns the key of the verification of |cert| for |hostname| with
+  // |flags|.
+  static SHA1Fingerprint ComputeKey(X509Certificate* cert,
+                                    const std::string& hostname,
+                                    int flags);
+
+  // Looks up |key| in the mapped file, like Lookup(). |lock_| must be held.
+  bool LookupMapped(const SHA1Fingerprint& key,
+                    uint32 crl_set_sequence,
+                    base::Time now,
+                    CachedCertVerifyResult* result) const;
+
+  // Returns the contents of a cache file holding the entries which have not
+  // expired at |now|. |lock_| must be held.
+  std::string Serialize(base::Time now) const;
+
+  // Maps |path_|, and checks that it is a valid cache file. |lock_| must be
+  // held.
+  bool MapFile();
+
+  // Deletes |path_|, unless the cache was cleared again or saved since the
+  // Clear() which started generation |generation|. Blocks on file IO.
+  void DeleteFile(uint32 generation);
+
+  const FilePath path_;
+
+  // |lock_| protects all the members below.
+  mutable base::Lock lock_;
+
+  // The mapped cache file, or NULL if there is none.
+  scoped_ptr<file_util::MemoryMappedFile> file_;
+  // The number of entries in the index of |file_|.
+  size_t num_mapped_entries_;
+
+  // Entries which are not in |file_| yet. They supersede the entries of
+  // |file_| with the same key.
+  EntryMap entries_;
+
+  // Incremented by every Clear(), so that a Save() can tell whether the data
+  // it wrote is still current.
+  uint32 generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(CertVerifyCache);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_CERT_VERIFY_CACHE_H_
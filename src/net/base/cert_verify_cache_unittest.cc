@@ -0,0 +1,215 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/cert_verify_cache.h"
+
+#include <string>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/string_piece.h"
+#include "base/threading/platform_thread.h"
+#include "net/base/cert_status_flags.h"
+#include "net/base/cert_test_util.h"
+#include "net/base/crl_set.h"
+#include "net/base/net_errors.h"
+#include "net/base/x509_certificate.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Returns a CRLSet with no CRLs and the given |sequence| number.
+scoped_refptr<CRLSet> MakeCRLSet(int sequence) {
+  std::string header = base::StringPrintf(
+      "{\"Version\":0,\"ContentType\":\"CRLSet\",\"Sequence\":%d}", sequence);
+  std::string data;
+  data.push_back(static_cast<char>(header.size() & 0xff));
+  data.push_back(static_cast<char>(header.size() >> 8));
+  data.append(header);
+
+  scoped_refptr<CRLSet> crl_set;
+  EXPECT_TRUE(CRLSet::Parse(data, &crl_set));
+  return crl_set;
+}
+
+class CertVerifyCacheTest : public testing::Test {
+ public:
+  virtual void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    cert_ = ImportCertFromFile(GetTestCertsDirectory(), "ok_cert.pem");
+    ASSERT_NE(static_cast<X509Certificate*>(NULL), cert_);
+
+    now_ = base::Time::Now();
+    result_.error = ERR_CERT_AUTHORITY_INVALID;
+    result_.result.verified_cert = cert_;
+    result_.result.cert_status = CERT_STATUS_AUTHORITY_INVALID;
+    result_.result.is_issued_by_known_root = false;
+    result_.result.public_key_hashes.push_back(cert_->fingerprint());
+    result_.expiry = now_ + base::TimeDelta::FromMinutes(30);
+  }
+
+ protected:
+  FilePath cache_path() const {
+    return temp_dir_.path().AppendASCII("Certificate Verifications");
+  }
+
+  ScopedTempDir temp_dir_;
+  scoped_refptr<X509Certificate> cert_;
+  base::Time now_;
+  CachedCertVerifyResult result_;
+};
+
+}  // namespace
+
+TEST_F(CertVerifyCacheTest, InsertAndLookup) {
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  CachedCertVerifyResult result;
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, NULL, now_, &result));
+
+  cache->Insert(cert_, "www.example.com", 0, NULL, result_);
+  EXPECT_EQ(1u, cache->size());
+  ASSERT_TRUE(cache->Lookup(cert_, "www.example.com", 0, NULL, now_, &result));
+  EXPECT_EQ(ERR_CERT_AUTHORITY_INVALID, result.error);
+  EXPECT_EQ(CERT_STATUS_AUTHORITY_INVALID, result.result.cert_status);
+
+  // The hostname and the flags are part of the key.
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.org", 0, NULL, now_, &result));
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com",
+                             X509Certificate::VERIFY_EV_CERT, NULL, now_,
+                             &result));
+
+  // Expired entries are not used.
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, NULL,
+                             result_.expiry, &result));
+
+  cache->Clear();
+  EXPECT_EQ(0u, cache->size());
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, NULL, now_, &result));
+}
+
+TEST_F(CertVerifyCacheTest, SaveAndLoad) {
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  EXPECT_FALSE(cache->Load());
+  cache->Insert(cert_, "www.example.com", 0, NULL, result_);
+  ASSERT_TRUE(cache->Save());
+  EXPECT_TRUE(file_util::PathExists(cache_path()));
+
+  // The saved entry is now served from the mapped file.
+  EXPECT_EQ(1u, cache->size());
+  CachedCertVerifyResult result;
+  EXPECT_TRUE(cache->Lookup(cert_, "www.example.com", 0, NULL, now_, &result));
+
+  scoped_refptr<CertVerifyCache> loaded_cache(
+      new CertVerifyCache(cache_path()));
+  ASSERT_TRUE(loaded_cache->Load());
+  EXPECT_EQ(1u, loaded_cache->size());
+  ASSERT_TRUE(loaded_cache->Lookup(cert_, "www.example.com", 0, NULL, now_,
+                                   &result));
+  EXPECT_EQ(ERR_CERT_AUTHORITY_INVALID, result.error);
+  EXPECT_EQ(CERT_STATUS_AUTHORITY_INVALID, result.result.cert_status);
+  EXPECT_FALSE(result.result.is_issued_by_known_root);
+  EXPECT_TRUE(result_.expiry == result.expiry);
+  ASSERT_EQ(1u, result.result.public_key_hashes.size());
+  EXPECT_TRUE(result.result.public_key_hashes[0].Equals(cert_->fingerprint()));
+  ASSERT_TRUE(result.result.verified_cert != NULL);
+  EXPECT_TRUE(result.result.verified_cert->Equals(cert_));
+  EXPECT_FALSE(loaded_cache->Lookup(cert_, "www.example.org", 0, NULL, now_,
+                                    &result));
+
+  // Saving again keeps the entries of the mapped file, and adds the new ones.
+  loaded_cache->Insert(cert_, "www.example.org", 0, NULL, result_);
+  ASSERT_TRUE(loaded_cache->Save());
+  EXPECT_EQ(2u, loaded_cache->size());
+  EXPECT_TRUE(loaded_cache->Lookup(cert_, "www.example.com", 0, NULL, now_,
+                                   &result));
+  EXPECT_TRUE(loaded_cache->Lookup(cert_, "www.example.org", 0, NULL, now_,
+                                   &result));
+}
+
+TEST_F(CertVerifyCacheTest, SaveDropsExpiredEntries) {
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  CachedCertVerifyResult expired_result = result_;
+  expired_result.expiry = now_ - base::TimeDelta::FromMinutes(1);
+  cache->Insert(cert_, "www.example.com", 0, NULL, expired_result);
+  cache->Insert(cert_, "www.example.org", 0, NULL, result_);
+  ASSERT_TRUE(cache->Save());
+
+  scoped_refptr<CertVerifyCache> loaded_cache(
+      new CertVerifyCache(cache_path()));
+  ASSERT_TRUE(loaded_cache->Load());
+  EXPECT_EQ(1u, loaded_cache->size());
+}
+
+// Tests that a cleared cache is not loaded again by the next session.
+TEST_F(CertVerifyCacheTest, ClearDeletesFile) {
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  cache->Insert(cert_, "www.example.com", 0, NULL, result_);
+  ASSERT_TRUE(cache->Save());
+  cache->Clear();
+
+  // The file is deleted on a worker thread.
+  for (int i = 0; i < 1000 && file_util::PathExists(cache_path()); ++i)
+    base::PlatformThread::Sleep(10);
+  EXPECT_FALSE(file_util::PathExists(cache_path()));
+
+  scoped_refptr<CertVerifyCache> loaded_cache(
+      new CertVerifyCache(cache_path()));
+  EXPECT_FALSE(loaded_cache->Load());
+  CachedCertVerifyResult result;
+  EXPECT_FALSE(loaded_cache->Lookup(cert_, "www.example.com", 0, NULL, now_,
+                                    &result));
+}
+
+// Tests that results verified against another CRLSet are not used.
+TEST_F(CertVerifyCacheTest, CRLSetSequence) {
+  scoped_refptr<CRLSet> crl_set1 = MakeCRLSet(1);
+  scoped_refptr<CRLSet> crl_set2 = MakeCRLSet(2);
+  ASSERT_TRUE(crl_set1.get());
+  ASSERT_TRUE(crl_set2.get());
+
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  cache->Insert(cert_, "www.example.com", 0, crl_set1, result_);
+  CachedCertVerifyResult result;
+  EXPECT_TRUE(cache->Lookup(cert_, "www.example.com", 0, crl_set1, now_,
+                            &result));
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, crl_set2, now_,
+                             &result));
+
+  ASSERT_TRUE(cache->Save());
+  EXPECT_TRUE(cache->Lookup(cert_, "www.example.com", 0, crl_set1, now_,
+                            &result));
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, crl_set2, now_,
+                             &result));
+
+  // A result verified against the new CRLSet replaces the old one.
+  cache->Insert(cert_, "www.example.com", 0, crl_set2, result_);
+  EXPECT_FALSE(cache->Lookup(cert_, "www.example.com", 0, crl_set1, now_,
+                             &result));
+  EXPECT_TRUE(cache->Lookup(cert_, "www.example.com", 0, crl_set2, now_,
+                            &result));
+}
+
+TEST_F(CertVerifyCacheTest, InvalidFile) {
+  static const char kGarbage[] = "not a certificate verification cache";
+  ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+            file_util::WriteFile(cache_path(), kGarbage, sizeof(kGarbage)));
+
+  scoped_refptr<CertVerifyCache> cache(new CertVerifyCache(cache_path()));
+  EXPECT_FALSE(cache->Load());
+  EXPECT_EQ(0u, cache->size());
+
+  // The invalid file is replaced by the next Save().
+  cache->Insert(cert_, "www.example.com", 0, NULL, result_);
+  ASSERT_TRUE(cache->Save());
+  scoped_refptr<CertVerifyCache> loaded_cache(
+      new CertVerifyCache(cache_path()));
+  EXPECT_TRUE(loaded_cache->Load());
+  EXPECT_EQ(1u, loaded_cache->size());
+}
+
+}  // namespace net
@@ -108,6 +108,11 @@ typedef std::vector<CookieMonster::CanonicalCookie*> CanonicalCookieVector;
 // will update it again.
 const int kDefaultAccessUpdateThresholdSeconds = 60;
 
+// The number of hosts beyond which the host index and the cache of the keys of
+// hosts are dropped, so that they don't grow without bound.  The hosts visited
+// in a session are usually far fewer.
+const size_t kMaxIndexedHosts = 2000;
+
 // Comparator to sort cookies from highest creation date to lowest
 // creation date.
 struct OrderByCreationTimeDesc {
@@ -365,6 +370,7 @@ CookieMonster::CookieMonster(PersistentCookieStore* store, Delegate* delegate)
     : initialized_(false),
       loaded_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
+      indexed_hosts_(0),
       store_(store),
       last_access_threshold_(
           TimeDelta::FromSeconds(kDefaultAccessUpdateThresholdSeconds)),
@@ -382,6 +388,7 @@ CookieMonster::CookieMonster(PersistentCookieStore* store,
     : initialized_(false),
       loaded_(false),
       expiry_and_key_scheme_(expiry_and_key_default_),
+      indexed_hosts_(0),
       store_(store),
       last_access_threshold_(base::TimeDelta::FromMilliseconds(
           last_access_threshold_milliseconds)),
@@ -1671,34 +1678,11 @@ void CookieMonster::FindCookiesForHostAndDomain(
     FindCookiesForKey(key, url, options, current_time,
                       update_access_time, cookies);
   } else {
-    // Need to probe for all domains that might have relevant
-    // cookies for us.
-
-    // Query for the full host, For example: 'a.c.blah.com'.
-    std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time, update_access_time,
-                      cookies);
-
-    // See if we can search for domain cookies, i.e. if the host has a TLD + 1.
-    const std::string domain(cookie_util::GetEffectiveDomain(url.scheme(),
-                                                              key));
-    if (domain.empty())
-      return;
-    DCHECK_LE(domain.length(), key.length());
-    DCHECK_EQ(0, key.compare(key.length() - domain.length(), domain.length(),
-                             domain));
-
-    // Walk through the string and query at the dot points (GURL should have
-    // canonicalized the dots, so this should be safe).  Stop once we reach the
-    // domain + registry; we can't write cookies past this point, and with some
-    // registrars other domains can, in which case we don't want to read their
-    // cookies.
-    for (key = "." + key; key.length() > domain.length(); ) {
-      FindCookiesForKey(key, url, options, current_time, update_access_time,
-                        cookies);
-      const size_t next_dot = key.find('.', 1);  // Skip over leading dot.
-      key.erase(0, next_dot);
-    }
+    // All of the cookies which can apply to the host, host cookies and domain
+    // cookies alike, are under the key of its eTLD+1.
+    const std::string key(GetCachedKey(url.host()));
+    FindCookiesForIndexedHost(key, url, options, current_time,
+                              update_access_time, cookies);
   }
 }
 
@@ -1752,6 +1736,119 @@ void CookieMonster::FindCookiesForKey(
   }
 }
 
+void CookieMonster::FindCookiesForIndexedHost(
+    const std::string& key,
+    const GURL& url,
+    const CookieOptions& options,
+    const Time& current,
+    bool update_access_time,
+    std::vector<CanonicalCookie*>* cookies) {
+  lock_.AssertAcquired();
+  DCHECK_EQ(EKS_KEEP_RECENT_AND_PURGE_ETLDP1, expiry_and_key_scheme_);
+
+  const std::string path(url.path());
+  bool secure = url.SchemeIsSecure();
+
+  // Deleting a cookie invalidates the index entry being walked, so expired
+  // cookies are only deleted once the walk is done.
+  std::vector<CanonicalCookie*> expired_cookies;
+  const std::vector<CanonicalCookie*>& candidates =
+      GetIndexedCookiesForHost(key, url.host());
+  for (std::vector<CanonicalCookie*>::const_iterator it = candidates.begin();
+       it != candidates.end(); ++it) {
+    CanonicalCookie* cc = *it;
+
+    if (cc->IsExpired(current) && !keep_expired_cookies_) {
+      expired_cookies.push_back(cc);
+      continue;
+    }
+
+    // Filter out HttpOnly cookies, per options.
+    if (options.exclude_httponly() && cc->IsHttpOnly())
+      continue;
+
+    // Filter out secure cookies unless we're https.
+    if (!secure && cc->IsSecure())
+      continue;
+
+    if (!cc->IsOnPath(path))
+      continue;
+
+    // Add this cookie to the set of matching cookies.  Update the access
+    // time if we've been requested to do so.
+    if (update_access_time) {
+      InternalUpdateCookieAccessTime(cc, current);
+    }
+    cookies->push_back(cc);
+  }
+
+  for (std::vector<CanonicalCookie*>::const_iterator it =
+           expired_cookies.begin();
+       it != expired_cookies.end(); ++it) {
+    for (CookieMapItPair its = cookies_.equal_range(key);
+         its.first != its.second; ++its.first) {
+      if (its.first->second == *it) {
+        InternalDeleteCookie(its.first, true, DELETE_COOKIE_EXPIRED);
+        break;
+      }
+    }
+  }
+}
+
+const std::vector<CookieMonster::CanonicalCookie*>&
+CookieMonster::GetIndexedCookiesForHost(const std::string& key,
+                                        const std::string& host) {
+  lock_.AssertAcquired();
+
+  HostIndex::iterator key_it = host_index_.find(key);
+  if (key_it != host_index_.end()) {
+    HostCookies::const_iterator host_it = key_it->second.find(host);
+    if (host_it != key_it->second.end())
+      return host_it->second;
+  }
+
+  if (indexed_hosts_ >= kMaxIndexedHosts) {
+    host_index_.clear();
+    indexed_hosts_ = 0;
+    key_it = host_index_.end();
+  }
+  if (key_it == host_index_.end())
+    key_it = host_index_.insert(std::make_pair(key, HostCookies())).first;
+
+  std::vector<CanonicalCookie*>& host_cookies = key_it->second[host];
+  indexed_hosts_++;
+  const std::string scheme;  // IsDomainMatch() doesn't look at the scheme.
+  for (CookieMapItPair its = cookies_.equal_range(key);
+       its.first != its.second; ++its.first) {
+    if (its.first->second->IsDomainMatch(scheme, host))
+      host_cookies.push_back(its.first->second);
+  }
+  return host_cookies;
+}
+
+const std::string& CookieMonster::GetCachedKey(const std::string& host) {
+  lock_.AssertAcquired();
+
+  std::map<std::string, std::string>::const_iterator it =
+      host_keys_.find(host);
+  if (it != host_keys_.end())
+    return it->second;
+
+  if (host_keys_.size() >= kMaxIndexedHosts)
+    host_keys_.clear();
+  return host_keys_[host] = GetKey(host);
+}
+
+void CookieMonster::InvalidateHostIndex(const std::string& key) {
+  lock_.AssertAcquired();
+
+  HostIndex::iterator it = host_index_.find(key);
+  if (it == host_index_.end())
+    return;
+  indexed_hosts_ -= it->second.size();
+  host_index_.erase(it);
+}
+
 bool CookieMonster::DeleteAnyEquivalentCookie(const std::string& key,
                                               const CanonicalCookie& ecc,
                                               bool skip_httponly,
@@ -1792,6 +1889,7 @@ void CookieMonster::InternalInsertCookie(const std::string& key,
       store_ && sync_to_store)
     store_->AddCookie(*cc);
   cookies_.insert(CookieMap::value_type(key, cc));
+  InvalidateHostIndex(key);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(
         *cc, false, CookieMonster::Delegate::CHANGE_COOKIE_EXPLICIT);
@@ -1937,6 +2035,7 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
     if (mapping.notify)
       delegate_->OnCookieChanged(*cc, true, mapping.cause);
   }
+  InvalidateHostIndex(it->first);
   cookies_.erase(it);
   delete cc;
 }
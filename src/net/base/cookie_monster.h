@@ -512,6 +512,32 @@ class NET_EXPORT CookieMonster : public CookieStore {
                          bool update_access_time,
                          std::vector<CanonicalCookie*>* cookies);
 
+  // Like FindCookiesForKey(), but only considers the cookies under |key| that
+  // domain match |url|'s host, which are looked up in |host_index_| rather
+  // than by walking every cookie under |key|.  Only valid with
+  // EKS_KEEP_RECENT_AND_PURGE_ETLDP1, where all of the cookies which can
+  // apply to a host are under the single key of its eTLD+1.
+  void FindCookiesForIndexedHost(const std::string& key,
+                                 const GURL& url,
+                                 const CookieOptions& options,
+                                 const base::Time& current,
+                                 bool update_access_time,
+                                 std::vector<CanonicalCookie*>* cookies);
+
+  // Returns the cookies under |key| that domain match |host|, building the
+  // entry of |host_index_| for them if there is none.
+  const std::vector<CanonicalCookie*>& GetIndexedCookiesForHost(
+      const std::string& key,
+      const std::string& host);
+
+  // Returns GetKey(|host|), which is cached in |host_keys_| as it involves a
+  // lookup in the registry of effective TLDs.
+  const std::string& GetCachedKey(const std::string& host);
+
+  // Drops the entries of |host_index_| for the hosts under |key|, as the
+  // cookies under |key| have changed.
+  void InvalidateHostIndex(const std::string& key);
+
   // Delete any cookies that are equivalent to |ecc| (same path, domain, etc).
   // If |skip_httponly| is true, httponly cookies will not be deleted.  The
   // return value with be true if |skip_httponly| skipped an httponly cookie.
@@ -622,6 +648,21 @@ class NET_EXPORT CookieMonster : public CookieStore {
 
   CookieMap cookies_;
 
+  // For each key of |cookies_|, the hosts which cookies have been looked up
+  // for, and the cookies under the key which domain match each of them.
+  // The cookies still need to be filtered by path, security, and expiry.
+  // The entries of a key are dropped whenever a cookie is inserted under it
+  // or deleted from it, and the whole index is dropped when it grows past
+  // kMaxIndexedHosts hosts.
+  typedef std::map<std::string, std::vector<CanonicalCookie*> > HostCookies;
+  typedef std::map<std::string, HostCookies> HostIndex;
+  HostIndex host_index_;
+  size_t indexed_hosts_;
+
+  // The keys of the hosts which cookies have been looked up for; see
+  // GetCachedKey().  Dropped when it grows past kMaxIndexedHosts hosts.
+  std::map<std::string, std::string> host_keys_;
+
   // Indicates whether the cookie store has been initialized. This happens
   // lazily in InitStoreIfNecessary().
   bool initialized_;
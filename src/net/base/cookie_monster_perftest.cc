@@ -110,6 +110,23 @@ class GetCookiesCallback : public BaseCallback {
   net::CookieOptions options_;
 };
 
+class GetAllCookiesCallback : public BaseCallback {
+ public:
+  const CookieList& GetAllCookies(CookieMonster* cm) {
+    cm->GetAllCookiesAsync(base::Bind(
+        &GetAllCookiesCallback::Run, base::Unretained(this)));
+    WaitForCallback();
+    return cookies_;
+  }
+
+ private:
+  void Run(const CookieList& cookies) {
+    cookies_ = cookies;
+    BaseCallback::Run();
+  }
+  CookieList cookies_;
+};
+
 class GetCookiesWithInfoCallback : public BaseCallback {
  public:
   const std::string& GetCookiesWithInfo(CookieMonster* cm, const GURL& gurl) {
@@ -321,6 +338,54 @@ TEST_F(CookieMonsterTest, TestDomainLine) {
   timer2.Done();
 }
 
+// Queries a store close to its size limit, shaped like a real profile: many
+// domains, each with a few domain cookies and host cookies on several of its
+// hosts.
+TEST_F(CookieMonsterTest, TestQueryFullStore) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  SetCookieCallback setCookieCallback;
+  GetCookiesCallback getCookiesCallback;
+  GetAllCookiesCallback getAllCookiesCallback;
+  const int kNumDomains = 100;
+  const int kHostsPerDomain = 10;
+  const int kDomainCookiesPerDomain = 10;
+  const int kCookiesPerHost = 2;
+
+  std::vector<GURL> gurls;
+  for (int domain_num = 0; domain_num < kNumDomains; domain_num++) {
+    const std::string domain(base::StringPrintf("domain%d.izzle", domain_num));
+    for (int host_num = 0; host_num < kHostsPerDomain; host_num++) {
+      GURL gurl(base::StringPrintf("https://host%d.%s/", host_num,
+                                   domain.c_str()));
+      gurls.push_back(gurl);
+      for (int cookie_num = 0; cookie_num < kCookiesPerHost; cookie_num++) {
+        setCookieCallback.SetCookie(
+            cm, gurl, base::StringPrintf("h%d=v; path=/", cookie_num));
+      }
+    }
+    for (int cookie_num = 0; cookie_num < kDomainCookiesPerDomain;
+         cookie_num++) {
+      setCookieCallback.SetCookie(
+          cm, gurls.back(),
+          base::StringPrintf("d%d=v; path=/; domain=.%s", cookie_num,
+                             domain.c_str()));
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumDomains * (kHostsPerDomain *
+                                               kCookiesPerHost +
+                                               kDomainCookiesPerDomain)),
+            getAllCookiesCallback.GetAllCookies(cm).size());
+
+  std::string cookie_line = getCookiesCallback.GetCookies(cm, gurls[0]);
+  EXPECT_EQ(kCookiesPerHost + kDomainCookiesPerDomain,
+            CountInString(cookie_line, '=')) << "Cookie line: " << cookie_line;
+
+  PerfTimeLogger timer("Cookie_monster_query_full_store");
+  for (int i = 0; i < kNumCookies; i++)
+    getCookiesCallback.GetCookies(cm, gurls[(i * 7) % gurls.size()]);
+  timer.Done();
+}
+
 TEST_F(CookieMonsterTest, TestImport) {
   scoped_refptr<MockPersistentCookieStore> store(new MockPersistentCookieStore);
   std::vector<CookieMonster::CanonicalCookie*> initial_cookies;
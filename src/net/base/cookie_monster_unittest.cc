@@ -2082,6 +2082,39 @@ TEST_F(CookieMonsterTest, TestDeleteSingleCookie) {
   EXPECT_EQ("A=B; E=F", GetCookies(cm, url_google_));
 }
 
+// The cookies which apply to a host are remembered between lookups; make sure
+// that cookies set or deleted on other hosts of the same domain are seen.
+TEST_F(CookieMonsterTest, LookupsAfterChangesOnOtherHosts) {
+  scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
+  GURL url_google_specific(kUrlGoogleSpecific);
+
+  EXPECT_TRUE(SetCookie(cm, url_google_, "A=B"));
+  EXPECT_EQ("A=B", GetCookies(cm, url_google_));
+  EXPECT_EQ("", GetCookies(cm, url_google_specific));
+
+  EXPECT_TRUE(SetCookie(cm, url_google_specific, "C=D; domain=.google.izzle"));
+  EXPECT_EQ("A=B; C=D", GetCookies(cm, url_google_));
+  EXPECT_EQ("C=D", GetCookies(cm, url_google_specific));
+
+  EXPECT_TRUE(SetCookie(cm, url_google_specific, "E=F"));
+  EXPECT_EQ("A=B; C=D", GetCookies(cm, url_google_));
+  EXPECT_EQ("C=D; E=F", GetCookies(cm, url_google_specific));
+
+  // Overwriting and expiring a domain cookie.
+  EXPECT_TRUE(SetCookie(cm, url_google_, "C=G; domain=.google.izzle"));
+  EXPECT_EQ("A=B; C=G", GetCookies(cm, url_google_));
+  EXPECT_EQ("E=F; C=G", GetCookies(cm, url_google_specific));
+  EXPECT_TRUE(SetCookie(cm, url_google_,
+                        "C=G; domain=.google.izzle; "
+                        "expires=Mon, 18-Apr-1977 22:50:13 GMT"));
+  EXPECT_EQ("A=B", GetCookies(cm, url_google_));
+  EXPECT_EQ("E=F", GetCookies(cm, url_google_specific));
+
+  EXPECT_EQ(2, DeleteAll(cm));
+  EXPECT_EQ("", GetCookies(cm, url_google_));
+  EXPECT_EQ("", GetCookies(cm, url_google_specific));
+}
+
 TEST_F(CookieMonsterTest, SetCookieableSchemes) {
   scoped_refptr<CookieMonster> cm(new CookieMonster(NULL, NULL));
   scoped_refptr<CookieMonster> cm_foo(new CookieMonster(NULL, NULL));
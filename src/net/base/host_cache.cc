@@ -27,27 +27,51 @@ HostCache::HostCache(size_t max_entries,
                      base::TimeDelta failure_entry_ttl)
     : max_entries_(max_entries),
       success_entry_ttl_(success_entry_ttl),
-      failure_entry_ttl_(failure_entry_ttl) {
+      failure_entry_ttl_(failure_entry_ttl),
+      entries_(max_entries) {
 }
 
 HostCache::~HostCache() {
 }
 
 const HostCache::Entry* HostCache::Lookup(const Key& key,
-                                          base::TimeTicks now) const {
+                                          base::TimeTicks now) {
   DCHECK(CalledOnValidThread());
   if (caching_is_disabled())
     return NULL;
 
-  EntryMap::const_iterator it = entries_.find(key);
+  // Only usable entries count as used, so that expired ones are evicted
+  // first.
+  EntryMap::iterator it = entries_.Peek(key);
+  if (it == entries_.end() || !CanUseEntry(it->second.get(), now))
+    return NULL;
+
+  return entries_.Get(key)->second.get();
+}
+
+const HostCache::Entry* HostCache::LookupStale(const Key& key,
+                                               base::TimeTicks now,
+                                               bool* is_stale) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(is_stale);
+  *is_stale = false;
+  if (caching_is_disabled())
+    return NULL;
+
+  EntryMap::iterator it = entries_.Peek(key);
   if (it == entries_.end())
-    return NULL;  // Not found.
+    return NULL;
 
   Entry* entry = it->second.get();
-  if (CanUseEntry(entry, now))
-    return entry;
+  if (!CanUseEntry(entry, now)) {
+    // Failures are never served stale, as there would be nothing to gain.
+    if (entry->error != OK || entry->expiration + max_stale_age_ <= now)
+      return NULL;
+    *is_stale = true;
+  }
 
-  return NULL;
+  entries_.Get(key);
+  return entry;
 }
 
 HostCache::Entry* HostCache::Set(const Key& key,
@@ -61,29 +85,26 @@ HostCache::Entry* HostCache::Set(const Key& key,
   base::TimeTicks expiration = now +
       (error == OK ? success_entry_ttl_ : failure_entry_ttl_);
 
-  scoped_refptr<Entry>& entry = entries_[key];
-  if (!entry) {
-    // Entry didn't exist, creating one now.
-    Entry* ptr = new Entry(error, addrlist, expiration);
-    entry = ptr;
-
-    // Compact the cache if we grew it beyond limit -- exclude |entry| from
-    // being pruned though!
-    if (entries_.size() > max_entries_)
-      Compact(now, ptr);
-    return ptr;
-  } else {
-    // Update an existing cache entry.
-    entry->error = error;
-    entry->addrlist = addrlist;
-    entry->expiration = expiration;
-    return entry.get();
+  EntryMap::iterator it = entries_.Get(key);
+  if (it == entries_.end()) {
+    // Entry didn't exist, creating one now. The least recently used entry is
+    // evicted if the cache is full.
+    Entry* entry = new Entry(error, addrlist, expiration);
+    entries_.Put(key, entry);
+    return entry;
   }
+
+  // Update an existing cache entry.
+  Entry* entry = it->second.get();
+  entry->error = error;
+  entry->addrlist = addrlist;
+  entry->expiration = expiration;
+  return entry;
 }
 
 void HostCache::clear() {
   DCHECK(CalledOnValidThread());
-  entries_.clear();
+  entries_.Clear();
 }
 
 size_t HostCache::size() const {
@@ -106,6 +127,16 @@ base::TimeDelta HostCache::failure_entry_ttl() const {
   return failure_entry_ttl_;
 }
 
+base::TimeDelta HostCache::max_stale_age() const {
+  DCHECK(CalledOnValidThread());
+  return max_stale_age_;
+}
+
+void HostCache::set_max_stale_age(base::TimeDelta max_stale_age) {
+  DCHECK(CalledOnValidThread());
+  max_stale_age_ = max_stale_age;
+}
+
 // Note that this map may contain expired entries.
 const HostCache::EntryMap& HostCache::entries() const {
   DCHECK(CalledOnValidThread());
@@ -129,36 +160,4 @@ HostCache* HostCache::CreateDefaultCache() {
   return cache;
 }
 
-void HostCache::Compact(base::TimeTicks now, const Entry* pinned_entry) {
-  // Clear out expired entries.
-  for (EntryMap::iterator it = entries_.begin(); it != entries_.end(); ) {
-    Entry* entry = (it->second).get();
-    if (entry != pinned_entry && !CanUseEntry(entry, now)) {
-      entries_.erase(it++);
-    } else {
-      ++it;
-    }
-  }
-
-  if (entries_.size() <= max_entries_)
-    return;
-
-  // If we still have too many entries, start removing unexpired entries
-  // at random.
-  // TODO(eroman): this eviction policy could be better (access count FIFO
-  // or whatever).
-  for (EntryMap::iterator it = entries_.begin();
-       it != entries_.end() && entries_.size() > max_entries_; ) {
-    Entry* entry = (it->second).get();
-    if (entry != pinned_entry) {
-      entries_.erase(it++);
-    } else {
-      ++it;
-    }
-  }
-
-  if (entries_.size() > max_entries_)
-    DLOG(WARNING) << "Still above max entries limit";
-}
-
 }  // namespace net
@@ -6,10 +6,10 @@
 #define NET_BASE_HOST_CACHE_H_
 #pragma once
 
-#include <map>
 #include <string>
 
 #include "base/gtest_prod_util.h"
+#include "base/memory/mru_cache.h"
 #include "base/memory/ref_counted.h"
 #include "base/threading/non_thread_safe.h"
 #include "base/time.h"
@@ -71,11 +71,14 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
     HostResolverFlags host_resolver_flags;
   };
 
-  typedef std::map<Key, scoped_refptr<Entry> > EntryMap;
+  // The entries, ordered from the most recently used to the least recently
+  // used one.
+  typedef base::MRUCache<Key, scoped_refptr<Entry> > EntryMap;
 
   // Constructs a HostCache that caches successful host resolves for
   // |success_entry_ttl| time, and failed host resolves for
-  // |failure_entry_ttl|. The cache will store up to |max_entries|.
+  // |failure_entry_ttl|. The cache will store up to |max_entries|, evicting
+  // the least recently used entry to make room for a new one.
   HostCache(size_t max_entries,
             base::TimeDelta success_entry_ttl,
             base::TimeDelta failure_entry_ttl);
@@ -84,7 +87,12 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
 
   // Returns a pointer to the entry for |key|, which is valid at time
   // |now|. If there is no such entry, returns NULL.
-  const Entry* Lookup(const Key& key, base::TimeTicks now) const;
+  const Entry* Lookup(const Key& key, base::TimeTicks now);
+
+  // Like Lookup(), but also returns a successful entry which expired less
+  // than max_stale_age() before |now|, in which case |*is_stale| is set to
+  // true. The caller is expected to refresh such an entry.
+  const Entry* LookupStale(const Key& key, base::TimeTicks now, bool* is_stale);
 
   // Overwrites or creates an entry for |key|. Returns the pointer to the
   // entry, or NULL on failure (fails if caching is disabled).
@@ -108,6 +116,11 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
 
   base::TimeDelta failure_entry_ttl() const;
 
+  // How long past their expiration successful entries may be returned by
+  // LookupStale(). Zero, the default, disables stale entries.
+  base::TimeDelta max_stale_age() const;
+  void set_max_stale_age(base::TimeDelta max_stale_age);
+
   // Note that this map may contain expired entries.
   const EntryMap& entries() const;
 
@@ -115,16 +128,12 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
   static HostCache* CreateDefaultCache();
 
  private:
-  FRIEND_TEST_ALL_PREFIXES(HostCacheTest, Compact);
+  FRIEND_TEST_ALL_PREFIXES(HostCacheTest, EvictLeastRecentlyUsed);
   FRIEND_TEST_ALL_PREFIXES(HostCacheTest, NoCache);
 
   // Returns true if this cache entry's result is valid at time |now|.
   static bool CanUseEntry(const Entry* entry, const base::TimeTicks now);
 
-  // Prunes entries from the cache to bring it below max entry bound. Entries
-  // matching |pinned_entry| will NOT be pruned.
-  void Compact(base::TimeTicks now, const Entry* pinned_entry);
-
   // Returns true if this HostCache can contain no entries.
   bool caching_is_disabled() const {
     return max_entries_ == 0;
@@ -137,8 +146,11 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
   base::TimeDelta success_entry_ttl_;
   base::TimeDelta failure_entry_ttl_;
 
+  // See max_stale_age().
+  base::TimeDelta max_stale_age_;
+
   // Map from hostname (presumably in lowercase canonicalized format) to
-  // a resolved result entry.
+  // a resolved result entry. Bounded by |max_entries_|.
   EntryMap entries_;
 
   DISALLOW_COPY_AND_ASSIGN(HostCache);
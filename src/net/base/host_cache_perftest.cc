@@ -0,0 +1,90 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/base/address_list.h"
+#include "net/base/host_cache.h"
+#include "net/base/net_errors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumHostnames = 100000;
+
+const base::TimeDelta kSuccessEntryTTL = base::TimeDelta::FromMinutes(1);
+const base::TimeDelta kFailureEntryTTL = base::TimeDelta::FromSeconds(0);
+
+class HostCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    keys_.reserve(kNumHostnames);
+    for (int i = 0; i < kNumHostnames; ++i) {
+      keys_.push_back(HostCache::Key(
+          base::StringPrintf("host%d.example.com", i),
+          ADDRESS_FAMILY_UNSPECIFIED, 0));
+    }
+  }
+
+  std::vector<HostCache::Key> keys_;
+};
+
+}  // namespace
+
+// Fills a cache which holds all of the hostnames, and looks all of them up.
+TEST_F(HostCacheTest, TestFillAndLookup) {
+  HostCache cache(kNumHostnames, kSuccessEntryTTL, kFailureEntryTTL);
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  PerfTimeLogger timer("Host_cache_fill");
+  for (int i = 0; i < kNumHostnames; ++i)
+    cache.Set(keys_[i], OK, AddressList(), now);
+  timer.Done();
+  EXPECT_EQ(static_cast<size_t>(kNumHostnames), cache.size());
+
+  PerfTimeLogger timer2("Host_cache_lookup");
+  for (int i = 0; i < kNumHostnames; ++i)
+    EXPECT_TRUE(cache.Lookup(keys_[i], now) != NULL);
+  timer2.Done();
+}
+
+// Inserts all of the hostnames into a cache which only holds a tenth of them,
+// so that every insertion past the first tenth evicts an entry.
+TEST_F(HostCacheTest, TestEvict) {
+  HostCache cache(kNumHostnames / 10, kSuccessEntryTTL, kFailureEntryTTL);
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  PerfTimeLogger timer("Host_cache_evict");
+  for (int i = 0; i < kNumHostnames; ++i)
+    cache.Set(keys_[i], OK, AddressList(), now);
+  timer.Done();
+  EXPECT_EQ(static_cast<size_t>(kNumHostnames / 10), cache.size());
+}
+
+// Looks up expired entries, as HostResolverImpl does when stale entries are
+// allowed.
+TEST_F(HostCacheTest, TestLookupStale) {
+  HostCache cache(kNumHostnames, kSuccessEntryTTL, kFailureEntryTTL);
+  cache.set_max_stale_age(base::TimeDelta::FromHours(1));
+  base::TimeTicks now = base::TimeTicks::Now();
+  for (int i = 0; i < kNumHostnames; ++i)
+    cache.Set(keys_[i], OK, AddressList(), now);
+  now += kSuccessEntryTTL;
+
+  PerfTimeLogger timer("Host_cache_lookup_stale");
+  for (int i = 0; i < kNumHostnames; ++i) {
+    bool is_stale = false;
+    EXPECT_TRUE(cache.LookupStale(keys_[i], now, &is_stale) != NULL);
+    EXPECT_TRUE(is_stale);
+  }
+  timer.Done();
+}
+
+}  // namespace net
@@ -5,7 +5,6 @@
 #include "net/base/host_cache.h"
 
 #include "base/format_macros.h"
-#include "base/stl_util.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "net/base/net_errors.h"
@@ -168,70 +167,77 @@ TEST(HostCacheTest, CacheNegativeEntry) {
   EXPECT_TRUE(cache.Lookup(Key("foobar2.com"), now) == NULL);
 }
 
-TEST(HostCacheTest, Compact) {
-  // Initial entries limit is big enough to accomadate everything we add.
-  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
-
-  EXPECT_EQ(0U, cache.size());
+TEST(HostCacheTest, EvictLeastRecentlyUsed) {
+  HostCache cache(3, kSuccessEntryTTL, kFailureEntryTTL);
 
   // t=10
-  base::TimeTicks now = base::TimeTicks() + base::TimeDelta::FromSeconds(10);
+  base::TimeTicks now = base::TimeTicks() + kSuccessEntryTTL;
 
-  // Add five valid entries at t=10.
-  for (int i = 0; i < 5; ++i) {
-    std::string hostname = base::StringPrintf("valid%d", i);
-    cache.Set(Key(hostname), OK, AddressList(), now);
-  }
-  EXPECT_EQ(5U, cache.size());
+  cache.Set(Key("host1"), OK, AddressList(), now);
+  cache.Set(Key("host2"), OK, AddressList(), now);
+  cache.Set(Key("host3"), OK, AddressList(), now);
+  EXPECT_EQ(3U, cache.size());
 
-  // Add 3 expired entries at t=0.
-  for (int i = 0; i < 3; ++i) {
-    std::string hostname = base::StringPrintf("expired%d", i);
-    base::TimeTicks t = now - base::TimeDelta::FromSeconds(10);
-    cache.Set(Key(hostname), OK, AddressList(), t);
-  }
-  EXPECT_EQ(8U, cache.size());
+  // Using "host1" makes "host2" the least recently used entry.
+  EXPECT_FALSE(NULL == cache.Lookup(Key("host1"), now));
 
-  // Add 2 negative entries at t=10
-  for (int i = 0; i < 2; ++i) {
-    std::string hostname = base::StringPrintf("negative%d", i);
-    cache.Set(Key(hostname), ERR_NAME_NOT_RESOLVED, AddressList(), now);
-  }
-  EXPECT_EQ(10U, cache.size());
-
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid0")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid1")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid2")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid3")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid4")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("expired0")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("expired1")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("expired2")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("negative0")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("negative1")));
-
-  // Shrink the max constraints bound and compact. We expect the "negative"
-  // and "expired" entries to have been dropped.
-  cache.max_entries_ = 5;
-  cache.Compact(now, NULL);
-  EXPECT_EQ(5U, cache.entries_.size());
-
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid0")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid1")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid2")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid3")));
-  EXPECT_TRUE(ContainsKey(cache.entries_, Key("valid4")));
-  EXPECT_FALSE(ContainsKey(cache.entries_, Key("expired0")));
-  EXPECT_FALSE(ContainsKey(cache.entries_, Key("expired1")));
-  EXPECT_FALSE(ContainsKey(cache.entries_, Key("expired2")));
-  EXPECT_FALSE(ContainsKey(cache.entries_, Key("negative0")));
-  EXPECT_FALSE(ContainsKey(cache.entries_, Key("negative1")));
-
-  // Shrink further -- this time the compact will start dropping valid entries
-  // to make space.
-  cache.max_entries_ = 3;
-  cache.Compact(now, NULL);
+  cache.Set(Key("host4"), OK, AddressList(), now);
   EXPECT_EQ(3U, cache.size());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host1")) != cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host2")) == cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host3")) != cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host4")) != cache.entries_.end());
+
+  // Overwriting "host3" uses it too, so "host1" goes next.
+  cache.Set(Key("host3"), OK, AddressList(), now);
+  cache.Set(Key("host5"), OK, AddressList(), now);
+  EXPECT_EQ(3U, cache.size());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host1")) == cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host3")) != cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host4")) != cache.entries_.end());
+  EXPECT_TRUE(cache.entries_.Peek(Key("host5")) != cache.entries_.end());
+}
+
+TEST(HostCacheTest, LookupStale) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+  EXPECT_EQ(base::TimeDelta(), cache.max_stale_age());
+
+  // t=0.
+  base::TimeTicks now;
+  bool is_stale = true;
+
+  cache.Set(Key("foobar.com"), OK, AddressList(), now);
+  cache.Set(Key("failed.com"), ERR_NAME_NOT_RESOLVED, AddressList(),
+            now - kSuccessEntryTTL);
+
+  const HostCache::Entry* entry =
+      cache.LookupStale(Key("foobar.com"), now, &is_stale);
+  EXPECT_FALSE(entry == NULL);
+  EXPECT_FALSE(is_stale);
+
+  // Expired entries aren't returned until a stale age is set.
+  now += kSuccessEntryTTL;
+  EXPECT_TRUE(cache.LookupStale(Key("foobar.com"), now, &is_stale) == NULL);
+  EXPECT_FALSE(is_stale);
+
+  cache.set_max_stale_age(base::TimeDelta::FromSeconds(5));
+  EXPECT_EQ(entry, cache.LookupStale(Key("foobar.com"), now, &is_stale));
+  EXPECT_TRUE(is_stale);
+  EXPECT_TRUE(cache.Lookup(Key("foobar.com"), now) == NULL);
+
+  // Failed resolves are never stale.
+  EXPECT_TRUE(cache.LookupStale(Key("failed.com"), now, &is_stale) == NULL);
+  EXPECT_FALSE(is_stale);
+
+  // Refreshing the entry makes it fresh again.
+  cache.Set(Key("foobar.com"), OK, AddressList(), now);
+  EXPECT_EQ(entry, cache.LookupStale(Key("foobar.com"), now, &is_stale));
+  EXPECT_FALSE(is_stale);
+
+  // Past the stale age, the entry is gone for good.
+  now += kSuccessEntryTTL + base::TimeDelta::FromSeconds(5);
+  EXPECT_TRUE(cache.LookupStale(Key("foobar.com"), now, &is_stale) == NULL);
+  EXPECT_FALSE(is_stale);
 }
 
 // Add entries while the cache is at capacity, causing evictions.
@@ -126,6 +126,11 @@ std::vector<int> GetAllGetAddrinfoOSErrors() {
                                                     arraysize(os_errors));
 }
 
+// Completion callback of the requests which refresh stale cache entries. The
+// result is only needed in the cache, where the job puts it.
+void OnStaleEntryRefreshed(AddressList* addresses, int result) {
+}
+
 }  // anonymous namespace
 
 // static
@@ -1308,18 +1313,51 @@ bool HostResolverImpl::ServeFromCache(const Key& key,
   if (!info.allow_cached_response() || !cache_.get())
     return false;
 
-  const HostCache::Entry* cache_entry = cache_->Lookup(
-      key, base::TimeTicks::Now());
+  bool is_stale = false;
+  const HostCache::Entry* cache_entry = cache_->LookupStale(
+      key, base::TimeTicks::Now(), &is_stale);
   if (!cache_entry)
     return false;
 
-  request_net_log.AddEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_CACHE_HIT, NULL);
+  if (is_stale) {
+    request_net_log.AddEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_STALE_CACHE_HIT,
+                             NULL);
+  } else {
+    request_net_log.AddEvent(NetLog::TYPE_HOST_RESOLVER_IMPL_CACHE_HIT, NULL);
+  }
   *net_error = cache_entry->error;
   if (*net_error == OK)
     *addresses = CreateAddressListUsingPort(cache_entry->addrlist, info.port());
+  if (is_stale)
+    RefreshStaleEntry(key, info);
   return true;
 }
 
+void HostResolverImpl::RefreshStaleEntry(const Key& key,
+                                         const RequestInfo& info) {
+  // The refresh is best effort: it is skipped rather than queued when the
+  // resolver is busy, and the stale entry is served until it ages out.
+  if (FindOutstandingJob(key))
+    return;
+
+  RequestInfo refresh_info(info);
+  refresh_info.set_priority(LOWEST);
+  BoundNetLog request_net_log = BoundNetLog::Make(net_log_,
+      NetLog::SOURCE_HOST_RESOLVER_IMPL_REQUEST);
+
+  AddressList* addresses = new AddressList;
+  Request* req = new Request(
+      BoundNetLog(), request_net_log, refresh_info,
+      base::Bind(&OnStaleEntryRefreshed, base::Owned(addresses)), addresses);
+  if (!CanCreateJobForPool(*GetPoolForRequest(req))) {
+    delete req;
+    return;
+  }
+
+  OnStartRequest(req->source_net_log(), req->request_net_log(), refresh_info);
+  CreateAndStartJob(req);
+}
+
 void HostResolverImpl::AddOutstandingJob(Job* job) {
   scoped_refptr<Job>& found_job = jobs_[job->key()];
   DCHECK(!found_job);
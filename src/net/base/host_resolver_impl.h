@@ -181,6 +181,10 @@ class NET_EXPORT HostResolverImpl
                       int* net_error,
                       AddressList* addresses);
 
+  // Starts a job which resolves |key| again to refresh its stale cache entry,
+  // unless one is already running or no job can be started right away.
+  void RefreshStaleEntry(const Key& key, const RequestInfo& info);
+
   // Returns the HostResolverProc to use for this instance.
   HostResolverProc* effective_resolver_proc() const {
     return resolver_proc_ ?
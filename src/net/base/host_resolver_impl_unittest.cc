@@ -1521,6 +1521,57 @@ TEST_F(HostResolverImplTest, DisallowNonCachedResponses) {
   EXPECT_TRUE(htonl(0xc0a8012a) == sa_in->sin_addr.s_addr);
 }
 
+// Test that an expired cache entry is served while it is refreshed in the
+// background, once the cache allows stale entries.
+TEST_F(HostResolverImplTest, ServeStaleWhileRefreshing) {
+  scoped_refptr<RuleBasedHostResolverProc> rules(
+      new RuleBasedHostResolverProc(NULL));
+  rules->AddRule("just.testing", "192.168.1.42");
+  scoped_refptr<CapturingHostResolverProc> resolver_proc(
+      new CapturingHostResolverProc(rules));
+  resolver_proc->Signal();
+
+  scoped_ptr<HostResolver> host_resolver(
+      CreateHostResolverImpl(resolver_proc));
+  HostCache* cache = host_resolver->GetHostCache();
+  cache->set_max_stale_age(TimeDelta::FromHours(1));
+
+  // Put an entry which expired a minute ago in the cache.
+  IPAddressNumber stale_ip;
+  ASSERT_TRUE(ParseIPLiteralToNumber("127.0.0.1", &stale_ip));
+  AddressList stale_addrlist = AddressList::CreateFromIPAddress(stale_ip, 0);
+  HostCache::Key key("just.testing", ADDRESS_FAMILY_UNSPECIFIED, 0);
+  cache->Set(key, OK, stale_addrlist,
+             TimeTicks::Now() - cache->success_entry_ttl() -
+                 TimeDelta::FromMinutes(1));
+  EXPECT_TRUE(cache->Lookup(key, TimeTicks::Now()) == NULL);
+
+  // The stale entry is served synchronously.
+  HostResolver::RequestInfo info(HostPortPair("just.testing", 80));
+  CapturingBoundNetLog log(CapturingNetLog::kUnbounded);
+  AddressList addrlist;
+  TestCompletionCallback callback;
+  int rv = host_resolver->Resolve(info, &addrlist, callback.callback(), NULL,
+                                  log.bound());
+  EXPECT_EQ(OK, rv);
+  EXPECT_EQ("127.0.0.1", NetAddressToString(addrlist.head()));
+
+  // A request which bypasses the cache joins the refresh, rather than
+  // resolving the host a second time.
+  info.set_allow_cached_response(false);
+  rv = host_resolver->Resolve(info, &addrlist, callback.callback(), NULL,
+                              log.bound());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback.WaitForResult());
+  EXPECT_EQ("192.168.1.42", NetAddressToString(addrlist.head()));
+  EXPECT_EQ(1u, resolver_proc->GetCaptureList().size());
+
+  // The refreshed entry is now fresh.
+  const HostCache::Entry* entry = cache->Lookup(key, TimeTicks::Now());
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_EQ("192.168.1.42", NetAddressToString(entry->addrlist.head()));
+}
+
 // Test the retry attempts simulating host resolver proc that takes too long.
 TEST_F(HostResolverImplTest, MultipleAttempts) {
   // Total number of attempts would be 3 and we want the 3rd attempt to resolve
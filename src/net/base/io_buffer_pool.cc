@@ -0,0 +1,170 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/io_buffer_pool.h"
+
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/threading/thread_local.h"
+#include "base/values.h"
+
+namespace net {
+
+namespace {
+
+// Holds the pool of the current thread, or NULL if it has none.  It is leaked
+// because buffers may be released on threads which outlive the AtExitManager.
+base::LazyInstance<base::ThreadLocalPointer<IOBufferPool>,
+                   base::LeakyLazyInstanceTraits<
+                       base::ThreadLocalPointer<IOBufferPool> > >
+    g_current_pool = LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// 512 bytes to 64 KB, in 8 size classes.  Reads and writes of the network
+// stack are mostly between 4 KB and 32 KB.
+const int IOBufferPool::kMinBlockSize = 512;
+const int IOBufferPool::kMaxBlockSize = 64 * 1024;
+const size_t IOBufferPool::kMaxFreeBlocksPerSizeClass = 8;
+
+IOBufferPool::Stats::Stats()
+    : allocations(0),
+      reused_blocks(0),
+      released_blocks(0),
+      freed_blocks(0),
+      unpooled_allocations(0),
+      free_blocks(0),
+      free_bytes(0) {
+}
+
+// static
+IOBufferPool* IOBufferPool::current() {
+  return g_current_pool.Pointer()->Get();
+}
+
+// static
+char* IOBufferPool::AllocateBlock(int size) {
+  DCHECK_GT(size, 0);
+  int size_class = GetSizeClass(size);
+  IOBufferPool* pool = current();
+  if (!pool && MessageLoop::current()) {
+    pool = new IOBufferPool();
+    g_current_pool.Pointer()->Set(pool);
+    MessageLoop::current()->AddDestructionObserver(pool);
+  }
+
+  if (size_class < 0) {
+    if (pool)
+      pool->stats_.unpooled_allocations++;
+    return new char[size];
+  }
+  // Blocks which may end up in a pool always have the size of their class.
+  if (!pool)
+    return new char[kMinBlockSize << size_class];
+  return pool->Allocate(size_class);
+}
+
+// static
+void IOBufferPool::FreeBlock(char* block, int size) {
+  int size_class = GetSizeClass(size);
+  IOBufferPool* pool = current();
+  if (size_class < 0 || !pool) {
+    delete[] block;
+    return;
+  }
+  pool->Free(block, size_class);
+}
+
+void IOBufferPool::Clear() {
+  for (size_t i = 0; i < free_blocks_.size(); ++i) {
+    for (size_t j = 0; j < free_blocks_[i].size(); ++j)
+      delete[] free_blocks_[i][j];
+    free_blocks_[i].clear();
+  }
+  stats_.free_blocks = 0;
+  stats_.free_bytes = 0;
+}
+
+base::DictionaryValue* IOBufferPool::GetStatsAsValue() const {
+  base::DictionaryValue* dict = new base::DictionaryValue();
+  dict->SetString("allocations", base::Int64ToString(stats_.allocations));
+  dict->SetString("reused_blocks", base::Int64ToString(stats_.reused_blocks));
+  dict->SetString("released_blocks",
+                  base::Int64ToString(stats_.released_blocks));
+  dict->SetString("freed_blocks", base::Int64ToString(stats_.freed_blocks));
+  dict->SetString("unpooled_allocations",
+                  base::Int64ToString(stats_.unpooled_allocations));
+  dict->SetString("free_blocks", base::Int64ToString(stats_.free_blocks));
+  dict->SetString("free_bytes", base::Int64ToString(stats_.free_bytes));
+  return dict;
+}
+
+void IOBufferPool::WillDestroyCurrentMessageLoop() {
+  DCHECK_EQ(this, current());
+  g_current_pool.Pointer()->Set(NULL);
+  delete this;
+}
+
+IOBufferPool::IOBufferPool() {
+  int num_size_classes = GetSizeClass(kMaxBlockSize) + 1;
+  free_blocks_.resize(num_size_classes);
+  for (int i = 0; i < num_size_classes; ++i)
+    free_blocks_[i].reserve(kMaxFreeBlocksPerSizeClass);
+}
+
+IOBufferPool::~IOBufferPool() {
+  Clear();
+}
+
+// static
+int IOBufferPool::GetSizeClass(int size) {
+  if (size > kMaxBlockSize)
+    return -1;
+  int size_class = 0;
+  for (int block_size = kMinBlockSize; block_size < size; block_size <<= 1)
+    ++size_class;
+  return size_class;
+}
+
+char* IOBufferPool::Allocate(int size_class) {
+  stats_.allocations++;
+  std::vector<char*>& blocks = free_blocks_[size_class];
+  if (blocks.empty())
+    return new char[kMinBlockSize << size_class];
+
+  char* block = blocks.back();
+  blocks.pop_back();
+  stats_.reused_blocks++;
+  stats_.free_blocks--;
+  stats_.free_bytes -= kMinBlockSize << size_class;
+  return block;
+}
+
+void IOBufferPool::Free(char* block, int size_class) {
+  stats_.released_blocks++;
+  std::vector<char*>& blocks = free_blocks_[size_class];
+  if (blocks.size() >= kMaxFreeBlocksPerSizeClass) {
+    stats_.freed_blocks++;
+    delete[] block;
+    return;
+  }
+
+  blocks.push_back(block);
+  stats_.free_blocks++;
+  stats_.free_bytes += kMinBlockSize << size_class;
+}
+
+PooledIOBuffer::PooledIOBuffer(int size)
+    : IOBufferWithSize(IOBufferPool::AllocateBlock(size), size) {
+}
+
+PooledIOBuffer::~PooledIOBuffer() {
+  IOBufferPool::FreeBlock(data_, size_);
+  // The block isn't ours anymore, so keep the base class destructor from
+  // deleting it.
+  data_ = NULL;
+}
+
+}  // namespace net
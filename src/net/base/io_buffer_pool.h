@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_IO_BUFFER_POOL_H_
+#define NET_BASE_IO_BUFFER_POOL_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/message_loop.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_export.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace net {
+
+// IOBufferPool keeps the data blocks of destroyed PooledIOBuffers, so that
+// code which allocates a buffer for every read or write doesn't go through the
+// heap each time.  Blocks are rounded up to a power of two size class, from
+// kMinBlockSize to kMaxBlockSize bytes, and up to kMaxFreeBlocksPerSizeClass
+// free blocks of each class are kept.  Larger buffers aren't pooled.
+//
+// There is one pool per thread, which is only used on that thread, so no
+// locking is needed.  The pool of a thread is created by the first block
+// allocated on it, if the thread has a MessageLoop, and is deleted along with
+// the MessageLoop.  Blocks are given back to the pool of the thread which
+// frees them, or to the heap if that thread has no pool.
+class NET_EXPORT IOBufferPool : public MessageLoop::DestructionObserver {
+ public:
+  static const int kMinBlockSize;
+  static const int kMaxBlockSize;
+  static const size_t kMaxFreeBlocksPerSizeClass;
+
+  // Allocation statistics of a pool.
+  struct NET_EXPORT Stats {
+    Stats();
+
+    // Number of blocks handed out, and how many of them were reused.
+    int64 allocations;
+    int64 reused_blocks;
+    // Number of blocks given back, and how many of them were freed because
+    // their size class was full.
+    int64 released_blocks;
+    int64 freed_blocks;
+    // Number of buffers which were too large to be pooled.
+    int64 unpooled_allocations;
+    // Free blocks currently kept by the pool.
+    int64 free_blocks;
+    int64 free_bytes;
+  };
+
+  // Returns the pool of the current thread, or NULL if it has none.
+  static IOBufferPool* current();
+
+  // Returns a block of at least |size| bytes, which must be given back with
+  // FreeBlock(), possibly on another thread.
+  static char* AllocateBlock(int size);
+
+  // Takes back a |block| which was allocated for |size| bytes.
+  static void FreeBlock(char* block, int size);
+
+  // Frees all the free blocks of the pool, e.g. on memory pressure.
+  void Clear();
+
+  const Stats& stats() const { return stats_; }
+
+  // Returns the statistics of the pool, for about:net-internals.  The caller
+  // takes ownership.
+  base::DictionaryValue* GetStatsAsValue() const;
+
+  // MessageLoop::DestructionObserver implementation:
+  virtual void WillDestroyCurrentMessageLoop() OVERRIDE;
+
+ private:
+  IOBufferPool();
+  virtual ~IOBufferPool();
+
+  // Returns the size class of blocks of |size| bytes, or -1 if they are too
+  // large to be pooled.  Blocks of size class |i| have kMinBlockSize << |i|
+  // bytes.
+  static int GetSizeClass(int size);
+
+  char* Allocate(int size_class);
+  void Free(char* block, int size_class);
+
+  // The free blocks of each size class.
+  std::vector<std::vector<char*> > free_blocks_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(IOBufferPool);
+};
+
+// An IOBufferWithSize whose data comes from the IOBufferPool of the current
+// thread, and goes back to a pool when the buffer is destroyed by its last
+// Release().  Code which allocates a buffer for every read or write can use
+// it instead of IOBuffer or IOBufferWithSize.
+class NET_EXPORT PooledIOBuffer : public IOBufferWithSize {
+ public:
+  explicit PooledIOBuffer(int size);
+
+ private:
+  virtual ~PooledIOBuffer();
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_IO_BUFFER_POOL_H_
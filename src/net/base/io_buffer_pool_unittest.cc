@@ -0,0 +1,244 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/io_buffer_pool.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// The main thread of the tests already has a MessageLoop, and maybe a pool, so
+// each test runs on a thread of its own, whose pool starts out empty and goes
+// away with the thread.
+void RunOnThreadWithMessageLoop(const base::Closure& task) {
+  base::Thread thread("IOBufferPoolTest");
+  ASSERT_TRUE(thread.Start());
+  thread.message_loop()->PostTask(FROM_HERE, task);
+  thread.Stop();
+}
+
+void ReuseBlock() {
+  scoped_refptr<PooledIOBuffer> buffer(new PooledIOBuffer(4096));
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(1, pool->stats().allocations);
+  EXPECT_EQ(0, pool->stats().reused_blocks);
+
+  char* data = buffer->data();
+  buffer = NULL;
+  EXPECT_EQ(1, pool->stats().released_blocks);
+  EXPECT_EQ(1, pool->stats().free_blocks);
+  EXPECT_EQ(4096, pool->stats().free_bytes);
+
+  buffer = new PooledIOBuffer(4096);
+  EXPECT_EQ(data, buffer->data());
+  EXPECT_EQ(2, pool->stats().allocations);
+  EXPECT_EQ(1, pool->stats().reused_blocks);
+  EXPECT_EQ(0, pool->stats().free_blocks);
+  EXPECT_EQ(0, pool->stats().free_bytes);
+}
+
+void SizeClasses() {
+  scoped_refptr<PooledIOBuffer> buffer(new PooledIOBuffer(3000));
+  char* data = buffer->data();
+  memset(data, 'x', 4096);
+  buffer = NULL;
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(4096, pool->stats().free_bytes);
+
+  // Neither a smaller nor a larger class reuses the block.
+  buffer = new PooledIOBuffer(2048);
+  EXPECT_NE(data, buffer->data());
+  buffer = new PooledIOBuffer(4097);
+  EXPECT_NE(data, buffer->data());
+  buffer = NULL;
+
+  buffer = new PooledIOBuffer(2049);
+  EXPECT_EQ(data, buffer->data());
+  EXPECT_EQ(2049, buffer->size());
+
+  // Small buffers get a block of the smallest class.
+  scoped_refptr<PooledIOBuffer> small_buffer(new PooledIOBuffer(1));
+  memset(small_buffer->data(), 'x', IOBufferPool::kMinBlockSize);
+}
+
+void MaxFreeBlocksPerSizeClass() {
+  const size_t kNumBuffers = IOBufferPool::kMaxFreeBlocksPerSizeClass + 2;
+  std::vector<scoped_refptr<PooledIOBuffer> > buffers;
+  for (size_t i = 0; i < kNumBuffers; ++i)
+    buffers.push_back(new PooledIOBuffer(1024));
+  buffers.clear();
+
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(static_cast<int64>(kNumBuffers), pool->stats().released_blocks);
+  EXPECT_EQ(2, pool->stats().freed_blocks);
+  EXPECT_EQ(static_cast<int64>(IOBufferPool::kMaxFreeBlocksPerSizeClass),
+            pool->stats().free_blocks);
+}
+
+void LargeBuffersAreNotPooled() {
+  const int kSize = IOBufferPool::kMaxBlockSize + 1;
+  scoped_refptr<PooledIOBuffer> buffer(new PooledIOBuffer(kSize));
+  memset(buffer->data(), 'x', kSize);
+  buffer = NULL;
+
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(1, pool->stats().unpooled_allocations);
+  EXPECT_EQ(0, pool->stats().allocations);
+  EXPECT_EQ(0, pool->stats().released_blocks);
+  EXPECT_EQ(0, pool->stats().free_blocks);
+
+  // The largest pooled size still goes through the pool.
+  buffer = new PooledIOBuffer(IOBufferPool::kMaxBlockSize);
+  buffer = NULL;
+  EXPECT_EQ(1, pool->stats().free_blocks);
+  EXPECT_EQ(IOBufferPool::kMaxBlockSize, pool->stats().free_bytes);
+}
+
+void Clear() {
+  scoped_refptr<PooledIOBuffer> buffer1(new PooledIOBuffer(1024));
+  scoped_refptr<PooledIOBuffer> buffer2(new PooledIOBuffer(8192));
+  buffer1 = NULL;
+  buffer2 = NULL;
+
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  EXPECT_EQ(2, pool->stats().free_blocks);
+  EXPECT_EQ(1024 + 8192, pool->stats().free_bytes);
+
+  pool->Clear();
+  EXPECT_EQ(0, pool->stats().free_blocks);
+  EXPECT_EQ(0, pool->stats().free_bytes);
+  EXPECT_EQ(2, pool->stats().allocations);
+  EXPECT_EQ(2, pool->stats().released_blocks);
+}
+
+void GetStatsAsValue() {
+  scoped_refptr<PooledIOBuffer> buffer(new PooledIOBuffer(1024));
+  buffer = NULL;
+  buffer = new PooledIOBuffer(1024);
+  buffer = NULL;
+
+  IOBufferPool* pool = IOBufferPool::current();
+  ASSERT_TRUE(pool);
+  scoped_ptr<base::DictionaryValue> dict(pool->GetStatsAsValue());
+  std::string value;
+  EXPECT_TRUE(dict->GetString("allocations", &value));
+  EXPECT_EQ("2", value);
+  EXPECT_TRUE(dict->GetString("reused_blocks", &value));
+  EXPECT_EQ("1", value);
+  EXPECT_TRUE(dict->GetString("released_blocks", &value));
+  EXPECT_EQ("2", value);
+  EXPECT_TRUE(dict->GetString("free_bytes", &value));
+  EXPECT_EQ("1024", value);
+}
+
+// Checks that the pool of the thread is gone by the time the MessageLoop
+// destruction observers which were added after it run.
+class PoolDeletedObserver : public MessageLoop::DestructionObserver {
+ public:
+  PoolDeletedObserver() : called_(false) {}
+
+  bool called() const { return called_; }
+
+  virtual void WillDestroyCurrentMessageLoop() OVERRIDE {
+    called_ = true;
+    EXPECT_FALSE(IOBufferPool::current());
+  }
+
+ private:
+  bool called_;
+};
+
+void AllocateAndWatchPool(scoped_refptr<PooledIOBuffer>* buffer,
+                          PoolDeletedObserver* observer) {
+  *buffer = new PooledIOBuffer(1024);
+  EXPECT_TRUE(IOBufferPool::current());
+  MessageLoop::current()->AddDestructionObserver(observer);
+}
+
+// Uses the pool of a thread without a MessageLoop.
+class NoMessageLoopThread : public base::SimpleThread {
+ public:
+  NoMessageLoopThread() : base::SimpleThread("IOBufferPoolTest") {}
+
+  virtual void Run() OVERRIDE {
+    ASSERT_FALSE(MessageLoop::current());
+    scoped_refptr<PooledIOBuffer> buffer(new PooledIOBuffer(4096));
+    EXPECT_EQ(4096, buffer->size());
+    memset(buffer->data(), 'x', buffer->size());
+    EXPECT_FALSE(IOBufferPool::current());
+    buffer = NULL;
+    EXPECT_FALSE(IOBufferPool::current());
+  }
+};
+
+}  // namespace
+
+TEST(IOBufferPoolTest, ReuseBlock) {
+  RunOnThreadWithMessageLoop(base::Bind(&ReuseBlock));
+}
+
+// Buffers share the blocks of their power of two size class.
+TEST(IOBufferPoolTest, SizeClasses) {
+  RunOnThreadWithMessageLoop(base::Bind(&SizeClasses));
+}
+
+TEST(IOBufferPoolTest, MaxFreeBlocksPerSizeClass) {
+  RunOnThreadWithMessageLoop(base::Bind(&MaxFreeBlocksPerSizeClass));
+}
+
+TEST(IOBufferPoolTest, LargeBuffersAreNotPooled) {
+  RunOnThreadWithMessageLoop(base::Bind(&LargeBuffersAreNotPooled));
+}
+
+TEST(IOBufferPoolTest, Clear) {
+  RunOnThreadWithMessageLoop(base::Bind(&Clear));
+}
+
+TEST(IOBufferPoolTest, GetStatsAsValue) {
+  RunOnThreadWithMessageLoop(base::Bind(&GetStatsAsValue));
+}
+
+// The pool goes away with the MessageLoop of its thread, and a buffer which
+// outlives it is released on another thread.
+TEST(IOBufferPoolTest, DeletedWithMessageLoop) {
+  scoped_refptr<PooledIOBuffer> buffer;
+  PoolDeletedObserver observer;
+  RunOnThreadWithMessageLoop(
+      base::Bind(&AllocateAndWatchPool, &buffer, &observer));
+  EXPECT_TRUE(observer.called());
+  ASSERT_TRUE(buffer);
+  memset(buffer->data(), 'x', buffer->size());
+  buffer = NULL;
+}
+
+// Threads without a MessageLoop don't get a pool, since nothing would delete
+// it.
+TEST(IOBufferPoolTest, NoPoolWithoutMessageLoop) {
+  NoMessageLoopThread thread;
+  thread.Start();
+  thread.Join();
+}
+
+}  // namespace net
@@ -64,6 +64,10 @@ EVENT_TYPE(HOST_RESOLVER_IMPL_REQUEST)
 // This event is logged when a request is handled by a cache entry.
 EVENT_TYPE(HOST_RESOLVER_IMPL_CACHE_HIT)
 
+// This event is logged when a request is handled by an expired cache entry,
+// which is refreshed in the background.
+EVENT_TYPE(HOST_RESOLVER_IMPL_STALE_CACHE_HIT)
+
 // This event means a request was queued/dequeued for subsequent job creation,
 // because there are already too many active HostResolverImpl::Jobs.
 //
@@ -16,9 +16,13 @@
 #include <pk11pub.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 #include "base/base64.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
@@ -150,6 +154,10 @@ bool TransportSecurityState::HasMetadata(DomainState* result,
     if (has_preload && host_sub_chunk == canonicalized_preload)
       return true;
 
+    // Don't hash the name if there is nothing to look it up in.
+    if (enabled_hosts_.empty())
+      continue;
+
     std::map<std::string, DomainState>::iterator j =
         enabled_hosts_.find(HashHost(host_sub_chunk));
     if (j == enabled_hosts_.end())
@@ -864,41 +872,34 @@ struct HSTSPreload {
   SecondLevelDomainName second_level_domain_name;
 };
 
-static bool HasPreload(const struct HSTSPreload* entries, size_t num_entries,
-                       const std::string& canonicalized_host, size_t i,
-                       TransportSecurityState::DomainState* out, bool* ret) {
-  for (size_t j = 0; j < num_entries; j++) {
-    if (entries[j].length == canonicalized_host.size() - i &&
-        memcmp(entries[j].dns_name, &canonicalized_host[i],
-               entries[j].length) == 0) {
-      if (!entries[j].include_subdomains && i != 0) {
-        *ret = false;
-      } else {
-        out->include_subdomains = entries[j].include_subdomains;
-        *ret = true;
-        if (!entries[j].https_required)
-          out->mode = TransportSecurityState::DomainState::MODE_PINNING_ONLY;
-        if (entries[j].pins.required_hashes) {
-          const char* const* hash = entries[j].pins.required_hashes;
-          while (*hash) {
-            bool ok = AddHash(*hash, &out->public_key_hashes);
-            DCHECK(ok) << " failed to parse " << *hash;
-            hash++;
-          }
-        }
-        if (entries[j].pins.excluded_hashes) {
-          const char* const* hash = entries[j].pins.excluded_hashes;
-          while (*hash) {
-            bool ok = AddHash(*hash, &out->bad_public_key_hashes);
-            DCHECK(ok) << " failed to parse " << *hash;
-            hash++;
-          }
-        }
-      }
-      return true;
+// Fills |out| from |entry|, which was preloaded either for the host itself
+// or, if |is_subdomain|, for one of its parents. Returns false if |entry|
+// doesn't apply to the subdomains of its host.
+static bool ApplyPreload(const struct HSTSPreload* entry, bool is_subdomain,
+                         TransportSecurityState::DomainState* out) {
+  if (!entry->include_subdomains && is_subdomain)
+    return false;
+
+  out->include_subdomains = entry->include_subdomains;
+  if (!entry->https_required)
+    out->mode = TransportSecurityState::DomainState::MODE_PINNING_ONLY;
+  if (entry->pins.required_hashes) {
+    const char* const* hash = entry->pins.required_hashes;
+    while (*hash) {
+      bool ok = AddHash(*hash, &out->public_key_hashes);
+      DCHECK(ok) << " failed to parse " << *hash;
+      hash++;
     }
   }
-  return false;
+  if (entry->pins.excluded_hashes) {
+    const char* const* hash = entry->pins.excluded_hashes;
+    while (*hash) {
+      bool ok = AddHash(*hash, &out->bad_public_key_hashes);
+      DCHECK(ok) << " failed to parse " << *hash;
+      hash++;
+    }
+  }
+  return true;
 }
 
 // kNoRejectedPublicKeys is a placeholder for when no public keys are rejected.
@@ -1224,7 +1225,85 @@ static const struct HSTSPreload kPreloadedSNISTS[] = {
 };
 static const size_t kNumPreloadedSNISTS = ARRAYSIZE_UNSAFE(kPreloadedSNISTS);
 
-// Returns the HSTSPreload entry for the |canonicalized_host| in |entries|,
+// Returns true if the name of |entry| sorts before the |length| bytes at
+// |dns_name|. Names are ordered by length first, so that a lookup compares
+// the bytes of a name only with the entries which have the same length.
+static bool PreloadNameLess(const struct HSTSPreload* entry,
+                            const char* dns_name,
+                            size_t length) {
+  if (entry->length != length)
+    return entry->length < length;
+  return memcmp(entry->dns_name, dns_name, length) < 0;
+}
+
+// PreloadIndex orders the entries of a preload table by name, so that looking
+// up a name is a binary search rather than a walk over the whole table. The
+// tables themselves stay in the order in which they are maintained above.
+class PreloadIndex {
+ public:
+  PreloadIndex(const struct HSTSPreload* entries, size_t num_entries) {
+    sorted_entries_.reserve(num_entries);
+    for (size_t i = 0; i < num_entries; i++)
+      sorted_entries_.push_back(entries + i);
+    std::stable_sort(sorted_entries_.begin(), sorted_entries_.end(),
+                     EntryLess());
+  }
+
+  // Returns the entry named |length| bytes at |dns_name|, which are in DNS
+  // form, or NULL if there is none.
+  const struct HSTSPreload* Find(const char* dns_name, size_t length) const {
+    // This is std::lower_bound, which can't be given a key which isn't an
+    // entry on every platform.
+    size_t begin = 0;
+    size_t end = sorted_entries_.size();
+    while (begin < end) {
+      size_t middle = begin + (end - begin) / 2;
+      if (PreloadNameLess(sorted_entries_[middle], dns_name, length)) {
+        begin = middle + 1;
+      } else {
+        end = middle;
+      }
+    }
+    if (begin == sorted_entries_.size())
+      return NULL;
+    const struct HSTSPreload* entry = sorted_entries_[begin];
+    if (entry->length != length ||
+        memcmp(entry->dns_name, dns_name, length) != 0) {
+      return NULL;
+    }
+    return entry;
+  }
+
+ private:
+  struct EntryLess {
+    bool operator()(const struct HSTSPreload* a,
+                    const struct HSTSPreload* b) const {
+      return PreloadNameLess(a, b->dns_name, b->length);
+    }
+  };
+
+  std::vector<const struct HSTSPreload*> sorted_entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreloadIndex);
+};
+
+// The indexes of kPreloadedSTS and kPreloadedSNISTS, which are built the
+// first time a host is looked up, and are never freed.
+struct PreloadIndexes {
+  PreloadIndexes()
+      : sts(kPreloadedSTS, kNumPreloadedSTS),
+        sni_sts(kPreloadedSNISTS, kNumPreloadedSNISTS) {
+  }
+
+  PreloadIndex sts;
+  PreloadIndex sni_sts;
+};
+
+static base::LazyInstance<PreloadIndexes,
+                          base::LeakyLazyInstanceTraits<PreloadIndexes> >
+    g_preload_indexes = LAZY_INSTANCE_INITIALIZER;
+
+// Returns the HSTSPreload entry for the |canonicalized_host| in |index|,
 // or NULL if there is none. Prefers exact hostname matches to those that
 // match only because HSTSPreload.include_subdomains is true.
 //
@@ -1232,20 +1311,12 @@ static const size_t kNumPreloadedSNISTS = ARRAYSIZE_UNSAFE(kPreloadedSNISTS);
 // CanonicalizeHost.
 static const struct HSTSPreload* GetHSTSPreload(
     const std::string& canonicalized_host,
-    const struct HSTSPreload* entries,
-    size_t num_entries) {
+    const PreloadIndex& index) {
   for (size_t i = 0; canonicalized_host[i]; i += canonicalized_host[i] + 1) {
-    for (size_t j = 0; j < num_entries; j++) {
-      const struct HSTSPreload* entry = entries + j;
-
-      if (i != 0 && !entry->include_subdomains)
-        continue;
-
-      if (entry->length == canonicalized_host.size() - i &&
-          memcmp(entry->dns_name, &canonicalized_host[i], entry->length) == 0) {
-        return entry;
-      }
-    }
+    const struct HSTSPreload* entry =
+        index.Find(&canonicalized_host[i], canonicalized_host.size() - i);
+    if (entry && (i == 0 || entry->include_subdomains))
+      return entry;
   }
 
   return NULL;
@@ -1255,15 +1326,15 @@ static const struct HSTSPreload* GetHSTSPreload(
 bool TransportSecurityState::IsGooglePinnedProperty(const std::string& host,
                                                     bool sni_available) {
   std::string canonicalized_host = CanonicalizeHost(host);
+  const PreloadIndexes& indexes = g_preload_indexes.Get();
   const struct HSTSPreload* entry =
-      GetHSTSPreload(canonicalized_host, kPreloadedSTS, kNumPreloadedSTS);
+      GetHSTSPreload(canonicalized_host, indexes.sts);
 
   if (entry && entry->pins.required_hashes == kGoogleAcceptableCerts)
     return true;
 
   if (sni_available) {
-    entry = GetHSTSPreload(canonicalized_host, kPreloadedSNISTS,
-                           kNumPreloadedSNISTS);
+    entry = GetHSTSPreload(canonicalized_host, indexes.sni_sts);
     if (entry && entry->pins.required_hashes == kGoogleAcceptableCerts)
       return true;
   }
@@ -1275,13 +1346,12 @@ bool TransportSecurityState::IsGooglePinnedProperty(const std::string& host,
 void TransportSecurityState::ReportUMAOnPinFailure(const std::string& host) {
   std::string canonicalized_host = CanonicalizeHost(host);
 
+  const PreloadIndexes& indexes = g_preload_indexes.Get();
   const struct HSTSPreload* entry =
-      GetHSTSPreload(canonicalized_host, kPreloadedSTS, kNumPreloadedSTS);
+      GetHSTSPreload(canonicalized_host, indexes.sts);
 
-  if (!entry) {
-    entry = GetHSTSPreload(canonicalized_host, kPreloadedSNISTS,
-                           kNumPreloadedSNISTS);
-  }
+  if (!entry)
+    entry = GetHSTSPreload(canonicalized_host, indexes.sni_sts);
 
   DCHECK(entry);
   DCHECK(entry->pins.required_hashes);
@@ -1303,26 +1373,27 @@ bool TransportSecurityState::IsPreloadedSTS(
   out->mode = DomainState::MODE_STRICT;
   out->include_subdomains = false;
 
+  const PreloadIndexes& indexes = g_preload_indexes.Get();
   for (size_t i = 0; canonicalized_host[i]; i += canonicalized_host[i] + 1) {
-    std::string host_sub_chunk(&canonicalized_host[i],
-                               canonicalized_host.size() - i);
-    out->domain = DNSDomainToString(host_sub_chunk);
-    std::string hashed_host(HashHost(host_sub_chunk));
-    if (forced_hosts_.find(hashed_host) != forced_hosts_.end()) {
-      *out = forced_hosts_[hashed_host];
-      out->domain = DNSDomainToString(host_sub_chunk);
-      out->preloaded = true;
-      return true;
-    }
-    bool ret;
-    if (HasPreload(kPreloadedSTS, kNumPreloadedSTS, canonicalized_host, i, out,
-                   &ret)) {
-      return ret;
+    const char* dns_name = &canonicalized_host[i];
+    size_t length = canonicalized_host.size() - i;
+    if (!forced_hosts_.empty()) {
+      std::string host_sub_chunk(dns_name, length);
+      std::map<std::string, DomainState>::iterator j =
+          forced_hosts_.find(HashHost(host_sub_chunk));
+      if (j != forced_hosts_.end()) {
+        *out = j->second;
+        out->domain = DNSDomainToString(host_sub_chunk);
+        out->preloaded = true;
+        return true;
+      }
     }
-    if (sni_available &&
-        HasPreload(kPreloadedSNISTS, kNumPreloadedSNISTS, canonicalized_host, i,
-                   out, &ret)) {
-      return ret;
+    const struct HSTSPreload* entry = indexes.sts.Find(dns_name, length);
+    if (!entry && sni_available)
+      entry = indexes.sni_sts.Find(dns_name, length);
+    if (entry) {
+      out->domain = DNSDomainToString(std::string(dns_name, length));
+      return ApplyPreload(entry, i != 0, out);
     }
   }
 
@@ -185,6 +185,7 @@ class NET_EXPORT TransportSecurityState
 
  private:
   FRIEND_TEST_ALL_PREFIXES(TransportSecurityStateTest, IsPreloaded);
+  FRIEND_TEST_ALL_PREFIXES(TransportSecurityStateTest, IsPreloadedSameLength);
 
   // If we have a callback configured, call it to let our serialiser know that
   // our state is dirty.
@@ -0,0 +1,76 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/transport_security_state.h"
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(USE_OPENSSL)
+#include "crypto/openssl_util.h"
+#else
+#include "crypto/nss_util.h"
+#endif
+
+namespace net {
+
+namespace {
+
+const int kNumIterations = 20000;
+
+// A mix of preloaded hosts, subdomains of preloaded hosts, and hosts which
+// aren't preloaded at all, as looked up while browsing.
+const char* const kHosts[] = {
+  "mail.google.com",
+  "www.google.com",
+  "a.b.c.docs.google.com",
+  "www.paypal.com",
+  "s.ytimg.com",
+  "check.torproject.org",
+  "www.example.com",
+  "static.example.net",
+  "a.very.deep.subdomain.of.example.org",
+  "en.wikipedia.org",
+};
+
+class TransportSecurityStatePerfTest : public testing::Test {
+  virtual void SetUp() {
+#if defined(USE_OPENSSL)
+    crypto::EnsureOpenSSLInit();
+#else
+    crypto::EnsureNSSInit();
+#endif
+  }
+};
+
+}  // namespace
+
+// Looks up the HSTS and pinning metadata of every host, as is done for every
+// request.
+TEST_F(TransportSecurityStatePerfTest, GetDomainState) {
+  TransportSecurityState state("");
+  TransportSecurityState::DomainState domain_state;
+
+  PerfTimeLogger timer("TransportSecurityState_GetDomainState");
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kHosts); ++j)
+      state.GetDomainState(&domain_state, kHosts[j], true);
+  }
+  timer.Done();
+}
+
+// Looks up only the preloaded pins of every host.
+TEST_F(TransportSecurityStatePerfTest, IsGooglePinnedProperty) {
+  PerfTimeLogger timer("TransportSecurityState_IsGooglePinnedProperty");
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kHosts); ++j)
+      TransportSecurityState::IsGooglePinnedProperty(kHosts[j], true);
+  }
+  timer.Done();
+}
+
+}  // namespace net
@@ -330,6 +330,42 @@ TEST_F(TransportSecurityStateTest, IsPreloaded) {
   EXPECT_FALSE(state.IsPreloadedSTS(aypal, true, &domain_state));
 }
 
+// Preloaded names are looked up by length first, so check that names which
+// have the same length as preloaded ones aren't confused with them.
+TEST_F(TransportSecurityStateTest, IsPreloadedSameLength) {
+  TransportSecurityState state("");
+  TransportSecurityState::DomainState domain_state;
+
+  // www.paypal.com, www.elanex.biz, googleplex.com and torproject.org are
+  // all preloaded, and all have the same length.
+  EXPECT_TRUE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("www.paypal.com"), true,
+      &domain_state));
+  EXPECT_EQ("www.paypal.com", domain_state.domain);
+  EXPECT_TRUE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("www.elanex.biz"), true,
+      &domain_state));
+  EXPECT_EQ("www.elanex.biz", domain_state.domain);
+  EXPECT_TRUE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("googleplex.com"), true,
+      &domain_state));
+  EXPECT_EQ("googleplex.com", domain_state.domain);
+  EXPECT_TRUE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("torproject.org"), true,
+      &domain_state));
+  EXPECT_EQ("torproject.org", domain_state.domain);
+
+  EXPECT_FALSE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("www.paypal.org"), true,
+      &domain_state));
+  EXPECT_FALSE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("aaaaaaaaaa.com"), true,
+      &domain_state));
+  EXPECT_FALSE(state.IsPreloadedSTS(
+      TransportSecurityState::CanonicalizeHost("zzzzzzzzzz.zzz"), true,
+      &domain_state));
+}
+
 TEST_F(TransportSecurityStateTest, PreloadedDomainSet) {
   TransportSecurityState state("");
   TransportSecurityState::DomainState domain_state;
@@ -28,6 +28,7 @@
 #include "net/disk_cache/file.h"
 #include "net/disk_cache/hash.h"
 #include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/sharded_backend.h"
 
 // This has to be defined before including histogram_macros.h from this file.
 #define NET_DISK_CACHE_BACKEND_IMPL_CC_
@@ -49,9 +50,17 @@ const int k64kEntriesStore = 240 * 1000 * 1000;
 const int kBaseTableLen = 64 * 1024;
 const int kDefaultCacheSize = 80 * 1024 * 1024;
 
+// The index table grows online (one bucket at a time) once the number of
+// entries goes over 75% of the number of buckets, up to a 16 MB table.
+const int kMaxIndexLoad = 75;
+const int kMaxIndexTableLen = kBaseTableLen * 64;
+
 // Avoid trimming the cache for the first 5 minutes (10 timer ticks).
 const int kTrimDelay = 10;
 
+// The number of cache threads used by CreateCacheBackend() for net::DISK_CACHE.
+int g_num_cache_shards = 1;
+
 int DesiredIndexTableLen(int32 storage_size) {
   if (storage_size <= k64kEntriesStore)
     return kBaseTableLen;
@@ -309,10 +318,26 @@ int CreateCacheBackend(net::CacheType type, const FilePath& path, int max_bytes,
   }
   DCHECK(thread);
 
+  if (type == net::DISK_CACHE && g_num_cache_shards > 1) {
+    return ShardedBackend::CreateBackend(path, g_num_cache_shards, force,
+                                         max_bytes, type, kNone, net_log,
+                                         backend, callback);
+  }
+
+  // Remove the shards left by a previous run with a sharded cache.
+  if (type == net::DISK_CACHE) {
+    thread->PostTask(FROM_HERE,
+                     base::Bind(&ShardedBackend::DeleteShards, path, 0));
+  }
+
   return BackendImpl::CreateBackend(path, force, max_bytes, type, kNone, thread,
                                     net_log, backend, callback);
 }
 
+void SetNumCacheShards(int num_shards) {
+  g_num_cache_shards = num_shards;
+}
+
 // Returns the preferred maximum number of bytes for the cache given the
 // number of available bytes.
 int PreferedCacheSize(int64 available) {
@@ -352,6 +377,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       block_files_(path),
       mask_(0),
       max_size_(0),
+      group_index_(0),
       up_ticks_(0),
       cache_type_(net::DISK_CACHE),
       uma_report_(0),
@@ -364,6 +390,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       new_eviction_(false),
       first_timer_(true),
       user_load_(false),
+      index_growth_failed_(false),
       net_log_(net_log),
       done_(true, false),
       ALLOW_THIS_IN_INITIALIZER_LIST(ptr_factory_(this)) {
@@ -378,6 +405,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       block_files_(path),
       mask_(mask),
       max_size_(0),
+      group_index_(0),
       up_ticks_(0),
       cache_type_(net::DISK_CACHE),
       uma_report_(0),
@@ -390,6 +418,7 @@ BackendImpl::BackendImpl(const FilePath& path,
       new_eviction_(false),
       first_timer_(true),
       user_load_(false),
+      index_growth_failed_(false),
       net_log_(net_log),
       done_(true, false),
       ALLOW_THIS_IN_INITIALIZER_LIST(ptr_factory_(this)) {
@@ -482,11 +511,22 @@ int BackendImpl::SyncInit() {
     return net::ERR_FAILED;
   }
 
+  // The frequency eviction group is only kept while it is requested, so that
+  // the profile can join other experiments once it goes away.
+  if (data_->header.experiment == EXPERIMENT_FREQUENCY_EVICTION &&
+      !(user_flags_ & kFrequencyEviction))
+    data_->header.experiment = NO_EXPERIMENT;
+
   if (!(user_flags_ & disk_cache::kNoRandom) &&
       cache_type_ == net::DISK_CACHE &&
       !InitExperiment(&data_->header, mask_))
     return net::ERR_FAILED;
 
+  // Don't override the group of any other experiment.
+  if ((user_flags_ & kFrequencyEviction) && cache_type_ == net::DISK_CACHE &&
+      data_->header.experiment == NO_EXPERIMENT)
+    data_->header.experiment = EXPERIMENT_FREQUENCY_EVICTION;
+
   // We don't care if the value overflows. The only thing we care about is that
   // the id cannot be zero, because that value is used as "not dirty".
   // Increasing the value once per second gives us many years before we start
@@ -736,7 +776,7 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
   Trace("Create hash 0x%x", hash);
 
   scoped_refptr<EntryImpl> parent;
-  Addr entry_address(data_->table[hash & mask_]);
+  Addr entry_address(data_->table[GetBucket(hash)]);
   if (entry_address.is_initialized()) {
     // We have an entry already. It could be the one we are looking for, or just
     // a hash conflict.
@@ -749,7 +789,7 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
     DCHECK(!error);
     if (parent_entry) {
       parent.swap(&parent_entry);
-    } else if (data_->table[hash & mask_]) {
+    } else if (data_->table[GetBucket(hash)]) {
       // We should have corrected the problem.
       NOTREACHED();
       return NULL;
@@ -811,12 +851,14 @@ EntryImpl* BackendImpl::CreateEntryImpl(const std::string& key) {
   if (parent.get()) {
     parent->SetNextAddress(entry_address);
   } else {
-    data_->table[hash & mask_] = entry_address.value();
+    data_->table[GetBucket(hash)] = entry_address.value();
   }
 
   // Link this entry through the lists.
   eviction_.OnCreateEntry(cache_entry);
 
+  MaybeGrowIndex();
+
   CACHE_UMA(AGE_MS, "CreateTime", GetSizeGroup(), start);
   stats_.OnEvent(Stats::CREATE_HIT);
   SIMPLE_STATS_COUNTER("disk_cache.miss");
@@ -855,6 +897,16 @@ void BackendImpl::SetType(net::CacheType type) {
   cache_type_ = type;
 }
 
+void BackendImpl::JoinEvictionGroup(EvictionGroup* group, int index) {
+  DCHECK(background_queue_.BackgroundIsCurrentThread());
+  eviction_group_ = group;
+  group_index_ = index;
+
+  // A disabled cache joins the group when it restarts.
+  if (!disabled_)
+    eviction_.JoinGroup();
+}
+
 FilePath BackendImpl::GetFileName(Addr address) const {
   if (!address.is_separate_file() || !address.is_initialized()) {
     NOTREACHED();
@@ -912,6 +964,12 @@ bool BackendImpl::CreateBlock(FileType block_type, int block_count,
   return block_files_.CreateBlock(block_type, block_count, block_address);
 }
 
+bool BackendImpl::CreateBlocks(FileType block_type, int num_entries,
+                               const int* block_counts, Addr* block_addresses) {
+  return block_files_.CreateBlocks(block_type, num_entries, block_counts,
+                                   block_addresses);
+}
+
 void BackendImpl::DeleteBlock(Addr block_address, bool deep) {
   block_files_.DeleteBlock(block_address, deep);
 }
@@ -938,10 +996,10 @@ void BackendImpl::RecoveredEntry(CacheRankingsBlock* rankings) {
   cache_entry->Release();
 
   // Anything on the table means that this entry is there.
-  if (data_->table[hash & mask_])
+  if (data_->table[GetBucket(hash)])
     return;
 
-  data_->table[hash & mask_] = address.value();
+  data_->table[GetBucket(hash)] = address.value();
 }
 
 void BackendImpl::InternalDoomEntry(EntryImpl* entry) {
@@ -968,7 +1026,7 @@ void BackendImpl::InternalDoomEntry(EntryImpl* entry) {
     parent_entry->SetNextAddress(Addr(child));
     parent_entry->Release();
   } else if (!error) {
-    data_->table[hash & mask_] = child;
+    data_->table[GetBucket(hash)] = child;
   }
 }
 
@@ -990,7 +1048,7 @@ CacheAddr BackendImpl::GetNextAddr(Addr address) {
 
 void BackendImpl::NotLinked(EntryImpl* entry) {
   Addr entry_addr = entry->entry()->address();
-  uint32 i = entry->GetHash() & mask_;
+  uint32 i = GetBucket(entry->GetHash());
   Addr address(data_->table[i]);
   if (!address.is_initialized())
     return;
@@ -1028,9 +1086,16 @@ void BackendImpl::OnEntryDestroyBegin(Addr address) {
 
 void BackendImpl::OnEntryDestroyEnd() {
   DecreaseNumRefs();
-  if (data_->header.num_bytes > max_size_ && !read_only_ &&
-      (up_ticks_ > kTrimDelay || user_flags_ & disk_cache::kNoRandom))
+  if (read_only_ ||
+      (up_ticks_ <= kTrimDelay && !(user_flags_ & disk_cache::kNoRandom)))
+    return;
+
+  // The group decides which member has to trim.
+  if (eviction_group_) {
+    eviction_group_->OnSizeChanged(group_index_, data_->header.num_bytes);
+  } else if (data_->header.num_bytes > max_size_) {
     eviction_.TrimCache(false);
+  }
 }
 
 EntryImpl* BackendImpl::GetOpenEntry(CacheRankingsBlock* rankings) const {
@@ -1451,9 +1516,9 @@ bool BackendImpl::CreateBackingStore(disk_cache::File* file) {
   IndexHeader header;
   header.table_len = DesiredIndexTableLen(max_size_);
 
-  // We need file version 2.1 for the new eviction algorithm.
+  // We need file version 3.1 for the new eviction algorithm.
   if (new_eviction_)
-    header.version = 0x20001;
+    header.version = 0x30001;
 
   header.create_time = Time::Now().ToInternalValue();
 
@@ -1573,6 +1638,7 @@ void BackendImpl::PrepareForRestart() {
   if (!(user_flags_ & kNewEviction))
     new_eviction_ = false;
 
+  index_growth_failed_ = false;
   disabled_ = true;
   data_->header.crash = 0;
   index_ = NULL;
@@ -1583,6 +1649,178 @@ void BackendImpl::PrepareForRestart() {
   restarted_ = true;
 }
 
+uint32 BackendImpl::GetBucket(uint32 hash) const {
+  // Buckets below the split point were already split on this round, so they
+  // use one more bit of the hash.
+  uint32 bucket = hash & mask_;
+  if (bucket < static_cast<uint32>(data_->header.split_point))
+    bucket = hash & ((mask_ << 1) | 1);
+  return bucket;
+}
+
+uint32 BackendImpl::NumBuckets() const {
+  return mask_ + 1 + data_->header.split_point;
+}
+
+void BackendImpl::MaybeGrowIndex() {
+  if (disabled_ || read_only_)
+    return;
+
+  // Unit tests use a small mask to force hash collisions.
+  if ((user_flags_ & kMask) && !(user_flags_ & kGrowIndex))
+    return;
+
+  int64 max_entries = static_cast<int64>(NumBuckets()) * kMaxIndexLoad / 100;
+  if (data_->header.num_entries <= max_entries)
+    return;
+
+  if (!data_->header.split_point) {
+    // We are starting a new round, so the table has to be able to hold twice
+    // the number of buckets of the current round.
+    int new_len = static_cast<int>(mask_ + 1) * 2;
+    if (new_len > kMaxIndexTableLen)
+      return;
+
+    if (new_len > data_->header.table_len) {
+      // Don't keep trying (and failing) on every new entry.
+      if (index_growth_failed_)
+        return;
+      if (!ResizeIndexFile(new_len)) {
+        index_growth_failed_ = true;
+        return;
+      }
+    }
+
+    data_->header.level_len = mask_ + 1;
+  }
+
+  SplitBucket();
+}
+
+void BackendImpl::SplitBucket() {
+  uint32 bucket = data_->header.split_point;
+  uint32 new_bucket = bucket + mask_ + 1;
+  uint32 high_bit = mask_ + 1;
+  DCHECK(!data_->table[new_bucket]);
+  Trace("Split bucket 0x%x", bucket);
+
+  // Walk the chain once, building two lists: the entries that stay on this
+  // bucket and the entries that move to |new_bucket|. The relative order of
+  // the entries is preserved on both lists. Entries that cannot be used are
+  // left out of both lists (so they are unlinked from the index), and the walk
+  // goes on with the rest of the chain.
+  Addr address(data_->table[bucket]);
+  scoped_refptr<EntryImpl> low_tail, high_tail;
+  CacheAddr low_head = 0, high_head = 0;
+  std::set<CacheAddr> visited;
+  std::vector<scoped_refptr<EntryImpl> > invalid_entries;
+  while (address.is_initialized()) {
+    if (visited.find(address.value()) != visited.end()) {
+      Trace("Hash collision loop on split 0x%x", address.value());
+      break;
+    }
+    visited.insert(address.value());
+
+    EntryImpl* tmp;
+    int error = NewEntry(address, &tmp);
+    if (error) {
+      // The entry is broken, but it may still tell us where the rest of the
+      // chain is. If it doesn't, the remaining entries will be reclaimed
+      // through the eviction lists.
+      Trace("NewEntry failed on SplitBucket 0x%x", address.value());
+      if (ERR_INVALID_ADDRESS == error)
+        break;
+      CacheEntryBlock entry_block(File(address), address);
+      if (!entry_block.Load())
+        break;
+      address.set_value(entry_block.Data()->next);
+      continue;
+    }
+    scoped_refptr<EntryImpl> cache_entry;
+    cache_entry.swap(&tmp);
+    Addr next(cache_entry->GetNextAddress());
+
+    if (cache_entry->dirty()) {
+      // This entry is dirty on disk (it was not properly closed): we cannot
+      // trust it.
+      Trace("SplitBucket dirty 0x%x", address.value());
+      invalid_entries.push_back(cache_entry);
+      address.set_value(next.value());
+      continue;
+    }
+
+    if (!cache_entry->Update()) {
+      address.set_value(next.value());
+      continue;
+    }
+
+    if (cache_entry->GetHash() & high_bit) {
+      if (high_tail && high_tail->GetNextAddress() != address.value())
+        high_tail->SetNextAddress(address);
+      else if (!high_tail)
+        high_head = address.value();
+      high_tail = cache_entry;
+    } else {
+      if (low_tail && low_tail->GetNextAddress() != address.value())
+        low_tail->SetNextAddress(address);
+      else if (!low_tail)
+        low_head = address.value();
+      low_tail = cache_entry;
+    }
+    address.set_value(next.value());
+  }
+
+  if (low_tail && low_tail->GetNextAddress())
+    low_tail->SetNextAddress(Addr(0));
+  if (high_tail && high_tail->GetNextAddress())
+    high_tail->SetNextAddress(Addr(0));
+
+  // Publish the new bucket before advancing the split point, so that a crash
+  // leaves (at worst) a few entries that cannot be reached through the index.
+  data_->table[new_bucket] = high_head;
+  data_->table[bucket] = low_head;
+
+  // It is important to call DestroyInvalidEntry after removing the entries
+  // from the table.
+  for (size_t i = 0; i < invalid_entries.size(); i++)
+    DestroyInvalidEntry(invalid_entries[i]);
+
+  data_->header.split_point++;
+  if (static_cast<uint32>(data_->header.split_point) == high_bit) {
+    // This round is complete.
+    mask_ = (mask_ << 1) | 1;
+    data_->header.level_len = mask_ + 1;
+    data_->header.split_point = 0;
+  }
+}
+
+bool BackendImpl::ResizeIndexFile(int table_len) {
+  DCHECK_GT(table_len, data_->header.table_len);
+  if (!index_->SetLength(GetIndexSize(table_len))) {
+    LOG(ERROR) << "Unable to extend the index file";
+    return false;
+  }
+
+  // Map the file again before releasing the current view, so that we can keep
+  // using the old table if something goes wrong.
+  scoped_refptr<MappedFile> new_index(new MappedFile());
+  Index* new_data = reinterpret_cast<Index*>(
+      new_index->Init(path_.AppendASCII(kIndexName), 0));
+  if (!new_data) {
+    LOG(ERROR) << "Unable to map Index file";
+    return false;
+  }
+
+  index_.swap(new_index);
+  data_ = new_data;
+  new_index = NULL;
+
+  data_->header.table_len = table_len;
+  eviction_.UpdateIndexHeader();
+  rankings_.UpdateControlData();
+  return true;
+}
+
 int BackendImpl::NewEntry(Addr address, EntryImpl** entry) {
   EntriesMap::iterator it = open_entries_.find(address.value());
   if (it != open_entries_.end()) {
@@ -1664,7 +1902,7 @@ int BackendImpl::NewEntry(Addr address, EntryImpl** entry) {
 EntryImpl* BackendImpl::MatchEntry(const std::string& key, uint32 hash,
                                    bool find_parent, Addr entry_addr,
                                    bool* match_error) {
-  Addr address(data_->table[hash & mask_]);
+  Addr address(data_->table[GetBucket(hash)]);
   scoped_refptr<EntryImpl> cache_entry, parent_entry;
   EntryImpl* tmp = NULL;
   bool found = false;
@@ -1704,7 +1942,7 @@ EntryImpl* BackendImpl::MatchEntry(const std::string& key, uint32 hash,
         parent_entry->SetNextAddress(child);
         parent_entry = NULL;
       } else {
-        data_->table[hash & mask_] = child.value();
+        data_->table[GetBucket(hash)] = child.value();
       }
 
       Trace("MatchEntry dirty %d 0x%x 0x%x", find_parent, entry_addr.value(),
@@ -1720,12 +1958,12 @@ EntryImpl* BackendImpl::MatchEntry(const std::string& key, uint32 hash,
       }
 
       // Restart the search.
-      address.set_value(data_->table[hash & mask_]);
+      address.set_value(data_->table[GetBucket(hash)]);
       visited.clear();
       continue;
     }
 
-    DCHECK_EQ(hash & mask_, cache_entry->entry()->Data()->hash & mask_);
+    DCHECK_EQ(GetBucket(hash), GetBucket(cache_entry->entry()->Data()->hash));
     if (cache_entry->IsSameEntry(key, hash)) {
       if (!cache_entry->Update())
         cache_entry = NULL;
@@ -2051,7 +2289,7 @@ void BackendImpl::ReportStats() {
   CACHE_UMA(COUNTS, "EntriesFull", 0, data_->header.num_entries);
 
   CACHE_UMA(PERCENTAGE, "IndexLoad", 0,
-            data_->header.num_entries * 100 / (mask_ + 1));
+            data_->header.num_entries * 100 / NumBuckets());
 
   int large_entries_bytes = stats_.GetLargeEntriesSize();
   int large_ratio = large_entries_bytes * 100 / data_->header.num_bytes;
@@ -2077,11 +2315,21 @@ void BackendImpl::ReportStats() {
     block_files_.ReportStats();
 }
 
-void BackendImpl::UpgradeTo2_1() {
-  // 2.1 is basically the same as 2.0, except that new fields are actually
+void BackendImpl::UpgradeFrom2_x() {
+  // 3.x is the same as 2.x, except that 2.x files don't know about the state of
+  // the split round of the table (and 2.x code would ignore it), so the fields
+  // are cleared before using them.
+  DCHECK_EQ(2u, data_->header.version >> 16);
+  data_->header.version += 0x10000;
+  data_->header.level_len = 0;
+  data_->header.split_point = 0;
+}
+
+void BackendImpl::UpgradeTo3_1() {
+  // 3.1 is basically the same as 3.0, except that new fields are actually
   // updated by the new eviction algorithm.
-  DCHECK(0x20000 == data_->header.version);
-  data_->header.version = 0x20001;
+  DCHECK(0x30000 == data_->header.version);
+  data_->header.version = 0x30001;
   data_->header.lru.sizes[Rankings::NO_USE] = data_->header.num_entries;
 }
 
@@ -2094,16 +2342,19 @@ bool BackendImpl::CheckIndex() {
     return false;
   }
 
+  if (kIndexMagic == data_->header.magic && 2 == data_->header.version >> 16)
+    UpgradeFrom2_x();
+
   if (new_eviction_) {
-    // We support versions 2.0 and 2.1, upgrading 2.0 to 2.1.
+    // We support versions 3.0 and 3.1, upgrading 3.0 to 3.1.
     if (kIndexMagic != data_->header.magic ||
         kCurrentVersion >> 16 != data_->header.version >> 16) {
       LOG(ERROR) << "Invalid file version or magic";
       return false;
     }
     if (kCurrentVersion == data_->header.version) {
-      // We need file version 2.1 for the new eviction algorithm.
-      UpgradeTo2_1();
+      // We need file version 3.1 for the new eviction algorithm.
+      UpgradeTo3_1();
     }
   } else {
     if (kIndexMagic != data_->header.magic ||
@@ -2140,6 +2391,23 @@ bool BackendImpl::CheckIndex() {
     return false;
   }
 
+  if (data_->header.level_len) {
+    // The table was resized online, so the split round stored on the file
+    // determines the mask, even if the user provided one.
+    int level_len = data_->header.level_len;
+    int split_point = data_->header.split_point;
+    if (level_len < 0 || level_len & (level_len - 1) || split_point < 0 ||
+        split_point >= level_len || level_len > data_->header.table_len ||
+        (split_point && level_len * 2 > data_->header.table_len)) {
+      LOG(ERROR) << "Invalid index split state";
+      return false;
+    }
+    mask_ = level_len - 1;
+  } else if (data_->header.split_point) {
+    LOG(ERROR) << "Invalid index split state";
+    return false;
+  }
+
   if (!mask_)
     mask_ = data_->header.table_len - 1;
 
@@ -2152,7 +2420,8 @@ int BackendImpl::CheckAllEntries() {
   int num_dirty = 0;
   int num_entries = 0;
   DCHECK(mask_ < kuint32max);
-  for (unsigned int i = 0; i <= mask_; i++) {
+  uint32 num_buckets = NumBuckets();
+  for (uint32 i = 0; i < num_buckets; i++) {
     Addr address(data_->table[i]);
     if (!address.is_initialized())
       continue;
@@ -2173,7 +2442,7 @@ int BackendImpl::CheckAllEntries() {
       else
         return ERR_INVALID_ENTRY;
 
-      DCHECK_EQ(i, cache_entry->entry()->Data()->hash & mask_);
+      DCHECK_EQ(i, GetBucket(cache_entry->entry()->Data()->hash));
       address.set_value(cache_entry->GetNextAddress());
       if (!address.is_initialized())
         break;
@@ -2207,21 +2476,22 @@ bool BackendImpl::CheckEntry(EntryImpl* cache_entry) {
 }
 
 int BackendImpl::MaxBuffersSize() {
-  static int64 total_memory = base::SysInfo::AmountOfPhysicalMemory();
-  static bool done = false;
+  // This may be called from more than one cache thread, so the value is
+  // computed on a local variable and only then stored (always the same value).
+  static int max_buffers_size = 0;
 
-  if (!done) {
+  if (!max_buffers_size) {
     const int kMaxBuffersSize = 30 * 1024 * 1024;
 
     // We want to use up to 2% of the computer's memory.
-    total_memory = total_memory * 2 / 100;
+    int64 total_memory = base::SysInfo::AmountOfPhysicalMemory() * 2 / 100;
     if (total_memory > kMaxBuffersSize || total_memory <= 0)
       total_memory = kMaxBuffersSize;
 
-    done = true;
+    max_buffers_size = static_cast<int>(total_memory);
   }
 
-  return static_cast<int>(total_memory);
+  return max_buffers_size;
 }
 
 }  // namespace disk_cache
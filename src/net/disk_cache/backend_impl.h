@@ -14,6 +14,7 @@
 #include "net/disk_cache/block_files.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/eviction.h"
+#include "net/disk_cache/eviction_group.h"
 #include "net/disk_cache/in_flight_backend_io.h"
 #include "net/disk_cache/rankings.h"
 #include "net/disk_cache/stats.h"
@@ -35,7 +36,9 @@ enum BackendFlags {
   kNewEviction = 1 << 4,        // Use of new eviction was specified.
   kNoRandom = 1 << 5,           // Don't add randomness to the behavior.
   kNoLoadProtection = 1 << 6,   // Don't act conservatively under load.
-  kNoBuffering = 1 << 7         // Disable extended IO buffering.
+  kNoBuffering = 1 << 7,        // Disable extended IO buffering.
+  kGrowIndex = 1 << 8,          // Grow the index table even if kMask is set.
+  kFrequencyEviction = 1 << 9   // Use the frequency eviction experiment.
 };
 
 // This class implements the Backend interface. An object of this
@@ -94,6 +97,11 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Sets the cache type for this backend.
   void SetType(net::CacheType type);
 
+  // Makes this instance share its size limit with the other members of
+  // |group|, as member |index|. Must be called on the cache thread, after the
+  // initialization completes.
+  void JoinEvictionGroup(EvictionGroup* group, int index);
+
   // Returns the full name for an external storage file.
   FilePath GetFileName(Addr address) const;
 
@@ -111,6 +119,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   bool CreateBlock(FileType block_type, int block_count,
                    Addr* block_address);
 
+  // Creates |num_entries| storage blocks at once. See BlockFiles::CreateBlocks.
+  bool CreateBlocks(FileType block_type, int num_entries,
+                    const int* block_counts, Addr* block_addresses);
+
   // Deletes a given storage block. deep set to true can be used to zero-fill
   // the related storage in addition of releasing the related block.
   void DeleteBlock(Addr block_address, bool deep);
@@ -291,6 +303,24 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   void RestartCache(bool failure);
   void PrepareForRestart();
 
+  // Returns the index table bucket that stores entries with the given |hash|.
+  uint32 GetBucket(uint32 hash) const;
+
+  // Returns the number of buckets currently in use by the index table.
+  uint32 NumBuckets() const;
+
+  // Grows the index table by splitting one bucket, if the load factor of the
+  // table is too high. This is the only place where the table grows, so the
+  // cost of resizing is distributed across entry creations.
+  void MaybeGrowIndex();
+
+  // Moves the entries of the next bucket to split that belong to the upper
+  // half of the table to their new bucket.
+  void SplitBucket();
+
+  // Extends the index file to hold |table_len| buckets and maps it again.
+  bool ResizeIndexFile(int table_len);
+
   // Creates a new entry object. Returns zero on success, or a disk_cache error
   // on failure.
   int NewEntry(Addr address, EntryImpl** entry);
@@ -339,8 +369,9 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Send UMA stats.
   void ReportStats();
 
-  // Upgrades the index file to version 2.1.
-  void UpgradeTo2_1();
+  // Upgrade the index file from version 2.x to 3.x, and from 3.0 to 3.1.
+  void UpgradeFrom2_x();
+  void UpgradeTo3_1();
 
   // Performs basic checks on the index file. Returns false on failure.
   bool CheckIndex();
@@ -360,9 +391,11 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   Index* data_;  // Pointer to the index data.
   BlockFiles block_files_;  // Set of files used to store all data.
   Rankings rankings_;  // Rankings to be able to trim the cache.
-  uint32 mask_;  // Binary mask to map a hash to the hash table.
+  uint32 mask_;  // Binary mask to map a hash to the current split round.
   int32 max_size_;  // Maximum data size for this instance.
   Eviction eviction_;  // Handler of the eviction algorithm.
+  scoped_refptr<EvictionGroup> eviction_group_;  // Shared size limit, if any.
+  int group_index_;  // Our index on |eviction_group_|.
   EntriesMap open_entries_;  // Map of open entries.
   int num_refs_;  // Number of referenced cache entries.
   int max_refs_;  // Max number of referenced cache entries.
@@ -382,6 +415,7 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   bool new_eviction_;  // What eviction algorithm should be used.
   bool first_timer_;  // True if the timer has not been called.
   bool user_load_;  // True if we see a high load coming from the caller.
+  bool index_growth_failed_;  // True if the index file could not be extended.
 
   net::NetLog* net_log_;
 
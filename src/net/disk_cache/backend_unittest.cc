@@ -17,6 +17,8 @@
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
 #include "net/disk_cache/entry_impl.h"
+#include "net/disk_cache/experiments.h"
+#include "net/disk_cache/hash.h"
 #include "net/disk_cache/histogram_macros.h"
 #include "net/disk_cache/mapped_file.h"
 #include "net/disk_cache/mem_backend_impl.h"
@@ -28,6 +30,54 @@
 
 using base::Time;
 
+namespace {
+
+// Returns the experiment group recorded in the index of the cache at |path|.
+int GetExperimentGroup(const FilePath& path) {
+  std::string index;
+  if (!file_util::ReadFileToString(path.AppendASCII("index"), &index) ||
+      index.size() < sizeof(disk_cache::IndexHeader))
+    return -1;
+  return reinterpret_cast<const disk_cache::IndexHeader*>(
+      index.data())->experiment;
+}
+
+// Records |group| as the experiment group in the index of the cache at |path|.
+bool SetExperimentGroup(const FilePath& path, int group) {
+  FilePath name = path.AppendASCII("index");
+  std::string index;
+  if (!file_util::ReadFileToString(name, &index) ||
+      index.size() < sizeof(disk_cache::IndexHeader))
+    return false;
+  reinterpret_cast<disk_cache::IndexHeader*>(&index[0])->experiment = group;
+  int size = static_cast<int>(index.size());
+  return file_util::WriteFile(name, index.data(), size) == size;
+}
+
+// Returns the version of the cache file |name|. The index and the block files
+// store it right after the magic number.
+uint32 GetFileVersion(const FilePath& name) {
+  std::string data;
+  if (!file_util::ReadFileToString(name, &data) ||
+      data.size() < sizeof(disk_cache::BlockFileHeader))
+    return 0;
+  return reinterpret_cast<const disk_cache::BlockFileHeader*>(
+      data.data())->version;
+}
+
+// Records |version| as the version of the cache file |name|.
+bool SetFileVersion(const FilePath& name, uint32 version) {
+  std::string data;
+  if (!file_util::ReadFileToString(name, &data) ||
+      data.size() < sizeof(disk_cache::BlockFileHeader))
+    return false;
+  reinterpret_cast<disk_cache::BlockFileHeader*>(&data[0])->version = version;
+  int size = static_cast<int>(data.size());
+  return file_util::WriteFile(name, data.data(), size) == size;
+}
+
+}  // namespace
+
 // Tests that can run with different types of caches.
 class DiskCacheBackendTest : public DiskCacheTestWithCache {
  protected:
@@ -35,6 +85,10 @@ class DiskCacheBackendTest : public DiskCacheTestWithCache {
   void BackendKeying();
   void BackendSetSize();
   void BackendLoad();
+  void BackendGrowIndex();
+  void BackendGrowIndexInvalidEntry();
+  int BackendFrequencyEviction();
+  void BackendFrequencyEvictionTrimPasses();
   void BackendValidEntry();
   void BackendInvalidEntry();
   void BackendInvalidEntryRead();
@@ -511,6 +565,275 @@ TEST_F(DiskCacheBackendTest, AppCacheLoad) {
   BackendLoad();
 }
 
+// Tests that the index table grows while the cache is in use, and that all the
+// entries remain reachable after the cache is reopened.
+void DiskCacheBackendTest::BackendGrowIndex() {
+  // Start with a tiny index table (16 entries) and let it grow.
+  SetMask(0xf);
+  SetMaxSize(0x100000);
+  InitCache();
+  cache_impl_->SetFlags(disk_cache::kGrowIndex);
+
+  int seed = static_cast<int>(Time::Now().ToInternalValue());
+  srand(seed);
+
+  const int kNumEntries = 300;
+  std::string keys[kNumEntries];
+  for (int i = 0; i < kNumEntries; i++) {
+    keys[i] = GenerateKey(true);
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, CreateEntry(keys[i], &entry));
+    entry->Close();
+  }
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, OpenEntry(keys[i], &entry));
+    entry->Close();
+  }
+
+  // The mask stored on the index file should override the one from the test.
+  SimulateCrash();
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, OpenEntry(keys[i], &entry)) << keys[i];
+    entry->Close();
+  }
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+}
+
+TEST_F(DiskCacheBackendTest, GrowIndex) {
+  BackendGrowIndex();
+}
+
+TEST_F(DiskCacheBackendTest, NewEvictionGrowIndex) {
+  SetNewEviction();
+  BackendGrowIndex();
+}
+
+// Tests that splitting a bucket with a corrupt entry keeps the entries that
+// follow it on the chain.
+void DiskCacheBackendTest::BackendGrowIndexInvalidEntry() {
+  SetMask(0xf);
+  SetMaxSize(0x100000);
+  SetDirectMode();
+  InitCache();
+
+  // Fill the table without letting it grow, until bucket 0 (the first one to
+  // be split) has a few entries.
+  const int kNumEntries = 40;
+  std::vector<std::string> bucket_keys;
+  int i = 0;
+  for (; i < kNumEntries || bucket_keys.size() < 4; i++) {
+    std::string key = base::StringPrintf("key %d", i);
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+    if (!(disk_cache::Hash(key) & 0xf))
+      bucket_keys.push_back(key);
+    entry->Close();
+  }
+
+  // Corrupt the first entry of bucket 0 (the head of the chain).
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, OpenEntry(bucket_keys[0], &entry));
+  disk_cache::EntryImpl* entry_impl =
+      static_cast<disk_cache::EntryImpl*>(entry);
+  entry_impl->entry()->Data()->state = 0xbad;
+  entry_impl->entry()->Store();
+  entry->Close();
+  FlushQueueForTest();
+
+  // Now add an entry that doesn't go to bucket 0, and split that bucket.
+  cache_impl_->SetFlags(disk_cache::kGrowIndex);
+  std::string key;
+  for (; key.empty() || !(disk_cache::Hash(key) & 0xf); i++)
+    key = base::StringPrintf("key %d", i);
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+  entry->Close();
+
+  for (size_t j = 1; j < bucket_keys.size(); j++) {
+    ASSERT_EQ(net::OK, OpenEntry(bucket_keys[j], &entry)) << bucket_keys[j];
+    entry->Close();
+  }
+  EXPECT_NE(net::OK, OpenEntry(bucket_keys[0], &entry));
+  DisableIntegrityCheck();
+}
+
+TEST_F(DiskCacheBackendTest, GrowIndexInvalidEntry) {
+  BackendGrowIndexInvalidEntry();
+}
+
+TEST_F(DiskCacheBackendTest, NewEvictionGrowIndexInvalidEntry) {
+  SetNewEviction();
+  BackendGrowIndexInvalidEntry();
+}
+
+// Tests that a cache from version 2.0 (which never grew) is upgraded.
+TEST_F(DiskCacheBackendTest, UpgradeVersion2) {
+  InitCache();
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry("some key", &entry));
+  entry->Close();
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+
+  const char* kFiles[] = { "index", "data_0", "data_1", "data_2", "data_3" };
+  for (size_t i = 0; i < arraysize(kFiles); i++)
+    ASSERT_TRUE(SetFileVersion(cache_path_.AppendASCII(kFiles[i]), 0x20000));
+
+  DisableFirstCleanup();
+  InitCache();
+  ASSERT_EQ(net::OK, OpenEntry("some key", &entry));
+  entry->Close();
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+
+  for (size_t i = 0; i < arraysize(kFiles); i++) {
+    EXPECT_EQ(disk_cache::kCurrentVersion,
+              GetFileVersion(cache_path_.AppendASCII(kFiles[i])));
+  }
+}
+
+// Uses a set of entries several times, and then goes through a scan of new
+// entries (each one used only once) big enough to fill the cache. Returns the
+// number of frequently used entries that survive the scan.
+int DiskCacheBackendTest::BackendFrequencyEviction() {
+  const int kCacheSize = 0x200000;  // 2 MB
+  const int kEntrySize = 0x4000;
+  const int kNumHotEntries = 20;
+  const int kNumScanEntries = 200;
+  SetMaxSize(kCacheSize);
+  SetDirectMode();
+  InitCache();
+
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kEntrySize));
+  CacheTestFillBuffer(buffer->data(), kEntrySize, false);
+
+  disk_cache::Entry* entry;
+  for (int i = 0; i < kNumHotEntries; i++) {
+    std::string key = base::StringPrintf("hot %d", i);
+    EXPECT_EQ(net::OK, CreateEntry(key, &entry));
+    EXPECT_EQ(kEntrySize, WriteData(entry, 0, 0, buffer, kEntrySize, false));
+    entry->Close();
+  }
+  for (int j = 0; j < 4; j++) {
+    for (int i = 0; i < kNumHotEntries; i++) {
+      EXPECT_EQ(net::OK, OpenEntry(base::StringPrintf("hot %d", i), &entry));
+      entry->Close();
+    }
+  }
+
+  for (int i = 0; i < kNumScanEntries; i++) {
+    std::string key = base::StringPrintf("scan %d", i);
+    EXPECT_EQ(net::OK, CreateEntry(key, &entry));
+    EXPECT_EQ(kEntrySize, WriteData(entry, 0, 0, buffer, kEntrySize, false));
+    entry->Close();
+  }
+  FlushQueueForTest();  // Make sure that we are done trimming the cache.
+  FlushQueueForTest();
+
+  EXPECT_GT(kCacheSize / kEntrySize, cache_->GetEntryCount());
+  int hot_entries = 0;
+  for (int i = 0; i < kNumHotEntries; i++) {
+    if (OpenEntry(base::StringPrintf("hot %d", i), &entry) == net::OK) {
+      hot_entries++;
+      entry->Close();
+    }
+  }
+  return hot_entries;
+}
+
+TEST_F(DiskCacheBackendTest, FrequencyEvictionControl) {
+  // Plain LRU keeps only the most recent entries.
+  EXPECT_EQ(0, BackendFrequencyEviction());
+}
+
+TEST_F(DiskCacheBackendTest, FrequencyEviction) {
+  SetFrequencyEviction();
+  EXPECT_EQ(20, BackendFrequencyEviction());
+}
+
+TEST_F(DiskCacheBackendTest, NewEvictionFrequencyEviction) {
+  SetNewEviction();
+  SetFrequencyEviction();
+  EXPECT_EQ(20, BackendFrequencyEviction());
+}
+
+// Each trim pass has its own limit of entries to keep, so frequently used
+// entries survive many more passes than that limit.
+void DiskCacheBackendTest::BackendFrequencyEvictionTrimPasses() {
+  SetFrequencyEviction();
+  SetDirectMode();
+  InitCache();
+
+  const int kNumHotEntries = 5;
+  disk_cache::Entry* entry;
+  for (int i = 0; i < kNumHotEntries; i++) {
+    std::string key = base::StringPrintf("hot %d", i);
+    ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+    entry->Close();
+    for (int j = 0; j < 3; j++) {
+      ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+      entry->Close();
+    }
+  }
+  // The last entry added to the cache is the one to compare with.
+  ASSERT_EQ(net::OK, CreateEntry("new entry", &entry));
+  entry->Close();
+
+  // In test mode, each trim pass looks at a single entry. The hot entry at the
+  // tail of the list is used more often than the new entry, so it is kept.
+  for (int i = 0; i < 200; i++)
+    TrimForTest(false);
+
+  for (int i = 0; i < kNumHotEntries; i++) {
+    ASSERT_EQ(net::OK, OpenEntry(base::StringPrintf("hot %d", i), &entry));
+    entry->Close();
+  }
+}
+
+TEST_F(DiskCacheBackendTest, FrequencyEvictionTrimPasses) {
+  BackendFrequencyEvictionTrimPasses();
+}
+
+TEST_F(DiskCacheBackendTest, NewEvictionFrequencyEvictionTrimPasses) {
+  SetNewEviction();
+  BackendFrequencyEvictionTrimPasses();
+}
+
+// The frequency eviction group stays in the index only while it is requested,
+// and it doesn't replace the group of another experiment.
+TEST_F(DiskCacheBackendTest, FrequencyEvictionExperimentGroup) {
+  SetFrequencyEviction();
+  InitCache();
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+  EXPECT_EQ(disk_cache::EXPERIMENT_FREQUENCY_EVICTION,
+            GetExperimentGroup(cache_path_));
+
+  DisableFirstCleanup();
+  frequency_eviction_ = false;
+  InitCache();
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+  EXPECT_EQ(disk_cache::NO_EXPERIMENT, GetExperimentGroup(cache_path_));
+
+  ASSERT_TRUE(SetExperimentGroup(cache_path_,
+                                 disk_cache::EXPERIMENT_DELETED_LIST_CONTROL));
+  frequency_eviction_ = true;
+  InitCache();
+  delete cache_;
+  cache_ = NULL;
+  cache_impl_ = NULL;
+  EXPECT_EQ(disk_cache::EXPERIMENT_DELETED_LIST_CONTROL,
+            GetExperimentGroup(cache_path_));
+}
+
 TEST_F(DiskCacheBackendTest, NewEvictionTrim) {
   SetNewEviction();
   SetDirectMode();
@@ -33,6 +33,70 @@ inline int GetMapBlockType(uint8 value) {
 
 void FixAllocationCounters(disk_cache::BlockFileHeader* header);
 
+// Returns a mask with the high bit of every nibble of |map_block| set when that
+// nibble is of the given |target| type (see GetMapBlockType()). All the nibbles
+// of the word are tested at once, so words without a suitable block are skipped
+// without looking at each nibble.
+inline uint32 GetMapBlockTypeMask(uint32 map_block, int target) {
+  const uint32 kHighBits = 0x88888888;
+  uint32 free_bits = ~map_block;
+
+  // A nibble is of type |target| when its |target| highest bits are free and
+  // the next one (if any) is used.
+  uint32 mask = kHighBits;
+  for (int i = 0; i < target; i++)
+    mask &= free_bits << i;
+  if (target < disk_cache::kMaxNumBlocks)
+    mask &= ~(free_bits << target);
+  return mask;
+}
+
+// Finds an empty block of the given |target| type on the allocation map and
+// marks |size| blocks of it as used, updating the apropriate counters. The
+// caller should be holding a FileLock for this header.
+bool AllocateMapBlock(int target, int size, disk_cache::BlockFileHeader* header,
+                      int* index) {
+  // We are going to process the map on 32-block chunks (32 bits), looking at
+  // the 8 nibbles of every chunk at the same time.
+  int current = header->hints[target - 1];
+  for (int i = 0; i < header->max_entries / 32; i++, current++) {
+    if (current == header->max_entries / 32)
+      current = 0;
+    uint32 mask = GetMapBlockTypeMask(header->allocation_map[current], target);
+    if (!mask)
+      continue;
+
+    int j = 0;
+    for (; !(mask & 0x8); j++, mask >>= 4) {}
+
+    int index_offset = j * 4 + 4 - target;
+    *index = current * 32 + index_offset;
+    DCHECK_EQ(*index / 4, (*index + size - 1) / 4);
+    uint32 to_add = ((1 << size) - 1) << index_offset;
+    header->allocation_map[current] |= to_add;
+
+    header->hints[target - 1] = current;
+    header->empty[target - 1]--;
+    DCHECK_GE(header->empty[target - 1], 0);
+    header->num_entries++;
+    if (target != size) {
+      header->empty[target - size - 1]++;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Returns the type of block (number of empty blocks) to use for a new entry of
+// |size| blocks, or 0 if there is no space for it on this file.
+int GetTargetSize(int size, const disk_cache::BlockFileHeader* header) {
+  for (int i = size; i <= disk_cache::kMaxNumBlocks; i++) {
+    if (header->empty[i - 1])
+      return i;
+  }
+  return 0;
+}
+
 // Creates a new entry on the allocation map, updating the apropriate counters.
 // target is the type of block to use (number of empty blocks), and size is the
 // actual number of blocks to use.
@@ -45,32 +109,9 @@ bool CreateMapBlock(int target, int size, disk_cache::BlockFileHeader* header,
   }
 
   TimeTicks start = TimeTicks::Now();
-  // We are going to process the map on 32-block chunks (32 bits), and on every
-  // chunk, iterate through the 8 nibbles where the new block can be located.
-  int current = header->hints[target - 1];
-  for (int i = 0; i < header->max_entries / 32; i++, current++) {
-    if (current == header->max_entries / 32)
-      current = 0;
-    uint32 map_block = header->allocation_map[current];
-
-    for (int j = 0; j < 8; j++, map_block >>= 4) {
-      if (GetMapBlockType(map_block) != target)
-        continue;
-
-      disk_cache::FileLock lock(header);
-      int index_offset = j * 4 + 4 - target;
-      *index = current * 32 + index_offset;
-      DCHECK_EQ(*index / 4, (*index + size - 1) / 4);
-      uint32 to_add = ((1 << size) - 1) << index_offset;
-      header->allocation_map[current] |= to_add;
-
-      header->hints[target - 1] = current;
-      header->empty[target - 1]--;
-      DCHECK_GE(header->empty[target - 1], 0);
-      header->num_entries++;
-      if (target != size) {
-        header->empty[target - size - 1]++;
-      }
+  {
+    disk_cache::FileLock lock(header);
+    if (AllocateMapBlock(target, size, header, index)) {
       HISTOGRAM_TIMES("DiskCache.CreateBlock", TimeTicks::Now() - start);
       return true;
     }
@@ -182,6 +223,43 @@ bool NeedToGrowBlockFile(const disk_cache::BlockFileHeader* header,
   return !have_space;
 }
 
+// Creates up to |num_entries| new entries on the allocation map, where |sizes|
+// holds the number of blocks of each entry, and returns the number of entries
+// created (the start of each one is stored on |indexes|). All the entries are
+// created under a single FileLock, and the scan for each entry resumes where
+// the previous one of the same type stopped.
+int CreateMapBlocks(int num_entries, const int* sizes,
+                    disk_cache::BlockFileHeader* header, int* indexes) {
+  TimeTicks start = TimeTicks::Now();
+  bool failed = false;
+  int created = 0;
+  {
+    disk_cache::FileLock lock(header);
+    for (; created < num_entries; created++) {
+      int size = sizes[created];
+      if (created && NeedToGrowBlockFile(header, size))
+        break;
+
+      int target = GetTargetSize(size, header);
+      DCHECK(created || target);
+      if (!target)
+        break;
+
+      if (!AllocateMapBlock(target, size, header, &indexes[created])) {
+        failed = true;
+        break;
+      }
+    }
+  }
+
+  if (failed) {
+    LOG(ERROR) << "Failing CreateMapBlocks";
+    FixAllocationCounters(header);
+  }
+  HISTOGRAM_TIMES("DiskCache.CreateBlocks", TimeTicks::Now() - start);
+  return created;
+}
+
 }  // namespace
 
 namespace disk_cache {
@@ -253,14 +331,7 @@ bool BlockFiles::CreateBlock(FileType block_type, int block_count,
 
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
 
-  int target_size = 0;
-  for (int i = block_count; i <= 4; i++) {
-    if (header->empty[i - 1]) {
-      target_size = i;
-      break;
-    }
-  }
-
+  int target_size = GetTargetSize(block_count, header);
   DCHECK(target_size);
   int index;
   if (!CreateMapBlock(target_size, block_count, header, &index))
@@ -272,6 +343,50 @@ bool BlockFiles::CreateBlock(FileType block_type, int block_count,
   return true;
 }
 
+bool BlockFiles::CreateBlocks(FileType block_type, int num_entries,
+                              const int* block_counts, Addr* block_addresses) {
+  DCHECK(thread_checker_->CalledOnValidThread());
+  if (block_type < RANKINGS || block_type > BLOCK_4K || num_entries < 1)
+    return false;
+  for (int i = 0; i < num_entries; i++) {
+    if (block_counts[i] < 1 || block_counts[i] > 4)
+      return false;
+  }
+  if (!init_)
+    return false;
+
+  std::vector<int> indexes(num_entries);
+  int created = 0;
+  while (created < num_entries) {
+    MappedFile* file = FileForNewBlock(block_type, block_counts[created]);
+    if (!file)
+      break;
+
+    BlockFileHeader* header =
+        reinterpret_cast<BlockFileHeader*>(file->buffer());
+    int count = CreateMapBlocks(num_entries - created, &block_counts[created],
+                                header, &indexes[created]);
+    for (int i = created; i < created + count; i++) {
+      Addr address(block_type, block_counts[i], header->this_file, indexes[i]);
+      block_addresses[i].set_value(address.value());
+      Trace("CreateBlocks 0x%x", address.value());
+    }
+    if (!count)
+      break;
+    created += count;
+  }
+
+  if (created == num_entries)
+    return true;
+
+  // Don't leave a partial set of blocks around.
+  for (int i = 0; i < created; i++) {
+    DeleteBlock(block_addresses[i], false);
+    block_addresses[i].set_value(0);
+  }
+  return false;
+}
+
 void BlockFiles::DeleteBlock(Addr address, bool deep) {
   DCHECK(thread_checker_->CalledOnValidThread());
   if (!address.is_initialized() || address.is_separate_file())
@@ -408,11 +523,16 @@ bool BlockFiles::OpenBlockFile(int index) {
   }
 
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
-  if (kBlockMagic != header->magic || kCurrentVersion != header->version) {
+  if (kBlockMagic != header->magic ||
+      (kCurrentVersion != header->version && 0x20000 != header->version)) {
     LOG(ERROR) << "Invalid file version or magic";
     return false;
   }
 
+  // Block files didn't change on version 3.0 (only the index did).
+  if (kCurrentVersion != header->version)
+    header->version = kCurrentVersion;
+
   if (header->updating) {
     // Last instance was not properly shutdown.
     if (!FixBlockFileHeader(file))
@@ -41,6 +41,14 @@ class NET_EXPORT_PRIVATE BlockFiles {
   // blocks to allocate, and block_address is the address of the new entry.
   bool CreateBlock(FileType block_type, int block_count, Addr* block_address);
 
+  // Creates |num_entries| new entries on the block files of |block_type|, where
+  // block_counts[i] is the number of blocks of entry i and block_addresses[i]
+  // receives its address. This is equivalent to calling CreateBlock() for each
+  // entry, but the file header is updated only once per block file used. Either
+  // all the entries are created, or none of them is.
+  bool CreateBlocks(FileType block_type, int num_entries,
+                    const int* block_counts, Addr* block_addresses);
+
   // Removes an entry from the block files. If deep is true, the storage is zero
   // filled; otherwise the entry is removed but the data is not altered (must be
   // already zeroed).
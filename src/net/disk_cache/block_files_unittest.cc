@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <vector>
+
 #include "base/file_util.h"
 #include "net/disk_cache/block_files.h"
 #include "net/disk_cache/disk_cache.h"
@@ -290,4 +292,63 @@ TEST_F(DiskCacheTest, AllocationMap) {
   }
 }
 
+// Tests that many blocks can be created at once, spanning multiple files.
+TEST_F(DiskCacheTest, BlockFiles_CreateBlocks) {
+  ASSERT_TRUE(CleanupCacheDir());
+  ASSERT_TRUE(file_util::CreateDirectory(cache_path_));
+
+  BlockFiles files(cache_path_);
+  ASSERT_TRUE(files.Init(true));
+
+  const int kSize = 100;
+  int block_counts[kSize];
+  Addr address[kSize];
+  for (int i = 0; i < kSize; i++)
+    block_counts[i] = i % 4 + 1;
+
+  EXPECT_TRUE(files.CreateBlocks(BLOCK_1K, kSize, block_counts, address));
+  for (int i = 0; i < kSize; i++) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(BLOCK_1K, address[i].file_type());
+    EXPECT_EQ(block_counts[i], address[i].num_blocks());
+    int start = address[i].start_block();
+    EXPECT_EQ(start / 4, (start + block_counts[i] - 1) / 4);
+    EXPECT_TRUE(files.IsValid(address[i]));
+  }
+
+  // The same 250 bits of the allocation map used by the AllocationMap test
+  // should be filled.
+  BlockFileHeader* header =
+      reinterpret_cast<BlockFileHeader*>(files.GetFile(address[0])->buffer());
+  EXPECT_EQ(kSize, header->num_entries);
+  EXPECT_EQ(0, header->updating);
+  uint8* buffer = reinterpret_cast<uint8*>(&header->allocation_map);
+  for (int i = 0; i < 29; i++) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(0xff, buffer[i]);
+  }
+
+  for (int i = 0; i < kSize; i++)
+    files.DeleteBlock(address[i], false);
+  EXPECT_EQ(0, header->num_entries);
+
+  // Now fill more than one file with a single call.
+  const int kNumEntries = 35000;
+  std::vector<int> counts(kNumEntries, 4);
+  std::vector<Addr> addresses(kNumEntries);
+  EXPECT_TRUE(files.CreateBlocks(RANKINGS, kNumEntries, &counts[0],
+                                 &addresses[0]));
+  EXPECT_EQ(6, NumberOfFiles(cache_path_));
+  for (int i = 0; i < kNumEntries; i += 100) {
+    SCOPED_TRACE(i);
+    EXPECT_TRUE(files.IsValid(addresses[i]));
+  }
+
+  // Invalid arguments should not create anything.
+  block_counts[1] = 5;
+  EXPECT_FALSE(files.CreateBlocks(BLOCK_1K, 2, block_counts, address));
+  EXPECT_FALSE(files.CreateBlocks(EXTERNAL, 1, block_counts, address));
+  EXPECT_EQ(0, header->num_entries);
+}
+
 }  // namespace disk_cache
@@ -55,6 +55,13 @@ NET_EXPORT int CreateCacheBackend(net::CacheType type, const FilePath& path,
                                   net::NetLog* net_log, Backend** backend,
                                   const net::CompletionCallback& callback);
 
+// Sets the number of cache threads (shards) used by caches of type
+// net::DISK_CACHE created after this call, up to 16. The default value of 1
+// means a single cache thread, the one passed to CreateCacheBackend(). With
+// more than one shard, the cache creates its own threads, and it stores its
+// files on sub-folders of the cache path. See sharded_backend.h for details.
+NET_EXPORT void SetNumCacheShards(int num_shards);
+
 // The root interface for a disk cache instance.
 class NET_EXPORT Backend {
  public:
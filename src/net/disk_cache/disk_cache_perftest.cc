@@ -2,13 +2,20 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <math.h>
+
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/file_util.h"
+#include "base/message_loop_proxy.h"
 #include "base/perftimer.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/threading/thread.h"
 #include "base/test/test_file_util.h"
 #include "base/timer.h"
@@ -20,7 +27,9 @@
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/disk_cache_test_base.h"
 #include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/entry_impl.h"
 #include "net/disk_cache/hash.h"
+#include "net/disk_cache/sharded_backend.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
@@ -138,6 +147,156 @@ bool TimeRead(int num_entries, disk_cache::Backend* cache,
   return (expected == helper.callbacks_called());
 }
 
+// Reads the data from each entry listed on |entries|, keeping a number of
+// operations in flight, so that a backend that uses more than one thread has
+// some work for all of them.
+class ParallelReader {
+ public:
+  ParallelReader(disk_cache::Backend* cache, const TestEntries& entries,
+                 int max_in_flight)
+      : cache_(cache), entries_(entries), max_in_flight_(max_in_flight),
+        next_(0), pending_(0), failed_(false) {}
+
+  // Returns false if any operation fails.
+  bool Run() {
+    for (int i = 0; i < max_in_flight_; i++)
+      StartNext();
+    if (pending_)
+      MessageLoop::current()->Run();
+    return !failed_ && next_ == entries_.size();
+  }
+
+ private:
+  struct Operation {
+    explicit Operation(size_t index)
+        : index(index), entry(NULL), buffer(new net::IOBuffer(kMaxSize)) {}
+
+    size_t index;
+    disk_cache::Entry* entry;
+    scoped_refptr<net::IOBuffer> buffer;
+  };
+
+  void StartNext() {
+    if (failed_ || next_ == entries_.size())
+      return;
+    Operation* op = new Operation(next_++);
+    pending_++;
+    int rv = cache_->OpenEntry(
+        entries_[op->index].key, &op->entry,
+        base::Bind(&ParallelReader::OnOpenComplete, base::Unretained(this),
+                   op));
+    if (rv != net::ERR_IO_PENDING)
+      OnOpenComplete(op, rv);
+  }
+
+  void OnOpenComplete(Operation* op, int result) {
+    if (result != net::OK)
+      return Done(op, false);
+    int rv = op->entry->ReadData(
+        1, 0, op->buffer, entries_[op->index].data_len,
+        base::Bind(&ParallelReader::OnReadComplete, base::Unretained(this),
+                   op));
+    if (rv != net::ERR_IO_PENDING)
+      OnReadComplete(op, rv);
+  }
+
+  void OnReadComplete(Operation* op, int result) {
+    Done(op, result == entries_[op->index].data_len);
+  }
+
+  void Done(Operation* op, bool success) {
+    if (!success)
+      failed_ = true;
+    if (op->entry)
+      op->entry->Close();
+    delete op;
+    pending_--;
+    StartNext();
+    if (!pending_)
+      MessageLoop::current()->Quit();
+  }
+
+  disk_cache::Backend* cache_;
+  const TestEntries& entries_;
+  int max_in_flight_;
+  size_t next_;
+  int pending_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelReader);
+};
+
+// Generates a synthetic trace of cache requests: a skewed (Zipf-like) access
+// pattern over a working set bigger than the cache, interrupted from time to
+// time by a scan of keys that are requested only once (as a big download would
+// do).
+void GenerateTrace(int num_requests, std::vector<std::string>* trace) {
+  const int kWorkingSet = 5000;
+  const int kScanInterval = 10000;
+  const int kScanLength = 3000;
+  const double kLogWorkingSet = log(static_cast<double>(kWorkingSet));
+  int scans = 0;
+  for (int i = 0; i < num_requests; i++) {
+    if (i && !(i % kScanInterval)) {
+      for (int j = 0; j < kScanLength; j++)
+        trace->push_back(base::StringPrintf("scan %d %d", scans, j));
+      scans++;
+    }
+    double value = static_cast<double>(rand()) / RAND_MAX;
+    int rank = static_cast<int>(exp(value * kLogWorkingSet)) - 1;
+    trace->push_back(base::StringPrintf("http://www.example.com/%d", rank));
+  }
+}
+
+// Replays |trace| on a new cache of |cache_size| bytes, using the eviction
+// policy selected by |new_eviction| and |flags|, and returns the hit ratio (as
+// a percentage).
+double ReplayTrace(const FilePath& path, const std::vector<std::string>& trace,
+                   int cache_size, bool new_eviction, uint32 flags) {
+  const int kEntrySize = 8 * 1024;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kEntrySize));
+  CacheTestFillBuffer(buffer->data(), kEntrySize, false);
+
+  // Use the backend directly, from the cache thread, so that evictions are not
+  // delayed by the thread hops.
+  disk_cache::BackendImpl* cache = new disk_cache::BackendImpl(
+      path, base::MessageLoopProxy::current(), NULL);
+  cache->SetMaxSize(cache_size);
+  if (new_eviction)
+    cache->SetNewEviction();
+  cache->SetFlags(disk_cache::kNoRandom | disk_cache::kNoLoadProtection |
+                  flags);
+  net::TestCompletionCallback cb;
+  int rv = cache->Init(cb.callback());
+  if (cb.GetResult(rv) != net::OK) {
+    delete cache;
+    return 0;
+  }
+
+  int hits = 0;
+  for (size_t i = 0; i < trace.size(); i++) {
+    disk_cache::EntryImpl* entry = cache->OpenEntryImpl(trace[i]);
+    if (entry) {
+      hits++;
+    } else {
+      entry = cache->CreateEntryImpl(trace[i]);
+      if (!entry)
+        continue;
+      entry->WriteDataImpl(1, 0, buffer, kEntrySize,
+                           net::CompletionCallback(), false);
+    }
+    entry->Release();
+
+    // Let the evictions run.
+    if (!(i % 100))
+      MessageLoop::current()->RunAllPending();
+  }
+
+  MessageLoop::current()->RunAllPending();
+  delete cache;
+  return hits * 100.0 / trace.size();
+}
+
 int BlockSize() {
   // We can use form 1 to 4 blocks.
   return (rand() & 0x3) + 1;
@@ -248,3 +407,183 @@ TEST_F(DiskCacheTest, BlockFilesPerformance) {
   MessageLoop::current()->RunAllPending();
   delete[] address;
 }
+
+// Compares creating blocks one at a time with creating them in batches, on
+// block files that get highly fragmented (as on BlockFilesPerformance).
+TEST_F(DiskCacheTest, BlockFilesBulkPerformance) {
+  const int kNumEntries = 60000;
+  const int kBatchSize = 32;
+  std::vector<int> counts(kNumEntries);
+  for (int i = 0; i < kNumEntries; i++)
+    counts[i] = BlockSize();
+
+  for (int batch_size = 1; batch_size <= kBatchSize; batch_size *= kBatchSize) {
+    ASSERT_TRUE(CleanupCacheDir());
+    disk_cache::BlockFiles files(cache_path_);
+    ASSERT_TRUE(files.Init(true));
+    std::vector<disk_cache::Addr> address(kNumEntries);
+    srand(1);
+
+    PerfTimeLogger timer1(base::StringPrintf(
+        "Fill three block-files, batches of %d", batch_size).c_str());
+    for (int i = 0; i < kNumEntries; i += batch_size) {
+      EXPECT_TRUE(files.CreateBlocks(disk_cache::RANKINGS, batch_size,
+                                     &counts[i], &address[i]));
+    }
+    timer1.Done();
+
+    PerfTimeLogger timer2(base::StringPrintf(
+        "Create and delete blocks, batches of %d", batch_size).c_str());
+    for (int i = 0; i < 200000 / kBatchSize; i++) {
+      int entry = rand() % (kNumEntries / kBatchSize) * kBatchSize;
+      for (int j = 0; j < kBatchSize; j++)
+        files.DeleteBlock(address[entry + j], false);
+      for (int j = 0; j < kBatchSize; j += batch_size) {
+        EXPECT_TRUE(files.CreateBlocks(disk_cache::RANKINGS, batch_size,
+                                       &counts[entry + j],
+                                       &address[entry + j]));
+      }
+    }
+    timer2.Done();
+  }
+  MessageLoop::current()->RunAllPending();
+}
+
+// Measures the cost of looking up entries on a cache with more than a million
+// entries. The index table starts with the default size and grows while the
+// entries are created, so this also measures the cost of resizing the table.
+TEST_F(DiskCacheTest, IndexLookupPerformance) {
+  ASSERT_TRUE(CleanupCacheDir());
+
+  // Use the backend directly, from the cache thread, so that we measure the
+  // lookup itself instead of the thread hops.
+  disk_cache::BackendImpl* cache = new disk_cache::BackendImpl(
+      cache_path_, base::MessageLoopProxy::current(), NULL);
+  cache->SetFlags(disk_cache::kNoRandom);
+  net::TestCompletionCallback cb;
+  int rv = cache->Init(cb.callback());
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+  const int kNumEntries = 1200 * 1000;
+  std::vector<std::string> keys;
+  keys.reserve(kNumEntries);
+  for (int i = 0; i < kNumEntries; i++)
+    keys.push_back(base::StringPrintf("http://www.example.com/%d/index.html",
+                                      i));
+
+  PerfTimeLogger timer1("Create 1.2M disk cache entries");
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::EntryImpl* entry = cache->CreateEntryImpl(keys[i]);
+    ASSERT_TRUE(NULL != entry);
+    entry->Release();
+  }
+  timer1.Done();
+  EXPECT_EQ(kNumEntries, cache->GetEntryCount());
+
+  int seed = static_cast<int>(Time::Now().ToInternalValue());
+  srand(seed);
+  std::random_shuffle(keys.begin(), keys.end());
+
+  PerfTimer timer2;
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::EntryImpl* entry = cache->OpenEntryImpl(keys[i]);
+    ASSERT_TRUE(NULL != entry);
+    entry->Release();
+  }
+  base::TimeDelta elapsed = timer2.Elapsed();
+  LogPerfResult("Open 1.2M disk cache entries", elapsed.InMillisecondsF(),
+                "ms");
+  LogPerfResult("Disk cache index lookup latency",
+                elapsed.InMillisecondsF() * 1000 / kNumEntries, "us");
+
+  PerfTimer timer3;
+  for (int i = 0; i < kNumEntries; i++) {
+    std::string key = base::StringPrintf("http://www.example.org/%d", i);
+    EXPECT_TRUE(NULL == cache->OpenEntryImpl(key));
+  }
+  LogPerfResult("Disk cache index miss latency",
+                timer3.Elapsed().InMillisecondsF() * 1000 / kNumEntries, "us");
+
+  MessageLoop::current()->RunAllPending();
+  delete cache;
+}
+
+// Measures how the throughput of a busy cache scales with the number of cache
+// threads (shards). The data is in the OS cache, so this is mostly a measure of
+// the work performed by the cache threads.
+TEST_F(DiskCacheTest, ShardedBackendPerformance) {
+  int seed = static_cast<int>(Time::Now().ToInternalValue());
+  srand(seed);
+
+  const int kNumEntries = 4000;
+  const int kMaxInFlight = 64;
+  const int kNumShards[] = {1, 2, 4, 8};
+  for (size_t i = 0; i < arraysize(kNumShards); i++) {
+    ASSERT_TRUE(file_util::Delete(cache_path_, true));
+
+    net::TestCompletionCallback cb;
+    disk_cache::Backend* cache;
+    int rv = disk_cache::ShardedBackend::CreateBackend(
+        cache_path_, kNumShards[i], false, 200 * 1024 * 1024, net::DISK_CACHE,
+        disk_cache::kNoRandom, NULL, &cache, cb.callback());
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+    TestEntries entries;
+    EXPECT_TRUE(TimeWrite(kNumEntries, cache, &entries));
+    std::random_shuffle(entries.begin(), entries.end());
+
+    // Read everything twice, and measure the second pass.
+    ParallelReader warm_up(cache, entries, kMaxInFlight);
+    EXPECT_TRUE(warm_up.Run());
+
+    PerfTimer timer;
+    ParallelReader reader(cache, entries, kMaxInFlight);
+    EXPECT_TRUE(reader.Run());
+    base::TimeDelta elapsed = timer.Elapsed();
+    LogPerfResult(
+        base::StringPrintf("Read disk cache entries, %d shards",
+                           kNumShards[i]).c_str(),
+        elapsed.InMillisecondsF(), "ms");
+    LogPerfResult(
+        base::StringPrintf("Disk cache read throughput, %d shards",
+                           kNumShards[i]).c_str(),
+        kNumEntries / elapsed.InSecondsF(), "entries/s");
+
+    MessageLoop::current()->RunAllPending();
+    delete cache;
+  }
+}
+
+// Replays the same trace of requests with each eviction policy, and reports
+// the hit ratio.
+TEST_F(DiskCacheTest, EvictionPolicyHitRatio) {
+  srand(7);
+  std::vector<std::string> trace;
+  GenerateTrace(60000, &trace);
+
+  const int kCacheSize = 8 * 1024 * 1024;
+  struct {
+    const char* name;
+    bool new_eviction;
+    uint32 flags;
+  } policies[] = {
+    { "LRU", false, 0 },
+    { "new eviction", true, 0 },
+    { "LRU + frequency", false, disk_cache::kFrequencyEviction },
+    { "new eviction + frequency", true, disk_cache::kFrequencyEviction },
+  };
+  for (size_t i = 0; i < arraysize(policies); i++) {
+    ASSERT_TRUE(CleanupCacheDir());
+    PerfTimer timer;
+    double ratio = ReplayTrace(cache_path_, trace, kCacheSize,
+                               policies[i].new_eviction, policies[i].flags);
+    base::TimeDelta elapsed = timer.Elapsed();
+    LogPerfResult(
+        base::StringPrintf("Disk cache hit ratio, %s",
+                           policies[i].name).c_str(), ratio, "%");
+    LogPerfResult(
+        base::StringPrintf("Disk cache trace replay, %s",
+                           policies[i].name).c_str(),
+        elapsed.InMillisecondsF(), "ms");
+  }
+}
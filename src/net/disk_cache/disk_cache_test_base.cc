@@ -54,6 +54,7 @@ DiskCacheTestWithCache::DiskCacheTestWithCache()
       implementation_(false),
       force_creation_(false),
       new_eviction_(false),
+      frequency_eviction_(false),
       first_cleanup_(true),
       integrity_(true),
       use_current_thread_(false),
@@ -63,7 +64,7 @@ DiskCacheTestWithCache::DiskCacheTestWithCache()
 DiskCacheTestWithCache::~DiskCacheTestWithCache() {}
 
 void DiskCacheTestWithCache::InitCache() {
-  if (mask_ || new_eviction_)
+  if (mask_ || new_eviction_ || frequency_eviction_)
     implementation_ = true;
 
   if (memory_only_)
@@ -284,6 +285,9 @@ void DiskCacheTestWithCache::InitDiskCacheImpl() {
   if (new_eviction_)
     cache_impl_->SetNewEviction();
 
+  if (frequency_eviction_)
+    cache_impl_->SetFlags(disk_cache::kFrequencyEviction);
+
   cache_impl_->SetType(type_);
   cache_impl_->SetFlags(disk_cache::kNoRandom);
   net::TestCompletionCallback cb;
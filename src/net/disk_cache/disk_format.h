@@ -12,7 +12,12 @@
 //
 // The index file is just a simple hash table that maps a particular entry to
 // a CacheAddr value. Linking for a given hash bucket is handled internally
-// by the cache entry.
+// by the cache entry. The table grows online using linear hashing: buckets are
+// split one at a time (in order) as the load factor goes up, so the cost of
+// resizing is spread across many operations instead of requiring a rebuild.
+// The state of the current split round is stored on the header of the index
+// (version 3.0); files from version 2.x never grew, so they are upgraded when
+// the cache is opened.
 //
 // The last element of the cache is the block-file. A block file is a file
 // designed to store blocks of data of a given size. It is able to store data
@@ -65,7 +70,7 @@ typedef uint32 CacheAddr;
 
 const int kIndexTablesize = 0x10000;
 const uint32 kIndexMagic = 0xC103CAC3;
-const uint32 kCurrentVersion = 0x20000;  // Version 2.0.
+const uint32 kCurrentVersion = 0x30000;  // Version 3.0.
 
 struct LruData {
   int32     pad1[2];
@@ -94,7 +99,10 @@ struct NET_EXPORT_PRIVATE IndexHeader {
   int32       crash;         // Signals a previous crash.
   int32       experiment;    // Id of an ongoing test.
   uint64      create_time;   // Creation time for this set of files.
-  int32       pad[52];
+  int32       level_len;     // Buckets at the start of the current split round
+                             // (0 == table_len, the table never grew).
+  int32       split_point;   // Next bucket to be split (linear hashing).
+  int32       pad[50];
   LruData     lru;           // Eviction control data.
 };
 
@@ -911,6 +911,7 @@ EntryImpl::~EntryImpl() {
 #endif
     net_log_.AddEvent(net::NetLog::TYPE_ENTRY_CLOSE, NULL);
     bool ret = true;
+    CreateBufferedDataBlocks();
     for (int index = 0; index < kNumStreams; index++) {
       if (user_buffers_[index].get()) {
         if (!(ret = Flush(index, 0)))
@@ -1155,6 +1156,47 @@ bool EntryImpl::CreateBlock(int size, Addr* address) {
   return true;
 }
 
+void EntryImpl::CreateBufferedDataBlocks() {
+  // Group the streams that need a new block by the type of block file to use.
+  int num_streams[BLOCK_4K + 1] = {0};
+  int streams[BLOCK_4K + 1][kNumStreams];
+  int block_counts[BLOCK_4K + 1][kNumStreams];
+  for (int index = 0; index < kNumStreams; index++) {
+    if (!user_buffers_[index].get() || entry_.Data()->data_addr[index])
+      continue;
+
+    int size = entry_.Data()->data_size[index];
+    FileType file_type = Addr::RequiredFileType(size);
+    if (!size || EXTERNAL == file_type)
+      continue;
+
+    int block_size = Addr::BlockSizeForFileType(file_type);
+    int count = num_streams[file_type]++;
+    streams[file_type][count] = index;
+    block_counts[file_type][count] = (size + block_size - 1) / block_size;
+  }
+
+  bool modified = false;
+  for (int file_type = BLOCK_256; file_type <= BLOCK_4K; file_type++) {
+    int count = num_streams[file_type];
+    if (!count)
+      continue;
+
+    Addr addresses[kNumStreams];
+    if (!backend_->CreateBlocks(static_cast<FileType>(file_type), count,
+                                block_counts[file_type], addresses)) {
+      continue;
+    }
+
+    for (int i = 0; i < count; i++)
+      entry_.Data()->data_addr[streams[file_type][i]] = addresses[i].value();
+    modified = true;
+  }
+
+  if (modified)
+    entry_.Store();
+}
+
 // Note that this method may end up modifying a block file so upon return the
 // involved block will be free, and could be reused for something else. If there
 // is a crash after that point (and maybe before returning to the caller), the
@@ -1396,7 +1438,9 @@ bool EntryImpl::PrepareBuffer(int index, int offset, int buf_len) {
 bool EntryImpl::Flush(int index, int min_len) {
   Addr address(entry_.Data()->data_addr[index]);
   DCHECK(user_buffers_[index].get());
-  DCHECK(!address.is_initialized() || address.is_separate_file());
+  // The block may have been created already by CreateBufferedDataBlocks().
+  DCHECK(!address.is_initialized() || address.is_separate_file() ||
+         !user_buffers_[index]->Start());
   DVLOG(3) << "Flush";
 
   int size = std::max(entry_.Data()->data_size[index], min_len);
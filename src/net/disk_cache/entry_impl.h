@@ -187,6 +187,12 @@ class NET_EXPORT_PRIVATE EntryImpl
   // Initializes the storage for an internal or external generic block.
   bool CreateBlock(int size, Addr* address);
 
+  // Initializes at once the storage for all the streams that will be written
+  // to a block file when the buffered data is flushed, so that the block files
+  // and the entry are updated only once. Streams that are not handled here get
+  // their storage from Flush().
+  void CreateBufferedDataBlocks();
+
   // Deletes the data pointed by address, maybe backed by files_[index].
   // Note that most likely the caller should delete (and store) the reference to
   // |address| *before* calling this method because we don't want to have an
@@ -26,6 +26,14 @@
 // size so that we have a chance to see an element again and move it to another
 // list.
 
+// The frequency eviction experiment adds a TinyLFU filter on top of either
+// policy: we keep an approximate count of recent accesses for each entry (see
+// frequency_sketch.h), and when the entry selected for eviction was accessed
+// more often than the last entry added to the cache, it is moved back to the
+// head of its list instead of being evicted. In other words, a burst of entries
+// that are used only once (for instance, a big download) has to go out of the
+// cache without pushing out entries that are used frequently.
+
 #include "net/disk_cache/eviction.h"
 
 #include "base/bind.h"
@@ -36,6 +44,7 @@
 #include "base/time.h"
 #include "net/disk_cache/backend_impl.h"
 #include "net/disk_cache/entry_impl.h"
+#include "net/disk_cache/eviction_group.h"
 #include "net/disk_cache/experiments.h"
 #include "net/disk_cache/histogram_macros.h"
 #include "net/disk_cache/trace.h"
@@ -49,6 +58,7 @@ const int kCleanUpMargin = 1024 * 1024;
 const int kHighUse = 10;  // Reuse count to be on the HIGH_USE list.
 const int kTargetTime = 24 * 7;  // Time to be evicted (hours since last use).
 const int kMaxDelayedTrims = 60;
+const int kMaxSecondChances = 64;  // Entries kept by a single trim pass.
 
 int LowWaterAdjust(int high_water) {
   if (high_water < kCleanUpMargin)
@@ -64,6 +74,12 @@ namespace disk_cache {
 Eviction::Eviction()
     : backend_(NULL),
       init_(false),
+      frequency_eviction_(false),
+      candidate_hash_(0),
+      second_chances_(0),
+      group_(NULL),
+      group_index_(0),
+      empty_in_group_(false),
       ALLOW_THIS_IN_INITIALIZER_LIST(ptr_factory_(this)) {
 }
 
@@ -85,6 +101,31 @@ void Eviction::Init(BackendImpl* backend) {
   init_ = true;
   test_mode_ = false;
   in_experiment_ = (header_->experiment == EXPERIMENT_DELETED_LIST_IN);
+  frequency_eviction_ =
+      (header_->experiment == EXPERIMENT_FREQUENCY_EVICTION);
+  if (frequency_eviction_)
+    sketch_.Init(backend_->mask_ + 1);
+
+  // A backend that restarts joins its group again.
+  group_ = NULL;
+  if (backend_->eviction_group_)
+    JoinGroup();
+}
+
+void Eviction::UpdateIndexHeader() {
+  if (!init_)
+    return;
+  header_ = &backend_->data_->header;
+}
+
+void Eviction::JoinGroup() {
+  DCHECK(init_);
+  group_ = backend_->eviction_group_;
+  group_index_ = backend_->group_index_;
+  empty_in_group_ = false;
+  group_->AddMember(group_index_, backend_->max_size_, header_->num_bytes,
+                    base::Bind(&Eviction::OnGroupTrim,
+                               ptr_factory_.GetWeakPtr()));
 }
 
 void Eviction::Stop() {
@@ -112,15 +153,16 @@ void Eviction::TrimCache(bool empty) {
 
   Trace("*** Trim Cache ***");
   trimming_ = true;
+  StartTrimPass();
   TimeTicks start = TimeTicks::Now();
   Rankings::ScopedRankingsBlock node(rankings_);
   Rankings::ScopedRankingsBlock next(
       rankings_, rankings_->GetPrev(node.get(), Rankings::NO_USE));
   int deleted_entries = 0;
-  int target_size = empty ? 0 : max_size_;
-  while ((header_->num_bytes > target_size || test_mode_) && next.get()) {
+  int64 target_size = GetTargetSize(empty);
+  while ((GetCurrentSize(empty) > target_size || test_mode_) && next.get()) {
     // The iterator could be invalidated within EvictEntry().
-    if (!next->HasData())
+    if (!next->HasData() || !ShouldEvict(next.get(), empty))
       break;
     node.reset(next.release());
     next.reset(rankings_->GetPrev(node.get(), Rankings::NO_USE));
@@ -149,6 +191,8 @@ void Eviction::TrimCache(bool empty) {
   }
   CACHE_UMA(COUNTS, "TrimItemsV1", 0, deleted_entries);
 
+  if (group_ && !empty)
+    UpdateOldestEntryTime();
   trimming_ = false;
   Trace("*** Trim Cache end ***");
   return;
@@ -162,11 +206,20 @@ void Eviction::UpdateRank(EntryImpl* entry, bool modified) {
 }
 
 void Eviction::OnOpenEntry(EntryImpl* entry) {
+  RecordAccess(entry);
   if (new_eviction_)
     return OnOpenEntryV2(entry);
 }
 
 void Eviction::OnCreateEntry(EntryImpl* entry) {
+  RecordAccess(entry);
+  if (empty_in_group_) {
+    empty_in_group_ = false;
+    group_->SetOldestEntryTime(group_index_, entry->GetLastUsed());
+  }
+  if (frequency_eviction_)
+    candidate_hash_ = entry->GetHash();
+
   if (new_eviction_)
     return OnCreateEntryV2(entry);
 
@@ -275,6 +328,11 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
     return false;
   }
 
+  if (!empty && KeepFrequentEntry(entry, list)) {
+    entry->Release();
+    return false;
+  }
+
   ReportTrimTimes(entry);
   if (empty || !new_eviction_) {
     entry->DoomImpl();
@@ -296,11 +354,86 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
   return true;
 }
 
+int64 Eviction::GetCurrentSize(bool empty) {
+  if (!group_ || empty)
+    return header_->num_bytes;
+  return group_->UpdateSize(group_index_, header_->num_bytes);
+}
+
+int64 Eviction::GetTargetSize(bool empty) {
+  if (empty)
+    return 0;
+  if (!group_)
+    return max_size_;
+  return LowWaterAdjust(group_->GetMaxBytes());
+}
+
+bool Eviction::ShouldEvict(CacheRankingsBlock* node, bool empty) {
+  if (!group_ || empty || test_mode_)
+    return true;
+  return group_->ShouldEvict(group_index_,
+                             Time::FromInternalValue(node->Data()->last_used));
+}
+
+void Eviction::UpdateOldestEntryTime() {
+  // Only the first three lists hold entries that can be evicted.
+  int num_lists = new_eviction_ ? Rankings::RESERVED : Rankings::LOW_USE;
+  bool found = false;
+  Time oldest;
+  for (int i = 0; i < num_lists; i++) {
+    Rankings::ScopedRankingsBlock node(
+        rankings_, rankings_->GetPrev(NULL, static_cast<Rankings::List>(i)));
+    if (!node.get())
+      continue;
+    Time last_used = Time::FromInternalValue(node->Data()->last_used);
+    if (!found || last_used < oldest)
+      oldest = last_used;
+    found = true;
+  }
+
+  empty_in_group_ = !found;
+  if (found)
+    group_->SetOldestEntryTime(group_index_, oldest);
+  else
+    group_->SetEmpty(group_index_);
+}
+
+void Eviction::OnGroupTrim() {
+  group_->OnTrimStarted();
+  TrimCache(false);
+}
+
+void Eviction::StartTrimPass() {
+  second_chances_ = 0;
+
+  // The index may have doubled since the last pass.
+  if (frequency_eviction_)
+    sketch_.Grow(backend_->mask_ + 1);
+}
+
+void Eviction::RecordAccess(EntryImpl* entry) {
+  if (frequency_eviction_)
+    sketch_.Increment(entry->GetHash());
+}
+
+bool Eviction::KeepFrequentEntry(EntryImpl* entry, Rankings::List list) {
+  if (!frequency_eviction_ || second_chances_ >= kMaxSecondChances)
+    return false;
+
+  if (sketch_.Estimate(entry->GetHash()) <= sketch_.Estimate(candidate_hash_))
+    return false;
+
+  second_chances_++;
+  rankings_->UpdateRank(entry->rankings(), false, list);
+  return true;
+}
+
 // -----------------------------------------------------------------------
 
 void Eviction::TrimCacheV2(bool empty) {
   Trace("*** Trim Cache ***");
   trimming_ = true;
+  StartTrimPass();
   TimeTicks start = TimeTicks::Now();
 
   const int kListsToSearch = 3;
@@ -329,13 +462,13 @@ void Eviction::TrimCacheV2(bool empty) {
 
   Rankings::ScopedRankingsBlock node(rankings_);
   int deleted_entries = 0;
-  int target_size = empty ? 0 : max_size_;
+  int64 target_size = GetTargetSize(empty);
 
   for (; list < kListsToSearch; list++) {
-    while ((header_->num_bytes > target_size || test_mode_) &&
+    while ((GetCurrentSize(empty) > target_size || test_mode_) &&
            next[list].get()) {
       // The iterator could be invalidated within EvictEntry().
-      if (!next[list]->HasData())
+      if (!next[list]->HasData() || !ShouldEvict(next[list].get(), empty))
         break;
       node.reset(next[list].release());
       next[list].reset(rankings_->GetPrev(node.get(),
@@ -375,6 +508,8 @@ void Eviction::TrimCacheV2(bool empty) {
   }
   CACHE_UMA(COUNTS, "TrimItemsV2", 0, deleted_entries);
 
+  if (group_ && !empty)
+    UpdateOldestEntryTime();
   Trace("*** Trim Cache end ***");
   trimming_ = false;
   return;
@@ -9,12 +9,14 @@
 #include "base/basictypes.h"
 #include "base/memory/weak_ptr.h"
 #include "net/disk_cache/disk_format.h"
+#include "net/disk_cache/frequency_sketch.h"
 #include "net/disk_cache/rankings.h"
 
 namespace disk_cache {
 
 class BackendImpl;
 class EntryImpl;
+class EvictionGroup;
 
 // This class implements the eviction algorithm for the cache and it is tightly
 // integrated with BackendImpl.
@@ -26,6 +28,12 @@ class Eviction {
   void Init(BackendImpl* backend);
   void Stop();
 
+  // Reloads the pointer to the index header after the index file is remapped.
+  void UpdateIndexHeader();
+
+  // Starts sharing the size limit with the eviction group of the backend.
+  void JoinGroup();
+
   // Deletes entries from the cache until the current size is below the limit.
   // If empty is true, the whole cache will be trimmed, regardless of being in
   // use.
@@ -53,6 +61,24 @@ class Eviction {
   Rankings::List GetListForEntry(EntryImpl* entry);
   bool EvictEntry(CacheRankingsBlock* node, bool empty, Rankings::List list);
 
+  // Support for eviction groups (see eviction_group.h). The size and limit of
+  // the whole group are used instead of those of this cache, and the trim stops
+  // as soon as another member of the group has older entries than |node|.
+  int64 GetCurrentSize(bool empty);
+  int64 GetTargetSize(bool empty);
+  bool ShouldEvict(CacheRankingsBlock* node, bool empty);
+  void UpdateOldestEntryTime();
+  void OnGroupTrim();
+
+  // Frequency based eviction (EXPERIMENT_FREQUENCY_EVICTION). StartTrimPass()
+  // resets the number of entries kept by the pass, and grows the sketch along
+  // with the index. RecordAccess() records an access to |entry|, and
+  // KeepFrequentEntry() returns true (after moving it to the head of |list|)
+  // if |entry| should not be evicted this time.
+  void StartTrimPass();
+  void RecordAccess(EntryImpl* entry);
+  bool KeepFrequentEntry(EntryImpl* entry, Rankings::List list);
+
   // We'll just keep for a while a separate set of methods that implement the
   // new eviction algorithm. This code will replace the original methods when
   // finished.
@@ -82,6 +108,13 @@ class Eviction {
   bool init_;
   bool test_mode_;
   bool in_experiment_;
+  bool frequency_eviction_;
+  FrequencySketch sketch_;
+  uint32 candidate_hash_;  // Hash of the last entry added to the cache.
+  int second_chances_;     // Entries kept by the current trim pass.
+  EvictionGroup* group_;   // Owned by the backend.
+  int group_index_;
+  bool empty_in_group_;    // The group was told that we have no entries.
   base::WeakPtrFactory<Eviction> ptr_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(Eviction);
@@ -0,0 +1,124 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/eviction_group.h"
+
+#include "base/location.h"
+#include "base/logging.h"
+
+using base::Time;
+
+namespace disk_cache {
+
+EvictionGroup::Member::Member() : active(false), empty(false), num_bytes(0) {
+}
+
+EvictionGroup::Member::~Member() {
+}
+
+EvictionGroup::EvictionGroup(int num_members)
+    : members_(num_members),
+      max_bytes_(0),
+      num_bytes_(0),
+      trim_pending_(false) {
+}
+
+EvictionGroup::~EvictionGroup() {
+}
+
+void EvictionGroup::AddMember(int index, int32 max_bytes, int32 num_bytes,
+                              const base::Closure& trim_task) {
+  base::AutoLock lock(lock_);
+  // A member joins again after it restarts.
+  Member& member = members_[index];
+  member.active = true;
+  num_bytes_ += num_bytes - member.num_bytes;
+  member.num_bytes = num_bytes;
+
+  // We don't know the age of the entries of this member yet, so it will be the
+  // first one to trim, and it will record the actual value at that point.
+  member.empty = false;
+  member.oldest = Time();
+  member.thread = base::MessageLoopProxy::current();
+  member.trim_task = trim_task;
+
+  if (!max_bytes_ || max_bytes < max_bytes_)
+    max_bytes_ = max_bytes;
+}
+
+int32 EvictionGroup::GetMaxBytes() {
+  base::AutoLock lock(lock_);
+  return max_bytes_;
+}
+
+int64 EvictionGroup::UpdateSize(int index, int32 num_bytes) {
+  base::AutoLock lock(lock_);
+  num_bytes_ += num_bytes - members_[index].num_bytes;
+  members_[index].num_bytes = num_bytes;
+  return num_bytes_;
+}
+
+void EvictionGroup::OnSizeChanged(int index, int32 num_bytes) {
+  base::AutoLock lock(lock_);
+  num_bytes_ += num_bytes - members_[index].num_bytes;
+  members_[index].num_bytes = num_bytes;
+  if (num_bytes_ > max_bytes_ && !trim_pending_)
+    RequestTrim();
+}
+
+void EvictionGroup::SetOldestEntryTime(int index, Time last_used) {
+  base::AutoLock lock(lock_);
+  members_[index].empty = false;
+  members_[index].oldest = last_used;
+}
+
+void EvictionGroup::SetEmpty(int index) {
+  base::AutoLock lock(lock_);
+  members_[index].empty = true;
+}
+
+bool EvictionGroup::ShouldEvict(int index, Time last_used) {
+  base::AutoLock lock(lock_);
+  members_[index].empty = false;
+  members_[index].oldest = last_used;
+
+  int oldest = index;
+  for (size_t i = 0; i < members_.size(); i++) {
+    if (members_[i].active && !members_[i].empty &&
+        members_[i].oldest < members_[oldest].oldest)
+      oldest = static_cast<int>(i);
+  }
+  if (oldest == index)
+    return true;
+
+  RequestTrim(oldest);
+  return false;
+}
+
+void EvictionGroup::OnTrimStarted() {
+  base::AutoLock lock(lock_);
+  trim_pending_ = false;
+}
+
+void EvictionGroup::RequestTrim() {
+  lock_.AssertAcquired();
+  int oldest = -1;
+  for (size_t i = 0; i < members_.size(); i++) {
+    if (!members_[i].active || members_[i].empty)
+      continue;
+    if (oldest < 0 || members_[i].oldest < members_[oldest].oldest)
+      oldest = static_cast<int>(i);
+  }
+  if (oldest >= 0)
+    RequestTrim(oldest);
+}
+
+void EvictionGroup::RequestTrim(int index) {
+  lock_.AssertAcquired();
+  // The thread of the member is gone when the cache is being destroyed.
+  trim_pending_ =
+      members_[index].thread->PostTask(FROM_HERE, members_[index].trim_task);
+}
+
+}  // namespace disk_cache
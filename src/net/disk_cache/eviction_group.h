@@ -0,0 +1,98 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_EVICTION_GROUP_H_
+#define NET_DISK_CACHE_EVICTION_GROUP_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop_proxy.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+
+namespace disk_cache {
+
+// This class lets a set of backends (the shards of a ShardedBackend) share a
+// single size limit. Each member reports its size and the last use time of its
+// oldest entry, and when the group goes over the limit, the member that holds
+// the oldest entry of the group is asked to trim. While trimming, a member
+// hands the work over to another member as soon as the other member has older
+// entries, so entries are evicted in the same order as with a single backend.
+//
+// Each member has its own thread. The methods of this class can be called from
+// any of them, and the trim requests are posted to the thread of the member.
+class NET_EXPORT_PRIVATE EvictionGroup
+    : public base::RefCountedThreadSafe<EvictionGroup> {
+ public:
+  explicit EvictionGroup(int num_members);
+
+  // Adds a member to the group. |max_bytes| is the size limit of the member,
+  // and the smallest of them becomes the limit of the group. |trim_task| is
+  // posted to the current thread when the member should trim.
+  void AddMember(int index, int32 max_bytes, int32 num_bytes,
+                 const base::Closure& trim_task);
+
+  // Returns the size limit of the group.
+  int32 GetMaxBytes();
+
+  // Sets the current size of a member, and returns the size of the group.
+  int64 UpdateSize(int index, int32 num_bytes);
+
+  // Sets the current size of a member, and asks the member with the oldest
+  // entries to trim if the group is over the limit.
+  void OnSizeChanged(int index, int32 num_bytes);
+
+  // Sets the last use time of the oldest entry of a member.
+  void SetOldestEntryTime(int index, base::Time last_used);
+
+  // Records that a member has no entries to evict.
+  void SetEmpty(int index);
+
+  // Called by a trimming member before evicting an entry last used at
+  // |last_used|. Returns false if another member has older entries, in which
+  // case that member is asked to trim, and this one should stop.
+  bool ShouldEvict(int index, base::Time last_used);
+
+  // Called by a member when it starts the trim requested by the group.
+  void OnTrimStarted();
+
+ private:
+  friend class base::RefCountedThreadSafe<EvictionGroup>;
+
+  struct Member {
+    Member();
+    ~Member();
+
+    bool active;
+    bool empty;
+    int32 num_bytes;
+    base::Time oldest;  // The last use time of the oldest entry.
+    scoped_refptr<base::MessageLoopProxy> thread;
+    base::Closure trim_task;
+  };
+
+  ~EvictionGroup();
+
+  // Posts a trim request to the member with the oldest entries. The lock must
+  // be held.
+  void RequestTrim();
+  void RequestTrim(int index);
+
+  base::Lock lock_;
+  std::vector<Member> members_;
+  int32 max_bytes_;
+  int64 num_bytes_;
+  bool trim_pending_;  // A member was asked to trim but has not started yet.
+
+  DISALLOW_COPY_AND_ASSIGN(EvictionGroup);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_EVICTION_GROUP_H_
@@ -7,8 +7,10 @@
 #include <fcntl.h>
 
 #include "base/bind.h"
+#include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/threading/thread_local.h"
 #include "base/threading/worker_pool.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/disk_cache.h"
@@ -146,22 +148,29 @@ void FileInFlightIO::OnOperationComplete(disk_cache::BackgroundIO* operation,
   callback->OnFileIOComplete(bytes);
 }
 
-// A static object tha will broker all async operations.
-FileInFlightIO* s_file_operations = NULL;
+// The objects that broker all async operations. There is one per cache thread
+// because completions are delivered to the thread that created the object, and
+// a process may run multiple backends (or a sharded backend) on different
+// threads.
+base::LazyInstance<base::ThreadLocalPointer<FileInFlightIO> >
+    g_file_operations = LAZY_INSTANCE_INITIALIZER;
 
-// Returns the current FileInFlightIO.
+// Returns the FileInFlightIO for the current thread.
 FileInFlightIO* GetFileInFlightIO() {
-  if (!s_file_operations) {
-    s_file_operations = new FileInFlightIO;
+  FileInFlightIO* file_operations = g_file_operations.Pointer()->Get();
+  if (!file_operations) {
+    file_operations = new FileInFlightIO;
+    g_file_operations.Pointer()->Set(file_operations);
   }
-  return s_file_operations;
+  return file_operations;
 }
 
-// Deletes the current FileInFlightIO.
+// Deletes the FileInFlightIO for the current thread.
 void DeleteFileInFlightIO() {
-  DCHECK(s_file_operations);
-  delete s_file_operations;
-  s_file_operations = NULL;
+  FileInFlightIO* file_operations = g_file_operations.Pointer()->Get();
+  DCHECK(file_operations);
+  delete file_operations;
+  g_file_operations.Pointer()->Set(NULL);
 }
 
 }  // namespace
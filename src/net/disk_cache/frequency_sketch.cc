@@ -0,0 +1,131 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/frequency_sketch.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace {
+
+const int kMinEntries = 1024;
+// 8 MB of counters, for an index of a million buckets or more.
+const int kMaxEntries = 1024 * 1024;
+const int kRows = 4;
+const int kCountersPerEntry = 16;
+const int kCountersPerWord = 16;
+const int kMaxFrequency = 15;  // 4-bit counters.
+
+// Seeds used to derive the counter of each row from the hash.
+const uint64 kSeeds[kRows] = {
+  GG_UINT64_C(0xc3a5c85c97cb3127),
+  GG_UINT64_C(0xb492b66fbe98f273),
+  GG_UINT64_C(0x9ae16a3b2f90404f),
+  GG_UINT64_C(0xcbf29ce484222325)
+};
+
+// Clears the top bit of every 4-bit counter after a shift.
+const uint64 kResetMask = GG_UINT64_C(0x7777777777777777);
+
+}  // namespace
+
+namespace disk_cache {
+
+FrequencySketch::FrequencySketch()
+    : mask_(0), additions_(0), sample_size_(0) {
+}
+
+FrequencySketch::~FrequencySketch() {
+}
+
+void FrequencySketch::Init(int max_entries) {
+  if (max_entries < kMinEntries)
+    max_entries = kMinEntries;
+  if (max_entries > kMaxEntries)
+    max_entries = kMaxEntries;
+
+  // Use a power of two. With kCountersPerEntry counters per entry, the
+  // average value of a counter stays low until the next reset.
+  int num_counters = kMinEntries * kCountersPerEntry;
+  while (num_counters < max_entries * kCountersPerEntry)
+    num_counters <<= 1;
+
+  table_.assign(num_counters / kCountersPerWord, 0);
+  mask_ = num_counters - 1;
+  additions_ = 0;
+  sample_size_ = max_entries * 10;
+}
+
+void FrequencySketch::Grow(int max_entries) {
+  if (table_.empty())
+    return Init(max_entries);
+
+  if (max_entries > kMaxEntries)
+    max_entries = kMaxEntries;
+  if (max_entries * 10 <= sample_size_)
+    return;
+
+  // Doubling the number of counters adds one bit to every index, so each
+  // counter becomes two counters (in the same position of each half of the
+  // table) that start with its current value.
+  int num_counters = mask_ + 1;
+  while (num_counters < max_entries * kCountersPerEntry) {
+    size_t num_words = table_.size();
+    table_.resize(num_words * 2);
+    std::copy(table_.begin(), table_.begin() + num_words,
+              table_.begin() + num_words);
+    num_counters <<= 1;
+  }
+  mask_ = num_counters - 1;
+  sample_size_ = max_entries * 10;
+}
+
+void FrequencySketch::Increment(uint32 hash) {
+  if (table_.empty())
+    return;
+
+  bool added = false;
+  for (int row = 0; row < kRows; row++) {
+    uint32 index = IndexOf(hash, row);
+    int shift = (index % kCountersPerWord) * 4;
+    uint64* word = &table_[index / kCountersPerWord];
+    if (((*word >> shift) & 0xf) != kMaxFrequency) {
+      *word += GG_UINT64_C(1) << shift;
+      added = true;
+    }
+  }
+
+  if (added && ++additions_ == sample_size_)
+    Reset();
+}
+
+int FrequencySketch::Estimate(uint32 hash) const {
+  if (table_.empty())
+    return 0;
+
+  int frequency = kMaxFrequency;
+  for (int row = 0; row < kRows; row++) {
+    uint32 index = IndexOf(hash, row);
+    int shift = (index % kCountersPerWord) * 4;
+    int count = static_cast<int>(
+        (table_[index / kCountersPerWord] >> shift) & 0xf);
+    frequency = std::min(frequency, count);
+  }
+  return frequency;
+}
+
+uint32 FrequencySketch::IndexOf(uint32 hash, int row) const {
+  uint64 value = (hash + kSeeds[row]) * kSeeds[row];
+  value += value >> 32;
+  return static_cast<uint32>(value) & mask_;
+}
+
+void FrequencySketch::Reset() {
+  for (size_t i = 0; i < table_.size(); i++)
+    table_[i] = (table_[i] >> 1) & kResetMask;
+  additions_ /= 2;
+}
+
+}  // namespace disk_cache
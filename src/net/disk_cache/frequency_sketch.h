@@ -0,0 +1,63 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+#define NET_DISK_CACHE_FREQUENCY_SKETCH_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "net/base/net_export.h"
+
+namespace disk_cache {
+
+// This class keeps an approximate count of how often a given hash was seen
+// recently, using a count-min sketch of 4-bit counters (four counters per
+// hash, the estimate is the smallest of them). The counters are halved after a
+// number of increments proportional to the size of the sketch, so old accesses
+// are forgotten over time (as in TinyLFU).
+//
+// The sketch lives only in memory; it is rebuilt from scratch every time the
+// cache is loaded.
+class NET_EXPORT_PRIVATE FrequencySketch {
+ public:
+  FrequencySketch();
+  ~FrequencySketch();
+
+  // Sizes the sketch to track about |max_entries| different hashes, and clears
+  // all the counters.
+  void Init(int max_entries);
+
+  // Makes room for about |max_entries| different hashes, keeping the current
+  // counts. The sketch never shrinks.
+  void Grow(int max_entries);
+
+  // Records one access to |hash|.
+  void Increment(uint32 hash);
+
+  // Returns the estimated number of recent accesses to |hash|.
+  int Estimate(uint32 hash) const;
+
+  // Returns the number of 64-bit words used by the sketch.
+  int Size() const { return static_cast<int>(table_.size()); }
+
+ private:
+  // Returns the counter of |hash| for the given |row|.
+  uint32 IndexOf(uint32 hash, int row) const;
+
+  // Halves all the counters.
+  void Reset();
+
+  std::vector<uint64> table_;  // 16 counters per word.
+  uint32 mask_;                // Number of counters - 1.
+  int additions_;              // Increments since the last reset.
+  int sample_size_;            // Increments before the next reset.
+
+  DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_FREQUENCY_SKETCH_H_
@@ -0,0 +1,106 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/stringprintf.h"
+#include "net/disk_cache/frequency_sketch.h"
+#include "net/disk_cache/hash.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+TEST(DiskCacheFrequencySketchTest, Basics) {
+  disk_cache::FrequencySketch sketch;
+  EXPECT_EQ(0, sketch.Estimate(1234));
+  sketch.Increment(1234);
+  EXPECT_EQ(0, sketch.Size());
+
+  sketch.Init(100);
+  EXPECT_EQ(1024, sketch.Size());
+  EXPECT_EQ(0, sketch.Estimate(1234));
+
+  for (int i = 0; i < 5; i++)
+    sketch.Increment(1234);
+  EXPECT_EQ(5, sketch.Estimate(1234));
+  EXPECT_EQ(0, sketch.Estimate(4321));
+
+  // The counters saturate.
+  for (int i = 0; i < 20; i++)
+    sketch.Increment(1234);
+  EXPECT_EQ(15, sketch.Estimate(1234));
+
+  sketch.Init(100);
+  EXPECT_EQ(0, sketch.Estimate(1234));
+}
+
+TEST(DiskCacheFrequencySketchTest, Accuracy) {
+  const int kNumEntries = 5000;
+  disk_cache::FrequencySketch sketch;
+  sketch.Init(kNumEntries);
+
+  // Every key is seen once, and one in ten keys is seen three more times.
+  for (int i = 0; i < kNumEntries; i++) {
+    uint32 hash = disk_cache::Hash(base::StringPrintf("key %d", i));
+    sketch.Increment(hash);
+    if (!(i % 10)) {
+      for (int j = 0; j < 3; j++)
+        sketch.Increment(hash);
+    }
+  }
+
+  int errors = 0;
+  for (int i = 0; i < kNumEntries; i++) {
+    uint32 hash = disk_cache::Hash(base::StringPrintf("key %d", i));
+    int expected = (i % 10) ? 1 : 4;
+    EXPECT_LE(expected, sketch.Estimate(hash));
+    if (sketch.Estimate(hash) != expected)
+      errors++;
+  }
+  EXPECT_GT(kNumEntries / 100, errors);
+}
+
+TEST(DiskCacheFrequencySketchTest, Aging) {
+  const int kNumEntries = 1024;
+  disk_cache::FrequencySketch sketch;
+  sketch.Init(kNumEntries);
+
+  for (int i = 0; i < 8; i++)
+    sketch.Increment(1234);
+  EXPECT_EQ(8, sketch.Estimate(1234));
+
+  // After enough accesses to other hashes, the counters are halved.
+  for (int i = 0; i < kNumEntries * 10; i++)
+    sketch.Increment(100000 + i);
+  EXPECT_GT(8, sketch.Estimate(1234));
+  EXPECT_LE(4, sketch.Estimate(1234));
+}
+
+TEST(DiskCacheFrequencySketchTest, Grow) {
+  disk_cache::FrequencySketch sketch;
+  sketch.Init(1024);
+  EXPECT_EQ(1024, sketch.Size());
+
+  for (int i = 0; i < 1000; i++) {
+    uint32 hash = disk_cache::Hash(base::StringPrintf("key %d", i));
+    for (int j = 0; j < i % 5; j++)
+      sketch.Increment(hash);
+  }
+
+  std::vector<int> estimates;
+  for (int i = 0; i < 1000; i++) {
+    uint32 hash = disk_cache::Hash(base::StringPrintf("key %d", i));
+    estimates.push_back(sketch.Estimate(hash));
+  }
+
+  // The counts are kept when the sketch grows.
+  sketch.Grow(4096);
+  EXPECT_EQ(4096, sketch.Size());
+  for (int i = 0; i < 1000; i++) {
+    uint32 hash = disk_cache::Hash(base::StringPrintf("key %d", i));
+    EXPECT_EQ(estimates[i], sketch.Estimate(hash));
+  }
+
+  // But it never shrinks.
+  sketch.Grow(1024);
+  EXPECT_EQ(4096, sketch.Size());
+}
@@ -231,6 +231,11 @@ void Rankings::Reset() {
   control_data_ = NULL;
 }
 
+void Rankings::UpdateControlData() {
+  DCHECK(init_);
+  control_data_ = backend_->GetLruData();
+}
+
 void Rankings::Insert(CacheRankingsBlock* node, bool modified, List list) {
   Trace("Insert 0x%x l %d", node->address().value(), list);
   DCHECK(node->HasData());
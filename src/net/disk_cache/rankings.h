@@ -109,6 +109,9 @@ class Rankings {
   // Restores original state, leaving the object ready for initialization.
   void Reset();
 
+  // Reloads the pointer to the LRU data after the index file is remapped.
+  void UpdateControlData();
+
   // Inserts a given entry at the head of the queue.
   void Insert(CacheRankingsBlock* node, bool modified, List list);
 
@@ -0,0 +1,385 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/sharded_backend.h"
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/cache_util.h"
+#include "net/disk_cache/eviction_group.h"
+#include "net/disk_cache/hash.h"
+#include "net/disk_cache/stats.h"
+#include "net/disk_cache/trace.h"
+
+namespace {
+
+// Deletes the files of a regular cache stored on |path| (by a previous run
+// without shards).
+void DeleteUnshardedCache(const FilePath& path) {
+  if (file_util::PathExists(path.AppendASCII("index")))
+    disk_cache::DeleteCache(path, false);
+}
+
+// Takes ownership of a new ShardedBackend until it is fully initialized.
+void OnShardedBackendCreated(disk_cache::ShardedBackend* cache,
+                             disk_cache::Backend** backend,
+                             const net::CompletionCallback& callback,
+                             int result) {
+  if (result == net::OK) {
+    *backend = cache;
+  } else {
+    LOG(ERROR) << "Unable to create cache";
+    *backend = NULL;
+    delete cache;
+  }
+  callback.Run(result);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// Collects the results of an operation that is sent to all the shards. The
+// callback is invoked (with the first error, if any) after the last shard
+// completes, unless all of them complete synchronously, in which case the
+// result is returned by Finish().
+class ShardedBackend::Barrier : public base::RefCounted<Barrier> {
+ public:
+  explicit Barrier(const net::CompletionCallback& callback)
+      : pending_(1), result_(net::OK), callback_(callback) {}
+
+  // Returns the callback to pass to a shard.
+  net::CompletionCallback NewCallback() {
+    return base::Bind(&Barrier::OnComplete, this);
+  }
+
+  // Records the value returned by a shard.
+  void Add(int result) {
+    if (result == net::ERR_IO_PENDING)
+      pending_++;
+    else
+      Record(result);
+  }
+
+  // Must be called after the operation was sent to all the shards.
+  int Finish() {
+    if (--pending_)
+      return net::ERR_IO_PENDING;
+    return result_;
+  }
+
+ private:
+  friend class base::RefCounted<Barrier>;
+  ~Barrier() {}
+
+  void Record(int result) {
+    if (result != net::OK && result_ == net::OK)
+      result_ = result;
+  }
+
+  void OnComplete(int result) {
+    Record(result);
+    if (!--pending_)
+      callback_.Run(result_);
+  }
+
+  int pending_;
+  int result_;
+  net::CompletionCallback callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Barrier);
+};
+
+// The enumeration state: the current shard and the iterator for that shard.
+struct ShardedBackend::Iterator {
+  Iterator() : shard(0), shard_iter(NULL) {}
+
+  int shard;
+  void* shard_iter;
+};
+
+ShardedBackend::ShardedBackend(const FilePath& path, int num_shards,
+                               net::NetLog* net_log)
+    : path_(path),
+      num_shards_(num_shards),
+      init_shard_(0),
+      force_(false),
+      max_bytes_(0),
+      type_(net::DISK_CACHE),
+      flags_(0),
+      shards_(num_shards, static_cast<Backend*>(NULL)),
+      group_(new EvictionGroup(num_shards)),
+      net_log_(net_log),
+      ALLOW_THIS_IN_INITIALIZER_LIST(ptr_factory_(this)) {
+  DCHECK(num_shards > 0 && num_shards <= kMaxShards);
+  for (int i = 0; i < num_shards_; i++) {
+    shard_paths_.push_back(
+        path_.AppendASCII(base::StringPrintf("shard_%d", i)));
+  }
+}
+
+ShardedBackend::~ShardedBackend() {
+  // Each BackendImpl waits for its own thread to perform the final cleanup, so
+  // the threads have to be stopped after all the shards go away.
+  for (int i = 0; i < num_shards_; i++)
+    delete shards_[i];
+  threads_.reset();
+}
+
+// Static.
+int ShardedBackend::CreateBackend(const FilePath& path, int num_shards,
+                                  bool force, int max_bytes,
+                                  net::CacheType type, uint32 flags,
+                                  net::NetLog* net_log, Backend** backend,
+                                  const net::CompletionCallback& callback) {
+  DCHECK(!callback.is_null());
+  if (num_shards <= 0 || num_shards > kMaxShards) {
+    LOG(ERROR) << "Invalid number of cache shards: " << num_shards;
+    *backend = NULL;
+    return net::ERR_INVALID_ARGUMENT;
+  }
+
+  ShardedBackend* cache = new ShardedBackend(path, num_shards, net_log);
+  return cache->Init(force, max_bytes, type, flags,
+                     base::Bind(&OnShardedBackendCreated,
+                                base::Unretained(cache), backend, callback));
+}
+
+int ShardedBackend::Init(bool force, int max_bytes, net::CacheType type,
+                         uint32 flags,
+                         const net::CompletionCallback& callback) {
+  DCHECK(init_callback_.is_null());
+  DCHECK(threads_.empty());
+  force_ = force;
+  max_bytes_ = max_bytes;
+  type_ = type;
+  flags_ = flags;
+  init_callback_ = callback;
+
+  // Keep the trace buffer alive while the shards come and go.
+  trace_object_ = TraceObject::GetTraceObject();
+
+  for (int i = 0; i < num_shards_; i++) {
+    base::Thread* thread =
+        new base::Thread(base::StringPrintf("cache_thread_%d", i).c_str());
+    threads_.push_back(thread);
+    if (!thread->StartWithOptions(
+            base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+      LOG(ERROR) << "Unable to start a cache thread";
+      MessageLoop::current()->PostTask(
+          FROM_HERE, base::Bind(&ShardedBackend::OnShardCreated,
+                                ptr_factory_.GetWeakPtr(), net::ERR_FAILED));
+      return net::ERR_IO_PENDING;
+    }
+  }
+
+  // Remove the files left by a previous run with a different configuration.
+  // The first shard is created on the same thread, after this task.
+  scoped_refptr<base::MessageLoopProxy> thread =
+      threads_[0]->message_loop_proxy();
+  thread->PostTask(FROM_HERE, base::Bind(&DeleteUnshardedCache, path_));
+  thread->PostTask(FROM_HERE,
+                   base::Bind(&ShardedBackend::DeleteShards, path_,
+                              num_shards_));
+
+  InitNextShard();
+  return net::ERR_IO_PENDING;
+}
+
+// Static.
+void ShardedBackend::DeleteShards(const FilePath& path, int first_shard) {
+  for (int i = first_shard; i < kMaxShards; i++) {
+    FilePath shard = path.AppendASCII(base::StringPrintf("shard_%d", i));
+    if (file_util::PathExists(shard))
+      file_util::Delete(shard, true);
+  }
+}
+
+int ShardedBackend::FlushQueueForTest(const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (int i = 0; i < num_shards_; i++) {
+    BackendImpl* shard = static_cast<BackendImpl*>(shards_[i]);
+    barrier->Add(shard->FlushQueueForTest(barrier->NewCallback()));
+  }
+  return barrier->Finish();
+}
+
+int ShardedBackend::GetShardIndex(const std::string& key) const {
+  // Use the most significant bits of the hash, so that the index buckets of a
+  // given shard (selected by the least significant bits) are evenly used.
+  return static_cast<int>((Hash(key) >> 24) % num_shards_);
+}
+
+int32 ShardedBackend::GetEntryCount() const {
+  int32 count = 0;
+  for (int i = 0; i < num_shards_; i++)
+    count += shards_[i]->GetEntryCount();
+  return count;
+}
+
+int ShardedBackend::OpenEntry(const std::string& key, Entry** entry,
+                              const net::CompletionCallback& callback) {
+  return GetShard(key)->OpenEntry(key, entry, callback);
+}
+
+int ShardedBackend::CreateEntry(const std::string& key, Entry** entry,
+                                const net::CompletionCallback& callback) {
+  return GetShard(key)->CreateEntry(key, entry, callback);
+}
+
+int ShardedBackend::DoomEntry(const std::string& key,
+                              const net::CompletionCallback& callback) {
+  return GetShard(key)->DoomEntry(key, callback);
+}
+
+int ShardedBackend::DoomAllEntries(const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (int i = 0; i < num_shards_; i++)
+    barrier->Add(shards_[i]->DoomAllEntries(barrier->NewCallback()));
+  return barrier->Finish();
+}
+
+int ShardedBackend::DoomEntriesBetween(
+    const base::Time initial_time, const base::Time end_time,
+    const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (int i = 0; i < num_shards_; i++) {
+    barrier->Add(shards_[i]->DoomEntriesBetween(initial_time, end_time,
+                                                barrier->NewCallback()));
+  }
+  return barrier->Finish();
+}
+
+int ShardedBackend::DoomEntriesSince(const base::Time initial_time,
+                                     const net::CompletionCallback& callback) {
+  scoped_refptr<Barrier> barrier(new Barrier(callback));
+  for (int i = 0; i < num_shards_; i++) {
+    barrier->Add(shards_[i]->DoomEntriesSince(initial_time,
+                                              barrier->NewCallback()));
+  }
+  return barrier->Finish();
+}
+
+int ShardedBackend::OpenNextEntry(void** iter, Entry** next_entry,
+                                  const net::CompletionCallback& callback) {
+  DCHECK(iter);
+  Iterator* iterator = reinterpret_cast<Iterator*>(*iter);
+  if (!iterator) {
+    iterator = new Iterator;
+    *iter = iterator;
+  }
+  return OpenNextEntryFromShard(iterator, iter, next_entry, callback);
+}
+
+void ShardedBackend::EndEnumeration(void** iter) {
+  Iterator* iterator = reinterpret_cast<Iterator*>(*iter);
+  *iter = NULL;
+  if (!iterator)
+    return;
+
+  if (iterator->shard < num_shards_ && iterator->shard_iter)
+    shards_[iterator->shard]->EndEnumeration(&iterator->shard_iter);
+  delete iterator;
+}
+
+void ShardedBackend::GetStats(StatsItems* stats) {
+  for (int i = 0; i < num_shards_; i++) {
+    StatsItems shard_stats;
+    shards_[i]->GetStats(&shard_stats);
+    for (size_t j = 0; j < shard_stats.size(); j++) {
+      stats->push_back(std::make_pair(
+          base::StringPrintf("Shard %d %s", i, shard_stats[j].first.c_str()),
+          shard_stats[j].second));
+    }
+  }
+}
+
+void ShardedBackend::OnExternalCacheHit(const std::string& key) {
+  GetShard(key)->OnExternalCacheHit(key);
+}
+
+// We initialize one shard at a time: the shards are independent, but the
+// initialization of the first backend of the process sets up some static state
+// (histograms and field trials) that is not meant to be used from more than one
+// thread at the same time.
+void ShardedBackend::InitNextShard() {
+  if (init_shard_ == num_shards_) {
+    net::CompletionCallback callback = init_callback_;
+    init_callback_.Reset();
+    callback.Run(net::OK);  // |this| may be deleted at this point.
+    return;
+  }
+
+  // Every shard gets the limit of the whole cache. When |max_bytes_| is zero,
+  // each one computes it, and the group uses the smallest value.
+  int rv = BackendImpl::CreateBackend(
+      shard_paths_[init_shard_], force_, max_bytes_, type_,
+      flags_, threads_[init_shard_]->message_loop_proxy(), net_log_,
+      &shards_[init_shard_],
+      base::Bind(&ShardedBackend::OnShardCreated, ptr_factory_.GetWeakPtr()));
+  DCHECK_EQ(net::ERR_IO_PENDING, rv);
+}
+
+void ShardedBackend::OnShardCreated(int result) {
+  if (result != net::OK) {
+    net::CompletionCallback callback = init_callback_;
+    init_callback_.Reset();
+    callback.Run(result);  // |this| may be deleted at this point.
+    return;
+  }
+
+  // The shard is deleted by our destructor, after any task already posted to
+  // its thread.
+  threads_[init_shard_]->message_loop_proxy()->PostTask(
+      FROM_HERE, base::Bind(&BackendImpl::JoinEvictionGroup,
+                            base::Unretained(static_cast<BackendImpl*>(
+                                shards_[init_shard_])),
+                            group_, init_shard_));
+  init_shard_++;
+  InitNextShard();
+}
+
+int ShardedBackend::OpenNextEntryFromShard(
+    Iterator* iterator, void** iter, Entry** next_entry,
+    const net::CompletionCallback& callback) {
+  while (iterator->shard < num_shards_) {
+    int rv = shards_[iterator->shard]->OpenNextEntry(
+        &iterator->shard_iter, next_entry,
+        base::Bind(&ShardedBackend::OnOpenNextEntryComplete,
+                   ptr_factory_.GetWeakPtr(), iterator, iter, next_entry,
+                   callback));
+    if (rv == net::OK || rv == net::ERR_IO_PENDING)
+      return rv;
+
+    // This shard is done; BackendImpl already released its iterator.
+    iterator->shard++;
+    iterator->shard_iter = NULL;
+  }
+
+  delete iterator;
+  *iter = NULL;
+  return net::ERR_FAILED;
+}
+
+void ShardedBackend::OnOpenNextEntryComplete(
+    Iterator* iterator, void** iter, Entry** next_entry,
+    const net::CompletionCallback& callback, int result) {
+  if (result == net::OK)
+    return callback.Run(result);
+
+  iterator->shard++;
+  iterator->shard_iter = NULL;
+  int rv = OpenNextEntryFromShard(iterator, iter, next_entry, callback);
+  if (rv != net::ERR_IO_PENDING)
+    callback.Run(rv);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,145 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_SHARDED_BACKEND_H_
+#define NET_DISK_CACHE_SHARDED_BACKEND_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
+#include "net/disk_cache/disk_cache.h"
+
+namespace base {
+class Thread;
+}
+
+namespace disk_cache {
+
+class EvictionGroup;
+class TraceObject;
+
+// This class implements the Backend interface by splitting the keys among a
+// number of BackendImpl instances (shards), each one with its own set of files
+// (on a sub-folder of the cache path) and its own cache thread.
+//
+// A single BackendImpl performs all index and block-file work on one thread,
+// so the throughput of a busy cache is limited by that thread. With shards,
+// operations on keys that map to different shards proceed in parallel, while
+// each shard keeps the single-threaded design of the regular backend. The
+// shards share the size limit of the cache through an EvictionGroup, so the
+// least recently used entries of the whole cache are evicted first.
+//
+// All the methods of this class must be called from the same thread, and all
+// callbacks are invoked on that thread.
+class NET_EXPORT_PRIVATE ShardedBackend : public Backend {
+ public:
+  // The maximum number of shards supported.
+  static const int kMaxShards = 16;
+
+  ShardedBackend(const FilePath& path, int num_shards, net::NetLog* net_log);
+  virtual ~ShardedBackend();
+
+  // Returns an instance of a sharded Backend. |num_shards| is the number of
+  // cache threads (and sub-folders of |path|) to use, up to kMaxShards. The
+  // rest of the arguments are the same as for BackendImpl::CreateBackend().
+  // |max_bytes| is the size of the whole cache.
+  static int CreateBackend(const FilePath& path, int num_shards, bool force,
+                           int max_bytes, net::CacheType type, uint32 flags,
+                           net::NetLog* net_log, Backend** backend,
+                           const net::CompletionCallback& callback);
+
+  // Starts the cache threads and initializes all the shards (one at a time).
+  // This method always completes asynchronously.
+  int Init(bool force, int max_bytes, net::CacheType type, uint32 flags,
+           const net::CompletionCallback& callback);
+
+  // Deletes the sub-folders used by shards |first_shard| and up on |path|.
+  // This method performs file IO.
+  static void DeleteShards(const FilePath& path, int first_shard);
+
+  // Returns the number of shards used by this object.
+  int num_shards() const { return num_shards_; }
+
+  // Sends a dummy operation through the operation queue of every shard, for
+  // unit tests.
+  int FlushQueueForTest(const net::CompletionCallback& callback);
+
+  // Returns the index of the shard that stores |key|.
+  int GetShardIndex(const std::string& key) const;
+
+  // Backend interface.
+  virtual int32 GetEntryCount() const OVERRIDE;
+  virtual int OpenEntry(const std::string& key, Entry** entry,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int CreateEntry(const std::string& key, Entry** entry,
+                          const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntry(const std::string& key,
+                        const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomAllEntries(const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesBetween(
+      const base::Time initial_time,
+      const base::Time end_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int DoomEntriesSince(
+      const base::Time initial_time,
+      const net::CompletionCallback& callback) OVERRIDE;
+  virtual int OpenNextEntry(void** iter, Entry** next_entry,
+                            const net::CompletionCallback& callback) OVERRIDE;
+  virtual void EndEnumeration(void** iter) OVERRIDE;
+  virtual void GetStats(
+      std::vector<std::pair<std::string, std::string> >* stats) OVERRIDE;
+  virtual void OnExternalCacheHit(const std::string& key) OVERRIDE;
+
+ private:
+  class Barrier;
+  struct Iterator;
+
+  // Initializes the next shard, or completes Init() when all of them are done.
+  void InitNextShard();
+  void OnShardCreated(int result);
+
+  // Returns the next entry from the shard pointed to by |iterator|, moving to
+  // the following shards when a shard has no more entries.
+  int OpenNextEntryFromShard(Iterator* iterator, void** iter,
+                             Entry** next_entry,
+                             const net::CompletionCallback& callback);
+  void OnOpenNextEntryComplete(Iterator* iterator, void** iter,
+                               Entry** next_entry,
+                               const net::CompletionCallback& callback,
+                               int result);
+
+  Backend* GetShard(const std::string& key) const {
+    return shards_[GetShardIndex(key)];
+  }
+
+  FilePath path_;
+  int num_shards_;
+  int init_shard_;  // The shard being initialized.
+  bool force_;
+  int max_bytes_;
+  net::CacheType type_;
+  uint32 flags_;
+  std::vector<FilePath> shard_paths_;  // Must outlive the shard creation.
+  std::vector<Backend*> shards_;
+  ScopedVector<base::Thread> threads_;
+  scoped_refptr<EvictionGroup> group_;  // Shared by all the shards.
+  scoped_refptr<TraceObject> trace_object_;  // Shared by all the shards.
+  net::NetLog* net_log_;
+  net::CompletionCallback init_callback_;
+  base::WeakPtrFactory<ShardedBackend> ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedBackend);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SHARDED_BACKEND_H_
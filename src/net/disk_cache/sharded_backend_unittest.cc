@@ -0,0 +1,296 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+
+#include "base/basictypes.h"
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/sharded_backend.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using base::Time;
+
+namespace {
+
+class DiskCacheShardedBackendTest : public DiskCacheTest {
+ protected:
+  DiskCacheShardedBackendTest() : max_size_(10 * 1024 * 1024) {}
+
+  // Deletes the files of all the shards.
+  bool CleanupShards() {
+    for (int i = 0; i < disk_cache::ShardedBackend::kMaxShards; i++) {
+      FilePath shard =
+          cache_path_.AppendASCII(base::StringPrintf("shard_%d", i));
+      if (!file_util::Delete(shard, true))
+        return false;
+    }
+    return CleanupCacheDir();
+  }
+
+  // Creates a cache with |num_shards| shards on |cache_path_|.
+  void InitCache(int num_shards) {
+    net::TestCompletionCallback cb;
+    disk_cache::Backend* cache = NULL;
+    int rv = disk_cache::ShardedBackend::CreateBackend(
+        cache_path_, num_shards, false, max_size_, net::DISK_CACHE,
+        disk_cache::kNoRandom, NULL, &cache, cb.callback());
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    ASSERT_TRUE(cache);
+    cache_.reset(static_cast<disk_cache::ShardedBackend*>(cache));
+  }
+
+  // Waits until all the shards are done with the work already queued.
+  void FlushQueues() {
+    net::TestCompletionCallback cb;
+    int rv = cache_->FlushQueueForTest(cb.callback());
+    EXPECT_EQ(net::OK, cb.GetResult(rv));
+  }
+
+  int OpenEntry(const std::string& key, disk_cache::Entry** entry) {
+    net::TestCompletionCallback cb;
+    int rv = cache_->OpenEntry(key, entry, cb.callback());
+    return cb.GetResult(rv);
+  }
+
+  int CreateEntry(const std::string& key, disk_cache::Entry** entry) {
+    net::TestCompletionCallback cb;
+    int rv = cache_->CreateEntry(key, entry, cb.callback());
+    return cb.GetResult(rv);
+  }
+
+  int OpenNextEntry(void** iter, disk_cache::Entry** next_entry) {
+    net::TestCompletionCallback cb;
+    int rv = cache_->OpenNextEntry(iter, next_entry, cb.callback());
+    return cb.GetResult(rv);
+  }
+
+  // Creates |num_entries| entries named "key N", with some data on stream 0.
+  void CreateEntries(int num_entries) {
+    scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(100));
+    CacheTestFillBuffer(buffer->data(), 100, false);
+    for (int i = 0; i < num_entries; i++) {
+      disk_cache::Entry* entry;
+      ASSERT_EQ(net::OK, CreateEntry(base::StringPrintf("key %d", i), &entry));
+      net::TestCompletionCallback cb;
+      int rv = entry->WriteData(0, 0, buffer, 100, cb.callback(), false);
+      EXPECT_EQ(100, cb.GetResult(rv));
+      entry->Close();
+    }
+  }
+
+  scoped_ptr<disk_cache::ShardedBackend> cache_;
+  int max_size_;
+};
+
+TEST_F(DiskCacheShardedBackendTest, Basics) {
+  ASSERT_TRUE(CleanupShards());
+  InitCache(4);
+
+  disk_cache::Entry* entry;
+  EXPECT_NE(net::OK, OpenEntry("the first key", &entry));
+  ASSERT_EQ(net::OK, CreateEntry("the first key", &entry));
+  EXPECT_EQ("the first key", entry->GetKey());
+  entry->Close();
+  EXPECT_NE(net::OK, CreateEntry("the first key", &entry));
+  ASSERT_EQ(net::OK, OpenEntry("the first key", &entry));
+  entry->Close();
+  EXPECT_EQ(1, cache_->GetEntryCount());
+
+  net::TestCompletionCallback cb;
+  int rv = cache_->DoomEntry("the first key", cb.callback());
+  EXPECT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_NE(net::OK, OpenEntry("the first key", &entry));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  // Each shard has its own set of files.
+  for (int i = 0; i < 4; i++) {
+    FilePath shard =
+        cache_path_.AppendASCII(base::StringPrintf("shard_%d", i));
+    EXPECT_TRUE(file_util::PathExists(shard.AppendASCII("index")));
+  }
+}
+
+// Tests that the keys are spread among all the shards, and that they are found
+// again when the cache is re-opened.
+TEST_F(DiskCacheShardedBackendTest, Distribution) {
+  ASSERT_TRUE(CleanupShards());
+  InitCache(4);
+
+  const int kNumEntries = 200;
+  int per_shard[4] = {0};
+  for (int i = 0; i < kNumEntries; i++)
+    per_shard[cache_->GetShardIndex(base::StringPrintf("key %d", i))]++;
+  for (int i = 0; i < 4; i++)
+    EXPECT_LT(kNumEntries / 8, per_shard[i]);
+
+  CreateEntries(kNumEntries);
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  cache_.reset();
+
+  InitCache(4);
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, OpenEntry(base::StringPrintf("key %d", i), &entry));
+    EXPECT_EQ(100, entry->GetDataSize(0));
+    entry->Close();
+  }
+}
+
+TEST_F(DiskCacheShardedBackendTest, Enumerations) {
+  ASSERT_TRUE(CleanupShards());
+  InitCache(3);
+
+  const int kNumEntries = 50;
+  CreateEntries(kNumEntries);
+
+  std::set<std::string> keys;
+  void* iter = NULL;
+  disk_cache::Entry* entry;
+  while (OpenNextEntry(&iter, &entry) == net::OK) {
+    EXPECT_TRUE(keys.insert(entry->GetKey()).second);
+    entry->Close();
+  }
+  EXPECT_TRUE(NULL == iter);
+  EXPECT_EQ(static_cast<size_t>(kNumEntries), keys.size());
+
+  // Stop an enumeration half way.
+  ASSERT_EQ(net::OK, OpenNextEntry(&iter, &entry));
+  entry->Close();
+  cache_->EndEnumeration(&iter);
+  EXPECT_TRUE(NULL == iter);
+}
+
+TEST_F(DiskCacheShardedBackendTest, DoomAll) {
+  ASSERT_TRUE(CleanupShards());
+  InitCache(4);
+
+  Time start = Time::Now();
+  CreateEntries(40);
+  EXPECT_EQ(40, cache_->GetEntryCount());
+
+  base::PlatformThread::Sleep(20);
+  net::TestCompletionCallback cb;
+  int rv = cache_->DoomEntriesSince(Time::Now(), cb.callback());
+  EXPECT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(40, cache_->GetEntryCount());
+
+  rv = cache_->DoomEntriesBetween(start, Time::Now(), cb.callback());
+  EXPECT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  CreateEntries(10);
+  rv = cache_->DoomAllEntries(cb.callback());
+  EXPECT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  std::vector<std::pair<std::string, std::string> > stats;
+  cache_->GetStats(&stats);
+  EXPECT_FALSE(stats.empty());
+}
+
+// Tests that the shards share the size limit of the cache, and that the least
+// recently used entries of the whole cache are evicted first.
+TEST_F(DiskCacheShardedBackendTest, SharedEviction) {
+  ASSERT_TRUE(CleanupShards());
+  max_size_ = 3 * 1024 * 1024;
+  InitCache(4);
+
+  const int kSize = 40 * 1024;
+  const int kNumEntries = 100;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    ASSERT_EQ(net::OK, CreateEntry(base::StringPrintf("key %d", i), &entry));
+    net::TestCompletionCallback cb;
+    int rv = entry->WriteData(0, 0, buffer, kSize, cb.callback(), false);
+    EXPECT_EQ(kSize, cb.GetResult(rv));
+    entry->Close();
+
+    // Keep the last use of the entries in creation order.
+    FlushQueues();
+  }
+
+  // The trim moves from one shard to another, so wait until it settles down.
+  int num_entries = kNumEntries + 1;
+  for (int i = 0; i < 100 && num_entries != cache_->GetEntryCount(); i++) {
+    num_entries = cache_->GetEntryCount();
+    FlushQueues();
+  }
+  EXPECT_LT(num_entries, kNumEntries);
+  EXPECT_LE(num_entries, max_size_ / kSize);
+
+  for (int i = 0; i < kNumEntries; i++) {
+    disk_cache::Entry* entry;
+    int rv = OpenEntry(base::StringPrintf("key %d", i), &entry);
+    if (i < kNumEntries - num_entries) {
+      EXPECT_NE(net::OK, rv) << i;
+    } else {
+      ASSERT_EQ(net::OK, rv) << i;
+      entry->Close();
+    }
+  }
+}
+
+TEST_F(DiskCacheShardedBackendTest, InvalidNumShards) {
+  disk_cache::Backend* cache = reinterpret_cast<disk_cache::Backend*>(1);
+  net::TestCompletionCallback cb;
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT,
+            disk_cache::ShardedBackend::CreateBackend(
+                cache_path_, 0, false, 0, net::DISK_CACHE,
+                disk_cache::kNoRandom, NULL, &cache, cb.callback()));
+  EXPECT_TRUE(NULL == cache);
+
+  cache = reinterpret_cast<disk_cache::Backend*>(1);
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT,
+            disk_cache::ShardedBackend::CreateBackend(
+                cache_path_, disk_cache::ShardedBackend::kMaxShards + 1, false,
+                0, net::DISK_CACHE, disk_cache::kNoRandom, NULL, &cache,
+                cb.callback()));
+  EXPECT_TRUE(NULL == cache);
+}
+
+// Tests that CreateCacheBackend() uses shards when requested, and that the
+// files of a previous configuration go away.
+TEST_F(DiskCacheShardedBackendTest, CreateCacheBackend) {
+  ASSERT_TRUE(CleanupShards());
+  base::Thread cache_thread("CacheThread");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+      base::Thread::Options(MessageLoop::TYPE_IO, 0)));
+  FilePath index = cache_path_.AppendASCII("index");
+  const int kNumShards[] = {1, 4, 2, 1};
+
+  for (size_t i = 0; i < arraysize(kNumShards); i++) {
+    disk_cache::SetNumCacheShards(kNumShards[i]);
+    disk_cache::Backend* cache;
+    net::TestCompletionCallback cb;
+    int rv = disk_cache::CreateCacheBackend(
+        net::DISK_CACHE, cache_path_, 0, false,
+        cache_thread.message_loop_proxy(), NULL, &cache, cb.callback());
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    delete cache;
+
+    EXPECT_EQ(kNumShards[i] == 1, file_util::PathExists(index));
+    for (int j = 0; j < 4; j++) {
+      FilePath shard = cache_path_.AppendASCII(
+          base::StringPrintf("shard_%d", j)).AppendASCII("index");
+      EXPECT_EQ(kNumShards[i] > 1 && j < kNumShards[i],
+                file_util::PathExists(shard));
+    }
+  }
+}
+
+}  // namespace
@@ -9,7 +9,9 @@
 #include <windows.h>
 #endif
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
 #include "net/disk_cache/stress_support.h"
 
 // Change this value to 1 to enable tracing on a release build. By default,
@@ -32,6 +34,11 @@ const int kNumberOfEntries = 5000;  // 240 KB.
 
 bool s_trace_enabled = false;
 
+// Protects the trace buffer and object, which can be used from more than one
+// cache thread.
+base::LazyInstance<base::Lock, base::LeakyLazyInstanceTraits<base::Lock> >
+    g_trace_lock = LAZY_INSTANCE_INITIALIZER;
+
 struct TraceBuffer {
   int num_traces;
   int current;
@@ -59,6 +66,7 @@ static TraceObject* s_trace_object = NULL;
 
 // Static.
 TraceObject* TraceObject::GetTraceObject() {
+  base::AutoLock lock(g_trace_lock.Get());
   if (s_trace_object)
     return s_trace_object;
 
@@ -71,6 +79,7 @@ TraceObject::TraceObject() {
 }
 
 TraceObject::~TraceObject() {
+  base::AutoLock lock(g_trace_lock.Get());
   DestroyTrace();
 }
 
@@ -101,6 +110,10 @@ void Trace(const char* format, ...) {
   if (!s_trace_buffer || !s_trace_enabled)
     return;
 
+  base::AutoLock lock(g_trace_lock.Get());
+  if (!s_trace_buffer)
+    return;
+
   va_list ap;
   va_start(ap, format);
 
@@ -5,6 +5,7 @@
 #include "net/dns/async_host_resolver.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/logging.h"
@@ -24,11 +25,6 @@ namespace net {
 
 namespace {
 
-// TODO(agayev): fix this when IPv6 support is added.
-uint16 QueryTypeFromAddressFamily(AddressFamily address_family) {
-  return dns_protocol::kTypeA;
-}
-
 class RequestParameters : public NetLog::EventParameters {
  public:
   RequestParameters(const HostResolver::RequestInfo& info,
@@ -106,9 +102,14 @@ class AsyncHostResolver::Request {
     DCHECK(addresses_);
     DCHECK(resolver_);
     resolver_->OnStart(this);
+    AddressFamily address_family = info.address_family();
+    if (address_family == ADDRESS_FAMILY_UNSPECIFIED)
+      address_family = resolver_->default_address_family_;
     std::string dns_name;
     if (DNSDomainFromDot(info.hostname(), &dns_name))
-      key_ = Key(dns_name, QueryTypeFromAddressFamily(info.address_family()));
+      key_ = Key(dns_name, address_family);
+    else
+      key_ = Key(std::string(), address_family);
   }
 
   ~Request() {
@@ -131,7 +132,8 @@ class AsyncHostResolver::Request {
     if (!ParseIPLiteralToNumber(info_.hostname(), &ip_number))
       return false;
 
-    if (ip_number.size() != kIPv4AddressSize) {
+    if (ip_number.size() != kIPv4AddressSize &&
+        key_.second == ADDRESS_FAMILY_IPV4) {
       result_ = ERR_NAME_NOT_RESOLVED;
     } else {
       *addresses_ = AddressList::CreateFromIPAddressWithCname(
@@ -201,6 +203,122 @@ class AsyncHostResolver::Request {
   int result_;
 };
 
+//-----------------------------------------------------------------------------
+// A Job looks up one Key for all of the requests attached to it. When both
+// A and AAAA records are wanted, it makes both DNS requests at once and
+// completes when the last one does.
+class AsyncHostResolver::Job {
+ public:
+  Job(AsyncHostResolver* resolver, const Key& key)
+      : resolver_(resolver),
+        key_(key),
+        num_pending_(0),
+        result_(ERR_NAME_NOT_RESOLVED) {
+  }
+
+  ~Job() {
+    STLDeleteElements(&dns_requests_);
+    STLDeleteElements(&requests_);
+  }
+
+  const Key& key() const { return key_; }
+  RequestList& requests() { return requests_; }
+
+  // Starts the DNS requests. Returns ERR_IO_PENDING if any of them is in
+  // progress, or else the error with which they all failed.
+  int Start(DnsClient* client, const BoundNetLog& source_net_log) {
+    if (key_.second != ADDRESS_FAMILY_IPV6)
+      StartDnsRequest(client, dns_protocol::kTypeA, source_net_log);
+    if (key_.second != ADDRESS_FAMILY_IPV4)
+      StartDnsRequest(client, dns_protocol::kTypeAAAA, source_net_log);
+    return num_pending_ > 0 ? ERR_IO_PENDING : result_;
+  }
+
+ private:
+  void StartDnsRequest(DnsClient* client,
+                       uint16 qtype,
+                       const BoundNetLog& source_net_log) {
+    DnsClient::Request* dns_req = client->CreateRequest(
+        key_.first,
+        qtype,
+        base::Bind(&Job::OnDnsRequestComplete, base::Unretained(this)),
+        source_net_log);
+    dns_requests_.push_back(dns_req);
+    int rv = dns_req->Start();
+    if (rv == ERR_IO_PENDING)
+      ++num_pending_;
+    else
+      result_ = rv;
+  }
+
+  void OnDnsRequestComplete(DnsClient::Request* dns_req,
+                            int result,
+                            const DnsResponse* response) {
+    DCHECK_GT(num_pending_, 0);
+    --num_pending_;
+
+    if (result == OK) {
+      // TODO(szym): Add stricter checking of names, aliases and address
+      // lengths.
+      IPAddressList& ip_addresses =
+          dns_req->qtype() == dns_protocol::kTypeA ? ipv4_addresses_
+                                                   : ipv6_addresses_;
+      DnsRecordParser parser = response->Parser();
+      DnsResourceRecord record;
+      while (parser.ParseRecord(&record)) {
+        if (record.type == dns_req->qtype() &&
+            (record.rdata.size() == kIPv4AddressSize ||
+             record.rdata.size() == kIPv6AddressSize)) {
+          ip_addresses.push_back(IPAddressNumber(record.rdata.begin(),
+                                                 record.rdata.end()));
+        }
+      }
+    } else if (result_ == ERR_NAME_NOT_RESOLVED) {
+      // A failure to reach the server is more telling than a missing record.
+      result_ = result;
+    }
+
+    if (num_pending_ > 0)
+      return;
+
+    // Without a way to tell whether IPv6 is usable, the IPv4 addresses are
+    // tried first.
+    IPAddressList ip_addresses(ipv4_addresses_);
+    ip_addresses.insert(ip_addresses.end(), ipv6_addresses_.begin(),
+                        ipv6_addresses_.end());
+
+    // If by the time requests that caused this job are cancelled, we do
+    // not have a port number to associate with the result, therefore, we
+    // assume the most common port, otherwise we use the port number of the
+    // first request.
+    AddressList addr_list;
+    if (!ip_addresses.empty()) {
+      int port = requests_.empty() ? 80 : requests_.front()->info().port();
+      addr_list = AddressList::CreateFromIPAddressList(ip_addresses, port);
+      result_ = OK;
+    }
+    resolver_->OnJobComplete(this, result_, addr_list);
+  }
+
+  AsyncHostResolver* resolver_;
+  const Key key_;
+
+  // The DNS requests, one per query type.
+  std::vector<DnsClient::Request*> dns_requests_;
+  int num_pending_;
+
+  // The error to report if no address is found.
+  int result_;
+
+  IPAddressList ipv4_addresses_;
+  IPAddressList ipv6_addresses_;
+
+  // The requests waiting for |key_| to resolve.
+  RequestList requests_;
+
+  DISALLOW_COPY_AND_ASSIGN(Job);
+};
+
 //-----------------------------------------------------------------------------
 AsyncHostResolver::AsyncHostResolver(size_t max_dns_requests,
                                      size_t max_pending_requests,
@@ -210,18 +328,15 @@ AsyncHostResolver::AsyncHostResolver(size_t max_dns_requests,
     : max_dns_requests_(max_dns_requests),
       max_pending_requests_(max_pending_requests),
       cache_(cache),
+      default_address_family_(ADDRESS_FAMILY_UNSPECIFIED),
       client_(client),
       net_log_(net_log) {
 }
 
 AsyncHostResolver::~AsyncHostResolver() {
-  // Destroy request lists.
-  for (KeyRequestListMap::iterator it = requestlist_map_.begin();
-       it != requestlist_map_.end(); ++it)
-    STLDeleteElements(&it->second);
-
-  // Destroy DNS requests.
-  STLDeleteElements(&dns_requests_);
+  // Destroy jobs, along with their DNS requests and the requests attached to
+  // them.
+  STLDeleteValues(&jobs_);
 
   // Destroy pending requests.
   for (size_t i = 0; i < arraysize(pending_requests_); ++i)
@@ -243,10 +358,10 @@ int AsyncHostResolver::Resolve(const RequestInfo& info,
     rv = ERR_NAME_NOT_RESOLVED;
   else if (request->ResolveAsIp() || request->ServeFromCache())
     rv = request->result();
-  else if (AttachToRequestList(request.get()))
+  else if (AttachToJob(request.get()))
     rv = ERR_IO_PENDING;
-  else if (dns_requests_.size() < max_dns_requests_)
-    rv = StartNewDnsRequestFor(request.get());
+  else if (jobs_.size() < max_dns_requests_)
+    rv = StartNewJobFor(request.get());
   else
     rv = Enqueue(request.get());
 
@@ -312,76 +427,46 @@ void AsyncHostResolver::CancelRequest(RequestHandle req_handle) {
   scoped_ptr<Request> request(reinterpret_cast<Request*>(req_handle));
   DCHECK(request.get());
 
-  KeyRequestListMap::iterator it = requestlist_map_.find(request->key());
-  if (it != requestlist_map_.end())
-    it->second.remove(request.get());
+  JobMap::iterator it = jobs_.find(request->key());
+  if (it != jobs_.end())
+    it->second->requests().remove(request.get());
   else
     pending_requests_[request->priority()].remove(request.get());
 }
 
 void AsyncHostResolver::SetDefaultAddressFamily(
     AddressFamily address_family) {
-  NOTIMPLEMENTED();
+  default_address_family_ = address_family;
 }
 
 AddressFamily AsyncHostResolver::GetDefaultAddressFamily() const {
-  return ADDRESS_FAMILY_IPV4;
+  return default_address_family_;
 }
 
 HostCache* AsyncHostResolver::GetHostCache() {
   return cache_.get();
 }
 
-void AsyncHostResolver::OnDnsRequestComplete(
-    DnsClient::Request* dns_req,
-    int result,
-    const DnsResponse* response) {
-  DCHECK(std::find(dns_requests_.begin(), dns_requests_.end(), dns_req)
-         != dns_requests_.end());
-
-  // If by the time requests that caused |dns_req| are cancelled, we do
-  // not have a port number to associate with the result, therefore, we
-  // assume the most common port, otherwise we use the port number of the
-  // first request.
-  KeyRequestListMap::iterator rit = requestlist_map_.find(
-      std::make_pair(dns_req->qname(), dns_req->qtype()));
-  DCHECK(rit != requestlist_map_.end());
-  RequestList& requests = rit->second;
-  int port = requests.empty() ? 80 : requests.front()->info().port();
-
-  // Extract AddressList out of DnsResponse.
-  AddressList addr_list;
-  if (result == OK) {
-    IPAddressList ip_addresses;
-    DnsRecordParser parser = response->Parser();
-    DnsResourceRecord record;
-    // TODO(szym): Add stricter checking of names, aliases and address lengths.
-    while (parser.ParseRecord(&record)) {
-      if (record.type == dns_req->qtype() &&
-          (record.rdata.size() == kIPv4AddressSize ||
-           record.rdata.size() == kIPv6AddressSize)) {
-        ip_addresses.push_back(IPAddressNumber(record.rdata.begin(),
-                                               record.rdata.end()));
-      }
-    }
-    if (!ip_addresses.empty())
-      addr_list = AddressList::CreateFromIPAddressList(ip_addresses, port);
-    else
-      result = ERR_NAME_NOT_RESOLVED;
-  }
+void AsyncHostResolver::OnJobComplete(Job* job,
+                                      int result,
+                                      const AddressList& addr_list) {
+  JobMap::iterator job_it = jobs_.find(job->key());
+  DCHECK(job_it != jobs_.end());
+  DCHECK_EQ(job, job_it->second);
+  RequestList& requests = job->requests();
 
-  // Run callback of every request that was depending on this DNS request,
-  // also notify observers.
+  // Run callback of every request that was depending on this job, also
+  // notify observers.
   for (RequestList::iterator it = requests.begin(); it != requests.end(); ++it)
     (*it)->OnAsyncComplete(result, addr_list);
 
-  // It is possible that the requests that caused |dns_req| to be
-  // created are cancelled by the time |dns_req| completes.  In that
-  // case |requests| would be empty.  We are knowingly throwing away the
-  // result of a DNS resolution in that case, because (a) if there are no
-  // requests, we do not have info to obtain a key from, (b) DnsTransaction
-  // does not have info(), adding one into it just temporarily doesn't make
-  // sense, since HostCache will be replaced with RR cache soon.
+  // It is possible that the requests that caused |job| to be created are
+  // cancelled by the time |job| completes.  In that case |requests| would be
+  // empty.  We are knowingly throwing away the result of a DNS resolution in
+  // that case, because (a) if there are no requests, we do not have info to
+  // obtain a key from, (b) DnsTransaction does not have info(), adding one
+  // into it just temporarily doesn't make sense, since HostCache will be
+  // replaced with RR cache soon.
   // Also, we only cache positive results.  All of this will change when RR
   // cache is added.
   if (result == OK && cache_.get() && !requests.empty()) {
@@ -392,13 +477,10 @@ void AsyncHostResolver::OnDnsRequestComplete(
     cache_->Set(key, result, addr_list, base::TimeTicks::Now());
   }
 
-  // Cleanup requests.
-  STLDeleteElements(&requests);
-  requestlist_map_.erase(rit);
-
-  // Cleanup |dns_req| and start a new one if there are pending requests.
-  dns_requests_.remove(dns_req);
-  delete dns_req;
+  // Cleanup |job|, along with its requests and DNS requests, and start a new
+  // one if there are pending requests.
+  jobs_.erase(job_it);
+  delete job;
   ProcessPending();
 }
 
@@ -413,30 +495,30 @@ AsyncHostResolver::Request* AsyncHostResolver::CreateNewRequest(
       this, source_net_log, request_net_log, info, callback, addresses);
 }
 
-bool AsyncHostResolver::AttachToRequestList(Request* request) {
-  KeyRequestListMap::iterator it = requestlist_map_.find(request->key());
-  if (it == requestlist_map_.end())
+bool AsyncHostResolver::AttachToJob(Request* request) {
+  JobMap::iterator it = jobs_.find(request->key());
+  if (it == jobs_.end())
     return false;
-  it->second.push_back(request);
+  it->second->requests().push_back(request);
   return true;
 }
 
-int AsyncHostResolver::StartNewDnsRequestFor(Request* request) {
-  DCHECK(requestlist_map_.find(request->key()) == requestlist_map_.end());
-  DCHECK(dns_requests_.size() < max_dns_requests_);
+int AsyncHostResolver::StartNewJobFor(Request* request) {
+  DCHECK(jobs_.find(request->key()) == jobs_.end());
+  DCHECK(jobs_.size() < max_dns_requests_);
 
   request->request_net_log().AddEvent(
       NetLog::TYPE_ASYNC_HOST_RESOLVER_CREATE_DNS_TRANSACTION, NULL);
 
-  requestlist_map_[request->key()].push_back(request);
-  DnsClient::Request* dns_req = client_->CreateRequest(
-      request->key().first,
-      request->key().second,
-      base::Bind(&AsyncHostResolver::OnDnsRequestComplete,
-                 base::Unretained(this)),
-      request->request_net_log());
-  dns_requests_.push_back(dns_req);
-  return dns_req->Start();
+  Job* job = new Job(this, request->key());
+  int rv = job->Start(client_, request->request_net_log());
+  if (rv != ERR_IO_PENDING) {
+    delete job;
+    return rv;
+  }
+  job->requests().push_back(request);
+  jobs_[request->key()] = job;
+  return rv;
 }
 
 int AsyncHostResolver::Enqueue(Request* request) {
@@ -494,22 +576,31 @@ AsyncHostResolver::Request* AsyncHostResolver::RemoveHighest() {
 }
 
 void AsyncHostResolver::ProcessPending() {
-  Request* request = RemoveHighest();
-  if (!request)
-    return;
-  for (size_t i = 0; i < arraysize(pending_requests_); ++i) {
-    RequestList& requests = pending_requests_[i];
-    RequestList::iterator it = requests.begin();
-    while (it != requests.end()) {
-      if (request->key() == (*it)->key()) {
-        requestlist_map_[request->key()].push_back(*it);
-        it = requests.erase(it);
-      } else {
-        ++it;
+  while (jobs_.size() < max_dns_requests_) {
+    Request* request = RemoveHighest();
+    if (!request)
+      return;
+    int rv = StartNewJobFor(request);
+    if (rv != ERR_IO_PENDING) {
+      request->OnAsyncComplete(rv, AddressList());
+      delete request;
+      continue;
+    }
+
+    // Attach the pending requests for the same key to the new job.
+    for (size_t i = 0; i < arraysize(pending_requests_); ++i) {
+      RequestList& requests = pending_requests_[i];
+      RequestList::iterator it = requests.begin();
+      while (it != requests.end()) {
+        if (request->key() == (*it)->key()) {
+          AttachToJob(*it);
+          it = requests.erase(it);
+        } else {
+          ++it;
+        }
       }
     }
   }
-  StartNewDnsRequestFor(request);
 }
 
 }  // namespace net
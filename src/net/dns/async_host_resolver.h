@@ -46,10 +46,6 @@ class NET_EXPORT AsyncHostResolver
   virtual AddressFamily GetDefaultAddressFamily() const OVERRIDE;
   virtual HostCache* GetHostCache() OVERRIDE;
 
-  void OnDnsRequestComplete(DnsClient::Request* request,
-                            int result,
-                            const DnsResponse* transaction);
-
  private:
   FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest, QueuedLookup);
   FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest, CancelPendingLookup);
@@ -60,12 +56,14 @@ class NET_EXPORT AsyncHostResolver
   FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest,
                            OverflowQueueWithHighPriorityLookup);
 
+  class Job;
   class Request;
 
-  typedef std::pair<std::string, uint16> Key;
+  // The name in DNS format and the address family which are looked up.
+  // ADDRESS_FAMILY_UNSPECIFIED looks up both A and AAAA records.
+  typedef std::pair<std::string, AddressFamily> Key;
   typedef std::list<Request*> RequestList;
-  typedef std::list<const DnsClient::Request*> DnsRequestList;
-  typedef std::map<Key, RequestList> KeyRequestListMap;
+  typedef std::map<Key, Job*> JobMap;
 
   // Create a new request for the incoming Resolve() call.
   Request* CreateNewRequest(const RequestInfo& info,
@@ -82,13 +80,17 @@ class NET_EXPORT AsyncHostResolver
   // Called when a request has been cancelled.
   void OnCancel(Request* request);
 
-  // If there is an in-progress transaction for Request->key(), this will
-  // attach |request| to the respective list.
-  bool AttachToRequestList(Request* request);
+  // Called by |job| once all of its DNS requests have completed. Runs the
+  // callbacks of its requests, and deletes |job|.
+  void OnJobComplete(Job* job, int result, const AddressList& addrlist);
+
+  // If there is an in-progress job for Request->key(), this will attach
+  // |request| to it.
+  bool AttachToJob(Request* request);
 
-  // Will start a new DNS request for |request|, will insert a new key in
-  // |requestlist_map_| and append |request| to the respective list.
-  int StartNewDnsRequestFor(Request* request);
+  // Will start a new job for |request|, which is attached to it. If the job
+  // fails synchronously, returns the error and |request| is not attached.
+  int StartNewJobFor(Request* request);
 
   // Will enqueue |request| in |pending_requests_|.
   int Enqueue(Request* request);
@@ -108,14 +110,13 @@ class NET_EXPORT AsyncHostResolver
   // there are pending requests.
   void ProcessPending();
 
-  // Maximum number of concurrent DNS requests.
+  // Maximum number of concurrent jobs. A job which looks up both A and AAAA
+  // records counts once.
   size_t max_dns_requests_;
 
-  // List of current DNS requests.
-  DnsRequestList dns_requests_;
-
-  // A map from Key to a list of requests waiting for the Key to resolve.
-  KeyRequestListMap requestlist_map_;
+  // The jobs in progress, which the requests waiting for their Key are
+  // attached to.
+  JobMap jobs_;
 
   // Maximum number of pending requests.
   size_t max_pending_requests_;
@@ -126,6 +127,9 @@ class NET_EXPORT AsyncHostResolver
   // Cache of host resolution results.
   scoped_ptr<HostCache> cache_;
 
+  // The address family used by requests which don't specify one.
+  AddressFamily default_address_family_;
+
   DnsClient* client_;
 
   NetLog* net_log_;
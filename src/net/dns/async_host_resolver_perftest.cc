@@ -0,0 +1,255 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/dns/async_host_resolver.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/rand_util.h"
+#include "base/stringprintf.h"
+#include "net/base/address_list.h"
+#include "net/base/host_cache.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/dns/dns_client.h"
+#include "net/dns/dns_protocol.h"
+#include "net/dns/dns_session.h"
+#include "net/socket/client_socket_factory.h"
+#include "net/udp/udp_server_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumHostnames = 2000;
+const size_t kMaxConcurrentResolves = 20;
+
+// DnsSession owns its factory, so this one forwards to the default factory,
+// which must not be deleted.
+class ForwardingClientSocketFactory : public ClientSocketFactory {
+ public:
+  ForwardingClientSocketFactory()
+      : factory_(ClientSocketFactory::GetDefaultFactory()) {}
+
+  virtual DatagramClientSocket* CreateDatagramClientSocket(
+      DatagramSocket::BindType bind_type,
+      const RandIntCallback& rand_int_cb,
+      NetLog* net_log,
+      const NetLog::Source& source) OVERRIDE {
+    return factory_->CreateDatagramClientSocket(bind_type, rand_int_cb,
+                                                net_log, source);
+  }
+
+  virtual StreamSocket* CreateTransportClientSocket(
+      const AddressList& addresses,
+      NetLog* net_log,
+      const NetLog::Source& source) OVERRIDE {
+    return factory_->CreateTransportClientSocket(addresses, net_log, source);
+  }
+
+  virtual SSLClientSocket* CreateSSLClientSocket(
+      ClientSocketHandle* transport_socket,
+      const HostPortPair& host_and_port,
+      const SSLConfig& ssl_config,
+      SSLHostInfo* ssl_host_info,
+      const SSLClientSocketContext& context) OVERRIDE {
+    return factory_->CreateSSLClientSocket(transport_socket, host_and_port,
+                                           ssl_config, ssl_host_info, context);
+  }
+
+  virtual void ClearSSLSessionCache() OVERRIDE {
+    factory_->ClearSSLSessionCache();
+  }
+
+ private:
+  ClientSocketFactory* factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ForwardingClientSocketFactory);
+};
+
+// A DNS server on the loopback interface, which answers every A query with
+// 127.0.0.1 and every AAAA query with ::1.
+class FakeDnsServer {
+ public:
+  FakeDnsServer()
+      : socket_(NULL, NetLog::Source()),
+        buffer_(new IOBufferWithSize(dns_protocol::kMaxUDPSize)) {
+  }
+
+  // Starts listening on an ephemeral port, and answering queries.
+  bool Start() {
+    IPAddressNumber loopback;
+    if (!ParseIPLiteralToNumber("127.0.0.1", &loopback))
+      return false;
+    if (socket_.Listen(IPEndPoint(loopback, 0)) != OK)
+      return false;
+    if (socket_.GetLocalAddress(&address_) != OK)
+      return false;
+    DoRecvFrom();
+    return true;
+  }
+
+  const IPEndPoint& address() const { return address_; }
+
+ private:
+  void DoRecvFrom() {
+    while (true) {
+      int rv = socket_.RecvFrom(
+          buffer_, buffer_->size(), &client_address_,
+          base::Bind(&FakeDnsServer::OnRecvFromComplete,
+                     base::Unretained(this)));
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (!SendResponse(rv))
+        return;
+    }
+  }
+
+  void OnRecvFromComplete(int rv) {
+    if (SendResponse(rv))
+      DoRecvFrom();
+  }
+
+  void OnSendToComplete(int rv) {
+    DoRecvFrom();
+  }
+
+  // Answers the query of |size| bytes in |buffer_|. Returns false if the
+  // answer is being sent asynchronously, in which case OnSendToComplete()
+  // resumes reading.
+  bool SendResponse(int size) {
+    if (size <= static_cast<int>(sizeof(dns_protocol::Header)))
+      return true;
+
+    // The query ends with its only question, whose type precedes its class.
+    const uint8* query = reinterpret_cast<const uint8*>(buffer_->data());
+    uint16 qtype = (query[size - 4] << 8) | query[size - 3];
+    std::string response(buffer_->data(), size);
+    response[2] = static_cast<char>(0x81);  // Response, recursion desired.
+    response[3] = static_cast<char>(0x80);  // Recursion available.
+    response[7] = 1;  // One answer.
+
+    // The answer points at the name of the question.
+    static const char kAnswerHeader[] = {
+      static_cast<char>(0xc0), 0x0c,
+    };
+    response.append(kAnswerHeader, arraysize(kAnswerHeader));
+    response.push_back(qtype >> 8);
+    response.push_back(qtype & 0xff);
+    static const char kClassAndTtl[] = { 0x00, 0x01, 0x00, 0x00, 0x0e, 0x10 };
+    response.append(kClassAndTtl, arraysize(kClassAndTtl));
+    if (qtype == dns_protocol::kTypeAAAA) {
+      static const char kIPv6Loopback[] = {
+        0x00, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+      };
+      response.append(kIPv6Loopback, arraysize(kIPv6Loopback));
+    } else {
+      static const char kIPv4Loopback[] = { 0x00, 0x04, 127, 0, 0, 1 };
+      response.append(kIPv4Loopback, arraysize(kIPv4Loopback));
+    }
+
+    scoped_refptr<StringIOBuffer> response_buffer(
+        new StringIOBuffer(response));
+    int rv = socket_.SendTo(
+        response_buffer, response_buffer->size(), client_address_,
+        base::Bind(&FakeDnsServer::OnSendToComplete, base::Unretained(this)));
+    return rv != ERR_IO_PENDING;
+  }
+
+  UDPServerSocket socket_;
+  IPEndPoint address_;
+  scoped_refptr<IOBufferWithSize> buffer_;
+  IPEndPoint client_address_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeDnsServer);
+};
+
+class AsyncHostResolverTest : public testing::Test {
+ public:
+  AsyncHostResolverTest()
+      : message_loop_(MessageLoop::TYPE_IO),
+        num_pending_(0) {
+  }
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(server_.Start());
+    DnsConfig config;
+    config.nameservers.push_back(server_.address());
+    DnsSession* session = new DnsSession(config,
+                                         new ForwardingClientSocketFactory(),
+                                         base::Bind(&base::RandInt),
+                                         NULL);
+    client_.reset(DnsClient::CreateClient(session));
+    // Caching is disabled, so that every lookup goes to the server.
+    resolver_.reset(new AsyncHostResolver(
+        kMaxConcurrentResolves,
+        kNumHostnames,
+        new HostCache(0, base::TimeDelta(), base::TimeDelta()),
+        client_.get(),
+        NULL));
+  }
+
+ protected:
+  // Resolves kNumHostnames distinct hostnames of |address_family|.
+  void ResolveHostnames(AddressFamily address_family,
+                        const std::string& name) {
+    ScopedVector<AddressList> addresses;
+    num_pending_ = 0;
+
+    PerfTimeLogger timer(name.c_str());
+    for (int i = 0; i < kNumHostnames; ++i) {
+      HostResolver::RequestInfo info(HostPortPair(
+          base::StringPrintf("host%d.example.com", i), 80));
+      info.set_address_family(address_family);
+      AddressList* addrlist = new AddressList();
+      addresses.push_back(addrlist);
+      int rv = resolver_->Resolve(
+          info, addrlist,
+          base::Bind(&AsyncHostResolverTest::OnResolveComplete,
+                     base::Unretained(this)),
+          NULL, BoundNetLog());
+      ASSERT_EQ(ERR_IO_PENDING, rv);
+      ++num_pending_;
+    }
+    MessageLoop::current()->Run();
+    timer.Done();
+    EXPECT_EQ(0, num_pending_);
+  }
+
+ private:
+  void OnResolveComplete(int rv) {
+    EXPECT_EQ(OK, rv);
+    if (--num_pending_ == 0)
+      MessageLoop::current()->Quit();
+  }
+
+  MessageLoop message_loop_;
+  FakeDnsServer server_;
+  scoped_ptr<DnsClient> client_;
+  scoped_ptr<HostResolver> resolver_;
+  int num_pending_;
+};
+
+}  // namespace
+
+// The rate of the resolutions is kNumHostnames divided by the time logged.
+TEST_F(AsyncHostResolverTest, TestResolveIPv4) {
+  ResolveHostnames(ADDRESS_FAMILY_IPV4, "Async_host_resolver_resolve_ipv4");
+}
+
+// Each resolution makes an A and an AAAA query at once.
+TEST_F(AsyncHostResolverTest, TestResolveBothFamilies) {
+  ResolveHostnames(ADDRESS_FAMILY_UNSPECIFIED,
+                   "Async_host_resolver_resolve_both_families");
+}
+
+}  // namespace net
@@ -27,6 +27,19 @@ const int kPortNum = 80;
 const size_t kMaxTransactions = 2;
 const size_t kMaxPendingRequests = 1;
 
+// Response to the AAAA query for www.google.com, which contains the address
+// 2001:db8::1.
+const uint8 kT0AAAAResponseDatagram[] = {
+  0x00, 0x00, 0x81, 0x80, 0x00, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x03, 0x77, 0x77, 0x77,
+  0x06, 0x67, 0x6f, 0x6f, 0x67, 0x6c, 0x65, 0x03,
+  0x63, 0x6f, 0x6d, 0x00, 0x00, 0x1c, 0x00, 0x01,
+  0xc0, 0x0c, 0x00, 0x1c, 0x00, 0x01, 0x00, 0x00,
+  0x0e, 0x10, 0x00, 0x10, 0x20, 0x01, 0x0d, 0xb8,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01
+};
+
 void VerifyAddressList(const std::vector<const char*>& ip_addresses,
                        int port,
                        const AddressList& addrlist) {
@@ -206,6 +219,16 @@ TEST_F(AsyncHostResolverTest, IPv6LiteralLookup) {
   EXPECT_EQ(ERR_NAME_NOT_RESOLVED, rv);
 }
 
+TEST_F(AsyncHostResolverTest, IPv6LiteralLookupWithUnspecifiedFamily) {
+  info0_.set_host_port_pair(HostPortPair("2001:db8:0::42", kPortNum));
+  info0_.set_address_family(ADDRESS_FAMILY_UNSPECIFIED);
+  int rv = resolver_->Resolve(info0_, &addrlist0_, callback0_.callback(), NULL,
+                              BoundNetLog());
+  EXPECT_EQ(OK, rv);
+  ASSERT_NE(static_cast<addrinfo*>(NULL), addrlist0_.head());
+  EXPECT_EQ("2001:db8::42", NetAddressToString(addrlist0_.head()));
+}
+
 TEST_F(AsyncHostResolverTest, CachedLookup) {
   int rv = resolver_->ResolveFromCache(info0_, &addrlist0_, BoundNetLog());
   EXPECT_EQ(ERR_DNS_CACHE_MISS, rv);
@@ -302,6 +325,54 @@ TEST_F(AsyncHostResolverTest, SameHostLookupsConsumeSingleTransaction) {
   EXPECT_EQ(1, client_->num_requests);
 }
 
+// Test that a lookup for both address families makes the A and AAAA queries
+// at once, and returns the IPv4 addresses first.
+TEST_F(AsyncHostResolverTest, ParallelLookupOfBothFamilies) {
+  AddResponse(std::string(kT0DnsName, arraysize(kT0DnsName)),
+      dns_protocol::kTypeAAAA,
+      new DnsResponse(reinterpret_cast<const char*>(kT0AAAAResponseDatagram),
+                      arraysize(kT0AAAAResponseDatagram),
+                      arraysize(kT0QueryDatagram)));
+  info0_.set_address_family(ADDRESS_FAMILY_UNSPECIFIED);
+
+  int rv0 = resolver_->Resolve(info0_, &addrlist0_, callback0_.callback(), NULL,
+                               BoundNetLog());
+  int rv1 = resolver_->Resolve(info0_, &addrlist1_, callback1_.callback(), NULL,
+                               BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv0);
+  EXPECT_EQ(ERR_IO_PENDING, rv1);
+  EXPECT_EQ(2, client_->num_requests);
+
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+  EXPECT_EQ(OK, callback1_.WaitForResult());
+
+  const struct addrinfo* ainfo = addrlist0_.head();
+  for (size_t i = 0; i < ip_addresses0_.size(); ++i) {
+    ASSERT_NE(static_cast<addrinfo*>(NULL), ainfo);
+    EXPECT_EQ(ip_addresses0_[i], NetAddressToString(ainfo));
+    ainfo = ainfo->ai_next;
+  }
+  ASSERT_NE(static_cast<addrinfo*>(NULL), ainfo);
+  EXPECT_EQ("2001:db8::1", NetAddressToString(ainfo));
+  EXPECT_EQ(static_cast<addrinfo*>(NULL), ainfo->ai_next);
+}
+
+// Test that requests which don't specify an address family use the default
+// one.
+TEST_F(AsyncHostResolverTest, DefaultAddressFamily) {
+  EXPECT_EQ(ADDRESS_FAMILY_UNSPECIFIED, resolver_->GetDefaultAddressFamily());
+  resolver_->SetDefaultAddressFamily(ADDRESS_FAMILY_IPV4);
+  EXPECT_EQ(ADDRESS_FAMILY_IPV4, resolver_->GetDefaultAddressFamily());
+
+  info0_.set_address_family(ADDRESS_FAMILY_UNSPECIFIED);
+  int rv = resolver_->Resolve(info0_, &addrlist0_, callback0_.callback(), NULL,
+                              BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+  VerifyAddressList(ip_addresses0_, kPortNum, addrlist0_);
+  EXPECT_EQ(1, client_->num_requests);
+}
+
 TEST_F(AsyncHostResolverTest, CancelLookup) {
   HostResolver::RequestHandle req0 = NULL, req2 = NULL;
   int rv0 = resolver_->Resolve(info0_, &addrlist0_, callback0_.callback(),
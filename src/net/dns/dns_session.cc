@@ -6,13 +6,22 @@
 
 #include "base/basictypes.h"
 #include "base/bind.h"
+#include "base/stl_util.h"
 #include "base/time.h"
 #include "net/base/ip_endpoint.h"
 #include "net/dns/dns_config_service.h"
 #include "net/socket/client_socket_factory.h"
+#include "net/udp/datagram_client_socket.h"
 
 namespace net {
 
+namespace {
+
+// The maximum number of idle sockets kept by a session.
+const size_t kMaxIdleSockets = 16;
+
+}  // namespace
+
 DnsSession::DnsSession(const DnsConfig& config,
                        ClientSocketFactory* factory,
                        const RandIntCallback& rand_int_callback,
@@ -41,7 +50,28 @@ base::TimeDelta DnsSession::NextTimeout(int attempt) {
   return config_.timeout * (attempt + 1);
 }
 
-DnsSession::~DnsSession() {}
+DatagramClientSocket* DnsSession::TakeIdleSocket(const IPEndPoint& server) {
+  IdleSocketMap::iterator it = idle_sockets_.find(server);
+  if (it == idle_sockets_.end())
+    return NULL;
+  DatagramClientSocket* socket = it->second;
+  idle_sockets_.erase(it);
+  return socket;
+}
+
+void DnsSession::ReleaseSocket(const IPEndPoint& server,
+                               DatagramClientSocket* socket) {
+  DCHECK(socket);
+  if (idle_sockets_.size() >= kMaxIdleSockets) {
+    delete socket;
+    return;
+  }
+  idle_sockets_.insert(std::make_pair(server, socket));
+}
+
+DnsSession::~DnsSession() {
+  STLDeleteValues(&idle_sockets_);
+}
 
 }  // namespace net
 
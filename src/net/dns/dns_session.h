@@ -6,9 +6,12 @@
 #define NET_DNS_DNS_SESSION_H_
 #pragma once
 
+#include <map>
+
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/time.h"
+#include "net/base/ip_endpoint.h"
 #include "net/base/net_export.h"
 #include "net/base/rand_callback.h"
 #include "net/dns/dns_config_service.h"
@@ -16,6 +19,7 @@
 namespace net {
 
 class ClientSocketFactory;
+class DatagramClientSocket;
 class NetLog;
 
 // Session parameters and state shared between DNS transactions.
@@ -44,10 +48,21 @@ class NET_EXPORT_PRIVATE DnsSession
   // Return the timeout for the next transaction.
   base::TimeDelta NextTimeout(int attempt);
 
+  // Returns an idle socket which is connected to |server|, or NULL if there is
+  // none. The caller takes ownership of the socket.
+  DatagramClientSocket* TakeIdleSocket(const IPEndPoint& server);
+
+  // Keeps |socket|, which is connected to |server|, for reuse by a later
+  // transaction. |socket| must not have any read or write in progress, nor any
+  // query whose response could still arrive. Takes ownership of |socket|.
+  void ReleaseSocket(const IPEndPoint& server, DatagramClientSocket* socket);
+
  private:
   friend class base::RefCounted<DnsSession>;
   ~DnsSession();
 
+  typedef std::multimap<IPEndPoint, DatagramClientSocket*> IdleSocketMap;
+
   const DnsConfig config_;
   scoped_ptr<ClientSocketFactory> socket_factory_;
   RandCallback rand_callback_;
@@ -56,10 +71,14 @@ class NET_EXPORT_PRIVATE DnsSession
   // Current index into |config_.nameservers|.
   int server_index_;
 
+  // Sockets which are done with their transactions, by server. Each one is
+  // given to a single transaction at a time, so that concurrent queries keep
+  // using different source ports.
+  IdleSocketMap idle_sockets_;
+
   // TODO(szym): add current RTT estimate
   // TODO(szym): add flag to indicate DNSSEC is supported
   // TODO(szym): add TCP connection pool to support DNS over TCP
-  // TODO(szym): add UDP socket pool ?
 
   DISALLOW_COPY_AND_ASSIGN(DnsSession);
 };
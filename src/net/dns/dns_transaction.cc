@@ -174,15 +174,21 @@ int DnsTransaction::DoConnect() {
   StartTimer(session_->NextTimeout(attempts_));
   ++attempts_;
 
+  // A socket left by a completed transaction is already connected. Sockets
+  // which timed out are never reused, since the late response could still
+  // arrive on them.
   // TODO(szym): keep all sockets around in case the server responds
   // after its timeout; state machine will need to change to handle that.
-  // The current plan is to move socket management out to DnsSession.
   // Hence also move retransmissions to DnsClient::Request.
-  socket_.reset(session_->socket_factory()->CreateDatagramClientSocket(
-      DatagramSocket::RANDOM_BIND,
-      base::Bind(&base::RandInt),
-      net_log_.net_log(),
-      net_log_.source()));
+  socket_.reset(session_->TakeIdleSocket(dns_server_));
+  bool reused = socket_.get() != NULL;
+  if (!reused) {
+    socket_.reset(session_->socket_factory()->CreateDatagramClientSocket(
+        DatagramSocket::RANDOM_BIND,
+        base::Bind(&base::RandInt),
+        net_log_.net_log(),
+        net_log_.source()));
+  }
 
   net_log_.AddEvent(
       NetLog::TYPE_DNS_TRANSACTION_ATTEMPT_STARTED,
@@ -190,6 +196,8 @@ int DnsTransaction::DoConnect() {
           new DnsTransactionRetryParameters(attempts_,
                                             socket_->NetLog().source())));
 
+  if (reused)
+    return OK;
   return socket_->Connect(dns_server_);
 }
 
@@ -238,6 +246,10 @@ int DnsTransaction::DoReadResponseComplete(int rv) {
   DCHECK(rv);
   if (!response_->InitParse(rv, *query_))
     return ERR_DNS_MALFORMED_RESPONSE;
+
+  // The server has answered the query, so the socket can serve another one.
+  session_->ReleaseSocket(dns_server_, socket_.release());
+
   // TODO(szym): define this flag value in dns_protocol
   if (response_->flags1() & 2)
     return ERR_DNS_SERVER_REQUIRES_TCP;
@@ -137,6 +137,39 @@ TEST_F(DnsTransactionTest, MismatchedQueryResponseTest) {
   EXPECT_TRUE(data.at_write_eof());
 }
 
+// Test that a transaction reuses the socket of a completed one.
+TEST_F(DnsTransactionTest, ReuseSocketTest) {
+  MockWrite writes0[] = {
+    MockWrite(true, reinterpret_cast<const char*>(kT0QueryDatagram),
+              arraysize(kT0QueryDatagram)),
+    MockWrite(true, reinterpret_cast<const char*>(kT0QueryDatagram),
+              arraysize(kT0QueryDatagram))
+  };
+
+  MockRead reads0[] = {
+    MockRead(true, reinterpret_cast<const char*>(kT0ResponseDatagram),
+             arraysize(kT0ResponseDatagram)),
+    MockRead(true, reinterpret_cast<const char*>(kT0ResponseDatagram),
+             arraysize(kT0ResponseDatagram))
+  };
+
+  StaticSocketDataProvider data(reads0, arraysize(reads0),
+                                writes0, arraysize(writes0));
+  factory().AddSocketDataProvider(&data);
+
+  StartTransaction();
+  MessageLoop::current()->Run();
+  EXPECT_EQ(OK, rv());
+
+  StartTransaction();
+  MessageLoop::current()->Run();
+  EXPECT_EQ(OK, rv());
+
+  EXPECT_TRUE(data.at_read_eof());
+  EXPECT_TRUE(data.at_write_eof());
+  EXPECT_EQ(1u, factory().udp_client_sockets().size());
+}
+
 // Test that after the first timeout we do a fresh connection and if we get
 // a response on the new connection, we return it.
 TEST_F(DnsTransactionTest, FirstTimeoutTest) {
@@ -104,7 +104,9 @@ HttpCache::ActiveEntry::ActiveEntry(disk_cache::Entry* entry)
     : disk_entry(entry),
       writer(NULL),
       will_process_pending_queue(false),
-      doomed(false) {
+      doomed(false),
+      streaming(false),
+      body_incomplete(false) {
 }
 
 HttpCache::ActiveEntry::~ActiveEntry() {
@@ -363,6 +365,7 @@ HttpCache::~HttpCache() {
     entry->will_process_pending_queue = false;
     entry->pending_queue.clear();
     entry->readers.clear();
+    entry->waiting_readers.clear();
     entry->writer = NULL;
     DeactivateEntry(entry);
   }
@@ -600,7 +603,8 @@ int HttpCache::DoomEntry(const std::string& key, Transaction* trans) {
   entry->disk_entry->Doom();
   entry->doomed = true;
 
-  DCHECK(entry->writer || !entry->readers.empty());
+  DCHECK(entry->writer || !entry->readers.empty() ||
+         entry->will_process_pending_queue);
   return OK;
 }
 
@@ -794,17 +798,22 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
   // We implement a basic reader/writer lock for the disk cache entry.  If
   // there is already a writer, then everyone has to wait for the writer to
   // finish before they can access the cache entry.  There can be multiple
-  // readers.
+  // readers. Once the writer is streaming the body of a response, readers
+  // that can use that response are let in to read the body as it arrives.
   //
   // NOTE: If the transaction can only write, then the entry should not be in
   // use (since any existing entry should have already been doomed).
 
-  if (entry->writer || entry->will_process_pending_queue) {
+  if (entry->will_process_pending_queue ||
+      (entry->writer && !CanTailWriter(entry, trans))) {
     entry->pending_queue.push_back(trans);
     return ERR_IO_PENDING;
   }
 
-  if (trans->mode() & Transaction::WRITE) {
+  if (entry->writer) {
+    // transaction reads the response while the writer stores it
+    entry->readers.push_back(trans);
+  } else if (trans->mode() & Transaction::WRITE) {
     // transaction needs exclusive access to the entry
     if (entry->readers.empty()) {
       entry->writer = trans;
@@ -820,7 +829,7 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
   // We do this before calling EntryAvailable to force any further calls to
   // AddTransactionToEntry to add their transaction to the pending queue, which
   // ensures FIFO ordering.
-  if (!entry->writer && !entry->pending_queue.empty())
+  if ((!entry->writer || entry->streaming) && !entry->pending_queue.empty())
     ProcessPendingQueue(entry);
 
   return OK;
@@ -830,11 +839,13 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
                               bool cancel) {
   // If we already posted a task to move on to the next transaction and this was
   // the writer, there is nothing to cancel.
-  if (entry->will_process_pending_queue && entry->readers.empty())
+  if (entry->will_process_pending_queue && !entry->writer &&
+      entry->readers.empty())
     return;
 
-  if (entry->writer) {
-    DCHECK(trans == entry->writer);
+  if (trans == entry->writer) {
+    // Readers tailing the writer will not get the rest of the body.
+    entry->body_incomplete = true;
 
     // Assume there was a failure.
     bool success = false;
@@ -851,21 +862,33 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
 }
 
 void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
-  DCHECK(entry->readers.empty());
+  DCHECK(entry->streaming || entry->readers.empty());
 
   entry->writer = NULL;
+  entry->streaming = false;
+  if (!success)
+    entry->body_incomplete = true;
+  ProcessWaitingReaders(entry);
 
   if (success) {
     ProcessPendingQueue(entry);
   } else {
-    DCHECK(!entry->will_process_pending_queue);
-
     // We failed to create this entry.
     TransactionList pending_queue;
     pending_queue.swap(entry->pending_queue);
 
-    entry->disk_entry->Doom();
-    DestroyEntry(entry);
+    if (entry->readers.empty() && !entry->will_process_pending_queue) {
+      entry->disk_entry->Doom();
+      DestroyEntry(entry);
+    } else if (!entry->doomed) {
+      // The entry is still in use by readers that were tailing the writer (or
+      // by a pending task), so keep it around but make sure that nobody else
+      // finds it.
+      int rv = DoomEntry(entry->disk_entry->GetKey(), NULL);
+      DCHECK_EQ(OK, rv);
+    } else {
+      entry->disk_entry->Doom();
+    }
 
     // We need to do something about these pending entries, which now need to
     // be added to a new entry.
@@ -878,13 +901,18 @@ void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
 }
 
 void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
-  DCHECK(!entry->writer);
+  DCHECK(!entry->writer || entry->streaming);
 
   TransactionList::iterator it =
       std::find(entry->readers.begin(), entry->readers.end(), trans);
   DCHECK(it != entry->readers.end());
 
   entry->readers.erase(it);
+  entry->waiting_readers.remove(trans);
+
+  // The writer keeps the entry alive, and will process the pending queue.
+  if (entry->writer)
+    return;
 
   ProcessPendingQueue(entry);
 }
@@ -902,6 +930,45 @@ void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
   ProcessPendingQueue(entry);
 }
 
+void HttpCache::BeginStreamingToEntry(ActiveEntry* entry) {
+  DCHECK(entry->writer);
+  DCHECK(entry->readers.empty());
+
+  entry->streaming = true;
+  entry->body_incomplete = false;
+
+  if (!entry->pending_queue.empty())
+    ProcessPendingQueue(entry);
+}
+
+int HttpCache::WaitForEntryData(ActiveEntry* entry, Transaction* trans) {
+  if (entry->streaming) {
+    DCHECK(entry->writer);
+    entry->waiting_readers.push_back(trans);
+    return ERR_IO_PENDING;
+  }
+  return entry->body_incomplete ? ERR_CACHE_READ_FAILURE : OK;
+}
+
+void HttpCache::ProcessWaitingReaders(ActiveEntry* entry) {
+  TransactionList waiting_readers;
+  waiting_readers.swap(entry->waiting_readers);
+
+  // The readers resume asynchronously, so they cannot modify the entry here.
+  for (TransactionList::iterator it = waiting_readers.begin();
+       it != waiting_readers.end(); ++it) {
+    (*it)->OnEntryDataAvailable();
+  }
+}
+
+bool HttpCache::CanTailWriter(ActiveEntry* entry, Transaction* trans) {
+  if (!entry->streaming)
+    return false;
+
+  const HttpResponseInfo* response = entry->writer->GetResponseInfo();
+  return response && trans->CanTailResponse(*response);
+}
+
 LoadState HttpCache::GetLoadStateForPendingTransaction(
       const Transaction* trans) {
   ActiveEntriesMap::const_iterator i = active_entries_.find(trans->key());
@@ -997,19 +1064,23 @@ void HttpCache::ProcessPendingQueue(ActiveEntry* entry) {
 
 void HttpCache::OnProcessPendingQueue(ActiveEntry* entry) {
   entry->will_process_pending_queue = false;
-  DCHECK(!entry->writer);
+  DCHECK(!entry->writer || entry->streaming);
 
   // If no one is interested in this entry, then we can deactivate it.
   if (entry->pending_queue.empty()) {
-    if (entry->readers.empty())
+    if (!entry->writer && entry->readers.empty())
       DestroyEntry(entry);
     return;
   }
 
   // Promote next transaction from the pending queue.
   Transaction* next = entry->pending_queue.front();
-  if ((next->mode() & Transaction::WRITE) && !entry->readers.empty())
+  if (entry->writer) {
+    if (!CanTailWriter(entry, next))
+      return;  // Have to wait for the writer.
+  } else if ((next->mode() & Transaction::WRITE) && !entry->readers.empty()) {
     return;  // Have to wait.
+  }
 
   entry->pending_queue.erase(entry->pending_queue.begin());
 
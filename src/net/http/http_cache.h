@@ -228,8 +228,15 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     Transaction*       writer;
     TransactionList    readers;
     TransactionList    pending_queue;
+    // While the writer is streaming the body of the response, |readers| may
+    // be reading it as it arrives. Readers which caught up with the writer
+    // wait for more data in |waiting_readers|.
+    TransactionList    waiting_readers;
     bool               will_process_pending_queue;
     bool               doomed;
+    bool               streaming;
+    // True if the last writer went away before storing the whole body.
+    bool               body_incomplete;
   };
 
   typedef base::hash_map<std::string, ActiveEntry*> ActiveEntriesMap;
@@ -325,6 +332,27 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // transactions can start reading from this entry.
   void ConvertWriterToReader(ActiveEntry* entry);
 
+  // Called when the writer of |entry| has stored the headers and the first
+  // part of the body of a response. From now on, transactions that can use
+  // the response without validating it are added to the entry as readers,
+  // and read the rest of the body while it is being written.
+  void BeginStreamingToEntry(ActiveEntry* entry);
+
+  // Called by a reader of |entry| that has read all the data stored so far.
+  // Returns ERR_IO_PENDING if the writer is still streaming the body, in which
+  // case |trans| is notified via OnEntryDataAvailable() when there is more
+  // data. Otherwise returns OK if the body is complete, or
+  // ERR_CACHE_READ_FAILURE if the writer went away before storing all of it,
+  // in which case |trans| has to get the rest of the body from the network.
+  int WaitForEntryData(ActiveEntry* entry, Transaction* trans);
+
+  // Resumes the readers of |entry| that are waiting for more data.
+  void ProcessWaitingReaders(ActiveEntry* entry);
+
+  // Returns true if |trans| can be added as a reader of |entry| while the
+  // writer is still streaming the response.
+  bool CanTailWriter(ActiveEntry* entry, Transaction* trans);
+
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* trans);
 
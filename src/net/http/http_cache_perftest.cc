@@ -0,0 +1,142 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/http/http_transaction.h"
+#include "net/http/http_transaction_unittest.h"
+#include "net/http/mock_http_cache.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumTransactions = 20;
+const int kBodySize = 512 * 1024;
+const int kReadSize = 4096;
+
+// Reads a whole response, and records when its first byte arrived.
+class TimedConsumer {
+ public:
+  TimedConsumer(net::HttpCache* cache, int* num_pending)
+      : num_pending_(num_pending),
+        read_buf_(new net::IOBuffer(kReadSize)),
+        ALLOW_THIS_IN_INITIALIZER_LIST(start_callback_(
+            base::Bind(&TimedConsumer::OnStartComplete,
+                       base::Unretained(this)))),
+        ALLOW_THIS_IN_INITIALIZER_LIST(read_callback_(
+            base::Bind(&TimedConsumer::OnReadComplete,
+                       base::Unretained(this)))) {
+    EXPECT_EQ(net::OK, cache->CreateTransaction(&trans_));
+  }
+
+  void Start(const net::HttpRequestInfo* request) {
+    start_time_ = base::TimeTicks::Now();
+    int rv = trans_->Start(request, start_callback_, net::BoundNetLog());
+    if (rv != net::ERR_IO_PENDING)
+      OnStartComplete(rv);
+  }
+
+  base::TimeDelta time_to_first_byte() const {
+    return first_byte_time_ - start_time_;
+  }
+
+ private:
+  void OnStartComplete(int result) {
+    EXPECT_EQ(net::OK, result);
+    if (result != net::OK) {
+      Done();
+      return;
+    }
+    Read();
+  }
+
+  void Read() {
+    int rv = trans_->Read(read_buf_, kReadSize, read_callback_);
+    if (rv != net::ERR_IO_PENDING)
+      OnReadComplete(rv);
+  }
+
+  void OnReadComplete(int result) {
+    EXPECT_GE(result, 0);
+    if (result > 0 && first_byte_time_.is_null())
+      first_byte_time_ = base::TimeTicks::Now();
+    if (result <= 0) {
+      Done();
+      return;
+    }
+    // Keep the stack shallow when reads complete synchronously.
+    MessageLoop::current()->PostTask(
+        FROM_HERE, base::Bind(&TimedConsumer::Read, base::Unretained(this)));
+  }
+
+  void Done() {
+    trans_.reset();
+    if (--*num_pending_ == 0)
+      MessageLoop::current()->Quit();
+  }
+
+  int* num_pending_;
+  scoped_ptr<net::HttpTransaction> trans_;
+  scoped_refptr<net::IOBuffer> read_buf_;
+  net::CompletionCallback start_callback_;
+  net::CompletionCallback read_callback_;
+  base::TimeTicks start_time_;
+  base::TimeTicks first_byte_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimedConsumer);
+};
+
+}  // namespace
+
+// Measures the time to first byte of |kNumTransactions| concurrent requests
+// for the same URL, which all have to go through the same cache entry.
+TEST(HttpCachePerfTest, ConcurrentRequestsTimeToFirstByte) {
+  MessageLoop message_loop;
+  MockHttpCache cache;
+
+  std::string body(kBodySize, 'x');
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.data = body.c_str();
+  MockHttpRequest request(transaction);
+
+  int num_pending = kNumTransactions;
+  ScopedVector<TimedConsumer> consumers;
+  for (int i = 0; i < kNumTransactions; ++i)
+    consumers.push_back(new TimedConsumer(cache.http_cache(), &num_pending));
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumTransactions; ++i)
+    consumers[i]->Start(&request);
+  MessageLoop::current()->Run();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  base::TimeDelta total_ttfb;
+  base::TimeDelta max_ttfb;
+  for (int i = 0; i < kNumTransactions; ++i) {
+    base::TimeDelta ttfb = consumers[i]->time_to_first_byte();
+    total_ttfb += ttfb;
+    if (ttfb > max_ttfb)
+      max_ttfb = ttfb;
+  }
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+
+  LogPerfResult("HttpCache_concurrent_mean_ttfb",
+                total_ttfb.InMillisecondsF() / kNumTransactions, "ms");
+  LogPerfResult("HttpCache_concurrent_max_ttfb",
+                max_ttfb.InMillisecondsF(), "ms");
+  LogPerfResult("HttpCache_concurrent_total", elapsed.InMillisecondsF(), "ms");
+}
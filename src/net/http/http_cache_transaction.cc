@@ -10,14 +10,17 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <string>
 
 #include "base/bind.h"
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
 #include "base/metrics/field_trial.h"
 #include "base/metrics/histogram.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/time.h"
 #include "net/base/cert_status_flags.h"
 #include "net/base/completion_callback.h"
@@ -118,7 +121,9 @@ HttpCache::Transaction::Transaction(HttpCache* cache)
       handling_206_(false),
       cache_pending_(false),
       done_reading_(false),
+      tailing_(false),
       read_offset_(0),
+      skip_bytes_(0),
       effective_load_flags_(0),
       write_len_(0),
       final_upload_progress_(0),
@@ -199,6 +204,29 @@ bool HttpCache::Transaction::AddTruncatedFlag() {
   return true;
 }
 
+bool HttpCache::Transaction::CanTailResponse(const HttpResponseInfo& response) {
+  // Byte range requests, and requests that would update the entry, need the
+  // whole entry.
+  if ((mode_ & READ) != READ || partial_.get() || range_requested_)
+    return false;
+
+  if (!response.headers || response.headers->response_code() != 200)
+    return false;
+
+  if (mode_ == READ || (effective_load_flags_ & LOAD_PREFERRING_CACHE))
+    return true;
+
+  return !RequiresValidation(response);
+}
+
+void HttpCache::Transaction::OnEntryDataAvailable() {
+  DCHECK(tailing_);
+  DCHECK_EQ(STATE_CACHE_READ_DATA, next_state_);
+  MessageLoop::current()->PostTask(
+      FROM_HERE,
+      base::Bind(&Transaction::OnIOComplete, weak_factory_.GetWeakPtr(), OK));
+}
+
 LoadState HttpCache::Transaction::GetWriterLoadState() const {
   if (network_trans_.get())
     return network_trans_->GetLoadState();
@@ -365,9 +393,10 @@ void HttpCache::Transaction::StopCaching() {
   // free, that would be an asynchronous operation). In other words, keep the
   // entry how it is (it will be marked as truncated at destruction), and let
   // the next piece of code that executes know that we are now reading directly
-  // from the net.
+  // from the net. Readers tailing this transaction need the rest of the body,
+  // so we keep caching if there are any.
   if (cache_ && entry_ && (mode_ & WRITE) && network_trans_.get() &&
-      !is_sparse_ && !range_requested_)
+      !is_sparse_ && !range_requested_ && entry_->readers.empty())
     mode_ = NONE;
 }
 
@@ -490,6 +519,11 @@ int HttpCache::Transaction::HandleResult(int rv) {
 //   SuccessfulSendRequest -> UpdateCachedResponse* -> OverwriteCachedResponse
 //   -> PartialHeadersReceived -> NetworkRead* -> CacheWriteData*
 //
+// Reading an entry while it is being written, the writer goes away:
+//   Read():
+//   CacheReadData* -> ResumeNetworkRequest* -> SkipNetworkData* ->
+//   NetworkRead*
+//
 int HttpCache::Transaction::DoLoop(int result) {
   DCHECK(next_state_ != STATE_NONE);
 
@@ -636,6 +670,20 @@ int HttpCache::Transaction::DoLoop(int result) {
       case STATE_CACHE_WRITE_DATA_COMPLETE:
         rv = DoCacheWriteDataComplete(rv);
         break;
+      case STATE_RESUME_NETWORK_REQUEST:
+        DCHECK_EQ(OK, rv);
+        rv = DoResumeNetworkRequest();
+        break;
+      case STATE_RESUME_NETWORK_REQUEST_COMPLETE:
+        rv = DoResumeNetworkRequestComplete(rv);
+        break;
+      case STATE_SKIP_NETWORK_DATA:
+        DCHECK_EQ(OK, rv);
+        rv = DoSkipNetworkData();
+        break;
+      case STATE_SKIP_NETWORK_DATA_COMPLETE:
+        rv = DoSkipNetworkDataComplete(rv);
+        break;
       default:
         NOTREACHED() << "bad state";
         rv = ERR_FAILED;
@@ -979,8 +1027,11 @@ int HttpCache::Transaction::DoAddToEntryComplete(int result) {
       partial_->RestoreHeaders(&custom_request_->extra_headers);
     next_state_ = STATE_SEND_REQUEST;
   } else {
-    // We have to read the headers from the cached entry.
+    // We have to read the headers from the cached entry. If another
+    // transaction is writing the entry, we were let in to read its response
+    // while it is being stored.
     DCHECK(mode_ & READ_META);
+    tailing_ = entry_->writer && entry_->writer != this;
     next_state_ = STATE_CACHE_READ_RESPONSE;
   }
   return OK;
@@ -1200,6 +1251,17 @@ int HttpCache::Transaction::DoCacheReadResponseComplete(int result) {
   if (response_.headers->GetContentLength() == current_size)
     truncated_ = false;
 
+  if (tailing_ && truncated_) {
+    // The writer went away before we read the headers, so this is not the
+    // response we were let in for. Start over.
+    cache_->DoneReadingFromEntry(entry_, this);
+    entry_ = NULL;
+    tailing_ = false;
+    truncated_ = false;
+    next_state_ = STATE_INIT_ENTRY;
+    return OK;
+  }
+
   // We now have access to the cache entry.
   //
   //  o if we are a reader for the transaction, then we can start reading the
@@ -1330,6 +1392,23 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   if (result > 0) {
     read_offset_ += result;
   } else if (result == 0) {  // End of file.
+    int64 body_size = response_.headers->GetContentLength();
+    if (tailing_ && (body_size < 0 || read_offset_ < body_size)) {
+      // The writer may not have stored the whole body yet.
+      result = cache_->WaitForEntryData(entry_, this);
+      if (result == ERR_IO_PENDING) {
+        next_state_ = STATE_CACHE_READ_DATA;
+        return result;
+      }
+      if (result != OK) {
+        // The writer went away before storing the whole body, so get the rest
+        // of it from the server instead.
+        if (effective_load_flags_ & LOAD_ONLY_FROM_CACHE)
+          return result;
+        next_state_ = STATE_RESUME_NETWORK_REQUEST;
+        return OK;
+      }
+    }
     cache_->DoneReadingFromEntry(entry_, this);
     entry_ = NULL;
   }
@@ -1368,6 +1447,17 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
       done_reading_ = true;
   }
 
+  if (entry_ && result > 0) {
+    // Once we have stored part of the body of a full response, other
+    // transactions can read it while we store the rest.
+    if (!entry_->streaming && !partial_.get() && !truncated_ &&
+        !auth_response_.headers && request_->method == "GET" &&
+        response_.headers->response_code() == 200) {
+      cache_->BeginStreamingToEntry(entry_);
+    }
+    cache_->ProcessWaitingReaders(entry_);
+  }
+
   if (partial_.get()) {
     // This may be the last request.
     if (!(result == 0 && !truncated_ &&
@@ -1386,6 +1476,103 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
   return result;
 }
 
+int HttpCache::Transaction::DoResumeNetworkRequest() {
+  DCHECK(tailing_);
+  DCHECK(!network_trans_.get());
+
+  // From now on we are just reading from the network.
+  cache_->DoneReadingFromEntry(entry_, this);
+  entry_ = NULL;
+  tailing_ = false;
+  mode_ = NONE;
+
+  // Ask only for the part of the body that we don't have, as long as the
+  // server can tell us if it is still the same resource.
+  std::string etag_value;
+  response_.headers->EnumerateHeader(NULL, "etag", &etag_value);
+  if (StartsWithASCII(etag_value, "w/", false))
+    etag_value.clear();
+
+  std::string last_modified_value;
+  response_.headers->EnumerateHeader(NULL, "last-modified",
+                                     &last_modified_value);
+
+  if (read_offset_ && response_.headers->HasStrongValidators()) {
+    if (!custom_request_.get()) {
+      custom_request_.reset(new HttpRequestInfo(*request_));
+      request_ = custom_request_.get();
+    }
+    custom_request_->extra_headers.SetHeader(
+        HttpRequestHeaders::kRange, base::StringPrintf("bytes=%d-",
+                                                       read_offset_));
+    custom_request_->extra_headers.SetHeader(
+        HttpRequestHeaders::kIfRange,
+        etag_value.empty() ? last_modified_value : etag_value);
+  }
+
+  int rv = cache_->network_layer_->CreateTransaction(&network_trans_);
+  if (rv != OK)
+    return rv;
+
+  next_state_ = STATE_RESUME_NETWORK_REQUEST_COMPLETE;
+  return network_trans_->Start(request_, io_callback_, net_log_);
+}
+
+int HttpCache::Transaction::DoResumeNetworkRequestComplete(int result) {
+  if (!cache_)
+    return ERR_UNEXPECTED;
+
+  if (result != OK)
+    return result;
+
+  // The consumer already has the headers of the cached response, so the new
+  // response must be the rest of the same body.
+  const HttpResponseHeaders* headers =
+      network_trans_->GetResponseInfo()->headers;
+  int64 body_size = response_.headers->GetContentLength();
+  if (headers->response_code() == 206) {
+    int64 first, last, instance_length;
+    if (read_offset_ &&
+        headers->GetContentRange(&first, &last, &instance_length) &&
+        first == read_offset_ &&
+        (body_size < 0 || instance_length < 0 ||
+         instance_length == body_size)) {
+      next_state_ = STATE_NETWORK_READ;
+      return OK;
+    }
+  } else if (headers->response_code() == 200 && IsSameResponse(*headers)) {
+    // The server sent the whole body, so drop what we already read.
+    skip_bytes_ = read_offset_;
+    next_state_ = skip_bytes_ ? STATE_SKIP_NETWORK_DATA : STATE_NETWORK_READ;
+    return OK;
+  }
+
+  DLOG(ERROR) << "unable to resume the response from the network";
+  return ERR_INVALID_RESPONSE;
+}
+
+int HttpCache::Transaction::DoSkipNetworkData() {
+  next_state_ = STATE_SKIP_NETWORK_DATA_COMPLETE;
+  return network_trans_->Read(read_buf_, std::min(io_buf_len_, skip_bytes_),
+                              io_callback_);
+}
+
+int HttpCache::Transaction::DoSkipNetworkDataComplete(int result) {
+  if (!cache_)
+    return ERR_UNEXPECTED;
+
+  if (result < 0)
+    return result;
+
+  // The body is shorter than the part that we already read.
+  if (!result)
+    return ERR_INVALID_RESPONSE;
+
+  skip_bytes_ -= result;
+  next_state_ = skip_bytes_ ? STATE_SKIP_NETWORK_DATA : STATE_NETWORK_READ;
+  return OK;
+}
+
 //-----------------------------------------------------------------------------
 
 void HttpCache::Transaction::SetRequest(const BoundNetLog& net_log,
@@ -1537,8 +1724,11 @@ int HttpCache::Transaction::BeginCacheRead() {
 int HttpCache::Transaction::BeginCacheValidation() {
   DCHECK(mode_ == READ_WRITE);
 
-  bool skip_validation = effective_load_flags_ & LOAD_PREFERRING_CACHE ||
-                         !RequiresValidation();
+  // A transaction tailing the writer was let in because the response does not
+  // need validation.
+  bool skip_validation = tailing_ ||
+                         effective_load_flags_ & LOAD_PREFERRING_CACHE ||
+                         !RequiresValidation(response_);
 
   if (truncated_)
     skip_validation = !partial_->initial_validation();
@@ -1553,7 +1743,8 @@ int HttpCache::Transaction::BeginCacheValidation() {
       next_state_ = STATE_PARTIAL_HEADERS_RECEIVED;
       return OK;
     }
-    cache_->ConvertWriterToReader(entry_);
+    if (!tailing_)
+      cache_->ConvertWriterToReader(entry_);
     mode_ = READ;
 
     if (entry_->disk_entry->GetDataSize(kMetadataIndex))
@@ -1686,7 +1877,8 @@ int HttpCache::Transaction::RestartNetworkRequestWithAuth(
   return rv;
 }
 
-bool HttpCache::Transaction::RequiresValidation() {
+bool HttpCache::Transaction::RequiresValidation(
+    const HttpResponseInfo& response) {
   // TODO(darin): need to do more work here:
   //  - make sure we have a matching request method
   //  - watch out for cached responses that depend on authentication
@@ -1697,13 +1889,13 @@ bool HttpCache::Transaction::RequiresValidation() {
   if (effective_load_flags_ & LOAD_VALIDATE_CACHE)
     return true;
 
-  if (response_.headers->RequiresValidation(
-          response_.request_time, response_.response_time, Time::Now()))
+  if (response.headers->RequiresValidation(
+          response.request_time, response.response_time, Time::Now()))
     return true;
 
   // Since Vary header computation is fairly expensive, we save it for last.
-  if (response_.vary_data.is_valid() &&
-      !response_.vary_data.MatchesRequest(*request_, *response_.headers))
+  if (response.vary_data.is_valid() &&
+      !response.vary_data.MatchesRequest(*request_, *response.headers))
     return true;
 
   return false;
@@ -2052,6 +2244,25 @@ bool HttpCache::Transaction::CanResume(bool has_data) {
   return true;
 }
 
+bool HttpCache::Transaction::IsSameResponse(
+    const HttpResponseHeaders& headers) {
+  int64 body_size = response_.headers->GetContentLength();
+  if (headers.GetContentLength() != body_size)
+    return false;
+
+  // We only read responses that are still being written if they don't need
+  // validation, so unless the server tells us otherwise, the body is the same.
+  const char* kValidators[] = { "etag", "last-modified" };
+  for (size_t i = 0; i < arraysize(kValidators); i++) {
+    std::string old_value, new_value;
+    response_.headers->EnumerateHeader(NULL, kValidators[i], &old_value);
+    headers.EnumerateHeader(NULL, kValidators[i], &new_value);
+    if (old_value != new_value)
+      return false;
+  }
+  return true;
+}
+
 void HttpCache::Transaction::OnIOComplete(int result) {
   DoLoop(result);
 }
@@ -21,6 +21,7 @@
 
 namespace net {
 
+class HttpResponseHeaders;
 class PartialData;
 struct HttpRequestInfo;
 
@@ -96,6 +97,16 @@ class HttpCache::Transaction : public HttpTransaction {
 
   const CompletionCallback& io_callback() { return io_callback_; }
 
+  // Returns true if this transaction can use |response| without validating it,
+  // so that it can read the response while another transaction is still
+  // writing it to the cache.
+  bool CanTailResponse(const HttpResponseInfo& response);
+
+  // Called by the cache when the transaction writing the entry that this
+  // transaction is reading has stored more data, or is done with the entry.
+  // The pending read is resumed asynchronously.
+  void OnEntryDataAvailable();
+
   const BoundNetLog& net_log() const;
 
   // HttpTransaction methods:
@@ -169,7 +180,11 @@ class HttpCache::Transaction : public HttpTransaction {
     STATE_CACHE_READ_DATA,
     STATE_CACHE_READ_DATA_COMPLETE,
     STATE_CACHE_WRITE_DATA,
-    STATE_CACHE_WRITE_DATA_COMPLETE
+    STATE_CACHE_WRITE_DATA_COMPLETE,
+    STATE_RESUME_NETWORK_REQUEST,
+    STATE_RESUME_NETWORK_REQUEST_COMPLETE,
+    STATE_SKIP_NETWORK_DATA,
+    STATE_SKIP_NETWORK_DATA_COMPLETE
   };
 
   // This is a helper function used to trigger a completion callback.  It may
@@ -224,6 +239,10 @@ class HttpCache::Transaction : public HttpTransaction {
   int DoCacheReadDataComplete(int result);
   int DoCacheWriteData(int num_bytes);
   int DoCacheWriteDataComplete(int result);
+  int DoResumeNetworkRequest();
+  int DoResumeNetworkRequestComplete(int result);
+  int DoSkipNetworkData();
+  int DoSkipNetworkDataComplete(int result);
 
   // Sets request_ and fields derived from it.
   void SetRequest(const BoundNetLog& net_log, const HttpRequestInfo* request);
@@ -264,8 +283,8 @@ class HttpCache::Transaction : public HttpTransaction {
   // Returns network error code.
   int RestartNetworkRequestWithAuth(const AuthCredentials& credentials);
 
-  // Called to determine if we need to validate the cache entry before using it.
-  bool RequiresValidation();
+  // Called to determine if we need to validate |response| before using it.
+  bool RequiresValidation(const HttpResponseInfo& response);
 
   // Called to make the request conditional (to ask the server if the cached
   // copy is valid).  Returns true if able to make the request conditional.
@@ -324,6 +343,10 @@ class HttpCache::Transaction : public HttpTransaction {
   // data is considered for the result.
   bool CanResume(bool has_data);
 
+  // Returns true if |headers| describe the same resource as the cached
+  // response, so that the bodies can be mixed.
+  bool IsSameResponse(const HttpResponseHeaders& headers);
+
   // Called to signal completion of asynchronous IO.
   void OnIOComplete(int result);
 
@@ -355,9 +378,11 @@ class HttpCache::Transaction : public HttpTransaction {
   bool handling_206_;  // We must deal with this 206 response.
   bool cache_pending_;  // We are waiting for the HttpCache.
   bool done_reading_;
+  bool tailing_;  // We are reading an entry that is still being written.
   scoped_refptr<IOBuffer> read_buf_;
   int io_buf_len_;
   int read_offset_;
+  int skip_bytes_;  // Network data that we already read from the cache.
   int effective_load_flags_;
   int write_len_;
   scoped_ptr<PartialData> partial_;  // We are dealing with range requests.
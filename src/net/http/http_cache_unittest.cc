@@ -952,11 +952,12 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   c->result = c->callback.WaitForResult();
   ReadAndVerifyTransaction(c->trans.get(), kSimpleGET_Transaction);
 
-  // Now we have 2 active readers and two queued transactions.
+  // The other transactions were added to the entry as readers while the first
+  // one was storing the body, so none of them is queued.
 
   EXPECT_EQ(net::LOAD_STATE_IDLE,
             context_list[2]->trans->GetLoadState());
-  EXPECT_EQ(net::LOAD_STATE_WAITING_FOR_CACHE,
+  EXPECT_EQ(net::LOAD_STATE_IDLE,
             context_list[3]->trans->GetLoadState());
 
   c = context_list[1];
@@ -965,10 +966,8 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   if (c->result == net::OK)
     ReadAndVerifyTransaction(c->trans.get(), kSimpleGET_Transaction);
 
-  // At this point we have one reader, two pending transactions and a task on
-  // the queue to move to the next transaction. Now we cancel the request that
-  // is the current reader, and expect the queued task to be able to start the
-  // next request.
+  // Now we cancel one of the readers, and expect the others to be able to
+  // complete.
 
   c = context_list[2];
   c->trans.reset();
@@ -993,6 +992,295 @@ TEST(HttpCache, SimpleGET_RacingReaders) {
   }
 }
 
+// Tests that transactions for the same URL can read the response while the
+// first transaction is still writing it to the cache, instead of waiting for
+// it to finish.
+TEST(HttpCache, SimpleGET_ReadersTailWriter) {
+  MockHttpCache cache;
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  const std::string expected(kSimpleGET_Transaction.data);
+  const int kChunkSize = 10;
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(expected.size()));
+
+  Context writer;
+  writer.result = cache.http_cache()->CreateTransaction(&writer.trans);
+  EXPECT_EQ(net::OK, writer.result);
+  writer.result = writer.trans->Start(
+      &request, writer.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  // Store the first part of the body.
+  int rv = writer.trans->Read(buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+
+  std::vector<Context*> context_list;
+  const int kNumTransactions = 3;
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    context_list.push_back(new Context());
+    Context* c = context_list[i];
+
+    c->result = cache.http_cache()->CreateTransaction(&c->trans);
+    EXPECT_EQ(net::OK, c->result);
+
+    c->result = c->trans->Start(
+        &request, c->callback.callback(), net::BoundNetLog());
+  }
+
+  // The new transactions get the response without waiting for the writer,
+  // and read what has been stored so far.
+  MessageLoop::current()->RunAllPending();
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    if (c->result == net::ERR_IO_PENDING) {
+      ASSERT_TRUE(c->callback.have_result());
+      c->result = c->callback.WaitForResult();
+    }
+    ASSERT_EQ(net::OK, c->result);
+
+    rv = c->trans->Read(buf, expected.size(), c->callback.callback());
+    rv = c->callback.GetResult(rv);
+    ASSERT_EQ(kChunkSize, rv);
+    EXPECT_EQ(expected.substr(0, kChunkSize), std::string(buf->data(), rv));
+
+    // There is nothing else to read until the writer stores more data.
+    c->result = c->trans->Read(buf, expected.size(), c->callback.callback());
+    EXPECT_EQ(net::ERR_IO_PENDING, c->result);
+  }
+
+  MessageLoop::current()->RunAllPending();
+  for (int i = 0; i < kNumTransactions; ++i)
+    EXPECT_FALSE(context_list[i]->callback.have_result());
+
+  std::string content;
+  EXPECT_EQ(net::OK, ReadTransaction(writer.trans.get(), &content));
+  EXPECT_EQ(expected.substr(kChunkSize), content);
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    rv = c->callback.WaitForResult();
+    ASSERT_GT(rv, 0);
+    content.assign(buf->data(), rv);
+
+    std::string rest;
+    EXPECT_EQ(net::OK, ReadTransaction(c->trans.get(), &rest));
+    EXPECT_EQ(expected.substr(kChunkSize), content + rest);
+  }
+
+  // We should not have had to re-open the disk entry.
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    delete c;
+  }
+}
+
+// Tests that a transaction that is reading the response while it is being
+// written gets the rest of the body from the network if the writer goes away
+// before storing all of it.
+TEST(HttpCache, SimpleGET_TailingReaderLosesWriter) {
+  MockHttpCache cache;
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  const std::string expected(kSimpleGET_Transaction.data);
+  const int kChunkSize = 10;
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(expected.size()));
+
+  Context writer;
+  writer.result = cache.http_cache()->CreateTransaction(&writer.trans);
+  EXPECT_EQ(net::OK, writer.result);
+  writer.result = writer.trans->Start(
+      &request, writer.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  int rv = writer.trans->Read(buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+
+  Context reader;
+  reader.result = cache.http_cache()->CreateTransaction(&reader.trans);
+  EXPECT_EQ(net::OK, reader.result);
+  reader.result = reader.trans->Start(
+      &request, reader.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, reader.callback.GetResult(reader.result));
+
+  rv = reader.trans->Read(buf, expected.size(), reader.callback.callback());
+  EXPECT_EQ(kChunkSize, reader.callback.GetResult(rv));
+  reader.result = reader.trans->Read(buf, expected.size(),
+                                     reader.callback.callback());
+  EXPECT_EQ(net::ERR_IO_PENDING, reader.result);
+
+  writer.trans.reset();
+
+  // Without validators, the server sends the whole body again, and the reader
+  // skips the part that it already has.
+  rv = reader.callback.WaitForResult();
+  ASSERT_GT(rv, 0);
+  std::string content(buf->data(), rv);
+  std::string rest;
+  EXPECT_EQ(net::OK, ReadTransaction(reader.trans.get(), &rest));
+  EXPECT_EQ(expected.substr(kChunkSize), content + rest);
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+
+  // The incomplete entry is not reused.
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+  EXPECT_EQ(3, cache.network_layer()->transaction_count());
+  EXPECT_EQ(2, cache.disk_cache()->create_count());
+}
+
+static void TailingReaderRange_Handler(
+    const net::HttpRequestInfo* request,
+    std::string* response_status,
+    std::string* response_headers,
+    std::string* response_data) {
+  std::string range;
+  if (!request->extra_headers.GetHeader(net::HttpRequestHeaders::kRange,
+                                        &range)) {
+    return;
+  }
+
+  std::string if_range;
+  EXPECT_TRUE(request->extra_headers.GetHeader(
+      net::HttpRequestHeaders::kIfRange, &if_range));
+  EXPECT_EQ("\"foopy\"", if_range);
+
+  std::vector<net::HttpByteRange> ranges;
+  ASSERT_TRUE(net::HttpUtil::ParseRangeHeader(range, &ranges));
+  ASSERT_EQ(1U, ranges.size());
+  int size = static_cast<int>(response_data->size());
+  EXPECT_TRUE(ranges[0].ComputeBounds(size));
+  int start = static_cast<int>(ranges[0].first_byte_position());
+  int end = static_cast<int>(ranges[0].last_byte_position());
+
+  response_status->assign("HTTP/1.1 206 Partial Content");
+  response_headers->assign(base::StringPrintf(
+      "Cache-Control: max-age=10000\n"
+      "ETag: \"foopy\"\n"
+      "Content-Range: bytes %d-%d/%d\n"
+      "Content-Length: %d\n",
+      start, end, size, end - start + 1));
+  *response_data = response_data->substr(start, end - start + 1);
+}
+
+// Tests that a transaction that is reading the response while it is being
+// written asks the server for the rest of the body when the writer fails to
+// store it.
+TEST(HttpCache, SimpleGET_TailingReaderResumesAfterWriteFailure) {
+  MockHttpCache cache;
+  const int kChunkSize = 10;
+  cache.disk_cache()->set_max_body_size(2 * kChunkSize);
+
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = "Cache-Control: max-age=10000\n"
+                                 "ETag: \"foopy\"\n"
+                                 "Content-Length: 42\n";
+  transaction.handler = TailingReaderRange_Handler;
+
+  MockHttpRequest request(transaction);
+  const std::string expected(transaction.data);
+  ASSERT_EQ(42U, expected.size());
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(expected.size()));
+
+  Context writer;
+  writer.result = cache.http_cache()->CreateTransaction(&writer.trans);
+  EXPECT_EQ(net::OK, writer.result);
+  writer.result = writer.trans->Start(
+      &request, writer.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  int rv = writer.trans->Read(buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+
+  Context reader;
+  reader.result = cache.http_cache()->CreateTransaction(&reader.trans);
+  EXPECT_EQ(net::OK, reader.result);
+  reader.result = reader.trans->Start(
+      &request, reader.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, reader.callback.GetResult(reader.result));
+
+  rv = reader.trans->Read(buf, expected.size(), reader.callback.callback());
+  EXPECT_EQ(kChunkSize, reader.callback.GetResult(rv));
+  reader.result = reader.trans->Read(buf, expected.size(),
+                                     reader.callback.callback());
+  EXPECT_EQ(net::ERR_IO_PENDING, reader.result);
+
+  // The second chunk still fits in the cache.
+  scoped_refptr<net::IOBuffer> writer_buf(new net::IOBuffer(kChunkSize));
+  rv = writer.trans->Read(writer_buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+  EXPECT_EQ(kChunkSize, reader.callback.WaitForResult());
+  EXPECT_EQ(expected.substr(kChunkSize, kChunkSize),
+            std::string(buf->data(), kChunkSize));
+
+  reader.result = reader.trans->Read(buf, expected.size(),
+                                     reader.callback.callback());
+  EXPECT_EQ(net::ERR_IO_PENDING, reader.result);
+
+  // The third one doesn't, but the writer keeps reading from the network.
+  rv = writer.trans->Read(writer_buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+  std::string content;
+  EXPECT_EQ(net::OK, ReadTransaction(writer.trans.get(), &content));
+  EXPECT_EQ(expected.substr(3 * kChunkSize), content);
+
+  // The reader gets the rest of the body with a byte range request.
+  rv = reader.callback.WaitForResult();
+  ASSERT_GT(rv, 0);
+  content.assign(buf->data(), rv);
+  std::string rest;
+  EXPECT_EQ(net::OK, ReadTransaction(reader.trans.get(), &rest));
+  EXPECT_EQ(expected.substr(2 * kChunkSize), content + rest);
+
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Tests that a transaction that has to validate the response does not read it
+// while it is being written.
+TEST(HttpCache, SimpleGET_ValidatingReaderWaitsForWriter) {
+  MockHttpCache cache;
+
+  MockHttpRequest request(kSimpleGET_Transaction);
+  MockHttpRequest validating_request(kSimpleGET_Transaction);
+  validating_request.load_flags = net::LOAD_VALIDATE_CACHE;
+  const int kChunkSize = 10;
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(kChunkSize));
+
+  Context writer;
+  writer.result = cache.http_cache()->CreateTransaction(&writer.trans);
+  EXPECT_EQ(net::OK, writer.result);
+  writer.result = writer.trans->Start(
+      &request, writer.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::OK, writer.callback.GetResult(writer.result));
+
+  int rv = writer.trans->Read(buf, kChunkSize, writer.callback.callback());
+  ASSERT_EQ(kChunkSize, writer.callback.GetResult(rv));
+
+  Context c;
+  c.result = cache.http_cache()->CreateTransaction(&c.trans);
+  EXPECT_EQ(net::OK, c.result);
+  c.result = c.trans->Start(
+      &validating_request, c.callback.callback(), net::BoundNetLog());
+  ASSERT_EQ(net::ERR_IO_PENDING, c.result);
+
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(c.callback.have_result());
+
+  std::string content;
+  EXPECT_EQ(net::OK, ReadTransaction(writer.trans.get(), &content));
+
+  ASSERT_EQ(net::OK, c.callback.WaitForResult());
+  ReadAndVerifyTransaction(c.trans.get(), kSimpleGET_Transaction);
+
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
 // Tests that we can doom an entry with pending transactions and delete one of
 // the pending transactions before the first one completes.
 // See http://code.google.com/p/chromium/issues/detail?id=25588
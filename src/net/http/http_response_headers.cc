@@ -116,6 +116,26 @@ int MapHttpResponseCode(int code) {
   return 0;
 }
 
+// Records the response code of headers received from the network.
+void RecordResponseCode(int response_code) {
+  // The most important thing to do with this histogram is find out
+  // the existence of unusual HTTP response codes.  As it happens
+  // right now, there aren't double-constructions of response headers
+  // using the constructors that call this, so our counts should also be
+  // accurate, without instantiating the histogram in two places.  It is
+  // also important that this histogram not collect data in the
+  // constructor which rebuilds an histogram from a pickle, since
+  // that would actually create a double call between the original
+  // HttpResponseHeader that was serialized, and initialization of the
+  // new object from that pickle.
+  UMA_HISTOGRAM_CUSTOM_ENUMERATION("Net.HttpResponseCode",
+                                   MapHttpResponseCode(response_code),
+                                   // Note the third argument is only
+                                   // evaluated once, see macro
+                                   // definition for details.
+                                   GetAllHttpResponseCodes());
+}
+
 void CheckDoesNotHaveEmbededNulls(const std::string& str) {
   // Care needs to be taken when adding values to the raw headers string to
   // make sure it does not contain embeded NULLs. Any embeded '\0' may be
@@ -141,23 +161,16 @@ struct HttpResponseHeaders::ParsedHeader {
 HttpResponseHeaders::HttpResponseHeaders(const std::string& raw_input)
     : response_code_(-1) {
   Parse(raw_input);
+  RecordResponseCode(response_code_);
+}
 
-  // The most important thing to do with this histogram is find out
-  // the existence of unusual HTTP response codes.  As it happens
-  // right now, there aren't double-constructions of response headers
-  // using this constructor, so our counts should also be accurate,
-  // without instantiating the histogram in two places.  It is also
-  // important that this histogram not collect data in the other
-  // constructor, which rebuilds an histogram from a pickle, since
-  // that would actually create a double call between the original
-  // HttpResponseHeader that was serialized, and initialization of the
-  // new object from that pickle.
-  UMA_HISTOGRAM_CUSTOM_ENUMERATION("Net.HttpResponseCode",
-                                   MapHttpResponseCode(response_code_),
-                                   // Note the third argument is only
-                                   // evaluated once, see macro
-                                   // definition for details.
-                                   GetAllHttpResponseCodes());
+HttpResponseHeaders::HttpResponseHeaders(const char* buf, int buf_len)
+    : response_code_(-1) {
+  // Leave room for the status line to grow when it is normalized.
+  raw_headers_.reserve(buf_len + 32);
+  HttpUtil::AssembleRawHeaders(buf, buf_len, &raw_headers_);
+  ParseInPlace();
+  RecordResponseCode(response_code_);
 }
 
 HttpResponseHeaders::HttpResponseHeaders(const Pickle& pickle, void** iter)
@@ -391,7 +404,7 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
   bool has_headers = (line_end != raw_input.end() &&
                       (line_end + 1) != raw_input.end() &&
                       *(line_end + 1) != '\0');
-  ParseStatusLine(line_begin, line_end, has_headers);
+  ParseStatusLine(line_begin, line_end, has_headers, &raw_headers_);
   raw_headers_.push_back('\0');  // Terminate status line with a null.
 
   if (line_end == raw_input.end()) {
@@ -409,6 +422,32 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
   // it (to populate our parsed_ vector).
   raw_headers_.append(line_end + 1, raw_input.end());
 
+  ParseHeaderLines(status_line_len);
+}
+
+void HttpResponseHeaders::ParseInPlace() {
+  std::string::const_iterator line_begin = raw_headers_.begin();
+  std::string::const_iterator raw_end = raw_headers_.end();
+  std::string::const_iterator line_end = std::find(line_begin, raw_end, '\0');
+  bool has_headers = (line_end != raw_end &&
+                      (line_end + 1) != raw_end &&
+                      *(line_end + 1) != '\0');
+  std::string status_line;
+  ParseStatusLine(line_begin, line_end, has_headers, &status_line);
+
+  if (line_end == raw_end) {
+    raw_headers_.swap(status_line);
+    raw_headers_.push_back('\0');
+    raw_headers_.push_back('\0');
+    return;
+  }
+
+  // The rest of the headers stay where they are.
+  raw_headers_.replace(0, line_end - line_begin, status_line);
+  ParseHeaderLines(status_line.size() + 1);
+}
+
+void HttpResponseHeaders::ParseHeaderLines(size_t status_line_len) {
   // Ensure the headers end with a double null.
   while (raw_headers_.size() < 2 ||
          raw_headers_[raw_headers_.size() - 2] != '\0' ||
@@ -417,7 +456,8 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
   }
 
   // Adjust to point at the null byte following the status line
-  line_end = raw_headers_.begin() + status_line_len - 1;
+  std::string::const_iterator line_end =
+      raw_headers_.begin() + status_line_len - 1;
 
   HttpUtil::HeadersIterator headers(line_end + 1, raw_headers_.end(),
                                     std::string(1, '\0'));
@@ -652,21 +692,22 @@ HttpVersion HttpResponseHeaders::ParseVersion(
 void HttpResponseHeaders::ParseStatusLine(
     std::string::const_iterator line_begin,
     std::string::const_iterator line_end,
-    bool has_headers) {
+    bool has_headers,
+    std::string* status_line) {
   // Extract the version number
   parsed_http_version_ = ParseVersion(line_begin, line_end);
 
   // Clamp the version number to one of: {0.9, 1.0, 1.1}
   if (parsed_http_version_ == HttpVersion(0, 9) && !has_headers) {
     http_version_ = HttpVersion(0, 9);
-    raw_headers_ = "HTTP/0.9";
+    *status_line = "HTTP/0.9";
   } else if (parsed_http_version_ >= HttpVersion(1, 1)) {
     http_version_ = HttpVersion(1, 1);
-    raw_headers_ = "HTTP/1.1";
+    *status_line = "HTTP/1.1";
   } else {
     // Treat everything else like HTTP 1.0
     http_version_ = HttpVersion(1, 0);
-    raw_headers_ = "HTTP/1.0";
+    *status_line = "HTTP/1.0";
   }
   if (parsed_http_version_ != http_version_) {
     DVLOG(1) << "assuming HTTP/" << http_version_.major_value() << "."
@@ -678,7 +719,7 @@ void HttpResponseHeaders::ParseStatusLine(
 
   if (p == line_end) {
     DVLOG(1) << "missing response status; assuming 200 OK";
-    raw_headers_.append(" 200 OK");
+    status_line->append(" 200 OK");
     response_code_ = 200;
     return;
   }
@@ -693,13 +734,13 @@ void HttpResponseHeaders::ParseStatusLine(
 
   if (p == code) {
     DVLOG(1) << "missing response status number; assuming 200";
-    raw_headers_.append(" 200 OK");
+    status_line->append(" 200 OK");
     response_code_ = 200;
     return;
   }
-  raw_headers_.push_back(' ');
-  raw_headers_.append(code, p);
-  raw_headers_.push_back(' ');
+  status_line->push_back(' ');
+  status_line->append(code, p);
+  status_line->push_back(' ');
   base::StringToInt(StringPiece(code, p), &response_code_);
 
   // Skip whitespace.
@@ -714,9 +755,9 @@ void HttpResponseHeaders::ParseStatusLine(
     DVLOG(1) << "missing response status text; assuming OK";
     // Not super critical what we put here. Just use "OK"
     // even if it isn't descriptive of response_code_.
-    raw_headers_.append("OK");
+    status_line->append("OK");
   } else {
-    raw_headers_.append(p, line_end);
+    status_line->append(p, line_end);
   }
 }
 
@@ -48,6 +48,13 @@ class NET_EXPORT HttpResponseHeaders
   //
   explicit HttpResponseHeaders(const std::string& raw_headers);
 
+  // Parses the headers in |buf| as they were received from the server, that
+  // is |buf_len| bytes ending with the end-of-headers marker as located by
+  // HttpUtil::LocateEndOfHeaders().  This is equivalent to
+  // HttpResponseHeaders(HttpUtil::AssembleRawHeaders(buf, buf_len)), except
+  // that the headers are assembled directly into this object.
+  HttpResponseHeaders(const char* buf, int buf_len);
+
   // Initializes from the representation stored in the given pickle.  The data
   // for this object is found relative to the given pickle_iter, which should
   // be passed to the pickle's various Read* methods.
@@ -265,6 +272,15 @@ class NET_EXPORT HttpResponseHeaders
   // Initializes from the given raw headers.
   void Parse(const std::string& raw_input);
 
+  // Initializes from the raw headers already held in raw_headers_, replacing
+  // their status line with its normalized version.
+  void ParseInPlace();
+
+  // Populates parsed_ with the headers that follow the status line in
+  // raw_headers_.  |status_line_len| includes the null byte terminating the
+  // status line.
+  void ParseHeaderLines(size_t status_line_len);
+
   // Helper function for ParseStatusLine.
   // Tries to extract the "HTTP/X.Y" from a status line formatted like:
   //    HTTP/1.1 200 OK
@@ -278,10 +294,11 @@ class NET_EXPORT HttpResponseHeaders
   // construct a valid one.  Example input:
   //    HTTP/1.1 200 OK
   // with line_begin and end pointing at the begin and end of this line.
-  // Output will be a normalized version of this.
+  // The normalized version of this is stored in |status_line|.
   void ParseStatusLine(std::string::const_iterator line_begin,
                        std::string::const_iterator line_end,
-                       bool has_headers);
+                       bool has_headers,
+                       std::string* status_line);
 
   // Find the header in our list (case-insensitive) starting with parsed_ at
   // index |from|.  Returns string::npos if not found.
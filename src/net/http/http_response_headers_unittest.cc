@@ -8,6 +8,7 @@
 #include "base/pickle.h"
 #include "base/time.h"
 #include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace {
@@ -283,6 +284,44 @@ TEST(HttpResponseHeadersTest, RepeatedSetCookie) {
   TestCommon(test);
 }
 
+// Check that parsing headers as received from the network gives the same
+// result as assembling them first.
+TEST(HttpResponseHeadersTest, ParseReceivedHeaders) {
+  const char* tests[] = {
+    "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nFoo: 1\r\n\r\n",
+    "HTTP/1.1    202   Accepted  \nSet-Cookie: a \nSet-Cookie:   b \n\n",
+    // Leading junk, and a line continuation.
+    "xx HTTP/1.0 404 Not Found\r\nFoo: 1\r\n  continued\r\nBar: 2\r\n\r\n",
+    // A status line that has to grow when it is normalized.
+    "HTTP\nFoo: 1\n\n",
+    "HTTP/1.1\n\n",
+    // An embedded null, which must not split the line.
+    "HTTP/1.1 200 OK\nFoo: 1|Bar: 2\n\n",
+    // No status line at all.
+    "\n   \n",
+  };
+  for (size_t i = 0; i < arraysize(tests); ++i) {
+    std::string input(tests[i]);
+    std::replace(input.begin(), input.end(), '|', '\0');
+
+    scoped_refptr<net::HttpResponseHeaders> assembled(
+        new net::HttpResponseHeaders(net::HttpUtil::AssembleRawHeaders(
+            input.data(), input.size())));
+    scoped_refptr<net::HttpResponseHeaders> received(
+        new net::HttpResponseHeaders(input.data(), input.size()));
+
+    EXPECT_EQ(assembled->raw_headers(), received->raw_headers()) << i;
+    std::string assembled_headers, received_headers;
+    assembled->GetNormalizedHeaders(&assembled_headers);
+    received->GetNormalizedHeaders(&received_headers);
+    EXPECT_EQ(assembled_headers, received_headers) << i;
+    EXPECT_EQ(assembled->response_code(), received->response_code()) << i;
+    EXPECT_TRUE(assembled->GetHttpVersion() == received->GetHttpVersion());
+    EXPECT_TRUE(assembled->GetParsedHttpVersion() ==
+                received->GetParsedHttpVersion());
+  }
+}
+
 TEST(HttpResponseHeadersTest, GetNormalizedHeader) {
   std::string headers =
       "HTTP/1.1 200 OK\n"
@@ -72,6 +72,7 @@ HttpStreamParser::HttpStreamParser(ClientSocketHandle* connection,
       read_buf_(read_buffer),
       read_buf_unused_offset_(0),
       response_header_start_offset_(-1),
+      response_header_search_offset_(0),
       response_body_length_(-1),
       response_body_read_(0),
       chunked_decoder_(NULL),
@@ -473,6 +474,7 @@ int HttpStreamParser::DoReadHeadersComplete(int result) {
       // tunnel.
       io_state_ = STATE_REQUEST_SENT;
       response_header_start_offset_ = -1;
+      response_header_search_offset_ = 0;
     } else {
       io_state_ = STATE_BODY_PENDING;
       CalculateResponseBodySize();
@@ -610,10 +612,17 @@ int HttpStreamParser::ParseResponseHeaders() {
   }
 
   if (response_header_start_offset_ >= 0) {
+    // Don't scan again the data that was already searched after the previous
+    // reads, except for the last two bytes, which may be the start of an
+    // end-of-headers marker completed by this read.
+    int buf_len = read_buf_->offset() - read_buf_unused_offset_;
+    int search_start = std::max(response_header_start_offset_,
+                                response_header_search_offset_ - 2);
     end_offset = HttpUtil::LocateEndOfHeaders(
-        read_buf_->StartOfBuffer() + read_buf_unused_offset_,
-        read_buf_->offset() - read_buf_unused_offset_,
-        response_header_start_offset_);
+        read_buf_->StartOfBuffer() + read_buf_unused_offset_, buf_len,
+        search_start);
+    if (end_offset == -1)
+      response_header_search_offset_ = buf_len;
   } else if (read_buf_->offset() - read_buf_unused_offset_ >= 8) {
     // Enough data to decide that this is an HTTP/0.9 response.
     // 8 bytes = (4 bytes of junk) + "http".length()
@@ -632,8 +641,8 @@ int HttpStreamParser::ParseResponseHeaders() {
 int HttpStreamParser::DoParseResponseHeaders(int end_offset) {
   scoped_refptr<HttpResponseHeaders> headers;
   if (response_header_start_offset_ >= 0) {
-    headers = new HttpResponseHeaders(HttpUtil::AssembleRawHeaders(
-        read_buf_->StartOfBuffer() + read_buf_unused_offset_, end_offset));
+    headers = new HttpResponseHeaders(
+        read_buf_->StartOfBuffer() + read_buf_unused_offset_, end_offset);
   } else {
     // Enough data was read -- there is no status line.
     headers = new HttpResponseHeaders(std::string("HTTP/0.9 200 OK"));
@@ -156,6 +156,10 @@ class HttpStreamParser  : public ChunkCallback {
   // -1 if not found yet.
   int response_header_start_offset_;
 
+  // The amount beyond |read_buf_unused_offset_| up to which the end of the
+  // headers has been searched for, so that each read only scans new data.
+  int response_header_search_offset_;
+
   // The parsed response headers.  Owned by the caller.
   HttpResponseInfo* response_;
 
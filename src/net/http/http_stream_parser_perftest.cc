@@ -0,0 +1,168 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/test_completion_callback.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_stream_parser.h"
+#include "net/http/http_util.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/socket_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumIterations = 500;
+
+// Response headers as sent by a few real servers, with the values of the
+// cookies and dates changed.
+const char* const kHeaderSets[] = {
+  // A search results page.
+  "HTTP/1.1 200 OK\r\n"
+  "Date: Tue, 15 Nov 2011 08:12:31 GMT\r\n"
+  "Expires: -1\r\n"
+  "Cache-Control: private, max-age=0\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "Set-Cookie: PREF=ID=4f5d2a7c1b3e9f08:FF=0:TM=1321344751:LM=1321344751:"
+  "S=q8Zx3kE1bJw9Yv2T; expires=Thu, 14-Nov-2013 08:12:31 GMT; path=/; "
+  "domain=.example.com\r\n"
+  "Set-Cookie: NID=54=Vb6yQm2HkD0sLp9rXc3fNw7tJ1aZe5uGo8iKq4TnWd2hRj6yMv0b"
+  "Sl3xCf9Ue7Pk1oAz5gYt8rLn2wQd4mHi6; expires=Wed, 16-May-2012 08:12:31 "
+  "GMT; path=/; domain=.example.com; HttpOnly\r\n"
+  "P3P: CP=\"This is not a P3P policy! See "
+  "http://www.example.com/support/accounts/bin/answer.py?hl=en&answer=151657 "
+  "for more info.\"\r\n"
+  "Server: gws\r\n"
+  "X-XSS-Protection: 1; mode=block\r\n"
+  "X-Frame-Options: SAMEORIGIN\r\n"
+  "Transfer-Encoding: chunked\r\n"
+  "\r\n",
+
+  // An image from a CDN.
+  "HTTP/1.1 200 OK\r\n"
+  "Server: Apache\r\n"
+  "ETag: \"9b6a4c1e2f3d8a7b5c0e1f2a3b4c5d6e:1318345321\"\r\n"
+  "Last-Modified: Tue, 11 Oct 2011 15:02:01 GMT\r\n"
+  "Accept-Ranges: bytes\r\n"
+  "Content-Length: 18342\r\n"
+  "Content-Type: image/png\r\n"
+  "Cache-Control: public, max-age=31536000\r\n"
+  "Expires: Wed, 14 Nov 2012 08:12:31 GMT\r\n"
+  "Date: Tue, 15 Nov 2011 08:12:31 GMT\r\n"
+  "Age: 84211\r\n"
+  "Via: 1.1 varnish, 1.1 cache-ams1234.example.net (squid/2.7.STABLE9)\r\n"
+  "X-Cache: HIT from cache-ams1234.example.net\r\n"
+  "X-Cache-Lookup: HIT from cache-ams1234.example.net:80\r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n",
+
+  // A login redirect which sets many cookies.
+  "HTTP/1.1 302 Found\r\n"
+  "Date: Tue, 15 Nov 2011 08:12:32 GMT\r\n"
+  "Server: Apache/2.2.3 (Red Hat)\r\n"
+  "X-Powered-By: PHP/5.2.17\r\n"
+  "P3P: CP=\"NOI DSP COR NID ADMa OPTa OUR NOR\"\r\n"
+  "Set-Cookie: session=7f3a9c2e4b1d8f6a0c5e3b7d9a1f4c2e; path=/; "
+  "secure; HttpOnly\r\n"
+  "Set-Cookie: user=deleted; expires=Mon, 15-Nov-2010 08:12:31 GMT; path=/\r\n"
+  "Set-Cookie: lang=en-US; expires=Wed, 14-Nov-2012 08:12:32 GMT; path=/; "
+  "domain=.example.org\r\n"
+  "Set-Cookie: tz=Europe%2FAmsterdam; expires=Wed, 14-Nov-2012 08:12:32 GMT; "
+  "path=/; domain=.example.org\r\n"
+  "Set-Cookie: csrf=a8f5f167f44f4964e6c998dee827110c; path=/; secure\r\n"
+  "Location: https://login.example.org/account/signin?continue="
+  "http%3A%2F%2Fwww.example.org%2Fmail%2F&service=mail&passive=true\r\n"
+  "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+  "Pragma: no-cache\r\n"
+  "Expires: Mon, 01 Jan 1990 00:00:00 GMT\r\n"
+  "Vary: Accept-Encoding\r\n"
+  "Content-Length: 0\r\n"
+  "Keep-Alive: timeout=15, max=100\r\n"
+  "Connection: Keep-Alive\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "\r\n",
+};
+
+// Reads the headers of |response| with an HttpStreamParser, receiving
+// |read_size| bytes at a time from the socket.
+void ReadResponseHeaders(const std::string& response, int read_size) {
+  std::vector<MockRead> reads;
+  for (size_t i = 0; i < response.size(); i += read_size) {
+    int len = std::min(read_size, static_cast<int>(response.size() - i));
+    reads.push_back(MockRead(false, response.data() + i, len));
+  }
+  StaticSocketDataProvider data(&reads[0], reads.size(), NULL, 0);
+  data.set_connect_data(MockConnect(false, OK));
+
+  TestCompletionCallback callback;
+  MockTCPClientSocket* socket =
+      new MockTCPClientSocket(AddressList(), NULL, &data);
+  ASSERT_EQ(OK, socket->Connect(callback.callback()));
+  ClientSocketHandle handle;
+  handle.set_socket(socket);
+
+  HttpRequestInfo request;
+  request.method = "GET";
+  request.url = GURL("http://www.example.com/");
+  scoped_refptr<GrowableIOBuffer> read_buffer(new GrowableIOBuffer);
+  HttpStreamParser parser(&handle, &request, read_buffer, BoundNetLog());
+
+  HttpResponseInfo response_info;
+  ASSERT_EQ(OK, parser.SendRequest("GET / HTTP/1.1\r\n", HttpRequestHeaders(),
+                                   NULL, &response_info, callback.callback()));
+  ASSERT_EQ(OK, parser.ReadResponseHeaders(callback.callback()));
+  ASSERT_TRUE(response_info.headers.get());
+}
+
+}  // namespace
+
+// Measures reading headers that arrive in reads of various sizes, from
+// single bytes as on a congested link to the whole block at once.
+TEST(HttpStreamParserPerfTest, ReadResponseHeaders) {
+  const int kReadSizes[] = { 1, 16, 256, 4096 };
+  for (size_t i = 0; i < arraysize(kReadSizes); ++i) {
+    PerfTimeLogger timer(
+        base::StringPrintf("Http_stream_parser_read_%d", kReadSizes[i])
+            .c_str());
+    for (int j = 0; j < kNumIterations; ++j) {
+      for (size_t k = 0; k < arraysize(kHeaderSets); ++k)
+        ReadResponseHeaders(kHeaderSets[k], kReadSizes[i]);
+    }
+    timer.Done();
+  }
+}
+
+// Measures building HttpResponseHeaders from the received bytes alone.
+TEST(HttpStreamParserPerfTest, ParseResponseHeaders) {
+  std::vector<std::string> responses(kHeaderSets,
+                                     kHeaderSets + arraysize(kHeaderSets));
+  PerfTimeLogger timer("Http_response_headers_parse");
+  for (int i = 0; i < kNumIterations * 10; ++i) {
+    for (size_t j = 0; j < responses.size(); ++j) {
+      const std::string& response = responses[j];
+      int end = HttpUtil::LocateEndOfHeaders(response.data(), response.size());
+      ASSERT_EQ(static_cast<int>(response.size()), end);
+      scoped_refptr<HttpResponseHeaders> headers(
+          new HttpResponseHeaders(response.data(), end));
+      EXPECT_NE(-1, headers->response_code());
+    }
+  }
+  timer.Done();
+}
+
+}  // namespace net
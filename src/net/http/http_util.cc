@@ -492,18 +492,19 @@ int HttpUtil::LocateStartOfStatusLine(const char* buf, int buf_len) {
 }
 
 int HttpUtil::LocateEndOfHeaders(const char* buf, int buf_len, int i) {
-  bool was_lf = false;
-  char last_c = '\0';
-  for (; i < buf_len; ++i) {
-    char c = buf[i];
-    if (c == '\n') {
-      if (was_lf)
-        return i + 1;
-      was_lf = true;
-    } else if (c != '\r' || last_c != '\n') {
-      was_lf = false;
-    }
-    last_c = c;
+  // Jump from one LF to the next, and check whether it is followed by an
+  // optional CR and a second LF.
+  const char* end = buf + buf_len;
+  const char* p = buf + i;
+  while (p < end) {
+    p = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!p)
+      break;
+    ++p;
+    if (p < end && *p == '\r')
+      ++p;
+    if (p < end && *p == '\n')
+      return p + 1 - buf;
   }
   return -1;
 }
@@ -553,7 +554,15 @@ static const char* FindFirstNonLWS(const char* begin, const char* end) {
 std::string HttpUtil::AssembleRawHeaders(const char* input_begin,
                                          int input_len) {
   std::string raw_headers;
-  raw_headers.reserve(input_len);
+  AssembleRawHeaders(input_begin, input_len, &raw_headers);
+  return raw_headers;
+}
+
+void HttpUtil::AssembleRawHeaders(const char* input_begin,
+                                  int input_len,
+                                  std::string* raw_headers) {
+  raw_headers->clear();
+  raw_headers->reserve(input_len);
 
   const char* input_end = input_begin + input_len;
 
@@ -565,7 +574,7 @@ std::string HttpUtil::AssembleRawHeaders(const char* input_begin,
 
   // Copy the status line.
   const char* status_line_end = FindStatusLineEnd(input_begin, input_end);
-  raw_headers.append(input_begin, status_line_end);
+  raw_headers->append(input_begin, status_line_end);
 
   // After the status line, every subsequent line is a header line segment.
   // Should a segment start with LWS, it is a continuation of the previous
@@ -583,30 +592,29 @@ std::string HttpUtil::AssembleRawHeaders(const char* input_begin,
 
     if (prev_line_continuable && IsLWS(*line_begin)) {
       // Join continuation; reduce the leading LWS to a single SP.
-      raw_headers.push_back(' ');
-      raw_headers.append(FindFirstNonLWS(line_begin, line_end), line_end);
+      raw_headers->push_back(' ');
+      raw_headers->append(FindFirstNonLWS(line_begin, line_end), line_end);
     } else {
       // Terminate the previous line.
-      raw_headers.push_back('\n');
+      raw_headers->push_back('\n');
 
       // Copy the raw data to output.
-      raw_headers.append(line_begin, line_end);
+      raw_headers->append(line_begin, line_end);
 
       // Check if the current line can be continued.
       prev_line_continuable = IsLineSegmentContinuable(line_begin, line_end);
     }
   }
 
-  raw_headers.append("\n\n", 2);
+  raw_headers->append("\n\n", 2);
 
   // Use '\0' as the canonical line terminator. If the input already contained
   // any embeded '\0' characters we will strip them first to avoid interpreting
   // them as line breaks.
-  raw_headers.erase(std::remove(raw_headers.begin(), raw_headers.end(), '\0'),
-                    raw_headers.end());
-  std::replace(raw_headers.begin(), raw_headers.end(), '\n', '\0');
-
-  return raw_headers;
+  raw_headers->erase(std::remove(raw_headers->begin(), raw_headers->end(),
+                                 '\0'),
+                     raw_headers->end());
+  std::replace(raw_headers->begin(), raw_headers->end(), '\n', '\0');
 }
 
 std::string HttpUtil::ConvertHeadersBackToHTTPResponse(const std::string& str) {
@@ -143,6 +143,11 @@ class NET_EXPORT HttpUtil {
   //               this is hard to change without breaking things.
   static std::string AssembleRawHeaders(const char* buf, int buf_len);
 
+  // Same as above, but stores the result in |raw_headers|, reusing the
+  // memory it already has.
+  static void AssembleRawHeaders(const char* buf, int buf_len,
+                                 std::string* raw_headers);
+
   // Converts assembled "raw headers" back to the HTTP response format. That is
   // convert each \0 occurence to CRLF. This is used by DevTools.
   // Since all line continuations info is already lost at this point, the result
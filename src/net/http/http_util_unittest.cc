@@ -264,6 +264,8 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
     { "foo\nbar\n\njunk", 9 },
     { "foo\nbar\n\r\njunk", 10 },
     { "foo\nbar\r\n\njunk", 10 },
+    { "foo\nbar\n\r\r\njunk", -1 },
+    { "foo\r\nbar\r\n\r", -1 },
   };
   for (size_t i = 0; i < ARRAYSIZE_UNSAFE(tests); ++i) {
     int input_len = static_cast<int>(strlen(tests[i].input));
@@ -272,6 +274,20 @@ TEST(HttpUtilTest, LocateEndOfHeaders) {
   }
 }
 
+// Searching again from anywhere before the marker finds the same end, so
+// callers can resume the search as more data arrives.
+TEST(HttpUtilTest, LocateEndOfHeadersFromOffset) {
+  const char kInput[] = "HTTP/1.1 200 OK\r\nFoo: 1\r\n\r\nbody";
+  const int kInputLen = static_cast<int>(strlen(kInput));
+  const int kEndOfHeaders = kInputLen - 4;
+  for (int i = 0; i <= kEndOfHeaders - 4; ++i) {
+    EXPECT_EQ(kEndOfHeaders,
+              HttpUtil::LocateEndOfHeaders(kInput, kInputLen, i)) << i;
+  }
+  for (int len = 0; len < kEndOfHeaders; ++len)
+    EXPECT_EQ(-1, HttpUtil::LocateEndOfHeaders(kInput, len)) << len;
+}
+
 TEST(HttpUtilTest, AssembleRawHeaders) {
   struct {
     const char* input;  // with '|' representing '\0'
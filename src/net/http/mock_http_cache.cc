@@ -52,12 +52,14 @@ struct MockDiskEntry::CallbackInfo {
 
 MockDiskEntry::MockDiskEntry()
     : test_mode_(0), doomed_(false), sparse_(false),
-      fail_requests_(false), busy_(false), delayed_(false) {
+      fail_requests_(false), max_body_size_(-1), busy_(false),
+      delayed_(false) {
 }
 
 MockDiskEntry::MockDiskEntry(const std::string& key)
     : key_(key), doomed_(false), sparse_(false),
-      fail_requests_(false), busy_(false), delayed_(false) {
+      fail_requests_(false), max_body_size_(-1), busy_(false),
+      delayed_(false) {
   test_mode_ = GetTestModeForEntry(key);
 }
 
@@ -127,6 +129,12 @@ int MockDiskEntry::WriteData(
   if (offset < 0 || offset > static_cast<int>(data_[index].size()))
     return net::ERR_FAILED;
 
+  // The body of the response is stored at index 1.
+  if (index == 1 && max_body_size_ >= 0 && offset + buf_len > max_body_size_) {
+    CallbackLater(callback, net::ERR_FAILED);
+    return net::ERR_IO_PENDING;
+  }
+
   data_[index].resize(offset + buf_len);
   if (buf_len)
     memcpy(&data_[index][offset], buf->data(), buf_len);
@@ -334,7 +342,7 @@ bool MockDiskEntry::ignore_callbacks_ = false;
 
 MockDiskCache::MockDiskCache()
     : open_count_(0), create_count_(0), fail_requests_(false),
-      soft_failures_(false), double_create_check_(true) {
+      soft_failures_(false), max_body_size_(-1), double_create_check_(true) {
 }
 
 MockDiskCache::~MockDiskCache() {
@@ -408,6 +416,8 @@ int MockDiskCache::CreateEntry(const std::string& key,
   if (soft_failures_)
     new_entry->set_fail_requests();
 
+  new_entry->set_max_body_size(max_body_size_);
+
   if (GetTestModeForEntry(key) & TEST_MODE_SYNC_CACHE_START)
     return net::OK;
 
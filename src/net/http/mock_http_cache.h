@@ -54,6 +54,10 @@ class MockDiskEntry : public disk_cache::Entry,
   // Fail most subsequent requests.
   void set_fail_requests() { fail_requests_ = true; }
 
+  // Fail writes that would store more than |size| bytes of the response body,
+  // the way the disk cache enforces its size limit for a single entry.
+  void set_max_body_size(int size) { max_body_size_ = size; }
+
   // If |value| is true, don't deliver any completion callbacks until called
   // again with |value| set to false.  Caution: remember to enable callbacks
   // again or all subsequent tests will fail.
@@ -86,6 +90,7 @@ class MockDiskEntry : public disk_cache::Entry,
   bool doomed_;
   bool sparse_;
   bool fail_requests_;
+  int max_body_size_;
   bool busy_;
   bool delayed_;
   static bool cancel_;
@@ -131,6 +136,9 @@ class MockDiskCache : public disk_cache::Backend {
   // Return entries that fail some of their requests.
   void set_soft_failures(bool value) { soft_failures_ = value; }
 
+  // Return entries that can store up to |size| bytes of the response body.
+  void set_max_body_size(int size) { max_body_size_ = size; }
+
   // Makes sure that CreateEntry is not called twice for a given key.
   void set_double_create_check(bool value) { double_create_check_ = value; }
 
@@ -146,6 +154,7 @@ class MockDiskCache : public disk_cache::Backend {
   int create_count_;
   bool fail_requests_;
   bool soft_failures_;
+  int max_body_size_;
   bool double_create_check_;
 };
 
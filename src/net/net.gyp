@@ -70,6 +70,8 @@
         'base/cert_status_flags.h',
         'base/cert_verifier.cc',
         'base/cert_verifier.h',
+        'base/cert_verify_cache.cc',
+        'base/cert_verify_cache.h',
         'base/cert_verify_result.cc',
         'base/cert_verify_result.h',
         'base/completion_callback.cc',
@@ -134,6 +136,8 @@
         'base/host_resolver_proc.h',
         'base/io_buffer.cc',
         'base/io_buffer.h',
+        'base/io_buffer_pool.cc',
+        'base/io_buffer_pool.h',
         'base/ip_endpoint.cc',
         'base/ip_endpoint.h',
         'base/keygen_handler.cc',
@@ -283,6 +287,8 @@
         'disk_cache/errors.h',
         'disk_cache/eviction.cc',
         'disk_cache/eviction.h',
+        'disk_cache/eviction_group.cc',
+        'disk_cache/eviction_group.h',
         'disk_cache/experiments.h',
         'disk_cache/file.cc',
         'disk_cache/file.h',
@@ -291,6 +297,8 @@
         'disk_cache/file_lock.h',
         'disk_cache/file_posix.cc',
         'disk_cache/file_win.cc',
+        'disk_cache/frequency_sketch.cc',
+        'disk_cache/frequency_sketch.h',
         'disk_cache/hash.cc',
         'disk_cache/hash.h',
         'disk_cache/histogram_macros.h',
@@ -311,6 +319,8 @@
         'disk_cache/net_log_parameters.h',
         'disk_cache/rankings.cc',
         'disk_cache/rankings.h',
+        'disk_cache/sharded_backend.cc',
+        'disk_cache/sharded_backend.h',
         'disk_cache/sparse_control.cc',
         'disk_cache/sparse_control.h',
         'disk_cache/stats.cc',
@@ -657,6 +667,8 @@
         'third_party/mozilla_security_manager/nsNSSCertificateDB.h',
         'third_party/mozilla_security_manager/nsPKCS12Blob.cpp',
         'third_party/mozilla_security_manager/nsPKCS12Blob.h',
+        'udp/datagram_batch.cc',
+        'udp/datagram_batch.h',
         'udp/datagram_client_socket.h',
         'udp/datagram_server_socket.h',
         'udp/datagram_socket.h',
@@ -1003,6 +1015,7 @@
         'base/big_endian_unittest.cc',
         'base/cert_database_nss_unittest.cc',
         'base/cert_verifier_unittest.cc',
+        'base/cert_verify_cache_unittest.cc',
         'base/cookie_monster_unittest.cc',
         'base/crl_set_unittest.cc',
         'base/data_url_unittest.cc',
@@ -1018,6 +1031,7 @@
         'base/host_mapping_rules_unittest.cc',
         'base/host_port_pair_unittest.cc',
         'base/host_resolver_impl_unittest.cc',
+        'base/io_buffer_pool_unittest.cc',
         'base/ip_endpoint_unittest.cc',
         'base/keygen_handler_unittest.cc',
         'base/listen_socket_unittest.cc',
@@ -1057,7 +1071,9 @@
         'disk_cache/block_files_unittest.cc',
         'disk_cache/cache_util_unittest.cc',
         'disk_cache/entry_unittest.cc',
+        'disk_cache/frequency_sketch_unittest.cc',
         'disk_cache/mapped_file_unittest.cc',
+        'disk_cache/sharded_backend_unittest.cc',
         'disk_cache/storage_block_unittest.cc',
         'dns/async_host_resolver_unittest.cc',
         'dns/dns_client_unittest.cc',
@@ -1303,12 +1319,26 @@
         '../base/base.gyp:base_i18n',
         '../base/base.gyp:test_support_perf',
         '../build/temp_gyp/googleurl.gyp:googleurl',
+        '../crypto/crypto.gyp:crypto',
         '../testing/gtest.gyp:gtest',
       ],
       'sources': [
+        'base/cert_verifier_perftest.cc',
         'base/cookie_monster_perftest.cc',
+        'base/host_cache_perftest.cc',
+        'base/transport_security_state_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
+        'dns/async_host_resolver_perftest.cc',
+        'http/http_cache_perftest.cc',
+        'http/http_stream_parser_perftest.cc',
+        'http/http_transaction_unittest.cc',
+        'http/http_transaction_unittest.h',
+        'http/mock_http_cache.cc',
+        'http/mock_http_cache.h',
         'proxy/proxy_resolver_perftest.cc',
+        'socket/client_socket_pool_base_perftest.cc',
+        'spdy/spdy_framer_perftest.cc',
+        'udp/udp_socket_perftest.cc',
       ],
       'conditions': [
         # This is needed to trigger the dll copy step on windows.
@@ -1639,6 +1669,35 @@
              'tools/flip_server/string_piece_utils.h',
            ],
          },
+         {
+           'target_name': 'flip_load_generator',
+           'type': 'executable',
+           'cflags': [
+             '-Wno-deprecated',
+           ],
+           'dependencies': [
+             '../base/base.gyp:base',
+           ],
+           'sources': [
+             'tools/flip_server/balsa_enums.h',
+             'tools/flip_server/balsa_frame.cc',
+             'tools/flip_server/balsa_frame.h',
+             'tools/flip_server/balsa_headers.cc',
+             'tools/flip_server/balsa_headers.h',
+             'tools/flip_server/balsa_headers_token_utils.cc',
+             'tools/flip_server/balsa_headers_token_utils.h',
+             'tools/flip_server/balsa_visitor_interface.h',
+             'tools/flip_server/buffer_interface.h',
+             'tools/flip_server/create_listener.cc',
+             'tools/flip_server/create_listener.h',
+             'tools/flip_server/epoll_server.cc',
+             'tools/flip_server/epoll_server.h',
+             'tools/flip_server/flip_load_generator.cc',
+             'tools/flip_server/split.cc',
+             'tools/flip_server/split.h',
+             'tools/flip_server/string_piece_utils.h',
+           ],
+         },
          {
            'target_name': 'curvecp',
            'type': 'static_library',
@@ -66,6 +66,10 @@ class MultiThreadedProxyResolver::Executor
 
   ProxyResolver* resolver() { return resolver_.get(); }
 
+  // Returns the resolver which owns this executor, or NULL once it has been
+  // destroyed.
+  MultiThreadedProxyResolver* coordinator() const { return coordinator_; }
+
   int thread_number() const { return thread_number_; }
 
  private:
@@ -269,6 +273,11 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
  private:
   // Runs the completion callback on the origin thread.
   void QueryComplete(int result_code) {
+    // The result is still good for later queries, even if this one was
+    // cancelled, as long as the executor (and so the script) is still live.
+    if (result_code == OK && executor())
+      executor()->coordinator()->AddResultToCache(url_, results_buf_);
+
     // The Job may have been cancelled after it was started.
     if (!was_cancelled()) {
       if (result_code >= OK) {  // Note: unit-tests use values > 0.
@@ -404,6 +413,17 @@ int MultiThreadedProxyResolver::GetProxyForURL(
   DCHECK(current_script_data_.get())
       << "Resolver is un-initialized. Must call SetPacScript() first!";
 
+  if (result_cache_.get()) {
+    ResultCache::iterator it = result_cache_->Get(url.spec());
+    if (it != result_cache_->end()) {
+      if (base::TimeTicks::Now() < it->second.expiration) {
+        results->Use(it->second.info);
+        return OK;
+      }
+      result_cache_->Erase(it);
+    }
+  }
+
   scoped_refptr<GetProxyForURLJob> job(
       new GetProxyForURLJob(url, results, callback, net_log));
 
@@ -482,12 +502,16 @@ void MultiThreadedProxyResolver::CancelSetPacScript() {
   // Defensively clear some data which shouldn't be getting used
   // anymore.
   current_script_data_ = NULL;
+  if (result_cache_.get())
+    result_cache_->Clear();
 
   ReleaseAllExecutors();
 }
 
 void MultiThreadedProxyResolver::PurgeMemory() {
   DCHECK(CalledOnValidThread());
+  if (result_cache_.get())
+    result_cache_->Clear();
   for (ExecutorList::iterator it = executors_.begin();
        it != executors_.end(); ++it) {
     Executor* executor = *it;
@@ -504,6 +528,10 @@ int MultiThreadedProxyResolver::SetPacScript(
   // Save the script details, so we can provision new executors later.
   current_script_data_ = script_data;
 
+  // Results of the previous script don't apply to the new one.
+  if (result_cache_.get())
+    result_cache_->Clear();
+
   // The user should not have any outstanding requests when they call
   // SetPacScript().
   CheckNoOutstandingUserRequests();
@@ -518,6 +546,17 @@ int MultiThreadedProxyResolver::SetPacScript(
   return ERR_IO_PENDING;
 }
 
+void MultiThreadedProxyResolver::SetResultCacheParams(size_t max_entries,
+                                                      base::TimeDelta ttl) {
+  DCHECK(CalledOnValidThread());
+  result_cache_ttl_ = ttl;
+  if (max_entries == 0 || ttl <= base::TimeDelta()) {
+    result_cache_.reset();
+    return;
+  }
+  result_cache_.reset(new ResultCache(max_entries));
+}
+
 void MultiThreadedProxyResolver::CheckNoOutstandingUserRequests() const {
   DCHECK(CalledOnValidThread());
   CHECK_EQ(0u, pending_jobs_.size());
@@ -583,4 +622,15 @@ void MultiThreadedProxyResolver::OnExecutorReady(Executor* executor) {
   executor->StartJob(job);
 }
 
+void MultiThreadedProxyResolver::AddResultToCache(const GURL& url,
+                                                  const ProxyInfo& info) {
+  DCHECK(CalledOnValidThread());
+  if (!result_cache_.get())
+    return;
+  CachedResult result;
+  result.info.Use(info);
+  result.expiration = base::TimeTicks::Now() + result_cache_ttl_;
+  result_cache_->Put(url.spec(), result);
+}
+
 }  // namespace net
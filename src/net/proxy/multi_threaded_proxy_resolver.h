@@ -7,13 +7,17 @@
 #pragma once
 
 #include <deque>
+#include <string>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/mru_cache.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/time.h"
 #include "net/base/net_export.h"
+#include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver.h"
 
 namespace base {
@@ -72,6 +76,12 @@ class ProxyResolverFactory {
 //     a global counter and using that to make a decision. In the
 //     multi-threaded model, each thread may have a different value for this
 //     counter, so it won't globally be seen as monotonically increasing!
+//
+// Optionally, the results of GetProxyForURL() can be cached for a while, so
+// that queries for a URL which was resolved recently complete synchronously,
+// without running the script on a worker thread (see
+// SetResultCacheParams()). As PAC scripts may also depend on DNS and on the
+// time of day, this is disabled by default.
 class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
     : public ProxyResolver,
       NON_EXPORTED_BASE(public base::NonThreadSafe) {
@@ -107,6 +117,13 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
       const scoped_refptr<ProxyResolverScriptData>& script_data,
       const CompletionCallback& callback) OVERRIDE;
 
+  // Caches the successful results of GetProxyForURL() for |ttl|, keyed by
+  // URL. At most |max_entries| results are kept, and the least recently used
+  // one is evicted first. A zero |ttl| or |max_entries| disables the cache,
+  // which is the default. Cached results are dropped whenever the PAC script
+  // changes.
+  void SetResultCacheParams(size_t max_entries, base::TimeDelta ttl);
+
  private:
   class Executor;
   class Job;
@@ -117,6 +134,13 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
   typedef std::deque<scoped_refptr<Job> > PendingJobsQueue;
   typedef std::vector<scoped_refptr<Executor> > ExecutorList;
 
+  // A result of GetProxyForURL(), and when it stops being used.
+  struct CachedResult {
+    ProxyInfo info;
+    base::TimeTicks expiration;
+  };
+  typedef base::MRUCache<std::string, CachedResult> ResultCache;
+
   // Asserts that there are no outstanding user-initiated jobs on any of the
   // worker threads.
   void CheckNoOutstandingUserRequests() const;
@@ -134,11 +158,20 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
   // Starts the next job from |pending_jobs_| if possible.
   void OnExecutorReady(Executor* executor);
 
+  // Adds the result of a GetProxyForURL() job for |url| to |result_cache_|,
+  // if it is enabled.
+  void AddResultToCache(const GURL& url, const ProxyInfo& info);
+
   const scoped_ptr<ProxyResolverFactory> resolver_factory_;
   const size_t max_num_threads_;
   PendingJobsQueue pending_jobs_;
   ExecutorList executors_;
   scoped_refptr<ProxyResolverScriptData> current_script_data_;
+
+  // The recent results of GetProxyForURL(), keyed by URL spec, or NULL if
+  // results aren't cached.
+  scoped_ptr<ResultCache> result_cache_;
+  base::TimeDelta result_cache_ttl_;
 };
 
 }  // namespace net
@@ -615,6 +615,104 @@ TEST(MultiThreadedProxyResolverTest, SingleThread_CancelSetPacScript) {
   EXPECT_FALSE(set_pac_script_callback.have_result());
 }
 
+// Tests that successful results are cached, and that cached results complete
+// synchronously, without reaching the synchronous resolver.
+TEST(MultiThreadedProxyResolverTest, SingleThread_ResultCache) {
+  const size_t kNumThreads = 1u;
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), kNumThreads);
+  resolver.SetResultCacheParams(10, base::TimeDelta::FromHours(1));
+
+  TestCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("pac script bytes"),
+      set_script_callback.callback());
+  EXPECT_EQ(OK, set_script_callback.GetResult(rv));
+
+  // The mock returns OK for its first request only, so only request0 is
+  // cached.
+  TestCompletionCallback callback0;
+  ProxyInfo results0;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results0,
+                               callback0.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0.WaitForResult());
+  EXPECT_EQ("PROXY request0:80", results0.ToPacString());
+
+  TestCompletionCallback callback1;
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(GURL("http://request1"), &results1,
+                               callback1.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1, callback1.WaitForResult());
+  EXPECT_EQ(2, mock->request_count());
+
+  // request0 is now served from the cache.
+  TestCompletionCallback callback2;
+  ProxyInfo results2;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results2,
+                               callback2.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(OK, rv);
+  EXPECT_EQ("PROXY request0:80", results2.ToPacString());
+  EXPECT_FALSE(callback2.have_result());
+  EXPECT_EQ(2, mock->request_count());
+
+  // Other URLs of the same host are not.
+  TestCompletionCallback callback3;
+  ProxyInfo results3;
+  rv = resolver.GetProxyForURL(GURL("http://request0/path"), &results3,
+                               callback3.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(2, callback3.WaitForResult());
+  EXPECT_EQ(3, mock->request_count());
+
+  // Setting a new script drops the cached results.
+  rv = resolver.SetPacScript(ProxyResolverScriptData::FromUTF8("new script"),
+                             set_script_callback.callback());
+  EXPECT_EQ(OK, set_script_callback.GetResult(rv));
+
+  TestCompletionCallback callback4;
+  ProxyInfo results4;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results4,
+                               callback4.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(3, callback4.WaitForResult());
+  EXPECT_EQ("PROXY request0:80", results4.ToPacString());
+  EXPECT_EQ(4, mock->request_count());
+}
+
+// Tests that cached results are not used once they have expired.
+TEST(MultiThreadedProxyResolverTest, SingleThread_ResultCacheExpiration) {
+  const size_t kNumThreads = 1u;
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), kNumThreads);
+  resolver.SetResultCacheParams(10, base::TimeDelta::FromMilliseconds(1));
+
+  TestCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("pac script bytes"),
+      set_script_callback.callback());
+  EXPECT_EQ(OK, set_script_callback.GetResult(rv));
+
+  TestCompletionCallback callback0;
+  ProxyInfo results0;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results0,
+                               callback0.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(OK, callback0.GetResult(rv));
+
+  base::PlatformThread::Sleep(2);
+
+  TestCompletionCallback callback1;
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(GURL("http://request0"), &results1,
+                               callback1.callback(), NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1, callback1.WaitForResult());
+  EXPECT_EQ(2, mock->request_count());
+}
+
 // Tests setting the PAC script once, lazily creating new threads, and
 // cancelling requests.
 TEST(MultiThreadedProxyResolverTest, ThreeThreads_Basic) {
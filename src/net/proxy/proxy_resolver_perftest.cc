@@ -5,11 +5,14 @@
 #include "base/base_paths.h"
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
+#include "base/message_loop.h"
 #include "base/path_service.h"
 #include "base/perftimer.h"
 #include "base/string_util.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/proxy/multi_threaded_proxy_resolver.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
 #include "net/proxy/proxy_resolver_v8.h"
@@ -33,6 +36,18 @@ class MockSyncHostResolver : public net::SyncHostResolver {
   virtual void Shutdown() OVERRIDE {}
 };
 
+// Creates ProxyResolverV8s for MultiThreadedProxyResolver.
+class ProxyResolverV8Factory : public net::ProxyResolverFactory {
+ public:
+  ProxyResolverV8Factory() : net::ProxyResolverFactory(true) {}
+
+  virtual net::ProxyResolver* CreateProxyResolver() OVERRIDE {
+    return new net::ProxyResolverV8(
+        net::ProxyResolverJSBindings::CreateDefault(
+            new MockSyncHostResolver, NULL, NULL));
+  }
+};
+
 // This class holds the URL to use for resolving, and the expected result.
 // We track the expected result in order to make sure the performance
 // test is actually resolving URLs properly, otherwise the perf numbers
@@ -118,10 +133,11 @@ class PacPerfSuiteRunner {
     if (!resolver_->expects_pac_bytes()) {
       GURL pac_url =
           test_server_.GetURL(std::string("files/") + script_name);
+      net::TestCompletionCallback callback;
       int rv = resolver_->SetPacScript(
           net::ProxyResolverScriptData::FromURL(pac_url),
-          net::CompletionCallback());
-      EXPECT_EQ(net::OK, rv);
+          callback.callback());
+      EXPECT_EQ(net::OK, callback.GetResult(rv));
     } else {
       LoadPacScriptIntoResolver(script_name);
     }
@@ -129,36 +145,41 @@ class PacPerfSuiteRunner {
     // Do a query to warm things up. In the case of internal-fetch proxy
     // resolvers, the first resolve will be slow since it has to download
     // the PAC script.
+    net::TestCompletionCallback callback;
     {
       net::ProxyInfo proxy_info;
       int result = resolver_->GetProxyForURL(
-          GURL("http://www.warmup.com"), &proxy_info, net::CompletionCallback(),
+          GURL("http://www.warmup.com"), &proxy_info, callback.callback(),
           NULL, net::BoundNetLog());
-      ASSERT_EQ(net::OK, result);
+      ASSERT_EQ(net::OK, callback.GetResult(result));
     }
 
     // Start the perf timer.
     std::string perf_test_name = resolver_name_ + "_" + script_name;
-    PerfTimeLogger timer(perf_test_name.c_str());
+    PerfTimer timer;
 
     for (int i = 0; i < kNumIterations; ++i) {
       // Round-robin between URLs to resolve.
       const PacQuery& query = queries[i % queries_len];
 
-      // Resolve.
+      // Resolve. Asynchronous resolvers are waited for.
       net::ProxyInfo proxy_info;
       int result = resolver_->GetProxyForURL(
-          GURL(query.query_url), &proxy_info, net::CompletionCallback(), NULL,
+          GURL(query.query_url), &proxy_info, callback.callback(), NULL,
           net::BoundNetLog());
 
       // Check that the result was correct. Note that ToPacString() and
       // ASSERT_EQ() are fast, so they won't skew the results.
-      ASSERT_EQ(net::OK, result);
+      ASSERT_EQ(net::OK, callback.GetResult(result));
       ASSERT_EQ(query.expected_result, proxy_info.ToPacString());
     }
 
-    // Print how long the test ran for.
-    timer.Done();
+    // Print how long the test ran for, and how many lookups it did per
+    // second.
+    base::TimeDelta elapsed = timer.Elapsed();
+    LogPerfResult(perf_test_name.c_str(), elapsed.InMillisecondsF(), "ms");
+    LogPerfResult((perf_test_name + "_rate").c_str(),
+                  kNumIterations / elapsed.InSecondsF(), "lookups/s");
   }
 
   // Read the PAC script from disk and initialize the proxy resolver with it.
@@ -179,10 +200,11 @@ class PacPerfSuiteRunner {
     ASSERT_TRUE(ok);
 
     // Load the PAC script into the ProxyResolver.
+    net::TestCompletionCallback callback;
     int rv = resolver_->SetPacScript(
         net::ProxyResolverScriptData::FromUTF8(file_contents),
-        net::CompletionCallback());
-    EXPECT_EQ(net::OK, rv);
+        callback.callback());
+    EXPECT_EQ(net::OK, callback.GetResult(rv));
   }
 
   net::ProxyResolver* resolver_;
@@ -214,3 +236,20 @@ TEST(ProxyResolverPerfTest, ProxyResolverV8) {
   runner.RunAllTests();
 }
 
+// Runs the PAC script on a worker thread, as ProxyService does.
+TEST(ProxyResolverPerfTest, MultiThreadedProxyResolverV8) {
+  MessageLoop message_loop;
+  net::MultiThreadedProxyResolver resolver(new ProxyResolverV8Factory, 1);
+  PacPerfSuiteRunner runner(&resolver, "MultiThreadedProxyResolverV8");
+  runner.RunAllTests();
+}
+
+// Same as above, but repeated queries are answered from the result cache.
+TEST(ProxyResolverPerfTest, MultiThreadedProxyResolverV8_ResultCache) {
+  MessageLoop message_loop;
+  net::MultiThreadedProxyResolver resolver(new ProxyResolverV8Factory, 1);
+  resolver.SetResultCacheParams(100, base::TimeDelta::FromMinutes(1));
+  PacPerfSuiteRunner runner(&resolver,
+                            "MultiThreadedProxyResolverV8_ResultCache");
+  runner.RunAllTests();
+}
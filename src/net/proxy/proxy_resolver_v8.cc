@@ -9,7 +9,9 @@
 
 #include "base/basictypes.h"
 #include "base/compiler_specific.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/string_tokenizer.h"
 #include "base/string_util.h"
 #include "base/synchronization/lock.h"
@@ -329,6 +331,49 @@ bool IsInNetEx(const std::string& ip_address, const std::string& ip_prefix) {
   return IPNumberMatchesPrefix(address, prefix, prefix_length_in_bits);
 }
 
+// PreparseDataCache keeps the V8 preparse data of the most recently loaded
+// PAC script. MultiThreadedProxyResolver loads the same ProxyResolverScriptData
+// into the ProxyResolverV8 of each of its threads, so all of them but the
+// first can compile the script without preparsing it again.
+class PreparseDataCache {
+ public:
+  PreparseDataCache() {}
+
+  // Returns the preparse data of |script_data|, whose contents are |source|,
+  // or NULL if it could not be preparsed. Must be called with the V8 lock
+  // held. The caller takes ownership of the result.
+  v8::ScriptData* GetPreparseData(
+      const scoped_refptr<ProxyResolverScriptData>& script_data,
+      v8::Handle<v8::String> source) {
+    base::AutoLock auto_lock(lock_);
+    if (script_data_.get() != script_data.get()) {
+      script_data_ = NULL;
+      data_.clear();
+      scoped_ptr<v8::ScriptData> pre_data(v8::ScriptData::PreCompile(source));
+      // Syntax errors are left to the compiler to report.
+      if (!pre_data.get() || pre_data->HasError())
+        return NULL;
+      data_.assign(pre_data->Data(), pre_data->Length());
+      script_data_ = script_data;
+    }
+    return v8::ScriptData::New(data_.data(), static_cast<int>(data_.size()));
+  }
+
+ private:
+  base::Lock lock_;
+
+  // The script which |data_| was preparsed from. Holding a reference keeps
+  // the pointer from being reused by another script.
+  scoped_refptr<ProxyResolverScriptData> script_data_;
+  std::string data_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreparseDataCache);
+};
+
+base::LazyInstance<PreparseDataCache,
+                   base::LeakyLazyInstanceTraits<PreparseDataCache> >
+    g_preparse_data_cache = LAZY_INSTANCE_INITIALIZER;
+
 }  // namespace
 
 // ProxyResolverV8::Context ---------------------------------------------------
@@ -460,14 +505,18 @@ class ProxyResolverV8::Context {
         ASCIILiteralToV8String(
             PROXY_RESOLVER_SCRIPT
             PROXY_RESOLVER_SCRIPT_EX),
-        kPacUtilityResourceName);
+        kPacUtilityResourceName, NULL);
     if (rv != OK) {
       NOTREACHED();
       return rv;
     }
 
-    // Add the user's PAC code to the environment.
-    rv = RunScript(ScriptDataToV8String(pac_script), kPacResourceName);
+    // Add the user's PAC code to the environment. It is compiled with the
+    // preparse data shared by every resolver which loads the same script.
+    v8::Local<v8::String> pac_source = ScriptDataToV8String(pac_script);
+    scoped_ptr<v8::ScriptData> pre_data(
+        g_preparse_data_cache.Get().GetPreparseData(pac_script, pac_source));
+    rv = RunScript(pac_source, kPacResourceName, pre_data.get());
     if (rv != OK)
       return rv;
 
@@ -544,15 +593,18 @@ class ProxyResolverV8::Context {
     js_bindings_->OnError(line_number, error_message);
   }
 
-  // Compiles and runs |script| in the current V8 context.
+  // Compiles and runs |script| in the current V8 context, using its
+  // |pre_data| if not NULL.
   // Returns OK on success, otherwise an error code.
-  int RunScript(v8::Handle<v8::String> script, const char* script_name) {
+  int RunScript(v8::Handle<v8::String> script, const char* script_name,
+                v8::ScriptData* pre_data) {
     v8::TryCatch try_catch;
 
     // Compile the script.
     v8::ScriptOrigin origin =
         v8::ScriptOrigin(ASCIILiteralToV8String(script_name));
-    v8::Local<v8::Script> code = v8::Script::Compile(script, &origin);
+    v8::Local<v8::Script> code =
+        v8::Script::Compile(script, &origin, pre_data);
 
     // Execute.
     if (!code.IsEmpty())
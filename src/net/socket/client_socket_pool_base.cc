@@ -272,6 +272,9 @@ int ClientSocketPoolBaseHelper::RequestSocket(
   } else {
     InsertRequestIntoQueue(request, group->mutable_pending_requests());
   }
+  // Even if the request got a socket, closing disconnected idle sockets may
+  // have freed up slots for the other requests of the group.
+  MaybeAddStalledGroup(group_name);
   return rv;
 }
 
@@ -322,6 +325,8 @@ void ClientSocketPoolBaseHelper::RequestSockets(
 
   if (!deleted_group && group->IsEmpty())
     RemoveGroup(group_name);
+  else
+    MaybeAddStalledGroup(group_name);
 
   if (rv == ERR_IO_PENDING)
     rv = OK;
@@ -393,7 +398,7 @@ int ClientSocketPoolBaseHelper::RequestSocketInternal(
       HandOutSocket(connect_job->ReleaseSocket(), false /* not reused */,
                     handle, base::TimeDelta(), group, request->net_log());
     } else {
-      AddIdleSocket(connect_job->ReleaseSocket(), group);
+      AddIdleSocket(connect_job->ReleaseSocket(), group_name, group);
     }
   } else if (rv == ERR_IO_PENDING) {
     // If we don't have any sockets in this group, set a timer for potentially
@@ -441,6 +446,7 @@ bool ClientSocketPoolBaseHelper::AssignIdleSocketToGroup(
     if (!it->socket->IsConnectedAndIdle()) {
       DecrementIdleCount();
       delete it->socket;
+      it->RemoveFromList();
       it = idle_sockets->erase(it);
       continue;
     }
@@ -478,11 +484,12 @@ bool ClientSocketPoolBaseHelper::AssignIdleSocketToGroup(
     DecrementIdleCount();
     base::TimeDelta idle_time =
         base::TimeTicks::Now() - idle_socket_it->start_time;
-    IdleSocket idle_socket = *idle_socket_it;
+    StreamSocket* socket = idle_socket_it->socket;
+    idle_socket_it->RemoveFromList();
     idle_sockets->erase(idle_socket_it);
     HandOutSocket(
-        idle_socket.socket,
-        idle_socket.socket->WasEverUsed(),
+        socket,
+        socket->WasEverUsed(),
         request->handle(),
         idle_time,
         group,
@@ -532,7 +539,10 @@ void ClientSocketPoolBaseHelper::CancelRequest(
       // We let the job run, unless we're at the socket limit.
       if (group->jobs().size() && ReachedMaxSocketsLimit()) {
         RemoveConnectJob(*group->jobs().begin(), group);
+        MaybeAddStalledGroup(group_name);
         CheckForStalledSocketGroups();
+      } else {
+        MaybeAddStalledGroup(group_name);
       }
       break;
     }
@@ -674,6 +684,7 @@ void ClientSocketPoolBaseHelper::CleanupIdleSockets(bool force) {
   GroupMap::iterator i = group_map_.begin();
   while (i != group_map_.end()) {
     Group* group = i->second;
+    bool closed_socket = false;
 
     std::list<IdleSocket>::iterator j = group->mutable_idle_sockets()->begin();
     while (j != group->idle_sockets().end()) {
@@ -682,8 +693,10 @@ void ClientSocketPoolBaseHelper::CleanupIdleSockets(bool force) {
           used_idle_socket_timeout_ : unused_idle_socket_timeout_;
       if (force || j->ShouldCleanup(now, timeout)) {
         delete j->socket;
+        j->RemoveFromList();
         j = group->mutable_idle_sockets()->erase(j);
         DecrementIdleCount();
+        closed_socket = true;
       } else {
         ++j;
       }
@@ -693,6 +706,8 @@ void ClientSocketPoolBaseHelper::CleanupIdleSockets(bool force) {
     if (group->IsEmpty()) {
       RemoveGroup(i++);
     } else {
+      if (closed_socket)
+        MaybeAddStalledGroup(i->first);
       ++i;
     }
   }
@@ -716,6 +731,10 @@ void ClientSocketPoolBaseHelper::RemoveGroup(const std::string& group_name) {
 }
 
 void ClientSocketPoolBaseHelper::RemoveGroup(GroupMap::iterator it) {
+  for (int priority = HIGHEST; priority < NUM_PRIORITIES; ++priority) {
+    stalled_groups_.erase(std::make_pair(
+        static_cast<RequestPriority>(priority), it->first));
+  }
   delete it->second;
   group_map_.erase(it);
 }
@@ -781,12 +800,13 @@ void ClientSocketPoolBaseHelper::ReleaseSocket(const std::string& group_name,
       id == pool_generation_number_;
   if (can_reuse) {
     // Add it to the idle list.
-    AddIdleSocket(socket, group);
+    AddIdleSocket(socket, group_name, group);
     OnAvailableSocketSlot(group_name, group);
   } else {
     delete socket;
   }
 
+  MaybeAddStalledGroup(group_name);
   CheckForStalledSocketGroups();
 }
 
@@ -816,42 +836,43 @@ void ClientSocketPoolBaseHelper::CheckForStalledSocketGroups() {
 
 // Search for the highest priority pending request, amongst the groups that
 // are not at the |max_sockets_per_group_| limit. Note: for requests with
-// the same priority, the winner is based on group hash ordering (and not
+// the same priority, the winner is based on group name ordering (and not
 // insertion order).
 bool ClientSocketPoolBaseHelper::FindTopStalledGroup(
     Group** group,
     std::string* group_name) const {
   CHECK((group && group_name) || (!group && !group_name));
-  Group* top_group = NULL;
-  const std::string* top_group_name = NULL;
-  bool has_stalled_group = false;
-  for (GroupMap::const_iterator i = group_map_.begin();
-       i != group_map_.end(); ++i) {
-    Group* curr_group = i->second;
-    const RequestQueue& queue = curr_group->pending_requests();
-    if (queue.empty())
+  while (!stalled_groups_.empty()) {
+    StalledGroupSet::iterator top = stalled_groups_.begin();
+    GroupMap::const_iterator i = group_map_.find(top->second);
+    CHECK(i != group_map_.end());
+    Group* top_group = i->second;
+    // Discard the entry if the group isn't stalled anymore, or if it has
+    // another entry for its current top priority.
+    if (!top_group->IsStalled(max_sockets_per_group_) ||
+        top_group->TopPendingPriority() != top->first) {
+      stalled_groups_.erase(top);
       continue;
-    if (curr_group->IsStalled(max_sockets_per_group_)) {
-      if (!group)
-        return true;
-      has_stalled_group = true;
-      bool has_higher_priority = !top_group ||
-          curr_group->TopPendingPriority() < top_group->TopPendingPriority();
-      if (has_higher_priority) {
-        top_group = curr_group;
-        top_group_name = &i->first;
-      }
     }
+    if (group) {
+      *group = top_group;
+      *group_name = i->first;
+    }
+    return true;
   }
+  return false;
+}
 
-  if (top_group) {
-    CHECK(group);
-    *group = top_group;
-    *group_name = *top_group_name;
-  } else {
-    CHECK(!has_stalled_group);
+void ClientSocketPoolBaseHelper::MaybeAddStalledGroup(
+    const std::string& group_name) {
+  GroupMap::const_iterator i = group_map_.find(group_name);
+  if (i == group_map_.end())
+    return;
+  const Group* group = i->second;
+  if (group->IsStalled(max_sockets_per_group_)) {
+    stalled_groups_.insert(
+        std::make_pair(group->TopPendingPriority(), group_name));
   }
-  return has_stalled_group;
 }
 
 void ClientSocketPoolBaseHelper::OnConnectJobComplete(
@@ -878,9 +899,11 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
           base::TimeDelta(), group, r->net_log());
       r->net_log().EndEvent(NetLog::TYPE_SOCKET_POOL, NULL);
       InvokeUserCallbackLater(r->handle(), r->callback(), result);
+      MaybeAddStalledGroup(group_name);
     } else {
-      AddIdleSocket(socket.release(), group);
+      AddIdleSocket(socket.release(), group_name, group);
       OnAvailableSocketSlot(group_name, group);
+      MaybeAddStalledGroup(group_name);
       CheckForStalledSocketGroups();
     }
   } else {
@@ -906,7 +929,10 @@ void ClientSocketPoolBaseHelper::OnConnectJobComplete(
     }
     if (!handed_out_socket) {
       OnAvailableSocketSlot(group_name, group);
+      MaybeAddStalledGroup(group_name);
       CheckForStalledSocketGroups();
+    } else {
+      MaybeAddStalledGroup(group_name);
     }
   }
 }
@@ -925,12 +951,7 @@ void ClientSocketPoolBaseHelper::Flush() {
 bool ClientSocketPoolBaseHelper::IsStalled() const {
   if ((handed_out_socket_count_ + connecting_socket_count_) < max_sockets_)
     return false;
-  for (GroupMap::const_iterator it = group_map_.begin();
-       it != group_map_.end(); it++) {
-    if (it->second->IsStalled(max_sockets_per_group_))
-      return true;
-  }
-  return false;
+  return FindTopStalledGroup(NULL, NULL);
 }
 
 void ClientSocketPoolBaseHelper::RemoveConnectJob(ConnectJob* job,
@@ -973,6 +994,7 @@ void ClientSocketPoolBaseHelper::ProcessPendingRequest(
     request->net_log().EndEventWithNetErrorCode(NetLog::TYPE_SOCKET_POOL, rv);
     InvokeUserCallbackLater(request->handle(), request->callback(), rv);
   }
+  MaybeAddStalledGroup(group_name);
 }
 
 void ClientSocketPoolBaseHelper::HandOutSocket(
@@ -1004,13 +1026,20 @@ void ClientSocketPoolBaseHelper::HandOutSocket(
 }
 
 void ClientSocketPoolBaseHelper::AddIdleSocket(
-    StreamSocket* socket, Group* group) {
+    StreamSocket* socket, const std::string& group_name, Group* group) {
   DCHECK(socket);
+  GroupMap::const_iterator it = group_map_.find(group_name);
+  DCHECK(it != group_map_.end());
+  DCHECK_EQ(group, it->second);
+
   IdleSocket idle_socket;
   idle_socket.socket = socket;
   idle_socket.start_time = base::TimeTicks::Now();
+  idle_socket.group = group;
+  idle_socket.group_name = &it->first;
 
   group->mutable_idle_sockets()->push_back(idle_socket);
+  idle_socket_lru_.Append(&group->mutable_idle_sockets()->back());
   IncrementIdleCount();
 }
 
@@ -1079,21 +1108,29 @@ bool ClientSocketPoolBaseHelper::CloseOneIdleSocketExceptInGroup(
     const Group* exception_group) {
   CHECK_GT(idle_socket_count(), 0);
 
-  for (GroupMap::iterator i = group_map_.begin(); i != group_map_.end(); ++i) {
-    Group* group = i->second;
+  // Close the least recently used idle socket outside of |exception_group|.
+  // Idle sockets are appended to |idle_socket_lru_| and to the list of their
+  // group at the same time, so it's also the oldest socket of its group.
+  for (base::LinkNode<IdleSocket>* node = idle_socket_lru_.head();
+       node != idle_socket_lru_.end(); node = node->next()) {
+    IdleSocket* idle_socket = node->value();
+    Group* group = idle_socket->group;
     if (exception_group == group)
       continue;
     std::list<IdleSocket>* idle_sockets = group->mutable_idle_sockets();
+    DCHECK_EQ(idle_socket, &idle_sockets->front());
 
-    if (!idle_sockets->empty()) {
-      delete idle_sockets->front().socket;
-      idle_sockets->pop_front();
-      DecrementIdleCount();
-      if (group->IsEmpty())
-        RemoveGroup(i);
+    const std::string group_name = *idle_socket->group_name;
+    delete idle_socket->socket;
+    node->RemoveFromList();
+    idle_sockets->pop_front();
+    DecrementIdleCount();
+    if (group->IsEmpty())
+      RemoveGroup(group_name);
+    else
+      MaybeAddStalledGroup(group_name);
 
-      return true;
-    }
+    return true;
   }
 
   return false;
@@ -28,9 +28,11 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/linked_list.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
@@ -347,9 +349,14 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
  private:
   friend class base::RefCounted<ClientSocketPoolBaseHelper>;
 
+  class Group;
+
   // Entry for a persistent socket which became idle at time |start_time|.
-  struct IdleSocket {
-    IdleSocket() : socket(NULL) {}
+  // Besides being in the idle list of its group, every idle socket is linked
+  // into the pool-wide |idle_socket_lru_|, so that the least recently used
+  // idle socket can be closed without scanning the groups.
+  struct IdleSocket : public base::LinkNode<IdleSocket> {
+    IdleSocket() : socket(NULL), group(NULL), group_name(NULL) {}
 
     // An idle socket should be removed if it can't be reused, or has been idle
     // for too long. |now| is the current time value (TimeTicks::Now()).
@@ -363,6 +370,9 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
 
     StreamSocket* socket;
     base::TimeTicks start_time;
+    // The group which owns the socket, and its key in |group_map_|.
+    Group* group;
+    const std::string* group_name;
   };
 
   typedef std::deque<const Request* > RequestQueue;
@@ -445,6 +455,10 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
 
   typedef std::set<ConnectJob*> ConnectJobSet;
 
+  // Groups which may be stalled, keyed by the priority of their top pending
+  // request and then by group name.
+  typedef std::set<std::pair<RequestPriority, std::string> > StalledGroupSet;
+
   struct CallbackResultPair {
     CallbackResultPair() : result(OK) {}
     CallbackResultPair(const CompletionCallback& callback_in, int result_in)
@@ -474,12 +488,17 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
   // Start cleanup timer for idle sockets.
   void StartIdleSocketTimer();
 
-  // Scans the group map for groups which have an available socket slot and
-  // at least one pending request. Returns true if any groups are stalled, and
-  // if so, fills |group| and |group_name| with data of the stalled group
-  // having highest priority.
+  // Looks through |stalled_groups_| for groups which have an available socket
+  // slot and at least one pending request. Returns true if any groups are
+  // stalled, and if so, fills |group| and |group_name| with data of the
+  // stalled group having highest priority.
   bool FindTopStalledGroup(Group** group, std::string* group_name) const;
 
+  // Adds the group named |group_name| to |stalled_groups_| if it exists and is
+  // stalled.  Must be called whenever a group may have become stalled, or the
+  // priority of its top pending request may have changed.
+  void MaybeAddStalledGroup(const std::string& group_name);
+
   // Called when timer_ fires.  This method scans the idle sockets removing
   // sockets that timed out or can't be reused.
   void OnCleanupTimerFired() {
@@ -503,8 +522,11 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
                      Group* group,
                      const BoundNetLog& net_log);
 
-  // Adds |socket| to the list of idle sockets for |group|.
-  void AddIdleSocket(StreamSocket* socket, Group* group);
+  // Adds |socket| to the list of idle sockets for |group|, which is named
+  // |group_name|.
+  void AddIdleSocket(StreamSocket* socket,
+                     const std::string& group_name,
+                     Group* group);
 
   // Iterates through |group_map_|, canceling all ConnectJobs and deleting
   // groups if they are no longer needed.
@@ -553,6 +575,15 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
 
   GroupMap group_map_;
 
+  // All the idle sockets of the pool, from the least to the most recently
+  // used.  The nodes are the entries of the groups' idle socket lists.
+  base::LinkedList<IdleSocket> idle_socket_lru_;
+
+  // Every stalled group has an entry with its current top priority.  Entries
+  // of groups which stopped being stalled, or whose top priority changed, are
+  // only discarded when they are looked at, which may happen in const methods.
+  mutable StalledGroupSet stalled_groups_;
+
   // Map of the ClientSocketHandles for which we have a pending Task to invoke a
   // callback.  This is necessary since, before we invoke said callback, it's
   // possible that the request is cancelled.
@@ -0,0 +1,233 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/client_socket_pool_base.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/test_completion_callback.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/stream_socket.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kMaxSockets = 256;
+const int kMaxSocketsPerGroup = 6;
+// The number of groups waiting for a socket, as with thousands of origins
+// behind a proxy.
+const int kNumStalledGroups = 10000;
+const int kNumIterations = 10000;
+
+class PerfSocketParams : public base::RefCounted<PerfSocketParams> {
+ public:
+  PerfSocketParams() {}
+
+  bool ignore_limits() const { return false; }
+
+ private:
+  friend class base::RefCounted<PerfSocketParams>;
+  ~PerfSocketParams() {}
+};
+typedef ClientSocketPoolBase<PerfSocketParams> PerfClientSocketPoolBase;
+
+// A socket which is connected until it is disconnected, and never reads or
+// writes anything.
+class PerfSocket : public StreamSocket {
+ public:
+  PerfSocket() : connected_(true) {}
+
+  // Socket implementation.
+  virtual int Read(IOBuffer* buf, int buf_len,
+                   const CompletionCallback& callback) OVERRIDE {
+    return ERR_UNEXPECTED;
+  }
+  virtual int Write(IOBuffer* buf, int buf_len,
+                    const CompletionCallback& callback) OVERRIDE {
+    return ERR_UNEXPECTED;
+  }
+  virtual bool SetReceiveBufferSize(int32 size) OVERRIDE { return true; }
+  virtual bool SetSendBufferSize(int32 size) OVERRIDE { return true; }
+
+  // StreamSocket implementation.
+  virtual int Connect(const CompletionCallback& callback) OVERRIDE {
+    connected_ = true;
+    return OK;
+  }
+  virtual void Disconnect() OVERRIDE { connected_ = false; }
+  virtual bool IsConnected() const OVERRIDE { return connected_; }
+  virtual bool IsConnectedAndIdle() const OVERRIDE { return connected_; }
+  virtual int GetPeerAddress(AddressList* address) const OVERRIDE {
+    return ERR_UNEXPECTED;
+  }
+  virtual int GetLocalAddress(IPEndPoint* address) const OVERRIDE {
+    return ERR_UNEXPECTED;
+  }
+  virtual const BoundNetLog& NetLog() const OVERRIDE { return net_log_; }
+  virtual void SetSubresourceSpeculation() OVERRIDE {}
+  virtual void SetOmniboxSpeculation() OVERRIDE {}
+  virtual bool WasEverUsed() const OVERRIDE { return false; }
+  virtual bool UsingTCPFastOpen() const OVERRIDE { return false; }
+  virtual int64 NumBytesRead() const OVERRIDE { return 0; }
+  virtual base::TimeDelta GetConnectTimeMicros() const OVERRIDE {
+    return base::TimeDelta();
+  }
+
+ private:
+  bool connected_;
+  BoundNetLog net_log_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerfSocket);
+};
+
+// Connects a PerfSocket synchronously.
+class PerfConnectJob : public ConnectJob {
+ public:
+  PerfConnectJob(const std::string& group_name, Delegate* delegate)
+      : ConnectJob(group_name, base::TimeDelta(), delegate, BoundNetLog()) {}
+
+  virtual LoadState GetLoadState() const OVERRIDE {
+    return LOAD_STATE_CONNECTING;
+  }
+
+ private:
+  virtual int ConnectInternal() OVERRIDE {
+    set_socket(new PerfSocket());
+    return OK;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(PerfConnectJob);
+};
+
+class PerfConnectJobFactory
+    : public PerfClientSocketPoolBase::ConnectJobFactory {
+ public:
+  PerfConnectJobFactory() {}
+
+  virtual ConnectJob* NewConnectJob(
+      const std::string& group_name,
+      const PerfClientSocketPoolBase::Request& request,
+      ConnectJob::Delegate* delegate) const OVERRIDE {
+    return new PerfConnectJob(group_name, delegate);
+  }
+
+  virtual base::TimeDelta ConnectionTimeout() const OVERRIDE {
+    return base::TimeDelta();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PerfConnectJobFactory);
+};
+
+// Keeps a pool at its socket limit, with |kNumStalledGroups| low priority
+// groups waiting for a socket.  They come first in the group map, which is the
+// worst case for scanning it.
+class ClientSocketPoolBasePerfTest : public testing::Test {
+ protected:
+  ClientSocketPoolBasePerfTest()
+      : params_(new PerfSocketParams()),
+        pool_(kMaxSockets, kMaxSocketsPerGroup, NULL,
+              base::TimeDelta::FromSeconds(10),
+              base::TimeDelta::FromSeconds(300),
+              new PerfConnectJobFactory()),
+        num_groups_(0) {
+  }
+
+  virtual void SetUp() {
+    for (int i = 0; i < kMaxSockets; ++i) {
+      ASSERT_EQ(OK, RequestSocket(NewGroupName("b"), HIGHEST));
+      handed_out_.push_back(i);
+    }
+    for (int i = 0; i < kNumStalledGroups; ++i)
+      ASSERT_EQ(ERR_IO_PENDING, RequestSocket(NewGroupName("a"), LOWEST));
+  }
+
+  virtual void TearDown() {
+    for (int i = kMaxSockets; i < kMaxSockets + kNumStalledGroups; ++i)
+      pool_.CancelRequest(group_names_[i], handles_[i]);
+    while (!handed_out_.empty())
+      ReleaseOldestSocket(false);
+    // Run the callbacks of the requests which got a socket.
+    MessageLoop::current()->RunAllPending();
+  }
+
+  // Requests a socket for a new high priority group, which has to wait for one
+  // as the pool is at its limit, then releases the oldest socket which was
+  // handed out.  The new group gets a socket, after closing the released one
+  // if it was kept alive.
+  void Cycle(bool keep_alive) {
+    size_t index = handles_.size();
+    ASSERT_EQ(ERR_IO_PENDING, RequestSocket(NewGroupName("b"), HIGHEST));
+    ReleaseOldestSocket(keep_alive);
+    ASSERT_TRUE(handles_[index]->socket());
+    handed_out_.push_back(index);
+  }
+
+ private:
+  std::string NewGroupName(const char* prefix) {
+    return base::StringPrintf("%s%05d", prefix, num_groups_++);
+  }
+
+  int RequestSocket(const std::string& group_name, RequestPriority priority) {
+    ClientSocketHandle* handle = new ClientSocketHandle();
+    handles_.push_back(handle);
+    group_names_.push_back(group_name);
+    return pool_.RequestSocket(group_name, params_, priority, handle,
+                               callback_.callback(), BoundNetLog());
+  }
+
+  void ReleaseOldestSocket(bool keep_alive) {
+    size_t index = handed_out_.front();
+    handed_out_.pop_front();
+    StreamSocket* socket = handles_[index]->release_socket();
+    if (!keep_alive)
+      socket->Disconnect();
+    pool_.ReleaseSocket(group_names_[index], socket, handles_[index]->id());
+  }
+
+  MessageLoop message_loop_;
+  scoped_refptr<PerfSocketParams> params_;
+  PerfClientSocketPoolBase pool_;
+  TestCompletionCallback callback_;
+  int num_groups_;
+  ScopedVector<ClientSocketHandle> handles_;
+  std::vector<std::string> group_names_;
+  // Indices of the handles which hold a socket, from the oldest one.
+  std::deque<size_t> handed_out_;
+};
+
+}  // namespace
+
+// Each released socket is closed, and its slot is given to the top stalled
+// group.
+TEST_F(ClientSocketPoolBasePerfTest, WakeUpStalledGroup) {
+  PerfTimeLogger timer("ClientSocketPoolBase_WakeUpStalledGroup");
+  for (int i = 0; i < kNumIterations; ++i)
+    Cycle(false);
+  timer.Done();
+}
+
+// Each released socket is kept alive, so an idle socket has to be closed
+// before the top stalled group can get a socket.
+TEST_F(ClientSocketPoolBasePerfTest, CloseIdleSocketForStalledGroup) {
+  PerfTimeLogger timer("ClientSocketPoolBase_CloseIdleSocketForStalledGroup");
+  for (int i = 0; i < kNumIterations; ++i)
+    Cycle(true);
+  timer.Done();
+}
+
+}  // namespace net
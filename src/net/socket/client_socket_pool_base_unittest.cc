@@ -998,6 +998,43 @@ TEST_F(ClientSocketPoolBaseTest, TotalLimitRespectsGroupLimit) {
   EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(8));
 }
 
+// Make sure that a stalled group is woken up according to the priority of its
+// top request, even if that changed after the group got stalled.
+TEST_F(ClientSocketPoolBaseTest, TotalLimitRespectsChangedPriority) {
+  CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
+
+  EXPECT_EQ(OK, StartRequest("a", LOWEST));
+  EXPECT_EQ(OK, StartRequest("a", LOWEST));
+  EXPECT_EQ(OK, StartRequest("b", LOWEST));
+  EXPECT_EQ(OK, StartRequest("b", LOWEST));
+
+  EXPECT_EQ(static_cast<int>(requests_size()),
+            client_socket_factory_.allocation_count());
+
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("c", LOWEST));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("d", MEDIUM));
+  EXPECT_EQ(ERR_IO_PENDING, StartRequest("c", HIGHEST));
+
+  ReleaseAllConnections(ClientSocketPoolTest::NO_KEEP_ALIVE);
+
+  EXPECT_EQ(requests_size() - kDefaultMaxSockets, completion_count());
+
+  // First 4 requests don't have to wait, and finish in order.
+  EXPECT_EQ(1, GetOrderOfRequest(1));
+  EXPECT_EQ(2, GetOrderOfRequest(2));
+  EXPECT_EQ(3, GetOrderOfRequest(3));
+  EXPECT_EQ(4, GetOrderOfRequest(4));
+
+  // Request ("c", HIGHEST) moved group "c" ahead of group "d", then ("d",
+  // MEDIUM) goes ahead of ("c", LOWEST).
+  EXPECT_EQ(7, GetOrderOfRequest(5));
+  EXPECT_EQ(6, GetOrderOfRequest(6));
+  EXPECT_EQ(5, GetOrderOfRequest(7));
+
+  // Make sure we test order of all requests made.
+  EXPECT_EQ(ClientSocketPoolTest::kIndexOutOfBounds, GetOrderOfRequest(8));
+}
+
 // Make sure that we count connecting sockets against the total limit.
 TEST_F(ClientSocketPoolBaseTest, TotalLimitCountsConnectingSockets) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
@@ -1269,6 +1306,45 @@ TEST_F(ClientSocketPoolBaseTest, CloseIdleSocketAtSocketLimitDeleteGroup) {
   EXPECT_EQ(kDefaultMaxSockets - 1, pool_->IdleSocketCount());
 }
 
+// At the socket limit, the least recently used idle socket should be closed,
+// whichever group it belongs to.
+TEST_F(ClientSocketPoolBaseTest, CloseLeastRecentlyUsedIdleSocketAtLimit) {
+  CreatePool(2, 1);
+  connect_job_factory_->set_job_type(TestConnectJob::kMockJob);
+
+  // Make "b"'s socket idle before "a"'s, even though "a" comes first in the
+  // group map.
+  const char* const kGroups[] = { "b", "a" };
+  for (size_t i = 0; i < arraysize(kGroups); ++i) {
+    ClientSocketHandle handle;
+    TestCompletionCallback callback;
+    EXPECT_EQ(OK, handle.Init(kGroups[i],
+                              params_,
+                              kDefaultPriority,
+                              callback.callback(),
+                              pool_.get(),
+                              BoundNetLog()));
+    handle.Reset();
+    // Flush the DoReleaseSocket task.
+    MessageLoop::current()->RunAllPending();
+  }
+  EXPECT_EQ(2, pool_->IdleSocketCount());
+
+  ClientSocketHandle handle;
+  TestCompletionCallback callback;
+  EXPECT_EQ(OK, handle.Init("c",
+                            params_,
+                            kDefaultPriority,
+                            callback.callback(),
+                            pool_.get(),
+                            BoundNetLog()));
+
+  EXPECT_EQ(3, client_socket_factory_.allocation_count());
+  EXPECT_EQ(1, pool_->IdleSocketCount());
+  EXPECT_FALSE(pool_->HasGroup("b"));
+  EXPECT_EQ(1, pool_->IdleSocketCountInGroup("a"));
+}
+
 TEST_F(ClientSocketPoolBaseTest, PendingRequests) {
   CreatePool(kDefaultMaxSockets, kDefaultMaxSocketsPerGroup);
 
@@ -9,8 +9,7 @@
 namespace spdy {
 
 BufferedSpdyFramer::BufferedSpdyFramer()
-    : header_buffer_used_(0),
-      header_buffer_valid_(false),
+    : header_buffer_valid_(false),
       header_stream_id_(SpdyFramer::kInvalidStream) {
 }
 
@@ -50,7 +49,7 @@ bool BufferedSpdyFramer::OnControlFrameHeaderData(
 
     const linked_ptr<SpdyHeaderBlock> headers(new SpdyHeaderBlock);
     bool parsed_headers = SpdyFramer::ParseHeaderBlockInBuffer(
-        header_buffer_, header_buffer_used_, headers.get());
+        header_buffer_.data(), header_buffer_.size(), headers.get());
     if (!parsed_headers) {
       LOG(WARNING) << "Could not parse Spdy Control Frame Header.";
       return false;
@@ -78,13 +77,12 @@ bool BufferedSpdyFramer::OnControlFrameHeaderData(
     return true;
   }
 
-  const size_t available = kHeaderBufferSize - header_buffer_used_;
+  const size_t available = kHeaderBufferSize - header_buffer_.size();
   if (len > available) {
     header_buffer_valid_ = false;
     return false;
   }
-  memcpy(header_buffer_ + header_buffer_used_, header_data, len);
-  header_buffer_used_ += len;
+  header_buffer_.append(header_data, len);
   return true;
 }
 
@@ -151,8 +149,7 @@ bool BufferedSpdyFramer::IsCompressible(const SpdyFrame& frame) const {
 }
 
 void BufferedSpdyFramer::InitHeaderStreaming(const SpdyControlFrame* frame) {
-  memset(header_buffer_, 0, kHeaderBufferSize);
-  header_buffer_used_ = 0;
+  header_buffer_.clear();
   header_buffer_valid_ = true;
   header_stream_id_ = SpdyFramer::GetControlFrameStreamId(frame);
   DCHECK_NE(header_stream_id_, SpdyFramer::kInvalidStream);
@@ -6,6 +6,8 @@
 #define NET_SPDY_BUFFERED_SPDY_FRAMER_H_
 #pragma once
 
+#include <string>
+
 #include "base/basictypes.h"
 #include "base/gtest_prod_util.h"
 #include "base/memory/linked_ptr.h"
@@ -84,7 +86,7 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer {
   bool IsCompressible(const SpdyFrame& frame) const;
 
  private:
-  // The size of the header_buffer_.
+  // The maximum size of the header_buffer_.
   enum { kHeaderBufferSize = 32 * 1024 };
 
   void InitHeaderStreaming(const SpdyControlFrame* frame);
@@ -93,8 +95,9 @@ class NET_EXPORT_PRIVATE BufferedSpdyFramer {
   BufferedSpdyFramerVisitorInterface* visitor_;
 
   // Header block streaming state:
-  char header_buffer_[kHeaderBufferSize];
-  size_t header_buffer_used_;
+  // Grows with the header block being received, rather than taking the
+  // maximum size up front, so that idle sessions stay small.
+  std::string header_buffer_;
   bool header_buffer_valid_;
   SpdyStreamId header_stream_id_;
 
@@ -81,6 +81,80 @@ void WriteHeaderBlock(SpdyFrameBuilder* frame, const SpdyHeaderBlock* headers) {
   }
 }
 
+namespace {
+
+// Serializes a SpdyHeaderBlock straight into a z_stream, a chunk at a time,
+// so that the uncompressed block is never held in memory as a whole.
+class HeaderBlockDeflater {
+ public:
+  explicit HeaderBlockDeflater(z_stream* compressor)
+      : compressor_(compressor),
+        buffer_used_(0),
+        succeeded_(true) {
+  }
+
+  void WriteUInt16(uint16 value) {
+    value = htons(value);
+    WriteBytes(&value, sizeof(value));
+  }
+
+  void WriteString(const std::string& value) {
+    DCHECK_LE(value.size(), 0xFFFFu);
+    WriteUInt16(static_cast<uint16>(value.size()));
+    WriteBytes(value.data(), value.size());
+  }
+
+  // Compresses what is left in the buffer and flushes the output. Returns
+  // false if any call to deflate() failed, or if the output may not have
+  // fit in the space given to |compressor_|.
+  bool Finish() {
+    Deflate(Z_SYNC_FLUSH);
+    // deflate() may not have finished flushing if it ran out of space.
+    return succeeded_ && compressor_->avail_out > 0;
+  }
+
+ private:
+  void WriteBytes(const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+      size_t bytes_to_copy = std::min(length, sizeof(buffer_) - buffer_used_);
+      memcpy(buffer_ + buffer_used_, bytes, bytes_to_copy);
+      buffer_used_ += bytes_to_copy;
+      bytes += bytes_to_copy;
+      length -= bytes_to_copy;
+      if (buffer_used_ == sizeof(buffer_))
+        Deflate(Z_NO_FLUSH);
+    }
+  }
+
+  void Deflate(int flush) {
+    compressor_->next_in = reinterpret_cast<Bytef*>(buffer_);
+    compressor_->avail_in = buffer_used_;
+    // Make sure that all the data we pass to zlib is defined.
+    // This way, all Valgrind reports on the compressed data are zlib's fault.
+    (void)VALGRIND_CHECK_MEM_IS_DEFINED(compressor_->next_in,
+                                        compressor_->avail_in);
+    int rv = deflate(compressor_, flush);
+    if (rv != Z_OK || compressor_->avail_in != 0) {
+      LOG(WARNING) << "deflate failure: " << rv;
+      succeeded_ = false;
+    }
+    buffer_used_ = 0;
+  }
+
+  // The size of the buffer_ in which the block is serialized.
+  enum { kBufferSize = 1024 };
+
+  z_stream* compressor_;
+  char buffer_[kBufferSize];
+  size_t buffer_used_;
+  bool succeeded_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeaderBlockDeflater);
+};
+
+}  // namespace
+
 // Creates a FlagsAndLength.
 FlagsAndLength CreateFlagsAndLength(SpdyControlFlags flags, size_t length) {
   DCHECK_EQ(0u, length & ~static_cast<size_t>(kLengthMask));
@@ -94,10 +168,9 @@ FlagsAndLength CreateFlagsAndLength(SpdyControlFlags flags, size_t length) {
 // By default is compression on or off.
 bool SpdyFramer::compression_default_ = true;
 
-// The initial size of the control frame buffer; this is used internally
-// as we parse through control frames. (It is exposed here for unit test
-// purposes.)
-size_t SpdyFramer::kControlFrameBufferInitialSize = 32 * 1024;
+// The size of the buffer into which compressed frames are decompressed by
+// DecompressFrame(). (It is exposed here for unit test purposes.)
+size_t SpdyFramer::kDecompressedFrameMaxSize = 32 * 1024;
 
 // The maximum size of the control frame buffer that we support.
 // TODO(mbelshe): We should make this stream-based so there are no limits.
@@ -155,16 +228,15 @@ void SpdyFramer::Reset() {
   remaining_control_payload_ = 0;
   remaining_control_header_ = 0;
   current_frame_len_ = 0;
-  // TODO(hkhalil): Remove once initial_size == kControlFrameBufferInitialSize.
-  size_t initial_size = kControlFrameBufferInitialSize;
-  if (!enable_compression_) {
-    initial_size = kUncompressedControlFrameBufferInitialSize;
-  }
-  if (current_frame_capacity_ != initial_size) {
+  // Header blocks are streamed to the visitor, so the buffer only has to
+  // hold the fixed fields of a control frame. It grows for the few frames
+  // whose whole payload is buffered, and shrinks back after them.
+  if (current_frame_capacity_ !=
+      kControlFrameBufferInitialSize + SpdyFrame::kHeaderSize) {
     delete [] current_frame_buffer_;
     current_frame_buffer_ = 0;
     current_frame_capacity_ = 0;
-    ExpandControlFrameBuffer(initial_size);
+    ExpandControlFrameBuffer(kControlFrameBufferInitialSize);
   }
 }
 
@@ -530,10 +602,6 @@ void SpdyFramer::ProcessControlFrameHeader() {
       break;
     default:
       frame_size_without_header_block = -1;
-      LOG_IF(DFATAL, remaining_control_payload_ + SpdyFrame::kHeaderSize >
-             current_frame_capacity_)
-          << display_protocol_
-          << " control frame buffer too small for fixed-length frame.";
       ExpandControlFrameBuffer(remaining_control_payload_);
       break;
   }
@@ -637,56 +705,6 @@ size_t SpdyFramer::ProcessControlFrameHeaderBlock(const char* data,
   return process_bytes;
 }
 
-size_t SpdyFramer::OldProcessControlFrameHeaderBlock(const char* data,
-                                                     size_t data_len) {
-  DCHECK_EQ(SPDY_CONTROL_FRAME_HEADER_BLOCK, state_);
-  size_t original_data_len = data_len;
-  SpdyControlFrame control_frame(current_frame_buffer_, false);
-  bool read_successfully = true;
-  DCHECK(control_frame.type() == SYN_STREAM ||
-         control_frame.type() == SYN_REPLY ||
-         control_frame.type() == HEADERS);
-
-  if (enable_compression_) {
-    // Note that the header block is held in the frame's payload, and is not
-    // part of the frame's headers.
-    if (remaining_control_payload_ > 0) {
-      size_t bytes_read = UpdateCurrentFrameBuffer(
-          &data,
-          &data_len,
-          remaining_control_payload_);
-      remaining_control_payload_ -= bytes_read;
-      if (remaining_control_payload_ == 0) {
-        read_successfully = OldIncrementallyDecompressControlFrameHeaderData(
-            &control_frame);
-      }
-    }
-  } else {
-    size_t bytes_to_send = std::min(data_len, remaining_control_payload_);
-    DCHECK_GT(bytes_to_send, 0u);
-    read_successfully = IncrementallyDeliverControlFrameHeaderData(
-        &control_frame, data, bytes_to_send);
-    data_len -= bytes_to_send;
-    remaining_control_payload_ -= bytes_to_send;
-  }
-  if (remaining_control_payload_ == 0 && read_successfully) {
-    // The complete header block has been delivered.
-    visitor_->OnControlFrameHeaderData(&control_frame, NULL, 0);
-
-    // If this is a FIN, tell the caller.
-    if (control_frame.flags() & CONTROL_FLAG_FIN) {
-      visitor_->OnStreamFrameData(GetControlFrameStreamId(&control_frame),
-                                  NULL, 0);
-    }
-
-    CHANGE_STATE(SPDY_RESET);
-  }
-  if (!read_successfully) {
-    return original_data_len;
-  }
-  return original_data_len - data_len;
-}
-
 size_t SpdyFramer::ProcessControlFramePayload(const char* data, size_t len) {
   size_t original_len = len;
   if (remaining_control_payload_) {
@@ -959,22 +977,17 @@ SpdySynStreamControlFrame* SpdyFramer::CreateSynStream(
       flags,
       expected_frame_size - SpdyFrame::kHeaderSize);
 
-  SpdyFrameBuilder frame(expected_frame_size);
+  SpdyFrameBuilder frame(SpdySynStreamControlFrame::size() +
+                         GetHeaderBlockBufferSize(headers, compressed));
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(SYN_STREAM);
   frame.WriteBytes(&flags_length, sizeof(flags_length));
   frame.WriteUInt32(stream_id);
   frame.WriteUInt32(associated_stream_id);
   frame.WriteUInt16(ntohs(priority) << 6);  // Priority.
-  WriteHeaderBlock(&frame, headers);
 
-  scoped_ptr<SpdySynStreamControlFrame> syn_frame(
-      reinterpret_cast<SpdySynStreamControlFrame*>(frame.take()));
-  if (compressed) {
-    return reinterpret_cast<SpdySynStreamControlFrame*>(
-        CompressControlFrame(*syn_frame.get()));
-  }
-  return syn_frame.release();
+  return reinterpret_cast<SpdySynStreamControlFrame*>(
+      FinishHeaderBlockFrame(&frame, headers, compressed));
 }
 
 SpdySynReplyControlFrame* SpdyFramer::CreateSynReply(SpdyStreamId stream_id,
@@ -991,21 +1004,16 @@ SpdySynReplyControlFrame* SpdyFramer::CreateSynReply(SpdyStreamId stream_id,
       flags,
       expected_frame_size - SpdyFrame::kHeaderSize);
 
-  SpdyFrameBuilder frame(expected_frame_size);
+  SpdyFrameBuilder frame(SpdySynReplyControlFrame::size() +
+                         GetHeaderBlockBufferSize(headers, compressed));
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(SYN_REPLY);
   frame.WriteBytes(&flags_length, sizeof(flags_length));
   frame.WriteUInt32(stream_id);
   frame.WriteUInt16(0);  // Unused
-  WriteHeaderBlock(&frame, headers);
 
-  scoped_ptr<SpdySynReplyControlFrame> reply_frame(
-      reinterpret_cast<SpdySynReplyControlFrame*>(frame.take()));
-  if (compressed) {
-    return reinterpret_cast<SpdySynReplyControlFrame*>(
-        CompressControlFrame(*reply_frame.get()));
-  }
-  return reply_frame.release();
+  return reinterpret_cast<SpdySynReplyControlFrame*>(
+      FinishHeaderBlockFrame(&frame, headers, compressed));
 }
 
 /* static */
@@ -1094,22 +1102,16 @@ SpdyHeadersControlFrame* SpdyFramer::CreateHeaders(SpdyStreamId stream_id,
       flags,
       expected_frame_size - SpdyFrame::kHeaderSize);
 
-  SpdyFrameBuilder frame(expected_frame_size);
+  SpdyFrameBuilder frame(SpdyHeadersControlFrame::size() +
+                         GetHeaderBlockBufferSize(headers, compressed));
   frame.WriteUInt16(kControlFlagMask | spdy_version_);
   frame.WriteUInt16(HEADERS);
   frame.WriteBytes(&flags_length, sizeof(flags_length));
   frame.WriteUInt32(stream_id);
   frame.WriteUInt16(0);  // Unused
-  WriteHeaderBlock(&frame, headers);
-  DCHECK_EQ(static_cast<size_t>(frame.length()), expected_frame_size);
 
-  scoped_ptr<SpdyHeadersControlFrame> headers_frame(
-      reinterpret_cast<SpdyHeadersControlFrame*>(frame.take()));
-  if (compressed) {
-    return reinterpret_cast<SpdyHeadersControlFrame*>(
-        CompressControlFrame(*headers_frame.get()));
-  }
-  return headers_frame.release();
+  return reinterpret_cast<SpdyHeadersControlFrame*>(
+      FinishHeaderBlockFrame(&frame, headers, compressed));
 }
 
 /* static */
@@ -1491,6 +1493,71 @@ SpdyFrame* SpdyFramer::CompressFrameWithZStream(const SpdyFrame& frame,
   return new_frame.release();
 }
 
+size_t SpdyFramer::GetHeaderBlockBufferSize(const SpdyHeaderBlock* headers,
+                                            bool compressed) {
+  size_t serialized_length = GetSerializedLength(headers);
+  if (!compressed || !enable_compression_)
+    return serialized_length;
+  z_stream* compressor = GetHeaderCompressor();
+  if (!compressor)
+    return 0;
+  return deflateBound(compressor, serialized_length);
+}
+
+SpdyControlFrame* SpdyFramer::FinishHeaderBlockFrame(
+    SpdyFrameBuilder* frame,
+    const SpdyHeaderBlock* headers,
+    bool compressed) {
+  if (!compressed || !enable_compression_) {
+    WriteHeaderBlock(frame, headers);
+    return reinterpret_cast<SpdyControlFrame*>(frame->take());
+  }
+
+  z_stream* compressor = GetHeaderCompressor();
+  if (!compressor)
+    return NULL;
+
+  base::StatsCounter compressed_frames("spdy.CompressedFrames");
+  base::StatsCounter pre_compress_bytes("spdy.PreCompressSize");
+  base::StatsCounter post_compress_bytes("spdy.PostCompressSize");
+
+  size_t header_length = frame->length();
+  size_t payload_length = GetSerializedLength(headers);
+  size_t compressed_max_size = deflateBound(compressor, payload_length);
+  scoped_ptr<SpdyControlFrame> new_frame(
+      reinterpret_cast<SpdyControlFrame*>(frame->take()));
+
+  compressor->next_out = reinterpret_cast<Bytef*>(new_frame->data()) +
+                         header_length;
+  compressor->avail_out = compressed_max_size;
+  HeaderBlockDeflater deflater(compressor);
+  deflater.WriteUInt16(headers->size());  // Number of headers.
+  SpdyHeaderBlock::const_iterator it;
+  for (it = headers->begin(); it != headers->end(); ++it) {
+    deflater.WriteString(it->first);
+    deflater.WriteString(it->second);
+  }
+  if (!deflater.Finish())
+    return NULL;
+
+  size_t compressed_size = compressed_max_size - compressor->avail_out;
+
+  // We trust zlib. Also, we can't do anything about it.
+  // See http://www.zlib.net/zlib_faq.html#faq36
+  (void)VALGRIND_MAKE_MEM_DEFINED(new_frame->data() + header_length,
+                                  compressed_size);
+
+  new_frame->set_length(
+      header_length + compressed_size - SpdyFrame::kHeaderSize);
+
+  pre_compress_bytes.Add(payload_length);
+  post_compress_bytes.Add(new_frame->length());
+
+  compressed_frames.Increment();
+
+  return new_frame.release();
+}
+
 SpdyFrame* SpdyFramer::DecompressFrameWithZStream(const SpdyFrame& frame,
                                                   z_stream* decompressor) {
   int payload_length;
@@ -1516,7 +1583,7 @@ SpdyFrame* SpdyFramer::DecompressFrameWithZStream(const SpdyFrame& frame,
 
   // Create an output frame.  Assume it does not need to be longer than
   // the input data.
-  size_t decompressed_max_size = kControlFrameBufferInitialSize;
+  size_t decompressed_max_size = kDecompressedFrameMaxSize;
   int new_frame_size = header_length + decompressed_max_size;
   if (frame.length() > decompressed_max_size)
     return NULL;
@@ -1570,55 +1637,6 @@ SpdyFrame* SpdyFramer::DecompressFrameWithZStream(const SpdyFrame& frame,
   return new_frame.release();
 }
 
-// Incrementally decompress the control frame's header block, feeding the
-// result to the visitor in chunks. Continue this until the visitor
-// indicates that it cannot process any more data, or (more commonly) we
-// run out of data to deliver.
-bool SpdyFramer::OldIncrementallyDecompressControlFrameHeaderData(
-    const SpdyControlFrame* control_frame) {
-  z_stream* decomp = GetHeaderDecompressor();
-  int payload_length;
-  int header_length;
-  const char* payload;
-  bool read_successfully = true;
-  bool more = true;
-  char buffer[kHeaderDataChunkMaxSize];
-
-  if (!GetFrameBoundaries(
-      *control_frame, &payload_length, &header_length, &payload)) {
-    DLOG(ERROR) << "Control frame of type "
-                << SpdyFramer::ControlTypeToString(control_frame->type())
-                <<" doesn't have headers";
-    return false;
-  }
-  decomp->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
-  decomp->avail_in = payload_length;
-  const SpdyStreamId stream_id = GetControlFrameStreamId(control_frame);
-  DCHECK_LT(0u, stream_id);
-  while (more && read_successfully) {
-    decomp->next_out = reinterpret_cast<Bytef*>(buffer);
-    decomp->avail_out = arraysize(buffer);
-    int rv = DecompressHeaderBlockInZStream(decomp);
-    if (rv != Z_OK) {
-      set_error(SPDY_DECOMPRESS_FAILURE);
-      DLOG(WARNING) << "inflate failure: " << rv;
-      more = read_successfully = false;
-    } else {
-      DCHECK_GT(arraysize(buffer), decomp->avail_out);
-      size_t len = arraysize(buffer) - decomp->avail_out;
-      read_successfully = visitor_->OnControlFrameHeaderData(
-          control_frame, buffer, len);
-      if (!read_successfully) {
-        // Assume that the problem was the header block was too large for the
-        // visitor.
-        set_error(SPDY_CONTROL_PAYLOAD_TOO_LARGE);
-      }
-      more = decomp->avail_in > 0;
-    }
-  }
-  return read_successfully;
-}
-
 // Incrementally decompress the control frame's header block, feeding the
 // result to the visitor in chunks. Continue this until the visitor
 // indicates that it cannot process any more data, or (more commonly) we
@@ -37,6 +37,7 @@ class WebSocketJobTest;
 namespace spdy {
 
 class SpdyFramer;
+class SpdyFrameBuilder;
 class SpdyFramerTest;
 
 namespace test {
@@ -412,7 +413,6 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   size_t ProcessCredentialFramePayload(const char* data, size_t len);
   size_t ProcessControlFrameBeforeHeaderBlock(const char* data, size_t len);
   size_t ProcessControlFrameHeaderBlock(const char* data, size_t len);
-  size_t OldProcessControlFrameHeaderBlock(const char* data, size_t len);
   size_t ProcessDataFramePayload(const char* data, size_t len);
 
   // Get (and lazily initialize) the ZLib state.
@@ -430,6 +430,22 @@ class NET_EXPORT_PRIVATE SpdyFramer {
                                       z_stream* compressor);
   SpdyFrame* DecompressFrameWithZStream(const SpdyFrame& frame,
                                         z_stream* decompressor);
+
+  // Returns the space that |headers| take in a SYN_STREAM, SYN_REPLY or
+  // HEADERS frame: their serialized length, or if |compressed|, the most
+  // that the header compressor can turn them into.
+  size_t GetHeaderBlockBufferSize(const SpdyHeaderBlock* headers,
+                                  bool compressed);
+
+  // Appends |headers| to the fixed fields of a SYN_STREAM, SYN_REPLY or
+  // HEADERS frame written in |frame|, and returns the frame. If |compressed|,
+  // the header block is compressed straight into the frame, which must have
+  // been created with room for GetHeaderBlockBufferSize(headers, true) more
+  // bytes. Returns NULL on failure.
+  SpdyControlFrame* FinishHeaderBlockFrame(SpdyFrameBuilder* frame,
+                                           const SpdyHeaderBlock* headers,
+                                           bool compressed);
+
   void CleanupCompressorForStream(SpdyStreamId id);
   void CleanupDecompressorForStream(SpdyStreamId id);
   void CleanupStreamCompressorsAndDecompressors();
@@ -437,12 +453,6 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   // Not used (yet)
   size_t BytesSafeToRead() const;
 
-  // Deliver the given control frame's compressed headers block to the visitor
-  // in decompressed form, in chunks. Returns true if the visitor has
-  // accepted all of the chunks.
-  bool OldIncrementallyDecompressControlFrameHeaderData(
-      const SpdyControlFrame* frame);
-
   // Deliver the given control frame's compressed headers block to the visitor
   // in decompressed form, in chunks. Returns true if the visitor has
   // accepted all of the chunks.
@@ -482,24 +492,15 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   int num_stream_decompressors() const { return stream_decompressors_.size(); }
 
   // The initial size of the control frame buffer; this is used internally
-  // as we parse through control frames. (It is exposed here for unit test
-  // purposes.)
-  // This is only used when compression is enabled; otherwise,
-  // kUncompressedControlFrameBufferInitialSize is used.
-  static size_t kControlFrameBufferInitialSize;
-
-  // The initial size of the control frame buffer when compression is disabled.
-  // This exists because we don't do stream (de)compressed control frame data to
-  // our visitor; we instead buffer the entirety of the control frame and then
-  // decompress in one fell swoop.
-  // Since this is only used for control frame headers, the maximum control
-  // frame header size (18B) is sufficient; all remaining control frame data is
-  // streamed to the visitor.
-  // In addition to the maximum control frame header size, we account for any
-  // LOAS checksumming (16B) that may occur in the VTL case.
-  // TODO(hkhalil): Remove post code-yellow once streamed inflate is properly
-  // implemented.
-  static const size_t kUncompressedControlFrameBufferInitialSize = 18 + 16;
+  // as we parse through control frames. Header blocks are streamed to the
+  // visitor, so this only needs to hold the largest fixed-size part of a
+  // control frame (18B), plus any LOAS checksumming (16B) that may occur in
+  // the VTL case. The buffer is expanded for frames which are buffered whole.
+  static const size_t kControlFrameBufferInitialSize = 18 + 16;
+
+  // The size of the buffer into which DecompressFrame() inflates frames.
+  // (It is exposed here for unit test purposes.)
+  static size_t kDecompressedFrameMaxSize;
 
   // The maximum size of the control frame buffer that we support.
   // TODO(mbelshe): We should make this stream-based so there are no limits.
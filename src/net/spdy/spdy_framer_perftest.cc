@@ -0,0 +1,180 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/compiler_specific.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "build/build_config.h"
+#include "net/spdy/buffered_spdy_framer.h"
+#include "net/spdy/spdy_framer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX)
+#include <malloc.h>
+#endif
+
+namespace spdy {
+
+namespace {
+
+const int kNumSessions = 1000;
+const int kNumFrames = 20000;
+
+// Returns the number of bytes allocated from the heap, or 0 if unknown.
+size_t GetAllocatedBytes() {
+#if defined(OS_LINUX)
+  return mallinfo().uordblks;
+#else
+  return 0;
+#endif
+}
+
+void GetRequestHeaders(SpdyHeaderBlock* headers) {
+  (*headers)["method"] = "GET";
+  (*headers)["url"] = "http://www.example.com/search?q=spdy&hl=en";
+  (*headers)["version"] = "HTTP/1.1";
+  (*headers)["host"] = "www.example.com";
+  (*headers)["user-agent"] =
+      "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/535.7 (KHTML, like Gecko) "
+      "Chrome/16.0.912.41 Safari/535.7";
+  (*headers)["accept"] =
+      "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8";
+  (*headers)["accept-encoding"] = "gzip,deflate,sdch";
+  (*headers)["accept-language"] = "en-US,en;q=0.8";
+  (*headers)["cookie"] = "PREF=ID=4f5d2a7c1b3e9f08:FF=0:TM=1321344751; "
+                         "NID=54=Vb6yQm2HkD0sLp9rXc3fNw7tJ1aZe5uGo8iKq4TnWd2";
+}
+
+void GetResponseHeaders(SpdyHeaderBlock* headers) {
+  (*headers)["status"] = "200 OK";
+  (*headers)["version"] = "HTTP/1.1";
+  (*headers)["date"] = "Tue, 15 Nov 2011 08:12:31 GMT";
+  (*headers)["cache-control"] = "private, max-age=0";
+  (*headers)["content-type"] = "text/html; charset=UTF-8";
+  (*headers)["server"] = "gws";
+}
+
+// The framing state of one client session: a BufferedSpdyFramer, and a
+// visitor which passes it the header blocks, as SpdySession does.
+class SessionFramer : public BufferedSpdyFramerVisitorInterface {
+ public:
+  SessionFramer() : syn_reply_count_(0) {
+    framer_.set_visitor(this);
+  }
+
+  BufferedSpdyFramer* framer() { return &framer_; }
+  int syn_reply_count() const { return syn_reply_count_; }
+
+  virtual void OnError(SpdyFramer* framer) OVERRIDE {
+    ADD_FAILURE() << SpdyFramer::ErrorCodeToString(framer->error_code());
+  }
+
+  virtual void OnControl(const SpdyControlFrame* frame) OVERRIDE {
+    framer_.OnControl(frame);
+  }
+
+  virtual bool OnControlFrameHeaderData(const SpdyControlFrame* control_frame,
+                                        const char* header_data,
+                                        size_t len) OVERRIDE {
+    return framer_.OnControlFrameHeaderData(control_frame, header_data, len);
+  }
+
+  virtual bool OnCredentialFrameData(const char* frame_data,
+                                     size_t len) OVERRIDE {
+    return false;
+  }
+
+  virtual void OnDataFrameHeader(const SpdyDataFrame* frame) OVERRIDE {}
+
+  virtual void OnStreamFrameData(SpdyStreamId stream_id,
+                                 const char* data,
+                                 size_t len) OVERRIDE {}
+
+  virtual void OnSyn(const SpdySynStreamControlFrame& frame,
+                     const linked_ptr<SpdyHeaderBlock>& headers) OVERRIDE {}
+
+  virtual void OnSynReply(const SpdySynReplyControlFrame& frame,
+                          const linked_ptr<SpdyHeaderBlock>& headers) OVERRIDE {
+    syn_reply_count_++;
+  }
+
+  virtual void OnHeaders(const SpdyHeadersControlFrame& frame,
+                         const linked_ptr<SpdyHeaderBlock>& headers) OVERRIDE {
+  }
+
+ private:
+  BufferedSpdyFramer framer_;
+  int syn_reply_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(SessionFramer);
+};
+
+}  // namespace
+
+// Measures the memory that the framing state of a session takes once it has
+// sent a request and received a reply, which is when all of the header
+// compression state exists.
+TEST(SpdyFramerPerfTest, MemoryPerSession) {
+  SpdyHeaderBlock request_headers;
+  GetRequestHeaders(&request_headers);
+  SpdyHeaderBlock response_headers;
+  GetResponseHeaders(&response_headers);
+
+  // The first frame of a peer only depends on the compression dictionary, so
+  // every session can read the same reply.
+  SpdyFramer server_framer;
+  scoped_ptr<SpdySynReplyControlFrame> reply(server_framer.CreateSynReply(
+      1, CONTROL_FLAG_NONE, true, &response_headers));
+  ASSERT_TRUE(reply.get() != NULL);
+
+  ScopedVector<SessionFramer> sessions;
+  size_t before = GetAllocatedBytes();
+  PerfTimer timer;
+  for (int i = 0; i < kNumSessions; ++i) {
+    SessionFramer* session = new SessionFramer;
+    sessions.push_back(session);
+    scoped_ptr<SpdySynStreamControlFrame> request(
+        session->framer()->CreateSynStream(1, 0, 1, CONTROL_FLAG_FIN, true,
+                                           &request_headers));
+    ASSERT_TRUE(request.get() != NULL);
+    size_t reply_size = reply->length() + SpdyFrame::kHeaderSize;
+    ASSERT_EQ(reply_size,
+              session->framer()->ProcessInput(reply->data(), reply_size));
+    ASSERT_EQ(1, session->syn_reply_count());
+  }
+  base::TimeDelta elapsed = timer.Elapsed();
+  size_t after = GetAllocatedBytes();
+
+  if (before || after) {
+    LogPerfResult("Spdy_session_memory",
+                  static_cast<double>(after - before) / kNumSessions,
+                  "bytes");
+  }
+  LogPerfResult("Spdy_session_setup",
+                elapsed.InMillisecondsF() * 1000 / kNumSessions, "us");
+}
+
+// Measures compressing the header blocks of requests on one session.
+TEST(SpdyFramerPerfTest, CreateCompressedSynStream) {
+  SpdyHeaderBlock headers;
+  GetRequestHeaders(&headers);
+  SpdyFramer framer;
+  size_t compressed_bytes = 0;
+  PerfTimer timer;
+  for (int i = 0; i < kNumFrames; ++i) {
+    scoped_ptr<SpdySynStreamControlFrame> frame(framer.CreateSynStream(
+        2 * i + 1, 0, 1, CONTROL_FLAG_FIN, true, &headers));
+    ASSERT_TRUE(frame.get() != NULL);
+    compressed_bytes += frame->length();
+  }
+  LogPerfResult("Spdy_compressed_syn_stream",
+                kNumFrames / timer.Elapsed().InSecondsF(), "frames/s");
+  LogPerfResult("Spdy_compressed_syn_stream_size",
+                static_cast<double>(compressed_bytes) / kNumFrames, "bytes");
+}
+
+}  // namespace spdy
@@ -658,6 +658,43 @@ TEST_F(SpdyFramerTest, BasicCompression) {
       SpdyFrame::kHeaderSize + uncompressed_frame->length()));
 }
 
+// Header blocks are compressed as they are serialized, in chunks. Check that
+// this gives the same frames as compressing the serialized block at once,
+// including for blocks larger than a chunk and across frames.
+TEST_F(SpdyFramerTest, CompressHeaderBlockInChunks) {
+  SpdyHeaderBlock headers;
+  headers["method"] = "GET";
+  headers["url"] = "http://www.example.com/" + std::string(3000, 'p');
+  headers["cookie"] = std::string(1021, 'c');
+  headers["version"] = "HTTP/1.1";
+
+  SpdyFramer framer;
+  SpdyFramer reference_framer;
+  framer.set_enable_compression(true);
+  reference_framer.set_enable_compression(true);
+  for (SpdyStreamId stream_id = 1; stream_id < 7; stream_id += 2) {
+    scoped_ptr<SpdySynStreamControlFrame> frame(framer.CreateSynStream(
+        stream_id, 0, 1, CONTROL_FLAG_NONE, true, &headers));
+    scoped_ptr<SpdySynStreamControlFrame> uncompressed_frame(
+        reference_framer.CreateSynStream(
+            stream_id, 0, 1, CONTROL_FLAG_NONE, false, &headers));
+    scoped_ptr<SpdyFrame> reference_frame(
+        reference_framer.CompressFrame(*uncompressed_frame));
+    ASSERT_TRUE(frame.get() != NULL);
+    ASSERT_TRUE(reference_frame.get() != NULL);
+    EXPECT_LT(frame->length(), uncompressed_frame->length());
+    ASSERT_EQ(reference_frame->length(), frame->length());
+    EXPECT_EQ(0, memcmp(reference_frame->data(), frame->data(),
+                        SpdyFrame::kHeaderSize + frame->length()));
+
+    SpdyHeaderBlock parsed_headers;
+    EXPECT_TRUE(reference_framer.ParseHeaderBlock(frame.get(),
+                                                  &parsed_headers));
+    EXPECT_TRUE(parsed_headers == headers);
+    headers["cookie"] += "c";
+  }
+}
+
 TEST_F(SpdyFramerTest, DecompressUncompressedFrame) {
   SpdyHeaderBlock headers;
   headers["server"] = "SpdyServer 1.0";
@@ -1726,8 +1763,8 @@ TEST_F(SpdyFramerTest, DuplicateFrame) {
 TEST_F(SpdyFramerTest, ExpandBuffer_HeapSmash) {
   // Sweep through the area of problematic values, to make sure we always cover
   // the danger zone, even if it moves around at bit due to SPDY changes.
-  for (uint16 val2_len = SpdyFramer::kControlFrameBufferInitialSize - 50;
-       val2_len < SpdyFramer::kControlFrameBufferInitialSize;
+  for (uint16 val2_len = SpdyFramer::kDecompressedFrameMaxSize - 50;
+       val2_len < SpdyFramer::kDecompressedFrameMaxSize;
        val2_len++) {
     std::string val2 = std::string(val2_len, 'a');
     SpdyHeaderBlock headers;
@@ -2024,7 +2061,7 @@ TEST_F(SpdyFramerTest, DISABLED_HugeHeaderBlock) {
   SpdyFramer compress_framer;
   SpdyFramer decompress_framer;
   for (size_t target_size = 1024;
-       target_size < SpdyFramer::kControlFrameBufferInitialSize;
+       target_size < SpdyFramer::kDecompressedFrameMaxSize;
        target_size += 1024) {
     SpdyHeaderBlock headers;
     for (size_t index = 0; index < target_size; ++index) {
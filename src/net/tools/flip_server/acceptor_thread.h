@@ -46,7 +46,12 @@ class SMAcceptorThread : public base::SimpleThread,
                          public EpollCallbackInterface,
                          public SMConnectionPoolInterface {
  public:
-  SMAcceptorThread(FlipAcceptor *acceptor, MemoryCache* memory_cache);
+  // Accepts connections for |acceptor| from |listen_fd|, which may be shared
+  // with other threads. If |cpu| isn't -1, the thread only runs on that CPU.
+  SMAcceptorThread(FlipAcceptor *acceptor,
+                   MemoryCache* memory_cache,
+                   int listen_fd,
+                   int cpu);
   virtual ~SMAcceptorThread();
 
   // EpollCallbackInteface interface
@@ -80,9 +85,14 @@ class SMAcceptorThread : public base::SimpleThread,
  private:
   EpollServer epoll_server_;
   FlipAcceptor* acceptor_;
+  int listen_fd_;
+  int cpu_;
   SSLState* ssl_state_;
   bool use_ssl_;
   int idle_socket_timeout_s_;
+  // The least recent of the last read times of the active connections, as
+  // last computed by HandleConnectionIdleTimeout().
+  time_t oldest_read_time_;
 
   std::vector<SMConnection*> unused_server_connections_;
   std::vector<SMConnection*> tmp_unused_server_connections_;
@@ -42,6 +42,12 @@ class FlipAcceptor {
                void *memory_cache);
   ~FlipAcceptor();
 
+  // Returns the socket on which acceptor thread |thread_index| listens. With
+  // SO_REUSEPORT, each thread after the first gets a socket of its own bound
+  // to the same address, and the kernel spreads new connections across them.
+  // Otherwise all of the threads accept from listen_fd_.
+  int GetListenFDForThread(int thread_index);
+
   enum FlipHandlerType flip_handler_type_;
   std::string listen_ip_;
   std::string listen_port_;
@@ -60,6 +66,14 @@ class FlipAcceptor {
   int ssl_session_expiry_;
   bool ssl_disable_compression_;
   int idle_socket_timeout_s_;
+
+ private:
+  // Creates a non-blocking socket listening on listen_ip_:listen_port_, or
+  // returns -1.
+  int CreateListener();
+
+  bool reuseport_;
+  bool wait_for_iface_;
 };
 
 class FlipConfig {
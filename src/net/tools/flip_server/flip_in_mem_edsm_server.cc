@@ -14,6 +14,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "base/timer.h"
 #include "net/tools/flip_server/acceptor_thread.h"
 #include "net/tools/flip_server/constants.h"
@@ -46,6 +47,18 @@ int32 FLAGS_accept_backlog_size = 1024;
 //  SO_REUSEPORT);
 bool FLAGS_reuseport = false;
 
+// The number of threads which accept and serve the connections of each
+//  acceptor. Each thread runs its own EpollServer.
+int32 FLAGS_acceptor_threads = 1;
+
+// If true, then each acceptor thread only runs on one CPU, the threads being
+//  spread across the CPUs in turn.
+bool FLAGS_cpu_affinity = false;
+
+// If true, then the files of the memory caches are mapped rather than read,
+//  and their bodies are sent to non-SSL HTTP clients without being copied.
+bool FLAGS_mmap_cache = false;
+
 // Flag to force spdy, even if NPN is not negotiated.
 bool FLAGS_force_spdy = false;
 
@@ -204,6 +217,18 @@ int main (int argc, char**argv)
     cout << "\t--ssl-session-expiry=<seconds> (default is 300)\n";
     cout << "\t--ssl-disable-compression\n";
     cout << "\t--idle-timeout=<seconds> (default is 300)\n";
+    cout << "\t--threads=<n> (default is 1)\n";
+    cout << "\t  * The number of threads which accept and serve the"
+         << " connections of\n"
+         << "\t    each proxy and server.\n";
+    cout << "\t--reuseport\n";
+    cout << "\t  * Gives each thread a listening socket of its own, with"
+         << " SO_REUSEPORT.\n";
+    cout << "\t--cpu-affinity\n";
+    cout << "\t  * Runs each thread on a CPU of its own, in turn.\n";
+    cout << "\t--mmap-cache\n";
+    cout << "\t  * Maps the cached files rather than reading them into"
+         << " memory.\n";
     cout << "\t--pidfile=<filepath> (default /var/run/flip-server.pid)\n";
     cout << "\t--help\n";
     exit(0);
@@ -269,6 +294,21 @@ int main (int argc, char**argv)
       atoi(cl.GetSwitchValueASCII("idle-timeout").c_str());
   }
 
+  if (cl.HasSwitch("threads")) {
+    FLAGS_acceptor_threads = atoi(cl.GetSwitchValueASCII("threads").c_str());
+    if (FLAGS_acceptor_threads < 1)
+      LOG(FATAL) << "Invalid number of threads: " << FLAGS_acceptor_threads;
+  }
+
+  if (cl.HasSwitch("reuseport"))
+    FLAGS_reuseport = true;
+
+  if (cl.HasSwitch("cpu-affinity"))
+    FLAGS_cpu_affinity = true;
+
+  if (cl.HasSwitch("mmap-cache"))
+    FLAGS_mmap_cache = true;
+
   if (cl.HasSwitch("force_spdy"))
     net::SMConnection::set_force_spdy(true);
 
@@ -291,6 +331,11 @@ int main (int argc, char**argv)
             << (FLAGS_disable_nagle?"true":"false");
   LOG(INFO) << "Reuseport               : "
             << (FLAGS_reuseport?"true":"false");
+  LOG(INFO) << "Threads per acceptor    : " << FLAGS_acceptor_threads;
+  LOG(INFO) << "CPU affinity            : "
+            << (FLAGS_cpu_affinity?"true":"false");
+  LOG(INFO) << "Map cached files        : "
+            << (FLAGS_mmap_cache?"true":"false");
   LOG(INFO) << "Force SPDY              : "
             << (FLAGS_force_spdy?"true":"false");
   LOG(INFO) << "SSL session expiry      : "
@@ -331,6 +376,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache spdy_memory_cache;
   if (cl.HasSwitch("spdy-server")) {
+    spdy_memory_cache.set_map_files(FLAGS_mmap_cache);
     spdy_memory_cache.AddFiles();
     std::string value = cl.GetSwitchValueASCII("spdy-server");
     std::vector<std::string> valueArgs = split(value, ',');
@@ -352,6 +398,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache http_memory_cache;
   if (cl.HasSwitch("http-server")) {
+    http_memory_cache.set_map_files(FLAGS_mmap_cache);
     http_memory_cache.AddFiles();
     std::string value = cl.GetSwitchValueASCII("http-server");
     std::vector<std::string> valueArgs = split(value, ',');
@@ -372,22 +419,28 @@ int main (int argc, char**argv)
 
   std::vector<net::SMAcceptorThread*> sm_worker_threads_;
 
+  int num_cpus = base::SysInfo::NumberOfProcessors();
   for (i = 0; i < g_proxy_config.acceptors_.size(); i++) {
     net::FlipAcceptor *acceptor = g_proxy_config.acceptors_[i];
 
-    sm_worker_threads_.push_back(
-        new net::SMAcceptorThread(acceptor,
-                                  (net::MemoryCache *)acceptor->memory_cache_));
-    // Note that spdy_memory_cache is not threadsafe, it is merely
-    // thread compatible. Thus, if ever we are to spawn multiple threads,
-    // we either must make the MemoryCache threadsafe, or use
-    // a separate MemoryCache for each thread.
-    //
-    // The latter is what is currently being done as we spawn
-    // a separate thread for each http and spdy server acceptor.
-
-    sm_worker_threads_.back()->InitWorker();
-    sm_worker_threads_.back()->Start();
+    for (int thread_index = 0; thread_index < FLAGS_acceptor_threads;
+         ++thread_index) {
+      int listen_fd = acceptor->GetListenFDForThread(thread_index);
+      if (listen_fd == -1)
+        LOG(FATAL) << "Unable to listen for acceptor thread " << thread_index;
+      int cpu = -1;
+      if (FLAGS_cpu_affinity)
+        cpu = sm_worker_threads_.size() % num_cpus;
+      // The MemoryCache is only read once its files are added, so the
+      // threads of an acceptor share it.
+      sm_worker_threads_.push_back(
+          new net::SMAcceptorThread(acceptor,
+                                    (net::MemoryCache *)acceptor->memory_cache_,
+                                    listen_fd,
+                                    cpu));
+      sm_worker_threads_.back()->InitWorker();
+      sm_worker_threads_.back()->Start();
+    }
   }
 
   while (!wantExit) {
@@ -0,0 +1,336 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A load generator for the flip server. It keeps a number of HTTP/1.1
+// keep-alive connections busy with GET requests, one request at a time on
+// each connection, and reports the rate of the requests and the percentiles
+// of their latencies.
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "net/tools/flip_server/balsa_frame.h"
+#include "net/tools/flip_server/balsa_headers.h"
+#include "net/tools/flip_server/create_listener.h"
+#include "net/tools/flip_server/epoll_server.h"
+
+using std::cout;
+
+namespace {
+
+// The host and port of the server.
+std::string FLAGS_host = "127.0.0.1";
+std::string FLAGS_port = "10040";
+
+// The path which is requested, and the Host header of the requests.
+std::string FLAGS_path = "/";
+std::string FLAGS_host_header = "www.example.com";
+
+// The number of threads, each of which runs its own EpollServer.
+int FLAGS_threads = 1;
+
+// The number of connections of each thread.
+int FLAGS_connections = 10;
+
+// How long requests are sent for, in seconds.
+int FLAGS_duration_s = 10;
+
+const int kReadBufferSize = 16 * 1024;
+
+class LoadThread;
+
+// One keep-alive connection, which sends the next request as soon as the
+// response to the previous one has been read.
+class LoadConnection : public net::EpollCallbackInterface {
+ public:
+  explicit LoadConnection(LoadThread* thread);
+  virtual ~LoadConnection();
+
+  // Connects to the server, and sends the first request once connected.
+  // Returns false if the connection can't be started.
+  bool Connect();
+
+  // EpollCallbackInterface:
+  virtual void OnRegistration(net::EpollServer* eps,
+                              int fd,
+                              int event_mask) OVERRIDE {}
+  virtual void OnModification(int fd, int event_mask) OVERRIDE {}
+  virtual void OnEvent(int fd, net::EpollEvent* event) OVERRIDE;
+  virtual void OnUnregistration(int fd, bool replaced) OVERRIDE {}
+  virtual void OnShutdown(net::EpollServer* eps, int fd) OVERRIDE {}
+
+ private:
+  void SendRequest();
+  void DoWrite();
+  void DoRead();
+  void Close();
+
+  LoadThread* thread_;
+  int fd_;
+  bool connected_;
+  std::string write_buffer_;
+  size_t bytes_written_;
+  net::BalsaHeaders headers_;
+  net::BalsaFrame frame_;
+  int64 request_start_us_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadConnection);
+};
+
+// Runs the connections of one thread, and records the latencies of their
+// requests.
+class LoadThread : public base::SimpleThread {
+ public:
+  explicit LoadThread(int64 end_time_us)
+      : base::SimpleThread("LoadThread"),
+        end_time_us_(end_time_us),
+        errors_(0) {
+  }
+
+  net::EpollServer* epoll_server() { return &epoll_server_; }
+  const std::vector<int64>& latencies_us() const { return latencies_us_; }
+  int errors() const { return errors_; }
+  bool done() const { return epoll_server_.NowInUsec() >= end_time_us_; }
+
+  void RecordResponse(int64 latency_us) { latencies_us_.push_back(latency_us); }
+  void RecordError() { errors_++; }
+
+  // SimpleThread:
+  virtual void Run() OVERRIDE {
+    for (int i = 0; i < FLAGS_connections; ++i) {
+      LoadConnection* connection = new LoadConnection(this);
+      connections_.push_back(connection);
+      if (!connection->Connect())
+        RecordError();
+    }
+    epoll_server_.set_timeout_in_us(10 * 1000);
+    while (!done())
+      epoll_server_.WaitForEventsAndExecuteCallbacks();
+    // The connections unregister themselves from the EpollServer, so they
+    // must go first.
+    connections_.reset();
+  }
+
+ private:
+  net::EpollServer epoll_server_;
+  ScopedVector<LoadConnection> connections_;
+  int64 end_time_us_;
+  std::vector<int64> latencies_us_;
+  int errors_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadThread);
+};
+
+LoadConnection::LoadConnection(LoadThread* thread)
+    : thread_(thread),
+      fd_(-1),
+      connected_(false),
+      bytes_written_(0),
+      request_start_us_(0) {
+  frame_.set_balsa_headers(&headers_);
+  frame_.set_is_request(false);
+}
+
+LoadConnection::~LoadConnection() {
+  Close();
+}
+
+bool LoadConnection::Connect() {
+  if (net::CreateConnectedSocket(&fd_, FLAGS_host, FLAGS_port, true,
+                                 true) < 0) {
+    return false;
+  }
+  connected_ = false;
+  thread_->epoll_server()->RegisterFD(fd_, this,
+                                      EPOLLIN | EPOLLOUT | EPOLLET);
+  SendRequest();
+  return true;
+}
+
+void LoadConnection::OnEvent(int fd, net::EpollEvent* event) {
+  if (event->in_events & (EPOLLHUP | EPOLLERR)) {
+    thread_->RecordError();
+    Close();
+    if (!thread_->done())
+      Connect();
+    return;
+  }
+  if (event->in_events & EPOLLOUT) {
+    connected_ = true;
+    DoWrite();
+  }
+  if (fd_ != -1 && (event->in_events & EPOLLIN))
+    DoRead();
+}
+
+void LoadConnection::SendRequest() {
+  write_buffer_ = base::StringPrintf(
+      "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+      FLAGS_path.c_str(), FLAGS_host_header.c_str());
+  bytes_written_ = 0;
+  frame_.Reset();
+  request_start_us_ = thread_->epoll_server()->NowInUsec();
+  if (connected_)
+    DoWrite();
+}
+
+void LoadConnection::DoWrite() {
+  while (bytes_written_ < write_buffer_.size()) {
+    ssize_t rv = write(fd_, write_buffer_.data() + bytes_written_,
+                       write_buffer_.size() - bytes_written_);
+    if (rv < 0) {
+      if (errno != EAGAIN && errno != EINTR) {
+        thread_->RecordError();
+        Close();
+      }
+      return;
+    }
+    bytes_written_ += rv;
+  }
+}
+
+void LoadConnection::DoRead() {
+  char buffer[kReadBufferSize];
+  while (true) {
+    ssize_t rv = read(fd_, buffer, sizeof(buffer));
+    if (rv < 0 && (errno == EAGAIN || errno == EINTR))
+      return;
+    if (rv <= 0) {
+      // The server closed the connection, which only counts as an error when
+      // a response was expected.
+      if (rv < 0 || bytes_written_ > 0)
+        thread_->RecordError();
+      Close();
+      if (!thread_->done())
+        Connect();
+      return;
+    }
+    const char* data = buffer;
+    size_t size = rv;
+    while (size > 0) {
+      size_t consumed = frame_.ProcessInput(data, size);
+      data += consumed;
+      size -= consumed;
+      if (frame_.Error()) {
+        thread_->RecordError();
+        Close();
+        return;
+      }
+      if (!frame_.MessageFullyRead()) {
+        if (consumed == 0)
+          break;
+        continue;
+      }
+      thread_->RecordResponse(
+          thread_->epoll_server()->NowInUsec() - request_start_us_);
+      if (thread_->done()) {
+        Close();
+        return;
+      }
+      SendRequest();
+    }
+  }
+}
+
+void LoadConnection::Close() {
+  if (fd_ == -1)
+    return;
+  thread_->epoll_server()->UnregisterFD(fd_);
+  close(fd_);
+  fd_ = -1;
+  bytes_written_ = 0;
+}
+
+// Returns the latency below which |percentile| percent of |latencies_us|,
+// which is sorted, are.
+int64 GetPercentile(const std::vector<int64>& latencies_us, int percentile) {
+  if (latencies_us.empty())
+    return 0;
+  size_t index = latencies_us.size() * percentile / 100;
+  return latencies_us[std::min(index, latencies_us.size() - 1)];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  CommandLine::Init(argc, argv);
+  CommandLine cl(argc, argv);
+
+  if (cl.HasSwitch("help") || argc < 2) {
+    cout << argv[0] << " <options>\n";
+    cout << "  Sends HTTP/1.1 requests to a flip server, and reports their"
+         << " rate and latency.\n\n";
+    cout << "\t--host=<ip> (default is 127.0.0.1)\n";
+    cout << "\t--port=<port> (default is 10040)\n";
+    cout << "\t--path=<path> (default is /)\n";
+    cout << "\t--host-header=<host> (default is www.example.com)\n";
+    cout << "\t--threads=<n> (default is 1)\n";
+    cout << "\t--connections=<n> (per thread, default is 10)\n";
+    cout << "\t--duration=<seconds> (default is 10)\n";
+    return 0;
+  }
+
+  if (cl.HasSwitch("host"))
+    FLAGS_host = cl.GetSwitchValueASCII("host");
+  if (cl.HasSwitch("port"))
+    FLAGS_port = cl.GetSwitchValueASCII("port");
+  if (cl.HasSwitch("path"))
+    FLAGS_path = cl.GetSwitchValueASCII("path");
+  if (cl.HasSwitch("host-header"))
+    FLAGS_host_header = cl.GetSwitchValueASCII("host-header");
+  if (cl.HasSwitch("threads"))
+    FLAGS_threads = atoi(cl.GetSwitchValueASCII("threads").c_str());
+  if (cl.HasSwitch("connections"))
+    FLAGS_connections = atoi(cl.GetSwitchValueASCII("connections").c_str());
+  if (cl.HasSwitch("duration"))
+    FLAGS_duration_s = atoi(cl.GetSwitchValueASCII("duration").c_str());
+  if (FLAGS_threads < 1 || FLAGS_connections < 1 || FLAGS_duration_s < 1)
+    LOG(FATAL) << "The threads, connections and duration must be positive.";
+
+  net::EpollServer clock;
+  int64 start_us = clock.NowInUsec();
+  int64 end_time_us = start_us + FLAGS_duration_s * 1000000LL;
+
+  ScopedVector<LoadThread> threads;
+  for (int i = 0; i < FLAGS_threads; ++i) {
+    LoadThread* thread = new LoadThread(end_time_us);
+    threads.push_back(thread);
+    thread->Start();
+  }
+
+  std::vector<int64> latencies_us;
+  int errors = 0;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Join();
+    latencies_us.insert(latencies_us.end(),
+                        threads[i]->latencies_us().begin(),
+                        threads[i]->latencies_us().end());
+    errors += threads[i]->errors();
+  }
+  double elapsed_s = (clock.NowInUsec() - start_us) / 1000000.0;
+  std::sort(latencies_us.begin(), latencies_us.end());
+
+  cout << "Requests     : " << latencies_us.size() << "\n";
+  cout << "Errors       : " << errors << "\n";
+  cout << "Requests/s   : " << latencies_us.size() / elapsed_s << "\n";
+  cout << "p50 latency  : " << GetPercentile(latencies_us, 50) << " us\n";
+  cout << "p99 latency  : " << GetPercentile(latencies_us, 99) << " us\n";
+  return 0;
+}
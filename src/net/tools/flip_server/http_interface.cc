@@ -317,6 +317,27 @@ void HttpSM::SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
   EnqueueDataFrame(df);
 }
 
+void HttpSM::SendFileBodyImpl(FileBody* body, size_t offset, size_t len) {
+  char chunk_buf[128];
+  snprintf(chunk_buf, sizeof(chunk_buf), "%x\r\n", (unsigned int)len);
+  size_t chunk_description_size = strlen(chunk_buf);
+  DataFrame* df = new DataFrame;
+  df->size = chunk_description_size;
+  char* buffer = new char[df->size];
+  df->data = buffer;
+  df->delete_when_done = true;
+  memcpy(buffer, chunk_buf, chunk_description_size);
+  EnqueueDataFrame(df);
+
+  EnqueueDataFrame(new FileBodyDataFrame(body, offset, len));
+
+  df = new DataFrame;
+  df->data = "\r\n";
+  df->size = 2;
+  df->delete_when_done = false;
+  EnqueueDataFrame(df);
+}
+
 void HttpSM::EnqueueDataFrame(DataFrame* df) {
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: Enqueue data frame: stream "
           << stream_id_;
@@ -338,7 +359,7 @@ void HttpSM::GetOutput() {
             << "header stream_id: [" << mci->stream_id << "]";
     return;
   }
-  if (mci->body_bytes_consumed >= mci->file_data->body.size()) {
+  if (mci->body_bytes_consumed >= mci->file_data->body->size()) {
     SendEOF(mci->stream_id);
     output_ordering_.RemoveStreamId(mci->stream_id);
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "GetOutput remove_stream_id: ["
@@ -346,13 +367,18 @@ void HttpSM::GetOutput() {
     return;
   }
   size_t num_to_write =
-    mci->file_data->body.size() - mci->body_bytes_consumed;
+    mci->file_data->body->size() - mci->body_bytes_consumed;
   if (num_to_write > mci->max_segment_size)
     num_to_write = mci->max_segment_size;
-
-  SendDataFrame(mci->stream_id,
-                mci->file_data->body.data() + mci->body_bytes_consumed,
-                num_to_write, 0, true);
+  if (!connection_->uses_ssl()) {
+    // Without SSL the chunk is sent straight from the cache.
+    SendFileBodyImpl(mci->file_data->body, mci->body_bytes_consumed,
+                     num_to_write);
+  } else {
+    SendDataFrame(mci->stream_id,
+                  mci->file_data->body->data() + mci->body_bytes_consumed,
+                  num_to_write, 0, true);
+  }
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput SendDataFrame["
           << mci->stream_id << "]: " << num_to_write;
   mci->body_bytes_consumed += num_to_write;
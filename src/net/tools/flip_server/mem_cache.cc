@@ -8,8 +8,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <deque>
 
@@ -24,8 +26,23 @@ std::string FLAGS_cache_base_dir = ".";
 
 namespace net {
 
+StoreBodyAndHeadersVisitor::StoreBodyAndHeadersVisitor()
+    : body_input_begin(NULL),
+      body_input_end(NULL),
+      error_(false) {
+}
+
 void StoreBodyAndHeadersVisitor::ProcessBodyData(const char *input,
                                                  size_t size) {
+  if (body.empty()) {
+    body_input_begin = input;
+    body_input_end = input + size;
+  } else if (body_input_begin && input == body_input_end) {
+    body_input_end += size;
+  } else {
+    body_input_begin = NULL;
+    body_input_end = NULL;
+  }
   body.append(input, size);
 }
 
@@ -45,7 +62,30 @@ void StoreBodyAndHeadersVisitor::HandleBodyError(BalsaFrame* framer) {
   HandleError();
 }
 
-FileData::FileData(BalsaHeaders* h, const std::string& b)
+FileBody::FileBody(const std::string& body)
+    : copy_(body),
+      mapping_(NULL),
+      mapping_size_(0),
+      data_(copy_.data()),
+      size_(copy_.size()) {
+}
+
+FileBody::FileBody(void* mapping,
+                   size_t mapping_size,
+                   const char* data,
+                   size_t size)
+    : mapping_(mapping),
+      mapping_size_(mapping_size),
+      data_(data),
+      size_(size) {
+}
+
+FileBody::~FileBody() {
+  if (mapping_)
+    munmap(mapping_, mapping_size_);
+}
+
+FileData::FileData(BalsaHeaders* h, FileBody* b)
     : headers(h), body(b) {
 }
 
@@ -61,7 +101,7 @@ void FileData::CopyFrom(const FileData& file_data) {
     body = file_data.body;
   }
 
-MemoryCache::MemoryCache() {}
+MemoryCache::MemoryCache() : map_files_(false) {}
 
 MemoryCache::~MemoryCache() {}
 
@@ -119,6 +159,17 @@ void MemoryCache::AddFiles() {
       }
     }
   }
+
+  size_t copied_bytes = 0;
+  size_t mapped_bytes = 0;
+  for (Files::const_iterator i = files_.begin(); i != files_.end(); ++i) {
+    if (i->second.body->is_mapped())
+      mapped_bytes += i->second.body->size();
+    else
+      copied_bytes += i->second.body->size();
+  }
+  LOG(INFO) << "Cached " << files_.size() << " files: " << copied_bytes
+            << " body bytes in memory, " << mapped_bytes << " mapped";
 }
 
 void MemoryCache::ReadToString(const char* filename, std::string* output) {
@@ -137,42 +188,85 @@ void MemoryCache::ReadToString(const char* filename, std::string* output) {
   close(fd);
 }
 
+char* MemoryCache::MapFile(const char* filename, size_t* size) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+  struct stat file_stat;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    *size = file_stat.st_size;
+    // The mapping is writable so that the status line can be patched below;
+    // only the page which is written to is copied.
+    mapping = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED)
+    return NULL;
+  return static_cast<char*>(mapping);
+}
+
 void MemoryCache::ReadAndStoreFileContents(const char* filename) {
   StoreBodyAndHeadersVisitor visitor;
   BalsaFrame framer;
   framer.set_balsa_visitor(&visitor);
   framer.set_balsa_headers(&(visitor.headers));
   std::string filename_contents;
-  ReadToString(filename, &filename_contents);
+  size_t contents_size = 0;
+  char* mapping = NULL;
+  if (map_files_)
+    mapping = MapFile(filename, &contents_size);
+  if (!mapping) {
+    ReadToString(filename, &filename_contents);
+    contents_size = filename_contents.size();
+  }
+  char* contents = mapping ? mapping : &filename_contents[0];
 
   // Ugly hack to make everything look like 1.1.
-  if (filename_contents.find("HTTP/1.0") == 0)
-    filename_contents[7] = '1';
+  if (base::StringPiece(contents, contents_size).starts_with("HTTP/1.0"))
+    contents[7] = '1';
 
   size_t pos = 0;
   size_t old_pos = 0;
   while (true) {
     old_pos = pos;
-    pos += framer.ProcessInput(filename_contents.data() + pos,
-                               filename_contents.size() - pos);
+    pos += framer.ProcessInput(contents + pos, contents_size - pos);
     if (framer.Error() || pos == old_pos) {
       LOG(ERROR) << "Unable to make forward progress, or error"
         " framing file: " << filename;
       if (framer.Error()) {
         LOG(INFO) << "********************************************ERROR!";
-        return;
       }
+      if (mapping)
+        munmap(mapping, contents_size);
       return;
     }
     if (framer.MessageFullyRead()) {
       // If no Content-Length or Transfer-Encoding was captured in the
       // file, then the rest of the data is the body.  Many of the captures
       // from within Chrome don't have content-lengths.
-      if (!visitor.body.length())
-        visitor.body = filename_contents.substr(pos);
+      if (!visitor.body.length()) {
+        visitor.body.assign(contents + pos, contents_size - pos);
+        visitor.body_input_begin = contents + pos;
+        visitor.body_input_end = contents + contents_size;
+      }
       break;
     }
   }
+
+  // A body which is one range of the mapping is sent from there. Others,
+  // such as chunked ones, have to be decoded, so they are copied.
+  FileBody* body = NULL;
+  if (mapping) {
+    if (visitor.body_input_begin) {
+      body = new FileBody(mapping, contents_size, visitor.body_input_begin,
+                          visitor.body_input_end - visitor.body_input_begin);
+    } else {
+      munmap(mapping, contents_size);
+    }
+  }
+  if (!body)
+    body = new FileBody(visitor.body);
   visitor.headers.RemoveAllOfHeader("content-length");
   visitor.headers.RemoveAllOfHeader("transfer-encoding");
   visitor.headers.RemoveAllOfHeader("connection");
@@ -194,11 +288,12 @@ void MemoryCache::ReadAndStoreFileContents(const char* filename) {
   BalsaHeaders* headers = new BalsaHeaders;
   headers->CopyFrom(visitor.headers);
   std::string filename_stripped = std::string(filename).substr(cwd_.size() + 1);
-  LOG(INFO) << "Adding file (" << visitor.body.length() << " bytes): "
+  LOG(INFO) << "Adding file (" << body->size() << " bytes"
+            << (body->is_mapped() ? ", mapped" : "") << "): "
             << filename_stripped;
   files_[filename_stripped] = FileData();
   FileData& fd = files_[filename_stripped];
-  fd = FileData(headers, visitor.body);
+  fd = FileData(headers, body);
   fd.filename = std::string(filename_stripped,
                             filename_stripped.find_first_of('/'));
 }
@@ -9,7 +9,9 @@
 #include <string>
 #include <vector>
 
+#include "base/basictypes.h"
 #include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
 #include "net/tools/flip_server/balsa_headers.h"
 #include "net/tools/flip_server/balsa_visitor_interface.h"
 #include "net/tools/flip_server/constants.h"
@@ -18,6 +20,8 @@ namespace net {
 
 class StoreBodyAndHeadersVisitor: public BalsaVisitorInterface {
  public:
+  StoreBodyAndHeadersVisitor();
+
   void HandleError() { error_ = true; }
 
   // BalsaVisitorInterface:
@@ -57,14 +61,47 @@ class StoreBodyAndHeadersVisitor: public BalsaVisitorInterface {
 
   BalsaHeaders headers;
   std::string body;
+  // The input which |body| was read from, while it is one contiguous range;
+  // NULL once it isn't, such as when the body is chunked.
+  const char* body_input_begin;
+  const char* body_input_end;
   bool error_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The body of a cached file, which is shared by the FileData and by the
+// frames which are sending it. It is either a copy of the body, or a range of
+// a private mapping of the file.
+class FileBody : public base::RefCountedThreadSafe<FileBody> {
+ public:
+  explicit FileBody(const std::string& body);
+  // Takes ownership of the |mapping_size| bytes mapped at |mapping|, of which
+  // |size| bytes from |data| are the body.
+  FileBody(void* mapping, size_t mapping_size, const char* data, size_t size);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_mapped() const { return mapping_ != NULL; }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileBody>;
+  ~FileBody();
+
+  std::string copy_;
+  void* mapping_;
+  size_t mapping_size_;
+  const char* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileBody);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct FileData {
   FileData();
-  FileData(BalsaHeaders* h, const std::string& b);
+  FileData(BalsaHeaders* h, FileBody* b);
   ~FileData();
   void CopyFrom(const FileData& file_data);
 
@@ -72,7 +109,7 @@ struct FileData {
   std::string filename;
   // priority, filename
   std::vector< std::pair<int, std::string> > related_files;
-  std::string body;
+  scoped_refptr<FileBody> body;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -106,6 +143,8 @@ class MemCacheIter {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The files are only read once AddFiles() has returned, so one MemoryCache
+// can be shared by the threads which serve them.
 class MemoryCache {
  public:
   typedef std::map<std::string, FileData> Files;
@@ -120,14 +159,23 @@ class MemoryCache {
 
   void ReadToString(const char* filename, std::string* output);
 
+  // Returns the contents of |filename| mapped privately, or NULL if it can't
+  // be mapped. |size| is set to the size of the mapping.
+  char* MapFile(const char* filename, size_t* size);
+
   void ReadAndStoreFileContents(const char* filename);
 
   FileData* GetFileData(const std::string& filename);
 
   bool AssignFileData(const std::string& filename, MemCacheIter* mci);
 
+  // If true, then the files added afterwards are mapped rather than read,
+  // and their bodies are sent from the mappings.
+  void set_map_files(bool map_files) { map_files_ = map_files; }
+
   Files files_;
   std::string cwd_;
+  bool map_files_;
 };
 
 class NotifierInterface {
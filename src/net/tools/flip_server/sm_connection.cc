@@ -7,7 +7,9 @@
 #include <errno.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <list>
 #include <string>
 
@@ -20,6 +22,14 @@
 
 namespace net {
 
+namespace {
+
+// Frames sent together with sendmsg() when there is no SSL. Enough for the
+// chunk header, body and chunk end of about twenty segments.
+const size_t kMaxFramesPerSend = 64;
+
+}  // namespace
+
 // static
 bool SMConnection::force_spdy_ = false;
 
@@ -28,6 +38,17 @@ DataFrame::~DataFrame() {
     delete[] data;
 }
 
+FileBodyDataFrame::FileBodyDataFrame(FileBody* body,
+                                     size_t offset,
+                                     size_t size)
+    : body_(body) {
+  DCHECK_LE(offset + size, body->size());
+  data = body->data() + offset;
+  this->size = size;
+}
+
+FileBodyDataFrame::~FileBodyDataFrame() {}
+
 SMConnection::SMConnection(EpollServer* epoll_server,
                            SSLState* ssl_state,
                            MemoryCache* memory_cache,
@@ -224,6 +245,33 @@ int SMConnection::Send(const char* data, int len, int flags) {
   return rv;
 }
 
+int SMConnection::SendOutputList(int flags) {
+  struct iovec iov[kMaxFramesPerSend];
+  size_t num_frames = 0;
+  OutputList::iterator i = output_list_.begin();
+  for (; i != output_list_.end() && num_frames < kMaxFramesPerSend; ++i) {
+    DataFrame* data_frame = *i;
+    if (data_frame->index >= data_frame->size)
+      continue;
+    iov[num_frames].iov_base =
+        const_cast<char*>(data_frame->data + data_frame->index);
+    iov[num_frames].iov_len = data_frame->size - data_frame->index;
+    ++num_frames;
+  }
+  if (i == output_list_.end())
+    flags &= ~MSG_MORE;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = num_frames;
+  CorkSocket();
+  int rv = sendmsg(fd_, &msg, flags);
+  if (!(flags & MSG_MORE))
+    UncorkSocket();
+  return rv;
+}
+
 void SMConnection::OnRegistration(EpollServer* eps, int fd, int event_mask) {
   registered_in_epoll_server_ = true;
 }
@@ -553,6 +601,13 @@ bool SMConnection::DoWrite() {
     }
     if (sm_interface_ && output_list_.size() < 2) {
       sm_interface_->GetOutput();
+      // Without SSL the frames are sent together, so queue a few segments.
+      while (!ssl_ && output_list_.size() < kMaxFramesPerSend) {
+        size_t num_frames = output_list_.size();
+        sm_interface_->GetOutput();
+        if (output_list_.size() == num_frames)
+          break;
+      }
     }
     DataFrame* data_frame = output_list_.front();
     const char*  bytes = data_frame->data;
@@ -575,7 +630,11 @@ bool SMConnection::DoWrite() {
       flags |= MSG_MORE;
     }
     VLOG(2) << log_prefix_ << "Attempting to send " << size << " bytes.";
-    ssize_t bytes_written = Send(bytes, size, flags);
+    ssize_t bytes_written;
+    if (ssl_)
+      bytes_written = Send(bytes, size, flags);
+    else
+      bytes_written = SendOutputList(flags);
     int stored_errno = errno;
     if (bytes_written == -1) {
       switch (stored_errno) {
@@ -597,8 +656,16 @@ bool SMConnection::DoWrite() {
     } else if (bytes_written > 0) {
       VLOG(2) << log_prefix_ << ACCEPTOR_CLIENT_IDENT << "Wrote: "
               << bytes_written << " bytes";
-      data_frame->index += bytes_written;
       bytes_sent += bytes_written;
+      // Without SSL, the bytes may be from several frames. The frames which
+      // were completely sent are removed at the top of the loop.
+      for (OutputList::iterator i = output_list_.begin();
+           bytes_written > 0; ++i) {
+        size_t frame_bytes = std::min(static_cast<size_t>(bytes_written),
+                                      (*i)->size - (*i)->index);
+        (*i)->index += frame_bytes;
+        bytes_written -= frame_bytes;
+      }
       continue;
     } else if (bytes_written == -2) {
       // -2 handles SSL_ERROR_WANT_* errors
@@ -36,6 +36,17 @@ class DataFrame {
   virtual ~DataFrame();
 };
 
+// A frame which sends part of a cached body without copying it, and keeps
+// the body alive until it has been sent.
+class FileBodyDataFrame : public DataFrame {
+ public:
+  FileBodyDataFrame(FileBody* body, size_t offset, size_t size);
+  virtual ~FileBodyDataFrame();
+
+ private:
+  scoped_refptr<FileBody> body_;
+};
+
 typedef std::list<DataFrame*> OutputList;
 
 class SMConnection : public SMConnectionInterface,
@@ -63,6 +74,7 @@ class SMConnection : public SMConnectionInterface,
 
   int fd() const { return fd_; }
   bool initialized() const { return initialized_; }
+  bool uses_ssl() const { return ssl_ != NULL; }
   std::string client_ip() const { return client_ip_; }
 
   void InitSMConnection(SMConnectionPoolInterface* connection_pool,
@@ -79,6 +91,10 @@ class SMConnection : public SMConnectionInterface,
 
   int Send(const char* data, int len, int flags);
 
+  // Sends as many of the frames at the front of the output list as fit in
+  // one call. Only used without SSL.
+  int SendOutputList(int flags);
+
   // EpollCallbackInterface interface.
   virtual void OnRegistration(EpollServer* eps,
                               int fd,
@@ -4,7 +4,12 @@
 
 #include "net/tools/flip_server/spdy_ssl.h"
 
+#include <vector>
+
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/platform_thread.h"
+#include "openssl/crypto.h"
 #include "openssl/err.h"
 #include "openssl/ssl.h"
 
@@ -23,6 +28,37 @@ int ssl_set_npn_callback(SSL *s,
   return SSL_TLSEXT_ERR_OK;
 }
 
+namespace {
+
+// The locks which OpenSSL needs when the acceptor threads use it at the same
+// time. They are never freed.
+std::vector<base::Lock*>* g_ssl_locks = NULL;
+
+void SSLLockingCallback(int mode, int n, const char* file, int line) {
+  if (mode & CRYPTO_LOCK)
+    (*g_ssl_locks)[n]->Acquire();
+  else
+    (*g_ssl_locks)[n]->Release();
+}
+
+unsigned long SSLThreadIdCallback() {
+  return static_cast<unsigned long>(base::PlatformThread::CurrentId());
+}
+
+// Gives OpenSSL its locks, unless it already has them. Called on the main
+// thread, before any acceptor thread is started.
+void InitSSLLocking() {
+  if (CRYPTO_get_locking_callback())
+    return;
+  g_ssl_locks = new std::vector<base::Lock*>(CRYPTO_num_locks());
+  for (size_t i = 0; i < g_ssl_locks->size(); ++i)
+    (*g_ssl_locks)[i] = new base::Lock;
+  CRYPTO_set_id_callback(SSLThreadIdCallback);
+  CRYPTO_set_locking_callback(SSLLockingCallback);
+}
+
+}  // namespace
+
 void InitSSL(SSLState* state,
              std::string ssl_cert_name,
              std::string ssl_key_name,
@@ -32,6 +68,8 @@ void InitSSL(SSLState* state,
   SSL_library_init();
   PrintSslError();
 
+  InitSSLLocking();
+
   SSL_load_error_strings();
   PrintSslError();
 
@@ -0,0 +1,89 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/udp/datagram_batch.h"
+
+#include <string.h>
+
+#include "base/logging.h"
+#include "net/base/io_buffer.h"
+
+namespace net {
+
+DatagramBatch::Slot::Slot() : length(0) {}
+
+DatagramBatch::Slot::~Slot() {}
+
+DatagramBatch::DatagramBatch(size_t capacity, int max_datagram_size)
+    : max_datagram_size_(max_datagram_size),
+      slots_(capacity),
+      head_(0),
+      size_(0) {
+  DCHECK_GT(capacity, 0u);
+  DCHECK_GT(max_datagram_size, 0);
+  for (size_t i = 0; i < slots_.size(); ++i)
+    slots_[i].buffer = new IOBufferWithSize(max_datagram_size);
+}
+
+DatagramBatch::~DatagramBatch() {}
+
+IOBuffer* DatagramBatch::data(size_t index) const {
+  DCHECK_LT(index, size_);
+  return slot(index).buffer;
+}
+
+int DatagramBatch::length(size_t index) const {
+  DCHECK_LT(index, size_);
+  return slot(index).length;
+}
+
+const IPEndPoint& DatagramBatch::address(size_t index) const {
+  DCHECK_LT(index, size_);
+  return slot(index).address;
+}
+
+bool DatagramBatch::Push(const char* data, int length,
+                         const IPEndPoint& address) {
+  if (full() || length > max_datagram_size_)
+    return false;
+  memcpy(free_buffer(0)->data(), data, length);
+  Commit(length, address);
+  return true;
+}
+
+void DatagramBatch::Pop(size_t count) {
+  DCHECK_LE(count, size_);
+  head_ = (head_ + count) % slots_.size();
+  size_ -= count;
+}
+
+void DatagramBatch::Clear() {
+  head_ = 0;
+  size_ = 0;
+}
+
+IOBuffer* DatagramBatch::free_buffer(size_t index) const {
+  DCHECK_LT(index, slots_.size() - size_);
+  return slot(size_ + index).buffer;
+}
+
+void DatagramBatch::Commit(int length, const IPEndPoint& address) {
+  DCHECK(!full());
+  DCHECK_GE(length, 0);
+  DCHECK_LE(length, max_datagram_size_);
+  Slot& free_slot = slot(size_);
+  free_slot.length = length;
+  free_slot.address = address;
+  ++size_;
+}
+
+const DatagramBatch::Slot& DatagramBatch::slot(size_t index) const {
+  return slots_[(head_ + index) % slots_.size()];
+}
+
+DatagramBatch::Slot& DatagramBatch::slot(size_t index) {
+  return slots_[(head_ + index) % slots_.size()];
+}
+
+}  // namespace net
@@ -0,0 +1,92 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_UDP_DATAGRAM_BATCH_H_
+#define NET_UDP_DATAGRAM_BATCH_H_
+#pragma once
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+class IOBuffer;
+class IOBufferWithSize;
+
+// DatagramBatch is a ring of datagrams, which lets a socket read or write
+// several datagrams with a single call. See DatagramServerSocket's
+// RecvFromBatch() and SendToBatch().
+//
+// The buffers of the ring are allocated once, and are reused by every read
+// and write, so a batch should be kept for the lifetime of the socket.
+class NET_EXPORT DatagramBatch {
+ public:
+  // Creates a batch of up to |capacity| datagrams of up to
+  // |max_datagram_size| bytes each.
+  DatagramBatch(size_t capacity, int max_datagram_size);
+  ~DatagramBatch();
+
+  size_t capacity() const { return slots_.size(); }
+  int max_datagram_size() const { return max_datagram_size_; }
+
+  // Returns the number of datagrams in the batch.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == slots_.size(); }
+
+  // Returns the data, length and address of the |index|th datagram, counting
+  // from the oldest one. The address is the sender of a datagram which was
+  // read, or the recipient of a datagram to write.
+  IOBuffer* data(size_t index) const;
+  int length(size_t index) const;
+  const IPEndPoint& address(size_t index) const;
+
+  // Appends a copy of the |length| bytes at |data|, to be sent to |address|.
+  // Returns false if the batch is full, or if |length| is larger than
+  // max_datagram_size().
+  bool Push(const char* data, int length, const IPEndPoint& address);
+
+  // Removes the |count| oldest datagrams.
+  void Pop(size_t count);
+
+  // Removes all the datagrams.
+  void Clear();
+
+  // Sockets read datagrams into the free slots of the batch. Returns the
+  // buffer of the |index|th free slot, which has max_datagram_size() bytes.
+  IOBuffer* free_buffer(size_t index) const;
+
+  // Appends the datagram which was read into free_buffer(0).
+  void Commit(int length, const IPEndPoint& address);
+
+ private:
+  struct Slot {
+    Slot();
+    ~Slot();
+
+    scoped_refptr<IOBufferWithSize> buffer;
+    int length;
+    IPEndPoint address;
+  };
+
+  // Returns the slot which is |index| slots after the oldest datagram.
+  const Slot& slot(size_t index) const;
+  Slot& slot(size_t index);
+
+  const int max_datagram_size_;
+  std::vector<Slot> slots_;
+  // The slot of the oldest datagram.
+  size_t head_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(DatagramBatch);
+};
+
+}  // namespace net
+
+#endif  // NET_UDP_DATAGRAM_BATCH_H_
@@ -11,6 +11,7 @@
 
 namespace net {
 
+class DatagramBatch;
 class IPEndPoint;
 class IOBuffer;
 
@@ -55,6 +56,26 @@ class NET_EXPORT DatagramServerSocket : public DatagramSocket {
                      const IPEndPoint& address,
                      const CompletionCallback& callback) = 0;
 
+  // Read as many datagrams as are available, up to the number of free slots
+  // of |batch|, which must not be full. The datagrams and the addresses of
+  // their senders are appended to |batch|.
+  // |callback| the callback on completion of the Recv.
+  // Returns the number of datagrams read, a net error code, or ERR_IO_PENDING
+  // if no datagram is available yet. If ERR_IO_PENDING is returned, the caller
+  // must keep |batch| alive until the callback is called.
+  virtual int RecvFromBatch(DatagramBatch* batch,
+                            const CompletionCallback& callback) = 0;
+
+  // Send as many of the datagrams of |batch| as possible, from the oldest
+  // one, each to its own address. The datagrams which are sent are removed
+  // from |batch|.
+  // |callback| is the user callback function to call on complete.
+  // Returns the number of datagrams sent, a net error code, or ERR_IO_PENDING
+  // if the IO is in progress. If ERR_IO_PENDING is returned, the caller must
+  // keep |batch| alive until the callback is called.
+  virtual int SendToBatch(DatagramBatch* batch,
+                          const CompletionCallback& callback) = 0;
+
   // Set the receive buffer size (in bytes) for the socket.
   virtual bool SetReceiveBufferSize(int32 size) = 0;
 
@@ -37,6 +37,16 @@ int UDPServerSocket::SendTo(IOBuffer* buf,
   return socket_.SendTo(buf, buf_len, address, callback);
 }
 
+int UDPServerSocket::RecvFromBatch(DatagramBatch* batch,
+                                   const CompletionCallback& callback) {
+  return socket_.RecvFromBatch(batch, callback);
+}
+
+int UDPServerSocket::SendToBatch(DatagramBatch* batch,
+                                 const CompletionCallback& callback) {
+  return socket_.SendToBatch(batch, callback);
+}
+
 bool UDPServerSocket::SetReceiveBufferSize(int32 size) {
   return socket_.SetReceiveBufferSize(size);
 }
@@ -32,6 +32,10 @@ class NET_EXPORT UDPServerSocket : public DatagramServerSocket {
                      int buf_len,
                      const IPEndPoint& address,
                      const CompletionCallback& callback) OVERRIDE;
+  virtual int RecvFromBatch(DatagramBatch* batch,
+                            const CompletionCallback& callback) OVERRIDE;
+  virtual int SendToBatch(DatagramBatch* batch,
+                          const CompletionCallback& callback) OVERRIDE;
   virtual bool SetReceiveBufferSize(int32 size) OVERRIDE;
   virtual bool SetSendBufferSize(int32 size) OVERRIDE;
   virtual void Close() OVERRIDE;
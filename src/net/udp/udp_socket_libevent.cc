@@ -8,6 +8,9 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
 
 #include "base/eintr_wrapper.h"
 #include "base/logging.h"
@@ -19,10 +22,15 @@
 #include "net/base/net_errors.h"
 #include "net/base/net_log.h"
 #include "net/base/net_util.h"
+#include "net/udp/datagram_batch.h"
 #include "net/udp/udp_data_transfer_param.h"
 #if defined(OS_POSIX)
 #include <netinet/in.h>
 #endif
+#if defined(OS_LINUX)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace {
 
@@ -30,6 +38,21 @@ static const int kBindRetries = 10;
 static const int kPortStart = 1024;
 static const int kPortEnd = 65535;
 
+// The maximum number of datagrams read or written by a single system call.
+static const size_t kMaxBatchDatagrams = 64;
+
+#if defined(OS_LINUX) && defined(__NR_recvmmsg) && defined(__NR_sendmmsg)
+#define USE_MMSG 1
+
+// The layout of struct mmsghdr, which the C library may not declare, since
+// recvmmsg() and sendmmsg() are newer than it. They are called through
+// syscall() for the same reason.
+struct MMsgHdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+#endif
+
 }  // namespace net
 
 namespace net {
@@ -47,6 +70,10 @@ UDPSocketLibevent::UDPSocketLibevent(
           read_buf_len_(0),
           recv_from_address_(NULL),
           write_buf_len_(0),
+          read_batch_(NULL),
+          write_batch_(NULL),
+          use_recvmmsg_(true),
+          use_sendmmsg_(true),
           net_log_(BoundNetLog::Make(net_log, NetLog::SOURCE_UDP_SOCKET)) {
   scoped_refptr<NetLog::EventParameters> params;
   if (source.is_valid())
@@ -72,10 +99,12 @@ void UDPSocketLibevent::Close() {
   read_buf_len_ = 0;
   read_callback_.Reset();
   recv_from_address_ = NULL;
+  read_batch_ = NULL;
   write_buf_ = NULL;
   write_buf_len_ = 0;
   write_callback_.Reset();
   send_to_address_.reset();
+  write_batch_ = NULL;
 
   bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
   DCHECK(ok);
@@ -169,6 +198,58 @@ int UDPSocketLibevent::RecvFrom(IOBuffer* buf,
   return ERR_IO_PENDING;
 }
 
+int UDPSocketLibevent::RecvFromBatch(DatagramBatch* batch,
+                                     const CompletionCallback& callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(read_callback_.is_null());
+  DCHECK(!callback.is_null());  // Synchronous operation not supported
+  DCHECK(!batch->full());
+
+  int nread = InternalRecvFromBatch(batch);
+  if (nread != ERR_IO_PENDING)
+    return nread;
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_, true, MessageLoopForIO::WATCH_READ,
+          &read_socket_watcher_, &read_watcher_)) {
+    PLOG(ERROR) << "WatchFileDescriptor failed on read";
+    int result = MapSystemError(errno);
+    LogRead(result, NULL, 0, NULL);
+    return result;
+  }
+
+  read_batch_ = batch;
+  read_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
+int UDPSocketLibevent::SendToBatch(DatagramBatch* batch,
+                                   const CompletionCallback& callback) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_NE(kInvalidSocket, socket_);
+  DCHECK(write_callback_.is_null());
+  DCHECK(!callback.is_null());  // Synchronous operation not supported
+  DCHECK(!batch->empty());
+
+  int result = InternalSendToBatch(batch);
+  if (result != ERR_IO_PENDING)
+    return result;
+
+  if (!MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_, true, MessageLoopForIO::WATCH_WRITE,
+          &write_socket_watcher_, &write_watcher_)) {
+    DVLOG(1) << "WatchFileDescriptor failed on write, errno " << errno;
+    int result = MapSystemError(errno);
+    LogWrite(result, NULL, NULL);
+    return result;
+  }
+
+  write_batch_ = batch;
+  write_callback_ = callback;
+  return ERR_IO_PENDING;
+}
+
 int UDPSocketLibevent::Write(IOBuffer* buf,
                              int buf_len,
                              const CompletionCallback& callback) {
@@ -304,11 +385,14 @@ void UDPSocketLibevent::DoWriteCallback(int rv) {
 }
 
 void UDPSocketLibevent::DidCompleteRead() {
-  int result = InternalRecvFrom(read_buf_, read_buf_len_, recv_from_address_);
+  int result = read_batch_ ?
+      InternalRecvFromBatch(read_batch_) :
+      InternalRecvFrom(read_buf_, read_buf_len_, recv_from_address_);
   if (result != ERR_IO_PENDING) {
     read_buf_ = NULL;
     read_buf_len_ = 0;
     recv_from_address_ = NULL;
+    read_batch_ = NULL;
     bool ok = read_socket_watcher_.StopWatchingFileDescriptor();
     DCHECK(ok);
     DoReadCallback(result);
@@ -355,13 +439,15 @@ int UDPSocketLibevent::CreateSocket(const IPEndPoint& address) {
 }
 
 void UDPSocketLibevent::DidCompleteWrite() {
-  int result = InternalSendTo(write_buf_, write_buf_len_,
-                              send_to_address_.get());
+  int result = write_batch_ ?
+      InternalSendToBatch(write_batch_) :
+      InternalSendTo(write_buf_, write_buf_len_, send_to_address_.get());
 
   if (result != ERR_IO_PENDING) {
     write_buf_ = NULL;
     write_buf_len_ = 0;
     send_to_address_.reset();
+    write_batch_ = NULL;
     write_socket_watcher_.StopWatchingFileDescriptor();
     DoWriteCallback(result);
   }
@@ -447,6 +533,126 @@ int UDPSocketLibevent::InternalSendTo(IOBuffer* buf, int buf_len,
   return result;
 }
 
+int UDPSocketLibevent::InternalRecvFromBatch(DatagramBatch* batch) {
+#if defined(USE_MMSG)
+  if (use_recvmmsg_) {
+    size_t count = std::min(batch->capacity() - batch->size(),
+                            kMaxBatchDatagrams);
+    MMsgHdr msgs[kMaxBatchDatagrams];
+    struct iovec iovs[kMaxBatchDatagrams];
+    struct sockaddr_storage addr_storages[kMaxBatchDatagrams];
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for (size_t i = 0; i < count; ++i) {
+      iovs[i].iov_base = batch->free_buffer(i)->data();
+      iovs[i].iov_len = batch->max_datagram_size();
+      msgs[i].msg_hdr.msg_name = &addr_storages[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof(addr_storages[i]);
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int nread = HANDLE_EINTR(syscall(__NR_recvmmsg, socket_, msgs, count, 0,
+                                     NULL));
+    if (nread >= 0) {
+      for (int i = 0; i < nread; ++i) {
+        struct sockaddr* addr =
+            reinterpret_cast<struct sockaddr*>(&addr_storages[i]);
+        socklen_t addr_len = msgs[i].msg_hdr.msg_namelen;
+        int length = static_cast<int>(msgs[i].msg_len);
+        // The datagram is kept even if its address cannot be converted, so
+        // that the datagrams which follow it stay in their slots.
+        IPEndPoint address;
+        address.FromSockAddr(addr, addr_len);
+        LogRead(length, batch->free_buffer(0)->data(), addr_len, addr);
+        batch->Commit(length, address);
+      }
+      return nread;
+    }
+    if (errno != ENOSYS) {
+      int result = MapSystemError(errno);
+      if (result != ERR_IO_PENDING)
+        LogRead(result, NULL, 0, NULL);
+      return result;
+    }
+    use_recvmmsg_ = false;
+  }
+#endif
+
+  int nread = 0;
+  while (!batch->full()) {
+    IPEndPoint address;
+    int result = InternalRecvFrom(batch->free_buffer(0),
+                                  batch->max_datagram_size(), &address);
+    if (result < 0)
+      return nread > 0 ? nread : result;
+    batch->Commit(result, address);
+    ++nread;
+  }
+  return nread;
+}
+
+int UDPSocketLibevent::InternalSendToBatch(DatagramBatch* batch) {
+#if defined(USE_MMSG)
+  if (use_sendmmsg_) {
+    size_t count = std::min(batch->size(), kMaxBatchDatagrams);
+    MMsgHdr msgs[kMaxBatchDatagrams];
+    struct iovec iovs[kMaxBatchDatagrams];
+    struct sockaddr_storage addr_storages[kMaxBatchDatagrams];
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for (size_t i = 0; i < count; ++i) {
+      size_t addr_len = sizeof(addr_storages[i]);
+      struct sockaddr* addr =
+          reinterpret_cast<struct sockaddr*>(&addr_storages[i]);
+      if (!batch->address(i).ToSockAddr(addr, &addr_len)) {
+        // Sends the datagrams before this one, so that the error is returned
+        // for this one by the next call.
+        if (i == 0) {
+          int result = ERR_FAILED;
+          LogWrite(result, NULL, NULL);
+          return result;
+        }
+        count = i;
+        break;
+      }
+      iovs[i].iov_base = batch->data(i)->data();
+      iovs[i].iov_len = batch->length(i);
+      msgs[i].msg_hdr.msg_name = addr;
+      msgs[i].msg_hdr.msg_namelen = addr_len;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int nwrite = HANDLE_EINTR(syscall(__NR_sendmmsg, socket_, msgs, count, 0));
+    if (nwrite >= 0) {
+      for (int i = 0; i < nwrite; ++i) {
+        LogWrite(static_cast<int>(msgs[i].msg_len), batch->data(i)->data(),
+                 &batch->address(i));
+      }
+      batch->Pop(nwrite);
+      return nwrite;
+    }
+    if (errno != ENOSYS) {
+      int result = MapSystemError(errno);
+      if (result != ERR_IO_PENDING)
+        LogWrite(result, NULL, NULL);
+      return result;
+    }
+    use_sendmmsg_ = false;
+  }
+#endif
+
+  int nwrite = 0;
+  while (!batch->empty()) {
+    int result = InternalSendTo(batch->data(0), batch->length(0),
+                                &batch->address(0));
+    if (result < 0)
+      return nwrite > 0 ? nwrite : result;
+    batch->Pop(1);
+    ++nwrite;
+  }
+  return nwrite;
+}
+
 int UDPSocketLibevent::DoBind(const IPEndPoint& address) {
   struct sockaddr_storage addr_storage;
   size_t addr_len = sizeof(addr_storage);
@@ -20,6 +20,8 @@
 
 namespace net {
 
+class DatagramBatch;
+
 class UDPSocketLibevent : public base::NonThreadSafe {
  public:
   UDPSocketLibevent(DatagramSocket::BindType bind_type,
@@ -93,6 +95,14 @@ class UDPSocketLibevent : public base::NonThreadSafe {
              const IPEndPoint& address,
              const CompletionCallback& callback);
 
+  // Read as many datagrams as are available into the free slots of |batch|.
+  // See DatagramServerSocket::RecvFromBatch().
+  int RecvFromBatch(DatagramBatch* batch, const CompletionCallback& callback);
+
+  // Send as many of the datagrams of |batch| as possible.
+  // See DatagramServerSocket::SendToBatch().
+  int SendToBatch(DatagramBatch* batch, const CompletionCallback& callback);
+
   // Set the receive buffer size (in bytes) for the socket.
   bool SetReceiveBufferSize(int32 size);
 
@@ -172,6 +182,8 @@ class UDPSocketLibevent : public base::NonThreadSafe {
   int InternalConnect(const IPEndPoint& address);
   int InternalRecvFrom(IOBuffer* buf, int buf_len, IPEndPoint* address);
   int InternalSendTo(IOBuffer* buf, int buf_len, const IPEndPoint* address);
+  int InternalRecvFromBatch(DatagramBatch* batch);
+  int InternalSendToBatch(DatagramBatch* batch);
 
   int DoBind(const IPEndPoint& address);
   int RandomBind(const IPEndPoint& address);
@@ -208,6 +220,16 @@ class UDPSocketLibevent : public base::NonThreadSafe {
   int write_buf_len_;
   scoped_ptr<IPEndPoint> send_to_address_;
 
+  // The batches used to retry RecvFromBatch and SendToBatch requests.
+  DatagramBatch* read_batch_;
+  DatagramBatch* write_batch_;
+
+  // Whether recvmmsg() and sendmmsg() may be used. They are cleared when the
+  // kernel turns out not to support them, in which case batches are read and
+  // written one datagram at a time.
+  bool use_recvmmsg_;
+  bool use_sendmmsg_;
+
   // External callback; called when read is complete.
   CompletionCallback read_callback_;
 
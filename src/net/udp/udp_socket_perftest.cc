@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/udp/udp_server_socket.h"
+
+#include <string>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/base/net_util.h"
+#include "net/base/test_completion_callback.h"
+#include "net/udp/datagram_batch.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Datagrams are sent in bursts which fit in the receive buffer, so that none
+// is dropped on the loopback interface.
+const int kNumBursts = 2000;
+const int kBurstSize = 32;
+const int kDatagramSize = 512;
+
+class UDPSocketPerfTest : public testing::Test {
+ public:
+  UDPSocketPerfTest()
+      : message_loop_(new MessageLoopForIO()),
+        sender_(NULL, NetLog::Source()),
+        receiver_(NULL, NetLog::Source()) {
+  }
+
+  virtual void SetUp() {
+    IPAddressNumber loopback;
+    ASSERT_TRUE(ParseIPLiteralToNumber("127.0.0.1", &loopback));
+    ASSERT_EQ(OK, sender_.Listen(IPEndPoint(loopback, 0)));
+    ASSERT_EQ(OK, receiver_.Listen(IPEndPoint(loopback, 0)));
+    ASSERT_EQ(OK, receiver_.GetLocalAddress(&receiver_address_));
+  }
+
+ protected:
+  // Logs the rate of |num_datagrams| datagrams sent and received in
+  // |elapsed|.
+  void LogRate(const char* name, int num_datagrams, base::TimeDelta elapsed) {
+    LogPerfResult(name, num_datagrams / elapsed.InSecondsF(), "packets/s");
+  }
+
+  scoped_ptr<MessageLoop> message_loop_;
+  UDPServerSocket sender_;
+  UDPServerSocket receiver_;
+  IPEndPoint receiver_address_;
+};
+
+}  // namespace
+
+// Sends and receives each datagram with its own system call.
+TEST_F(UDPSocketPerfTest, SingleDatagrams) {
+  scoped_refptr<IOBufferWithSize> send_buffer(
+      new IOBufferWithSize(kDatagramSize));
+  memset(send_buffer->data(), 'x', kDatagramSize);
+  scoped_refptr<IOBufferWithSize> recv_buffer(
+      new IOBufferWithSize(kDatagramSize));
+  IPEndPoint address;
+  TestCompletionCallback callback;
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumBursts; ++i) {
+    for (int j = 0; j < kBurstSize; ++j) {
+      int rv = sender_.SendTo(send_buffer, kDatagramSize, receiver_address_,
+                              callback.callback());
+      ASSERT_EQ(kDatagramSize, callback.GetResult(rv));
+    }
+    for (int j = 0; j < kBurstSize; ++j) {
+      int rv = receiver_.RecvFrom(recv_buffer, kDatagramSize, &address,
+                                  callback.callback());
+      ASSERT_EQ(kDatagramSize, callback.GetResult(rv));
+    }
+  }
+  LogRate("UDP_single_datagrams", kNumBursts * kBurstSize, timer.Elapsed());
+}
+
+// Sends and receives the datagrams of a burst with as few system calls as
+// possible.
+TEST_F(UDPSocketPerfTest, BatchedDatagrams) {
+  std::string datagram(kDatagramSize, 'x');
+  DatagramBatch send_batch(kBurstSize, kDatagramSize);
+  DatagramBatch recv_batch(kBurstSize, kDatagramSize);
+  TestCompletionCallback callback;
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumBursts; ++i) {
+    while (!send_batch.full()) {
+      send_batch.Push(datagram.data(), kDatagramSize, receiver_address_);
+    }
+    while (!send_batch.empty()) {
+      int rv = sender_.SendToBatch(&send_batch, callback.callback());
+      ASSERT_GT(callback.GetResult(rv), 0);
+    }
+    recv_batch.Clear();
+    while (!recv_batch.full()) {
+      int rv = receiver_.RecvFromBatch(&recv_batch, callback.callback());
+      ASSERT_GT(callback.GetResult(rv), 0);
+    }
+  }
+  LogRate("UDP_batched_datagrams", kNumBursts * kBurstSize, timer.Elapsed());
+}
+
+}  // namespace net
@@ -9,6 +9,7 @@
 #include "base/bind.h"
 #include "base/metrics/histogram.h"
 #include "base/stl_util.h"
+#include "base/stringprintf.h"
 #include "net/base/io_buffer.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
@@ -17,6 +18,7 @@
 #include "net/base/net_util.h"
 #include "net/base/sys_addrinfo.h"
 #include "net/base/test_completion_callback.h"
+#include "net/udp/datagram_batch.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/platform_test.h"
 
@@ -444,6 +446,59 @@ TEST_F(UDPSocketTest, CloseWithPendingRead) {
   EXPECT_FALSE(callback.have_result());
 }
 
+#if defined(OS_POSIX)
+// Sends several datagrams and reads them back with one call each.
+TEST_F(UDPSocketTest, SendAndRecvBatch) {
+  const size_t kNumDatagrams = 5;
+
+  IPEndPoint bind_address;
+  CreateUDPAddress("127.0.0.1", 0, &bind_address);
+  UDPServerSocket server(NULL, NetLog::Source());
+  ASSERT_EQ(OK, server.Listen(bind_address));
+  IPEndPoint server_address;
+  ASSERT_EQ(OK, server.GetLocalAddress(&server_address));
+
+  UDPServerSocket client(NULL, NetLog::Source());
+  ASSERT_EQ(OK, client.Listen(bind_address));
+  IPEndPoint client_address;
+  ASSERT_EQ(OK, client.GetLocalAddress(&client_address));
+
+  // Pops a datagram first, so that the datagrams wrap around the ring.
+  DatagramBatch send_batch(kNumDatagrams, kMaxRead);
+  ASSERT_TRUE(send_batch.Push("x", 1, server_address));
+  send_batch.Pop(1);
+  for (size_t i = 0; i < kNumDatagrams; ++i) {
+    std::string message = base::StringPrintf("datagram %d",
+                                             static_cast<int>(i));
+    ASSERT_TRUE(send_batch.Push(message.data(), message.size(),
+                                server_address));
+  }
+  EXPECT_TRUE(send_batch.full());
+
+  TestCompletionCallback callback;
+  int rv = client.SendToBatch(&send_batch, callback.callback());
+  if (rv == ERR_IO_PENDING)
+    rv = callback.WaitForResult();
+  ASSERT_EQ(static_cast<int>(kNumDatagrams), rv);
+  EXPECT_TRUE(send_batch.empty());
+
+  DatagramBatch recv_batch(kNumDatagrams, kMaxRead);
+  while (!recv_batch.full()) {
+    rv = server.RecvFromBatch(&recv_batch, callback.callback());
+    if (rv == ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    ASSERT_GT(rv, 0);
+  }
+  for (size_t i = 0; i < kNumDatagrams; ++i) {
+    std::string message = base::StringPrintf("datagram %d",
+                                             static_cast<int>(i));
+    EXPECT_EQ(message, std::string(recv_batch.data(i)->data(),
+                                   recv_batch.length(i)));
+    EXPECT_TRUE(client_address == recv_batch.address(i));
+  }
+}
+#endif  // defined(OS_POSIX)
+
 }  // namespace
 
 }  // namespace net
@@ -172,6 +172,19 @@ int UDPSocketWin::SendTo(IOBuffer* buf,
   return SendToOrWrite(buf, buf_len, &address, callback);
 }
 
+// Batched IO is only implemented by UDPSocketLibevent so far.
+int UDPSocketWin::RecvFromBatch(DatagramBatch* batch,
+                                const CompletionCallback& callback) {
+  NOTIMPLEMENTED();
+  return ERR_NOT_IMPLEMENTED;
+}
+
+int UDPSocketWin::SendToBatch(DatagramBatch* batch,
+                              const CompletionCallback& callback) {
+  NOTIMPLEMENTED();
+  return ERR_NOT_IMPLEMENTED;
+}
+
 int UDPSocketWin::SendToOrWrite(IOBuffer* buf,
                                 int buf_len,
                                 const IPEndPoint* address,
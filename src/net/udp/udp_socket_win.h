@@ -21,6 +21,8 @@
 
 namespace net {
 
+class DatagramBatch;
+
 class UDPSocketWin : public base::NonThreadSafe {
  public:
   UDPSocketWin(DatagramSocket::BindType bind_type,
@@ -94,6 +96,14 @@ class UDPSocketWin : public base::NonThreadSafe {
              const IPEndPoint& address,
              const CompletionCallback& callback);
 
+  // Read as many datagrams as are available into the free slots of |batch|.
+  // See DatagramServerSocket::RecvFromBatch().
+  int RecvFromBatch(DatagramBatch* batch, const CompletionCallback& callback);
+
+  // Send as many of the datagrams of |batch| as possible.
+  // See DatagramServerSocket::SendToBatch().
+  int SendToBatch(DatagramBatch* batch, const CompletionCallback& callback);
+
   // Set the receive buffer size (in bytes) for the socket.
   bool SetReceiveBufferSize(int32 size);
 